@@ -7,27 +7,100 @@
 #include "SceneBuilder.hpp"
 #include "Scenes.hpp"
 #include "SkyboxMappingRenderer.hpp"
+#include "String.hpp"
+#include <cstdlib>
+#include <string_view>
 #include <windows.h>
 
 
 #include "config.h"
 
+namespace {
+int InvalidArgument(const char* program, std::string_view arg, std::string_view value)
+{
+    Log::Error("Invalid value ", value, " for argument ", arg, "\n");
+    Log::Out("Usage: ", program, " [--scene <file>] [--headless] [--frames <count>] [--timestep <seconds>] [--width <pixels>] [--height <pixels>] ",
+             "[--dump <attachment>]... [--dump-dir <directory>]\n");
+    return EXIT_FAILURE;
+}
+}   // namespace
+
 int main(int argc, char** argv)
 {
-    auto engine = std::make_unique<Engine>(argv[0]);
-    engine->SetApp(std::make_unique<MapleLeafApp::MainApp>());
+    // --headless renders offscreen at a fixed timestep, --frames, --timestep, --width, --height, --dump and --dump-dir configure it.
+    std::optional<HeadlessSettings> headless;
+    std::string                     scenePath;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg   = argv[i];
+        const char*      value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (arg == "--headless") {
+            if (!headless) headless.emplace();
+            continue;
+        }
+        if (!value) {
+            Log::Warning("Ignoring argument ", arg, " without a value\n");
+            continue;
+        }
+
+        i++;
+        if (arg == "--scene") {
+            scenePath = value;
+            continue;
+        }
+
+        if (arg != "--frames" && arg != "--timestep" && arg != "--width" && arg != "--height" && arg != "--dump" && arg != "--dump-dir") {
+            Log::Warning("Ignoring argument ", arg, "\n");
+            continue;
+        }
+
+        if (!headless) headless.emplace();
+        if (arg == "--dump") {
+            headless->dumpAttachments.emplace_back(value);
+            continue;
+        }
+        if (arg == "--dump-dir") {
+            headless->dumpDirectory = value;
+            continue;
+        }
+
+        // Each value is parsed once, a malformed or out of range one stops the run instead of throwing out of main.
+        if (arg == "--timestep") {
+            auto timestep = String::ParseFloat(value);
+            if (!timestep || *timestep <= 0.0f) return InvalidArgument(argv[0], arg, value);
+            headless->timestep = Time::Seconds(*timestep);
+            continue;
+        }
+
+        auto number = String::ParseUint32(value);
+        if (!number || (arg != "--frames" && *number == 0)) return InvalidArgument(argv[0], arg, value);
+        if (arg == "--frames")
+            headless->frameCount = *number;
+        else if (arg == "--width")
+            headless->width = *number;
+        else
+            headless->height = *number;
+    }
+
+    auto engine = std::make_unique<Engine>(argv[0], ModuleFilter(), std::move(headless));
+    engine->SetApp(std::make_unique<MapleLeafApp::MainApp>(std::move(scenePath)));
 
     auto exitCode = engine->Run();
+    auto waitExit = !engine->IsHeadless();
     engine        = nullptr;
 
-    std::cout << "Press enter to continue...";
-    std::cin.get();
+    if (waitExit) {
+        std::cout << "Press enter to continue...";
+        std::cin.get();
+    }
     return exitCode;
 }
 
 namespace MapleLeafApp {
-MainApp::MainApp()
+MainApp::MainApp(std::string startScenePath)
     : App("MapleLeaf", {CONFIG_VERSION_MAJOR, CONFIG_VERSION_MINOR, CONFIG_VERSION_ALTER})
+    , startScenePath(std::move(startScenePath))
 {
     // Registers file search paths.
     Log::Out("Working Directory: ", std::filesystem::current_path(), '\n');
@@ -52,7 +125,7 @@ void MainApp::Start()
 #endif
 
     sceneLoaded = false;
-    scenePath.clear();
+    scenePath   = startScenePath;
 }
 
 void MainApp::RegisterImGui()
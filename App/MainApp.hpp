@@ -18,13 +18,14 @@ enum class RendererType
 class MainApp : public App
 {
 public:
-    MainApp();
+    explicit MainApp(std::string startScenePath = {});
     ~MainApp();
 
     void Start() override;
     void Update() override;
 
 private:
+    std::string  startScenePath;   // Loaded on start, headless runs have no file dialog
     std::string  scenePath;
     bool         sceneLoaded     = false;
     RendererType currentRenderer = RendererType::None;   // Track current renderer type
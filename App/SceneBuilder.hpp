@@ -40,10 +40,14 @@ public:
         auto     shadows       = GetSystem<ShadowSystem>();
         uint32_t instanceCount = 0;
 
+        // Parents come before their children in the scene graph, node names are not unique so parents are found by index.
+        std::vector<Entity*> nodeEntities;
+        nodeEntities.reserve(builder.sceneGraph.size());
+
         for (uint32_t index = 0; index < builder.sceneGraph.size(); index++) {
             const auto& node = builder.sceneGraph[index];
 
-            auto entity = CreateEntity();
+            auto entity = nodeEntities.emplace_back(CreateEntity());
             entity->SetName(node.name);
 
             if (node.flags.size() > 0) {
@@ -52,10 +56,7 @@ public:
                 }
             }
 
-            if (node.parent.isValid()) {
-                const auto& parent = builder.sceneGraph[node.parent.get()];
-                entity->SetParent(GetEntity(parent.name));
-            }
+            if (node.parent.isValid()) entity->SetParent(nodeEntities[node.parent.get()]);
 
             std::unique_ptr<Transform> transform;
             transform.reset(node.transform);
@@ -97,8 +98,6 @@ public:
                 light->SetPosition(transform->GetPosition());
                 light->SetDirection(glm::vec3(realDirection));
 
-                if (shadows && (light->type == LightType::Directional)) shadows->SetLightDirection(light->GetDirection());
-
                 entity->AddComponent(std::move(light));
             }
         }
@@ -0,0 +1,639 @@
+#include "BenchmarkApp.hpp"
+#include "BVH.hpp"
+#include "DeferredRenderer.hpp"
+#include "Engine.hpp"
+#include "Files.hpp"
+#include "GBufferSubrender.hpp"
+#include "Graphics.hpp"
+#include "LightSystem.hpp"
+#include "Log.hpp"
+#include "MeshOptimizer.hpp"
+#include "Scenes.hpp"
+#include "ShadowSubrender.hpp"
+#include "String.hpp"
+#include "ThreadPool.hpp"
+#include "Transform.hpp"
+#include "stb_image.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <glm/gtc/quaternion.hpp>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <string_view>
+
+#include "config.h"
+
+using namespace MapleLeafApp;
+
+namespace {
+int InvalidArgument(const char* program, std::string_view arg, std::string_view value)
+{
+    Log::Error("Invalid value ", value, " for argument ", arg, "\n");
+    Log::Out("Usage: ", program, " [--instances <count>] [--materials <count>] [--lights <count>] [--animated <fraction 0-1>] [--seed <seed>]\n",
+             "    [--warmup <frames>] [--frames <frames>] [--width <pixels>] [--height <pixels>] [--parallel-recording]\n",
+             "    [--output <file>] [--baseline <file>] [--update-baseline] [--threshold <fraction>]\n",
+             "    [--mesh-optimizer <segments>] [--bvh] [--transforms <depth>] [--runs <count>]\n",
+             "    [--compare <image> --reference <image> [--min-psnr <dB>]]\n");
+    return EXIT_FAILURE;
+}
+}   // namespace
+
+int main(int argc, char** argv)
+{
+    // Point VK_DRIVER_FILES at a software driver such as lavapipe to run without a GPU, the benchmark never opens a window.
+    BenchmarkSettings settings;
+    HeadlessSettings  headless;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+
+        if (arg == "--update-baseline") {
+            settings.updateBaseline = true;
+            continue;
+        }
+        if (arg == "--bvh") {
+            settings.bvh = true;
+            continue;
+        }
+        if (arg == "--parallel-recording") {
+            settings.parallelRecording = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            Log::Warning("Ignoring argument ", arg, " without a value\n");
+            continue;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--output") {
+            settings.output = value;
+            continue;
+        }
+        if (arg == "--baseline") {
+            settings.baseline = value;
+            continue;
+        }
+        if (arg == "--compare") {
+            settings.image = value;
+            continue;
+        }
+        if (arg == "--reference") {
+            settings.referenceImage = value;
+            continue;
+        }
+
+        // Numbers are parsed and range checked once, a typo stops the run with the usage instead of throwing out of main.
+        struct FloatArgument
+        {
+            std::string_view name;
+            float*           target;
+            float            min;
+            float            max;
+        };
+        const FloatArgument floatArguments[] = {
+            {"--animated", &settings.scene.animatedFraction, 0.0f, 1.0f},
+            {"--threshold", &settings.threshold, 0.0f, std::numeric_limits<float>::max()},
+            {"--min-psnr", &settings.minPsnr, 0.0f, std::numeric_limits<float>::max()},
+        };
+        // Counts that size the run itself must not be zero.
+        struct UintArgument
+        {
+            std::string_view name;
+            uint32_t*        target;
+            bool             positive;
+        };
+        const UintArgument uintArguments[] = {
+            {"--instances", &settings.scene.instanceCount, false},
+            {"--materials", &settings.scene.materialCount, false},
+            {"--lights", &settings.scene.lightCount, false},
+            {"--seed", &settings.scene.seed, false},
+            {"--warmup", &settings.warmupFrames, false},
+            {"--frames", &settings.measuredFrames, true},
+            {"--width", &headless.width, true},
+            {"--height", &headless.height, true},
+            {"--mesh-optimizer", &settings.meshOptimizerSegments, false},
+            {"--transforms", &settings.transformDepth, false},
+            {"--runs", &settings.runs, true},
+        };
+
+        auto floatArgument = std::find_if(std::begin(floatArguments), std::end(floatArguments), [arg](const auto& a) { return a.name == arg; });
+        if (floatArgument != std::end(floatArguments)) {
+            auto number = String::ParseFloat(value);
+            if (!number || *number < floatArgument->min || *number > floatArgument->max) return InvalidArgument(argv[0], arg, value);
+            *floatArgument->target = *number;
+            continue;
+        }
+
+        auto uintArgument = std::find_if(std::begin(uintArguments), std::end(uintArguments), [arg](const auto& a) { return a.name == arg; });
+        if (uintArgument != std::end(uintArguments)) {
+            auto number = String::ParseUint32(value);
+            if (!number || (uintArgument->positive && *number == 0)) return InvalidArgument(argv[0], arg, value);
+            *uintArgument->target = *number;
+            continue;
+        }
+
+        Log::Warning("Ignoring unknown argument ", arg, "\n");
+    }
+
+    if (settings.meshOptimizerSegments > 0) return RunMeshOptimizerBenchmark(settings);
+    if (settings.bvh) return RunBVHBenchmark(settings);
+    if (settings.transformDepth > 0) return RunTransformBenchmark(settings);
+    if (!settings.image.empty() && !settings.referenceImage.empty()) return RunImageComparison(settings);
+
+    auto engine    = std::make_unique<Engine>(argv[0], ModuleFilter(), std::move(headless));
+    auto app       = std::make_unique<BenchmarkApp>(settings);
+    auto benchmark = app.get();
+    engine->SetApp(std::move(app));
+
+    engine->Run();
+    auto exitCode = benchmark->GetExitCode();
+    engine        = nullptr;
+    return exitCode;
+}
+
+namespace MapleLeafApp {
+namespace {
+// Subrender zones are named after the type name of the subrender, which the compiler decorates differently.
+bool IsSubrenderZone(std::string_view zone, std::string_view subrender, std::string_view pass)
+{
+    return zone.find(subrender) != std::string_view::npos && zone.size() >= pass.size() && zone.substr(zone.size() - pass.size()) == pass;
+}
+
+nlohmann::json Summarize(std::vector<float> values)
+{
+    if (values.empty()) return {{"samples", 0}};
+
+    std::sort(values.begin(), values.end());
+    auto percentile = [&values](float p) {
+        auto index = static_cast<std::size_t>(std::ceil(p * values.size()));
+        return values[std::clamp<std::size_t>(index, 1, values.size()) - 1];
+    };
+
+    double sum = 0.0;
+    for (auto value : values) sum += value;
+
+    return {{"samples", values.size()},
+            {"mean", sum / values.size()},
+            {"median", percentile(0.5f)},
+            {"p95", percentile(0.95f)},
+            {"min", values.front()},
+            {"max", values.back()}};
+}
+
+// Compares the metric medians to the baseline unless it is being updated, then writes the results. Returns false if a metric regressed or a
+// file could not be written.
+bool CompareAndWrite(nlohmann::json& result, const BenchmarkSettings& settings)
+{
+    bool passed = true;
+
+    if (!settings.baseline.empty() && !settings.updateBaseline) {
+        std::ifstream file(settings.baseline);
+        auto          baseline = file ? nlohmann::json::parse(file, nullptr, false) : nlohmann::json();
+
+        // Medians of a different scene are not comparable, the run fails rather than passing silently.
+        if (!baseline.is_object() || baseline["scene"] != result["scene"]) {
+            Log::Error("Benchmark baseline ", settings.baseline, " is missing or was recorded with a different scene\n");
+            passed = false;
+        }
+        else {
+            for (const auto& [name, metric] : result["metrics"].items()) {
+                if (!baseline["metrics"].contains(name)) continue;
+
+                auto baselineMedian = baseline["metrics"][name].value("median", 0.0f);
+                auto median         = metric.value("median", 0.0f);
+
+                // Zones the baseline device could not measure, such as GPU zones without timestamp support, are skipped.
+                if (baselineMedian <= 0.0f) continue;
+
+                auto ratio     = median / baselineMedian;
+                auto regressed = ratio > 1.0f + settings.threshold;
+
+                result["comparison"][name] = {{"baseline", baselineMedian}, {"current", median}, {"ratio", ratio}, {"regressed", regressed}};
+                if (regressed) {
+                    Log::Error("Benchmark ", name, " regressed to ", median, " ms from ", baselineMedian, " ms\n");
+                    passed = false;
+                }
+            }
+        }
+    }
+    result["passed"] = passed;
+
+    auto write = [&passed, &result](const std::filesystem::path& filename) {
+        if (auto parentPath = filename.parent_path(); !parentPath.empty()) std::filesystem::create_directories(parentPath);
+
+        std::ofstream stream(filename);
+        if (!stream) {
+            Log::Error("Failed to write benchmark results ", filename, "\n");
+            passed = false;
+            return;
+        }
+        stream << result.dump(4) << '\n';
+    };
+
+    write(settings.output);
+    if (settings.updateBaseline && !settings.baseline.empty()) write(settings.baseline);
+    return passed;
+}
+}   // namespace
+
+int32_t RunMeshOptimizerBenchmark(const BenchmarkSettings& settings)
+{
+    std::vector<Vertex3D> sphereVertices;
+    std::vector<uint32_t> sphereIndices;
+    BenchmarkScene::GenerateSphere(settings.meshOptimizerSegments, settings.meshOptimizerSegments * 2, sphereVertices, sphereIndices);
+
+    // Triangles in random order are the worst case an exporter can write.
+    std::vector<uint32_t> triangles(sphereIndices.size() / 3);
+    for (uint32_t i = 0; i < triangles.size(); i++) triangles[i] = i;
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(settings.scene.seed));
+
+    std::vector<uint32_t> shuffledIndices;
+    shuffledIndices.reserve(sphereIndices.size());
+    for (auto triangle : triangles) shuffledIndices.insert(shuffledIndices.end(), &sphereIndices[triangle * 3], &sphereIndices[triangle * 3 + 3]);
+
+    std::map<std::string, std::vector<float>> samples;
+    MeshOptimizer::Statistics                 before = MeshOptimizer::AnalyzeVertexCache(shuffledIndices, sphereVertices.size());
+    MeshOptimizer::Statistics                 afterCache, afterOverdraw;
+
+    for (uint32_t run = 0; run < settings.runs; run++) {
+        auto vertices = sphereVertices;
+
+        auto start   = Time::Now();
+        auto indices = MeshOptimizer::OptimizeVertexCache(shuffledIndices, vertices.size());
+        samples["vertexCache"].push_back((Time::Now() - start).AsMilliseconds<float>());
+        afterCache = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+
+        start   = Time::Now();
+        indices = MeshOptimizer::OptimizeOverdraw(vertices, indices);
+        samples["overdraw"].push_back((Time::Now() - start).AsMilliseconds<float>());
+
+        start = Time::Now();
+        MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+        samples["vertexFetch"].push_back((Time::Now() - start).AsMilliseconds<float>());
+        afterOverdraw = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+    }
+
+    auto toJson = [](const MeshOptimizer::Statistics& statistics) { return nlohmann::json{{"acmr", statistics.acmr}, {"atvr", statistics.atvr}}; };
+
+    nlohmann::json result;
+    result["scene"]      = {{"meshOptimizer", {{"segments", settings.meshOptimizerSegments}, {"seed", settings.scene.seed}}}};
+    result["runs"]       = settings.runs;
+    result["triangles"]  = triangles.size();
+    result["statistics"] = {{"input", toJson(before)}, {"vertexCache", toJson(afterCache)}, {"overdraw", toJson(afterOverdraw)}};
+
+    for (const auto& [name, values] : samples) {
+        result["metrics"][name] = Summarize(values);
+        Log::Out("Benchmark ", name, " median ", result["metrics"][name].value("median", 0.0f), " ms\n");
+    }
+    Log::Out("Benchmark ACMR ", before.acmr, " -> ", afterCache.acmr, " -> ", afterOverdraw.acmr, ", ATVR ", before.atvr, " -> ", afterCache.atvr,
+             " -> ", afterOverdraw.atvr, "\n");
+
+    return CompareAndWrite(result, settings) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int32_t RunBVHBenchmark(const BenchmarkSettings& settings)
+{
+    // The grid of BenchmarkScene, each instance bounded by the box its unit model fills at its random scale.
+    constexpr float spacing   = 3.0f;
+    constexpr float frameTime = 1.0f / 60.0f;
+
+    const auto& scene = settings.scene;
+    auto        side  = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(scene.instanceCount))));
+
+    std::mt19937                          random(scene.seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<BVH::AABB> origins(scene.instanceCount);
+    std::vector<uint32_t>  instanceIDs(scene.instanceCount);
+    for (uint32_t i = 0; i < scene.instanceCount; i++) {
+        glm::vec3 position((i % side - side / 2.0f) * spacing, 0.0f, (i / side - side / 2.0f) * spacing);
+        glm::vec3 halfExtent(0.5f * (0.5f + unit(random)));
+        origins[i]     = {position - halfExtent, position + halfExtent};
+        instanceIDs[i] = i;
+    }
+    auto bounds = origins;
+
+    ThreadPool                                threadPool;
+    std::map<std::string, std::vector<float>> samples;
+    BVH                                       bvh;
+
+    for (uint32_t run = 0; run < settings.runs; run++) {
+        auto start = Time::Now();
+        bvh.Build(bounds, instanceIDs);
+        samples["build"].push_back((Time::Now() - start).AsMilliseconds<float>());
+
+        start = Time::Now();
+        bvh.Build(bounds, instanceIDs, &threadPool);
+        samples["parallelBuild"].push_back((Time::Now() - start).AsMilliseconds<float>());
+    }
+    auto built = bvh.GetStatistics();
+
+    // Animated instances bob like in BenchmarkScene::Update, every frame refits and rebuilds once the SAH cost degraded too far.
+    auto                  animatedCount = static_cast<uint32_t>(std::clamp(scene.animatedFraction, 0.0f, 1.0f) * scene.instanceCount);
+    std::vector<uint32_t> moved(animatedCount);
+    for (uint32_t i = 0; i < animatedCount; i++) moved[i] = i;
+
+    uint32_t rebuildCount = 0;
+    for (uint32_t frame = 0; frame < settings.measuredFrames; frame++) {
+        auto time = frame * frameTime;
+        for (uint32_t i = 0; i < animatedCount; i++) {
+            glm::vec3 offset(0.0f, std::sin(2.0f * time + 0.37f * i), 0.0f);
+            bounds[i] = {origins[i].first + offset, origins[i].second + offset};
+        }
+
+        auto start = Time::Now();
+        bvh.Refit(moved, bounds);
+        if (bvh.NeedsRebuild(BVH::DefaultRebuildThreshold)) {
+            bvh.Build(bounds, instanceIDs, &threadPool);
+            rebuildCount++;
+        }
+        samples["update"].push_back((Time::Now() - start).AsMilliseconds<float>());
+    }
+    auto updated = bvh.GetStatistics();
+
+    auto toJson = [](const BVH::Statistics& statistics) {
+        return nlohmann::json{{"sahCost", statistics.sahCost},
+                              {"buildSahCost", statistics.buildSahCost},
+                              {"nodeCount", statistics.nodeCount},
+                              {"maxDepth", statistics.maxDepth},
+                              {"averageLeafDepth", statistics.averageLeafDepth}};
+    };
+
+    nlohmann::json result;
+    result["scene"]      = {{"bvh", {{"instances", scene.instanceCount}, {"animatedFraction", scene.animatedFraction}, {"seed", scene.seed}}}};
+    result["frames"]     = {{"measured", settings.measuredFrames}, {"rebuilds", rebuildCount}};
+    result["statistics"] = {{"built", toJson(built)}, {"updated", toJson(updated)}};
+
+    for (const auto& [name, values] : samples) {
+        result["metrics"][name] = Summarize(values);
+        Log::Out("Benchmark ", name, " median ", result["metrics"][name].value("median", 0.0f), " ms\n");
+    }
+    Log::Out("Benchmark SAH cost ", built.sahCost, " built, ", updated.sahCost, " after ", settings.measuredFrames, " frames and ", rebuildCount,
+             " rebuilds\n");
+
+    return CompareAndWrite(result, settings) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int32_t RunTransformBenchmark(const BenchmarkSettings& settings)
+{
+    // Every link is offset, turned and scaled a little from its parent, the scale is uniform so the composition equals the matrix product.
+    std::vector<std::unique_ptr<Transform>> chain;
+    chain.reserve(settings.transformDepth);
+    for (uint32_t i = 0; i < settings.transformDepth; i++) {
+        auto& transform = chain.emplace_back(std::make_unique<Transform>(
+            glm::vec3(0.0f, 0.01f, 0.02f), glm::angleAxis(0.001f * (i % 7), glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(1.0f + 0.0001f * (i % 3))));
+        if (i > 0) transform->SetParent(chain[i - 1].get());
+    }
+
+    // The world matrix composed from the local states up to the root on every read, as the world state was built before it was cached.
+    auto composeWorldMatrix = [](const Transform& transform) {
+        glm::vec3 position = transform.GetLocalPosition();
+        glm::quat rotation = transform.GetLocalRotation();
+        glm::vec3 scale    = transform.GetLocalScale();
+        for (auto parent = transform.GetParent(); parent != nullptr; parent = parent->GetParent()) {
+            glm::mat4 local = glm::translate(glm::mat4(1.0f), parent->GetLocalPosition()) * glm::mat4_cast(parent->GetLocalRotation()) *
+                              glm::scale(glm::mat4(1.0f), parent->GetLocalScale());
+            position = glm::vec3(local * glm::vec4(position, 1.0f));
+            rotation = parent->GetLocalRotation() * rotation;
+            scale    = parent->GetLocalScale() * scale;
+        }
+        return glm::translate(glm::mat4(1.0f), position) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+    };
+
+    std::map<std::string, std::vector<float>> samples;
+    // Read back so the reads are not optimized away, and compared so a stale cache shows up.
+    float checksum = 0.0f, maxError = 0.0f;
+
+    for (uint32_t run = 0; run < settings.runs; run++) {
+        chain.front()->SetLocalPosition(glm::vec3(0.0f, 0.0f, 0.1f * run));
+
+        auto start = Time::Now();
+        for (const auto& transform : chain) checksum += transform->GetWorldMatrix()[3].x;
+        samples["cachedAfterMove"].push_back((Time::Now() - start).AsMilliseconds<float>());
+
+        start = Time::Now();
+        for (const auto& transform : chain) checksum += transform->GetWorldMatrix()[3].x;
+        samples["cachedUnchanged"].push_back((Time::Now() - start).AsMilliseconds<float>());
+
+        start = Time::Now();
+        for (const auto& transform : chain) checksum += composeWorldMatrix(*transform)[3].x;
+        samples["recompute"].push_back((Time::Now() - start).AsMilliseconds<float>());
+
+        auto difference = chain.back()->GetWorldMatrix()[3] - composeWorldMatrix(*chain.back())[3];
+        maxError        = std::max(maxError, glm::length(difference));
+    }
+
+    nlohmann::json result;
+    result["scene"]      = {{"transforms", {{"depth", settings.transformDepth}}}};
+    result["runs"]       = settings.runs;
+    result["statistics"] = {{"maxError", maxError}, {"checksum", checksum}};
+
+    for (const auto& [name, values] : samples) {
+        result["metrics"][name] = Summarize(values);
+        Log::Out("Benchmark ", name, " median ", result["metrics"][name].value("median", 0.0f), " ms\n");
+    }
+    Log::Out("Benchmark world position error of the last link ", maxError, "\n");
+
+    // Children are destroyed first, so no link invalidates the rest of the chain on its way out.
+    while (!chain.empty()) chain.pop_back();
+
+    return CompareAndWrite(result, settings) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int32_t RunImageComparison(const BenchmarkSettings& settings)
+{
+    struct LoadedImage
+    {
+        int32_t                                              width  = 0;
+        int32_t                                              height = 0;
+        std::unique_ptr<stbi_uc, decltype(&stbi_image_free)> pixels = {nullptr, stbi_image_free};
+    };
+
+    auto load = [](const std::filesystem::path& filename) {
+        LoadedImage image;
+        int32_t     channels;
+        image.pixels.reset(stbi_load(filename.string().c_str(), &image.width, &image.height, &channels, 4));
+        if (!image.pixels) Log::Error("Failed to read image ", filename, "\n");
+        return image;
+    };
+
+    auto image = load(settings.image), reference = load(settings.referenceImage);
+    if (!image.pixels || !reference.pixels) return EXIT_FAILURE;
+    if (image.width != reference.width || image.height != reference.height) {
+        Log::Error("Image ", settings.image, " is ", image.width, "x", image.height, ", the reference is ", reference.width, "x", reference.height,
+                   "\n");
+        return EXIT_FAILURE;
+    }
+
+    // Alpha is ignored, the swapchain does not store coverage.
+    auto     pixelCount      = static_cast<std::size_t>(image.width) * image.height;
+    double   squaredErrorSum = 0.0;
+    int32_t  maxError        = 0;
+    uint64_t differingPixels = 0;
+    for (std::size_t i = 0; i < pixelCount; i++) {
+        int32_t pixelError = 0;
+        for (std::size_t channel = 0; channel < 3; channel++) {
+            auto error = std::abs(static_cast<int32_t>(image.pixels.get()[4 * i + channel]) - reference.pixels.get()[4 * i + channel]);
+            squaredErrorSum += error * error;
+            pixelError = std::max(pixelError, error);
+        }
+        maxError = std::max(maxError, pixelError);
+        if (pixelError > 0) differingPixels++;
+    }
+
+    // Identical images have no finite ratio, it is written as null.
+    auto meanSquaredError = squaredErrorSum / (3.0 * pixelCount);
+    auto psnr             = meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : std::numeric_limits<double>::infinity();
+    auto withinThreshold  = psnr >= settings.minPsnr;
+
+    nlohmann::json result;
+    result["scene"]      = {{"imageComparison", {{"image", settings.image.string()}, {"reference", settings.referenceImage.string()}}}};
+    result["statistics"] = {{"psnr", psnr},
+                            {"meanSquaredError", meanSquaredError},
+                            {"maxError", maxError},
+                            {"differingPixels", static_cast<double>(differingPixels) / pixelCount},
+                            {"minPsnr", settings.minPsnr},
+                            {"withinThreshold", withinThreshold}};
+
+    Log::Out("Benchmark PSNR ", psnr, " dB, max error ", maxError, ", ", differingPixels, " of ", pixelCount, " pixels differ\n");
+    if (!withinThreshold) Log::Error("Image ", settings.image, " is below the minimum PSNR of ", settings.minPsnr, " dB\n");
+
+    return CompareAndWrite(result, settings) && withinThreshold ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+BenchmarkApp::BenchmarkApp(const BenchmarkSettings& settings)
+    : App("MapleLeafBenchmark", {CONFIG_VERSION_MAJOR, CONFIG_VERSION_MINOR, CONFIG_VERSION_ALTER})
+    , settings(settings)
+{
+    Files::Get()->AddSearchPath("Resources");
+    Files::Get()->AddSearchPath("Resources/Shader");
+    Files::Get()->AddSearchPath("Resources/Skybox");
+}
+
+void BenchmarkApp::Start()
+{
+    // Every metric except the frame time is read from the profiler zones.
+    Profiler::SetEnabled(true);
+
+    auto benchmarkScene = std::make_unique<BenchmarkScene>(settings.scene);
+    scene               = benchmarkScene.get();
+    Scenes::Get()->SetScene(std::move(benchmarkScene));
+
+    auto renderer = std::make_unique<DeferredRenderer>();
+    renderer->SetParallelRecording(settings.parallelRecording);
+    Graphics::Get()->SetRenderer(std::move(renderer));
+}
+
+void BenchmarkApp::Update()
+{
+    if (!scene->IsStarted()) return;
+
+    // GPU zones of a frame are read back once its frame slot comes around again, frames older than that are complete.
+    constexpr uint64_t latency    = Swapchain::OffscreenImageCount + 1;
+    auto               frameIndex = Profiler::GetFrameIndex();
+
+    if (!measuring) {
+        measuring = true;
+        nextFrame = frameIndex + settings.warmupFrames;
+        samples["import"].push_back(scene->GetImportTime().AsMilliseconds<float>());
+    }
+
+    for (; nextFrame + latency < frameIndex && collectedCount < settings.measuredFrames; nextFrame++, collectedCount++) {
+        if (auto frame = Profiler::GetFrame(nextFrame)) CollectFrame(*frame);
+    }
+
+    if (collectedCount == settings.measuredFrames) {
+        Finish();
+        Engine::Get()->RequestClose();
+    }
+}
+
+void BenchmarkApp::CollectFrame(const Profiler::Frame& frame)
+{
+    float gpuFrame = 0.0f, gpuSceneUpdate = 0.0f, bvhUpdate = 0.0f, recording = 0.0f, culling = 0.0f, gBuffer = 0.0f, occlusion = 0.0f,
+          shadows = 0.0f, lighting = 0.0f;
+
+    for (const auto& zone : frame.zones) {
+        auto milliseconds = (zone.end - zone.start).AsMilliseconds<float>();
+
+        if (zone.thread != Profiler::GpuThread) {
+            if (zone.name == "GPUScene::Update") gpuSceneUpdate += milliseconds;
+            if (zone.name == "ASScene::BuildBVH") bvhUpdate += milliseconds;
+            // Time the main thread spends recording the subpasses, inline or waiting on the secondary command buffers.
+            if (zone.name.rfind("Subpass ", 0) == 0 || zone.name == "Record secondaries") recording += milliseconds;
+            continue;
+        }
+
+        if (zone.depth == 0) gpuFrame += milliseconds;
+        if (IsSubrenderZone(zone.name, "GBufferSubrender", "::PreRender")) culling += milliseconds;
+        if (IsSubrenderZone(zone.name, "GBufferSubrender", "::Render")) gBuffer += milliseconds;
+        if (IsSubrenderZone(zone.name, "GBufferSubrender", "::PostRender")) occlusion += milliseconds;
+        // The shadow culling dispatch is recorded in PreRender, the cascade draws in Render.
+        if (IsSubrenderZone(zone.name, "ShadowSubrender", "::PreRender")) shadows += milliseconds;
+        if (IsSubrenderZone(zone.name, "ShadowSubrender", "::Render")) shadows += milliseconds;
+        if (IsSubrenderZone(zone.name, "DeferredSubrender", "::Render")) lighting += milliseconds;
+    }
+
+    samples["frame"].push_back((frame.end - frame.start).AsMilliseconds<float>());
+    samples["gpuFrame"].push_back(gpuFrame);
+    samples["gpuSceneUpdate"].push_back(gpuSceneUpdate);
+    samples["bvhUpdate"].push_back(bvhUpdate);
+    samples["recording"].push_back(recording);
+    samples["culling"].push_back(culling);
+    samples["gBuffer"].push_back(gBuffer);
+    samples["occlusion"].push_back(occlusion);
+    samples["shadows"].push_back(shadows);
+    samples["lighting"].push_back(lighting);
+}
+
+void BenchmarkApp::Finish()
+{
+    nlohmann::json result;
+    result["device"] = std::string(Graphics::Get()->GetPhysicalDevice()->GetProperties().deviceName);
+    result["scene"]  = {{"instances", settings.scene.instanceCount},
+                        {"materials", settings.scene.materialCount},
+                        {"lights", settings.scene.lightCount},
+                        {"animatedFraction", settings.scene.animatedFraction},
+                        {"seed", settings.scene.seed},
+                        {"generator", BenchmarkScene::GeneratorVersion},
+                        {"parallelRecording", settings.parallelRecording}};
+    result["frames"] = {{"warmup", settings.warmupFrames}, {"measured", settings.measuredFrames}};
+
+    // Instance or cluster counts of the last finished frame, informational only and never compared against the baseline.
+    if (auto gBufferSubrender = Graphics::Get()->GetRenderer()->GetSubrender<GBufferSubrender>()) {
+        const auto& statistics = gBufferSubrender->GetCullingStatistics();
+        result["culling"]      = {{"frustumCulled", statistics.frustumCulled},
+                                  {"occlusionCulled", statistics.occlusionCulled},
+                                  {"firstPhaseDrawn", statistics.firstPhaseDrawn},
+                                  {"secondPhaseDrawn", statistics.secondPhaseDrawn},
+                                  {"backfaceCulled", statistics.backfaceCulled},
+                                  {"trianglesDrawn", statistics.trianglesDrawn}};
+    }
+    if (auto shadowSubrender = Graphics::Get()->GetRenderer()->GetSubrender<ShadowSubrender>()) {
+        const auto& statistics = shadowSubrender->GetStatistics();
+        result["shadows"]      = {{"cascadesRendered", statistics.cascadesRendered},
+                                  {"drawCalls", statistics.drawCalls},
+                                  {"castersDrawn", statistics.castersDrawn}};
+    }
+    if (auto lightSystem = Scenes::Get()->GetScene()->GetSystem<LightSystem>()) {
+        // Light slots and buffer sizes stay constant while the lights only move or change.
+        VkDeviceSize bufferBytes = 0;
+        for (auto storage : {lightSystem->GetStoragePointLights(), lightSystem->GetStorageDirectionalLights(), lightSystem->GetStorageAreaLights()})
+            if (storage) bufferBytes += storage->GetSize();
+        result["lights"] = {{"pointSlots", lightSystem->GetPointLightsCount()},
+                            {"directionalSlots", lightSystem->GetDirectionalLightsCount()},
+                            {"areaSlots", lightSystem->GetAreaLightsCount()},
+                            {"bufferBytes", bufferBytes},
+                            {"uploadedBytes", lightSystem->GetUploadedBytes()}};
+    }
+
+    for (const auto& [name, values] : samples) {
+        result["metrics"][name] = Summarize(values);
+        Log::Out("Benchmark ", name, " median ", result["metrics"][name].value("median", 0.0f), " ms\n");
+    }
+
+    if (!CompareAndWrite(result, settings)) exitCode = EXIT_FAILURE;
+}
+}   // namespace MapleLeafApp
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "App.hpp"
+#include "BenchmarkScene.hpp"
+#include "Profiler.hpp"
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace MapleLeaf;
+
+namespace MapleLeafApp {
+struct BenchmarkSettings
+{
+    BenchmarkSceneSettings scene;
+    uint32_t               warmupFrames   = 60;
+    uint32_t               measuredFrames = 300;
+    std::filesystem::path  output         = "Benchmarks/Results/benchmark.json";
+    // Compared against when set, written instead when updateBaseline is set.
+    std::filesystem::path baseline;
+    bool                  updateBaseline = false;
+    // Relative slowdown of a metric median over the baseline counted as a regression.
+    float threshold = 0.1f;
+    // Segments of the sphere the CPU only mesh optimizer benchmark runs on instead of the scene, which has twice as many rings.
+    uint32_t meshOptimizerSegments = 0;
+    // Runs the CPU only instance BVH benchmark on the scene layout instead of the scene.
+    bool bvh = false;
+    // Depth of the transform chain the CPU only world matrix benchmark runs on instead of the scene.
+    uint32_t transformDepth = 0;
+    // Records the subrenders into secondary command buffers on the thread pool.
+    bool parallelRecording = false;
+    // Repetitions of the measured steps of the CPU only benchmarks.
+    uint32_t runs = 10;
+    // Compares the image to the reference instead of running the scene when both are set.
+    std::filesystem::path image;
+    std::filesystem::path referenceImage;
+    // Lowest peak signal to noise ratio in dB the compared image passes with.
+    float minPsnr = 40.0f;
+};
+
+/**
+ * Optimizes a generated sphere with its triangles in random order and writes the vertex cache statistics and the timings of every
+ * MeshOptimizer step as JSON, compared to a baseline like the scene benchmark. Runs on the CPU only, no engine or device is created.
+ * @param settings The settings, the scene settings other than the seed are ignored.
+ * @return The process exit code.
+ */
+int32_t RunMeshOptimizerBenchmark(const BenchmarkSettings& settings);
+
+/**
+ * Builds the instance BVH of the scene layout serially and on a thread pool, then moves the animated instances for the measured frames,
+ * refitting or rebuilding it like ASScene does. Writes the build and update timings and the tree statistics as JSON, compared to a
+ * baseline like the scene benchmark. Runs on the CPU only, no engine or device is created.
+ * @param settings The settings, the material and light counts are ignored.
+ * @return The process exit code.
+ */
+int32_t RunBVHBenchmark(const BenchmarkSettings& settings);
+
+/**
+ * Builds a chain of transforms, each the child of the one before, and times reading the world matrix of every link with the cached world state,
+ * once after moving the root and once with nothing changed, against composing it from the local states up to the root on every read. Writes
+ * the timings as JSON, compared to a baseline like the scene benchmark. Runs on the CPU only, no engine or device is created.
+ * @param settings The settings, the scene settings are ignored.
+ * @return The process exit code.
+ */
+int32_t RunTransformBenchmark(const BenchmarkSettings& settings);
+
+/**
+ * Compares two 8 bit images, such as headless swapchain dumps of the compact and the full G-buffer layout, and writes the error statistics as
+ * JSON. Runs on the CPU only, no engine or device is created.
+ * @param settings The settings, the scene settings are ignored.
+ * @return The process exit code, non zero if the peak signal to noise ratio is below the minimum or the images could not be read.
+ */
+int32_t RunImageComparison(const BenchmarkSettings& settings);
+
+/**
+ * Renders a generated scene headless for a fixed number of frames, writes the per metric statistics as JSON and compares them to a baseline.
+ */
+class BenchmarkApp : public App
+{
+public:
+    explicit BenchmarkApp(const BenchmarkSettings& settings);
+
+    void Start() override;
+    void Update() override;
+
+    /**
+     * Gets the process exit code, non zero if the benchmark regressed past the threshold or its results could not be written.
+     */
+    int32_t GetExitCode() const { return exitCode; }
+
+private:
+    void CollectFrame(const Profiler::Frame& frame);
+    void Finish();
+
+    BenchmarkSettings settings;
+    BenchmarkScene*   scene = nullptr;
+
+    // Milliseconds of every measured frame, by metric name.
+    std::map<std::string, std::vector<float>> samples;
+
+    bool     measuring      = false;
+    uint64_t nextFrame      = 0;
+    uint32_t collectedCount = 0;
+    int32_t  exitCode       = EXIT_SUCCESS;
+};
+}   // namespace MapleLeafApp
@@ -0,0 +1,202 @@
+#include "BenchmarkScene.hpp"
+#include "Camera.hpp"
+#include "DefaultMaterial.hpp"
+#include "Engine.hpp"
+#include "GPUScene.hpp"
+#include "Light.hpp"
+#include "LightSystem.hpp"
+#include "Mesh.hpp"
+#include "Resources.hpp"
+#include "ShadowRender.hpp"
+#include "ShadowSystem.hpp"
+#include "SkyboxSystem.hpp"
+#include <array>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <random>
+
+namespace MapleLeaf {
+BenchmarkScene::BenchmarkScene(const BenchmarkSceneSettings& settings)
+    : Scene()
+    , settings(settings)
+{
+    AddSystem<ShadowSystem>();
+    AddSystem<LightSystem>();
+    AddSystem<SkyboxSystem>();
+
+    AddDerivedScene<GPUScene>();
+    AddDerivedScene<ASScene>();
+}
+
+void BenchmarkScene::Start()
+{
+    auto start = Time::Now();
+
+    std::mt19937                          random(settings.seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    // The arguments of one call are evaluated in an unspecified order, drawing them one statement at a time keeps the scene the same across
+    // compilers.
+    auto unitVec3 = [&random, &unit]() {
+        auto x = unit(random);
+        auto y = unit(random);
+        auto z = unit(random);
+        return glm::vec3(x, y, z);
+    };
+
+    std::array<std::shared_ptr<Model>, 2> models = {CreateCube(), CreateSphere(24, 16)};
+    for (const auto& model : models) Resources::Get()->Add(model);
+
+    std::vector<std::shared_ptr<Material>> materials;
+    for (uint32_t i = 0; i < std::max(settings.materialCount, 1u); i++) {
+        auto diffuse   = unitVec3();
+        auto metallic  = unit(random);
+        auto roughness = unit(random);
+        materials.emplace_back(std::make_shared<DefaultMaterial>(Color(diffuse.x, diffuse.y, diffuse.z), nullptr, metallic, roughness));
+    }
+    std::uniform_int_distribution<std::size_t> materialIndex(0, materials.size() - 1);
+
+    // Instances are laid out on a square grid on the XZ plane, spaced so neighbours never overlap.
+    constexpr float spacing = 3.0f;
+    auto            side    = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(settings.instanceCount))));
+    auto            extent  = std::max(side * spacing, spacing);
+
+    auto shadows       = GetSystem<ShadowSystem>();
+    auto animatedCount = static_cast<uint32_t>(std::clamp(settings.animatedFraction, 0.0f, 1.0f) * settings.instanceCount);
+
+    for (uint32_t i = 0; i < settings.instanceCount; i++) {
+        glm::vec3 position((i % side - side / 2.0f) * spacing, 0.0f, (i / side - side / 2.0f) * spacing);
+        auto      rotation = glm::angleAxis(unit(random) * glm::two_pi<float>(), glm::vec3(0.0f, 1.0f, 0.0f));
+        auto      scale    = glm::vec3(0.5f + unit(random));
+
+        auto entity = CreateEntity();
+        entity->SetName("Instance" + std::to_string(i));
+
+        auto        transform = entity->AddComponent<Transform>(position, rotation, scale);
+        const auto& model     = models[i % models.size()];
+        SetExtents(model->GetMaxExtents(), model->GetMinExtents(), transform->GetWorldMatrix());
+
+        entity->AddComponent<Mesh>(model, materials[materialIndex(random)], i);
+        if (shadows) entity->AddComponent<ShadowRender>();
+
+        if (i < animatedCount) {
+            animatedTransforms.push_back(transform);
+            animatedOrigins.push_back(position);
+        }
+    }
+
+    // Looks down at the grid from above one edge so every instance is in the view frustum.
+    glm::vec3 eye(0.0f, 0.6f * extent, 0.9f * extent);
+    auto      cameraEntity = CreateEntity();
+    cameraEntity->SetName("Camera");
+    cameraEntity->AddComponent<Transform>(eye, glm::quatLookAt(glm::normalize(-eye), glm::vec3(0.0f, 1.0f, 0.0f)));
+    auto camera = cameraEntity->AddComponent<Camera>();
+    camera->SetName("Camera");
+    camera->SetFarPlane(4.0f * extent);
+    SetCamera(camera);
+
+    // The first light is the directional sun, the others are point lights scattered over the grid.
+    for (uint32_t i = 0; i < settings.lightCount; i++) {
+        auto      type      = i == 0 ? LightType::Directional : LightType::Point;
+        auto      placement = unitVec3();
+        glm::vec3 position((placement.x - 0.5f) * extent, 2.0f + 6.0f * placement.y, (placement.z - 0.5f) * extent);
+
+        auto entity = CreateEntity();
+        entity->SetName("Light" + std::to_string(i));
+        entity->AddComponent<Transform>(position);
+
+        auto light = entity->AddComponent<Light>(type);
+        light->SetName(entity->GetName());
+        auto color = glm::vec3(0.5f) + 0.5f * unitVec3();
+        light->SetColor(Color(color.x, color.y, color.z));
+        light->SetPosition(position);
+        light->SetDirection(glm::normalize(glm::vec3(-0.3f, -1.0f, -0.2f)));
+        light->SetAttenuation(glm::vec3(1.0f, 0.09f, 0.032f));
+    }
+
+    importTime = Time::Now() - start;
+}
+
+void BenchmarkScene::Update()
+{
+    // Animated instances bob on the simulated clock, every run moves them through the same positions.
+    animationTime += Engine::Get()->GetDelta();
+
+    for (std::size_t i = 0; i < animatedTransforms.size(); i++) {
+        auto offset = std::sin(2.0f * animationTime.AsSeconds() + 0.37f * i);
+        animatedTransforms[i]->SetLocalPosition(animatedOrigins[i] + glm::vec3(0.0f, offset, 0.0f));
+    }
+
+    Scene::Update();
+}
+
+std::shared_ptr<Model> BenchmarkScene::CreateModel(const std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices)
+{
+    // Imported models get theirs on the loader threads, the generated ones build them here.
+    auto lods     = MeshSimplifier::BuildLevels(vertices, indices);
+    auto meshlets = MeshletBuilder::BuildLevels(vertices, indices, lods);
+
+    auto model = std::make_shared<Model>(vertices, indices);
+    model->SetLods(std::move(lods));
+    model->SetMeshlets(std::move(meshlets));
+    return model;
+}
+
+std::shared_ptr<Model> BenchmarkScene::CreateCube()
+{
+    std::vector<Vertex3D> vertices;
+    std::vector<uint32_t> indices;
+
+    // Each face has its own four vertices so normals stay flat.
+    const std::array<glm::vec3, 6> normals = {
+        glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)};
+
+    for (const auto& normal : normals) {
+        auto tangent   = std::abs(normal.y) > 0.5f ? glm::vec3(1, 0, 0) : glm::normalize(glm::cross(glm::vec3(0, 1, 0), normal));
+        auto bitangent = glm::cross(normal, tangent);
+        auto base      = static_cast<uint32_t>(vertices.size());
+
+        for (const auto& corner : {glm::vec2(-1, -1), glm::vec2(1, -1), glm::vec2(1, 1), glm::vec2(-1, 1)}) {
+            auto position = 0.5f * (normal + corner.x * tangent + corner.y * bitangent);
+            vertices.emplace_back(position, 0.5f * corner + 0.5f, normal, tangent);
+        }
+
+        indices.insert(indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+    }
+
+    return CreateModel(vertices, indices);
+}
+
+std::shared_ptr<Model> BenchmarkScene::CreateSphere(uint32_t segments, uint32_t rings)
+{
+    std::vector<Vertex3D> vertices;
+    std::vector<uint32_t> indices;
+    GenerateSphere(segments, rings, vertices, indices);
+    return CreateModel(vertices, indices);
+}
+
+void BenchmarkScene::GenerateSphere(uint32_t segments, uint32_t rings, std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices)
+{
+    for (uint32_t ring = 0; ring <= rings; ring++) {
+        auto theta = glm::pi<float>() * ring / rings;
+
+        for (uint32_t segment = 0; segment <= segments; segment++) {
+            auto phi    = glm::two_pi<float>() * segment / segments;
+            auto normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+
+            vertices.emplace_back(0.5f * normal,
+                                  glm::vec2(static_cast<float>(segment) / segments, static_cast<float>(ring) / rings),
+                                  normal,
+                                  glm::vec3(-std::sin(phi), 0.0f, std::cos(phi)));
+        }
+    }
+
+    for (uint32_t ring = 0; ring < rings; ring++) {
+        for (uint32_t segment = 0; segment < segments; segment++) {
+            auto a = ring * (segments + 1) + segment;
+            auto b = a + segments + 1;
+            indices.insert(indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+        }
+    }
+}
+}   // namespace MapleLeaf
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Scene.hpp"
+#include "Transform.hpp"
+#include "Vertex.hpp"
+#include <memory>
+#include <vector>
+
+namespace MapleLeaf {
+class Model;
+
+struct BenchmarkSceneSettings
+{
+    uint32_t instanceCount = 10000;
+    uint32_t materialCount = 64;
+    uint32_t lightCount    = 16;
+    // Fraction of the instances moved every frame.
+    float    animatedFraction = 0.1f;
+    uint32_t seed             = 1;
+};
+
+/**
+ * A procedurally generated scene, instances of a few meshes laid out on a grid with random materials and lights.
+ * The same settings always generate the same scene, animated instances move on the simulated clock.
+ */
+class BenchmarkScene : public Scene
+{
+public:
+    // Bumped when the same settings generate a different scene, baselines of an older generator are not comparable.
+    static constexpr uint32_t GeneratorVersion = 2;
+
+    explicit BenchmarkScene(const BenchmarkSceneSettings& settings);
+
+    void Start() override;
+    void Update() override;
+
+    const BenchmarkSceneSettings& GetSettings() const { return settings; }
+
+    /**
+     * Gets the time taken to generate the scene and upload its models.
+     */
+    const Time& GetImportTime() const { return importTime; }
+
+    /**
+     * Generates the triangles of a UV sphere of diameter 1 without creating a model, so it needs no device.
+     * @param segments The number of segments around the poles.
+     * @param rings The number of rings from pole to pole.
+     * @param vertices Receives the vertices.
+     * @param indices Receives the triangle list, in ring order.
+     */
+    static void GenerateSphere(uint32_t segments, uint32_t rings, std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices);
+
+private:
+    /**
+     * Creates a model with its levels of detail and meshlets, built on the calling thread as part of the import time.
+     * @param vertices The model vertices.
+     * @param indices The triangle list, reordered by the meshlets.
+     * @return The model.
+     */
+    static std::shared_ptr<Model> CreateModel(const std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices);
+    static std::shared_ptr<Model> CreateCube();
+    static std::shared_ptr<Model> CreateSphere(uint32_t segments, uint32_t rings);
+
+    BenchmarkSceneSettings settings;
+    Time                   importTime;
+    Time                   animationTime;
+
+    std::vector<Transform*> animatedTransforms;
+    std::vector<glm::vec3>  animatedOrigins;
+};
+}   // namespace MapleLeaf
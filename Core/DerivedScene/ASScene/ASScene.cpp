@@ -1,8 +1,10 @@
 #include "ASScene.hpp"
 
 #include "BottomLevelAccelerationStruct.hpp"
+#include "GPUScene.hpp"
 #include "Mesh.hpp"
 #include "Model.hpp"
+#include "Profiler.hpp"
 #include "Resources.hpp"
 #include "Scenes.hpp"
 #include "TopLevelAccelerationStruct.hpp"
@@ -10,17 +12,6 @@
 namespace {
 using namespace MapleLeaf;
 
-struct TempNode : ASScene::BVHNode
-{
-    uint32_t visitOrder = InvalidMask;
-    uint32_t parent     = InvalidMask;
-
-    uint32_t left;
-    uint32_t right;
-
-    glm::vec3 aabbCenter;
-};
-
 ASScene::AABB CalculateBounds(glm::mat4 world, glm::vec3 min, glm::vec3 max)
 {
     glm::vec3 minWorld = glm::vec3(FLT_MAX);
@@ -36,80 +27,6 @@ ASScene::AABB CalculateBounds(glm::mat4 world, glm::vec3 min, glm::vec3 max)
 
     return {minWorld, maxWorld};
 }
-
-ASScene::AABB CalculateBounds(const std::vector<TempNode>& nodes, uint32_t start, uint32_t end)
-{
-    ASScene::AABB bounds = {glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest())};
-
-    for (uint32_t i = start; i < end; ++i) {
-        bounds.first  = glm::min(bounds.first, nodes[i].min);
-        bounds.second = glm::max(bounds.second, nodes[i].max);
-    }
-
-    return bounds;
-}
-
-uint32_t Split(std::vector<TempNode>& nodes, uint32_t start, uint32_t end, ASScene::AABB& bounds)
-{
-    glm::vec3            extent      = bounds.second - bounds.first;
-    std::array<float, 3> extentArray = {extent.x, extent.y, extent.z};
-    uint32_t splitAxis = static_cast<uint32_t>(std::distance(extentArray.begin(), std::max_element(extentArray.begin(), extentArray.end())));
-
-    std::sort(nodes.begin() + start, nodes.begin() + end, [splitAxis](const TempNode& a, const TempNode& b) {
-        return a.aabbCenter[splitAxis] < b.aabbCenter[splitAxis];
-    });
-
-    float splitPos = nodes[start + (end - start) / 2].aabbCenter[splitAxis];
-    for (uint32_t i = start + 1; i < end; ++i) {
-        if (nodes[i].aabbCenter[splitAxis] >= splitPos) {
-            return i;
-        }
-    }
-
-    return end - 1;
-}
-
-uint32_t RecursiveBuildBVH(std::vector<TempNode>& nodes, uint32_t start, uint32_t end)
-{
-    uint32_t count = end - start;
-    if (count == 1) return start;
-
-    ASScene::AABB bounds = CalculateBounds(nodes, start, end);
-
-    uint32_t split = Split(nodes, start, end, bounds);
-
-    uint32_t nodeId = nodes.size();
-    nodes.emplace_back(TempNode{});
-
-    nodes[nodeId].left  = RecursiveBuildBVH(nodes, start, split);
-    nodes[nodeId].right = RecursiveBuildBVH(nodes, split, end);
-
-    nodes[nodeId].SetBounds(bounds);
-    nodes[nodeId].aabbCenter = (bounds.first + bounds.second) * 0.5f;
-    nodes[nodeId].instanceID = ASScene::BVHNode::InvalidMask;
-
-    nodes[nodes[nodeId].left].parent  = nodeId;
-    nodes[nodes[nodeId].right].parent = nodeId;
-
-    return nodeId;
-}
-
-void SetDepthFirstVisitOrder(std::vector<TempNode>& nodes, uint32_t nodeID, uint32_t nextID, uint32_t& visitOrder)
-{
-    TempNode& node = nodes[nodeID];
-
-    node.visitOrder = visitOrder++;
-    node.next       = nextID;
-
-    if (node.left != ASScene::BVHNode::InvalidMask) SetDepthFirstVisitOrder(nodes, node.left, node.right, visitOrder);
-    if (node.right != ASScene::BVHNode::InvalidMask) SetDepthFirstVisitOrder(nodes, node.right, nextID, visitOrder);
-}
-
-void SetDepthFirstVisitOrder(std::vector<TempNode>& nodes, uint32_t root)
-{
-    uint32_t visitOrder = 0;
-    SetDepthFirstVisitOrder(nodes, root, ASScene::BVHNode::InvalidMask, visitOrder);
-}
 }   // namespace
 
 namespace MapleLeaf {
@@ -127,7 +44,7 @@ inline VkTransformMatrixKHR ASScene::ToTransformMatrixKHR(glm::mat4 matrix)
 
 void ASScene::Start()
 {
-    // BuildBVH();
+    BuildBVH();
 #ifdef MAPLELEAF_RAY_TRACING
     BuildBLAS();
     BuildTLAS();
@@ -136,7 +53,7 @@ void ASScene::Start()
 
 void ASScene::Update()
 {
-    // BuildBVH();
+    BuildBVH(true);
 #ifdef MAPLELEAF_RAY_TRACING
     // BuildBLAS(VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR, true);
     BuildTLAS(VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR, true);
@@ -145,47 +62,64 @@ void ASScene::Update()
 
 void ASScene::BuildBVH(bool update)
 {
-    bvhNodes.clear();
-    bvhPackedNodes.clear();
+    MAPLELEAF_PROFILE_SCOPE("ASScene::BuildBVH");
 
-    const auto& meshes = Scenes::Get()->GetScene()->GetComponents<Mesh>();
+    auto meshes = Scenes::Get()->GetScene()->GetComponentView<Mesh>();
 
-    std::vector<TempNode> nodes;
-    nodes.reserve(2 * meshes.size() - 1);
-    bvhNodes.reserve(2 * meshes.size() - 1);
+    // Removing a mesh moves the last one into its slot, so an add and a remove in the same frame keep the count but not the primitives.
+    // The hierarchy is only refitted while every primitive is still the mesh it was built from.
+    bool     rebuild   = !update;
+    uint32_t meshCount = 0;
+    for (auto mesh : meshes) {
+        if (meshCount >= bvhInstanceIds.size() || bvhInstanceIds[meshCount] != mesh->GetInstanceId()) rebuild = true;
+        meshCount++;
+    }
+    rebuild = rebuild || meshCount != bvhInstanceIds.size() || meshCount != bvh.GetPrimitiveCount();
 
-    for (uint32_t i = 0; i < meshes.size(); ++i) {
-        TempNode node;
-        node.SetBounds(CalculateBounds(meshes[i]->GetEntity()->GetComponent<Transform>()->GetWorldMatrix(),
-                                       meshes[i]->GetModel()->GetMinExtents(),
-                                       meshes[i]->GetModel()->GetMaxExtents()));
+    bvhBounds.resize(meshCount);
+    bvhInstanceIds.resize(meshCount);
 
-        node.aabbCenter = (node.min + node.max) * 0.5f;
-        node.instanceID = meshes[i]->GetInstanceId();
-        node.left       = BVHNode::InvalidMask;
-        node.right      = BVHNode::InvalidMask;
+    bvhMoved.clear();
+    uint32_t i = 0;
+    for (auto mesh : meshes) {
+        auto transform    = mesh->GetEntity()->GetComponent<Transform>();
+        bvhInstanceIds[i] = mesh->GetInstanceId();
 
-        nodes.emplace_back(node);
+        bool changed = transform->HasChangedSince(bvhGeneration) || mesh->GetUpdateStatus() == Mesh::UpdateStatus::MeshAlter;
+        if (rebuild || changed) {
+            bvhBounds[i] = CalculateBounds(transform->GetWorldMatrix(), mesh->GetModel()->GetMinExtents(), mesh->GetModel()->GetMaxExtents());
+            bvhMoved.push_back(i);
+        }
+        i++;
     }
+    bvhGeneration = Transform::GetCurrentGeneration();
 
-    const uint32_t root = RecursiveBuildBVH(nodes, 0, static_cast<uint32_t>(nodes.size()));
+    if (!rebuild) {
+        if (bvhMoved.empty()) return;
 
-    SetDepthFirstVisitOrder(nodes, root);
+        bvh.Refit(bvhMoved, bvhBounds);
+        rebuild = bvh.NeedsRebuild(bvhRebuildThreshold);
+    }
 
-    bvhNodes.resize(nodes.size());
-    bvhPackedNodes.reserve(bvhNodes.size() * 2);
+    const auto& nodes = bvh.GetNodes();
+    if (!rebuild) {
+        // Only the refitted nodes are uploaded, the topology and so the buffer size are unchanged. They are already sorted and unique.
+        bvhBuffer->Update(nodes.data(), Buffer::CoalesceSortedRanges(bvh.GetRefittedNodes(), sizeof(BVHNode)));
+        return;
+    }
 
-    for (uint32_t i = 0; i < nodes.size(); i++) {
-        const TempNode& oldNode = nodes[i];
+    bvh.Build(bvhBounds, bvhInstanceIds, &Resources::Get()->GetThreadPool());
 
-        BVHNode& newNode   = bvhNodes[oldNode.visitOrder];
-        newNode.min        = oldNode.min;
-        newNode.max        = oldNode.max;
-        newNode.instanceID = oldNode.instanceID;
-        newNode.next       = oldNode.next == BVHNode::InvalidMask ? BVHNode::InvalidMask : nodes[oldNode.next].visitOrder;
+    if (nodes.empty()) {
+        bvhBuffer = nullptr;
+        return;
     }
 
-    bvhBuffer = std::make_unique<StorageBuffer>(bvhNodes.size() * sizeof(BVHNode), bvhNodes.data());
+    VkDeviceSize size = nodes.size() * sizeof(BVHNode);
+    if (bvhBuffer && bvhBuffer->GetSize() == size)
+        bvhBuffer->Update(nodes.data());
+    else
+        bvhBuffer = std::make_unique<StorageBuffer>(size, nodes.data());
 }
 
 void ASScene::BuildBLAS(VkBuildAccelerationStructureFlagsKHR flags, bool update)
@@ -234,14 +168,13 @@ void ASScene::BuildBLAS(VkBuildAccelerationStructureFlagsKHR flags, bool update)
 
 void ASScene::BuildTLAS(VkBuildAccelerationStructureFlagsKHR flags, bool update)
 {
-    const auto& meshes = Scenes::Get()->GetScene()->GetComponents<Mesh>();
+    auto meshes = Scenes::Get()->GetScene()->GetComponentView<Mesh>();
 
     std::vector<VkAccelerationStructureInstanceKHR> instances{};
-    instances.reserve(meshes.size());
+    instances.reserve(meshes.GetPoolSize());
 
-    for (uint32_t i = 0; i < meshes.size(); ++i) {
-        const auto& instance   = meshes[i];
-        uint32_t    modelIndex = Resources::Get()->GetResourceIndex(instance->GetModel());
+    for (auto instance : meshes) {
+        uint32_t modelIndex = Resources::Get()->GetResourceIndex(instance->GetModel());
 
         VkAccelerationStructureInstanceKHR accelerationStructureInstance{};
         accelerationStructureInstance.transform           = ToTransformMatrixKHR(instance->GetEntity()->GetComponent<Transform>()->GetWorldMatrix());
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "AccelerationStruct.hpp"
+#include "BVH.hpp"
 #include "DerivedScene.hpp"
 
 #include "StorageBuffer.hpp"
@@ -19,37 +20,26 @@ public:
     void Update();
 
     // Build soft acceleration structure
-    using AABB = std::pair<glm::vec3, glm::vec3>;
-    struct BVHNode
-    {
-        static const uint32_t InvalidMask = 0xFFFFFFFF;
-
-        glm::vec3 min;
-        uint32_t  instanceID = InvalidMask;   // or proxyID
-        glm::vec3 max;
-        uint32_t  next = InvalidMask;
-
-        BVHNode() = default;
-
-        void SetBounds(const AABB& bounds)
-        {
-            this->min = bounds.first;
-            this->max = bounds.second;
-        }
-
-        bool IsLeaf() const { return instanceID != InvalidMask; }
-    };
-
-
-    struct BVHPackedNode
-    {
-        uint32_t a, b, c, d;
-    };
-
+    using AABB    = BVH::AABB;
+    using BVHNode = BVH::Node;
+
+    /**
+     * Builds the instance hierarchy, or refits it to the instances that moved since the last call when updating.
+     * An update rebuilds instead once instances were added or removed or the refits degraded the SAH cost past the rebuild threshold.
+     * @param update If the existing hierarchy is refitted when possible.
+     */
     void BuildBVH(bool update = false);
 
-    const std::vector<BVHNode>& GetBVHNodes() const { return bvhNodes; }
+    const std::vector<BVHNode>& GetBVHNodes() const { return bvh.GetNodes(); }
     const StorageBuffer*        GetBVHBuffer() const { return bvhBuffer.get(); }
+    BVH::Statistics             GetBVHStatistics() const { return bvh.GetStatistics(); }
+
+    /**
+     * Sets the relative SAH cost increase over the last build that refits may cause before the hierarchy is rebuilt.
+     * @param threshold The threshold.
+     */
+    void  SetBVHRebuildThreshold(float threshold) { bvhRebuildThreshold = threshold; }
+    float GetBVHRebuildThreshold() const { return bvhRebuildThreshold; }
 
     // Vk hardware raytracing acceleration structure, bottom level acceleration structure, top level acceleration structure
     void BuildBLAS(VkBuildAccelerationStructureFlagsKHR flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR, bool update = false);
@@ -68,8 +58,16 @@ private:
     std::vector<std::unique_ptr<AccelerationStruct>> bottomLevelaccelerationStructs;
     std::unique_ptr<AccelerationStruct>              topLevelAccelerationStruct;
 
-    std::vector<BVHNode>           bvhNodes;
+    BVH                            bvh;
     std::unique_ptr<StorageBuffer> bvhBuffer;
-    std::vector<BVHPackedNode>     bvhPackedNodes;
+    // World bounds and instance IDs of every enabled mesh in component order, the primitives of the hierarchy.
+    std::vector<AABB>     bvhBounds;
+    std::vector<uint32_t> bvhInstanceIds;
+    // Primitives that moved since the last call, kept to reuse its capacity.
+    std::vector<uint32_t> bvhMoved;
+    float                 bvhRebuildThreshold = BVH::DefaultRebuildThreshold;
+
+    // Transform generation the bounds were last read at.
+    uint64_t bvhGeneration = 0;
 };
 }   // namespace MapleLeaf
\ No newline at end of file
@@ -0,0 +1,322 @@
+#include "BVH.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+
+namespace MapleLeaf {
+namespace {
+constexpr uint32_t InvalidMask = BVH::Node::InvalidMask;
+
+BVH::AABB EmptyBounds()
+{
+    return {glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest())};
+}
+
+void Grow(BVH::AABB& bounds, const BVH::AABB& other)
+{
+    bounds.first  = glm::min(bounds.first, other.first);
+    bounds.second = glm::max(bounds.second, other.second);
+}
+
+// Half the surface area, the heuristic only compares ratios.
+float HalfArea(const glm::vec3& min, const glm::vec3& max)
+{
+    glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+    return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+class Builder
+{
+public:
+    struct BuildNode
+    {
+        BVH::AABB bounds;
+        uint32_t  left      = InvalidMask;
+        uint32_t  right     = InvalidMask;
+        uint32_t  primitive = InvalidMask;
+    };
+
+    explicit Builder(const std::vector<BVH::AABB>& bounds)
+        : primitives(bounds.size())
+        , buildNodes(2 * bounds.size() - 1)
+    {
+        for (uint32_t i = 0; i < bounds.size(); i++) primitives[i] = {bounds[i], (bounds[i].first + bounds[i].second) * 0.5f, i};
+    }
+
+    /**
+     * Builds the top levels on the calling thread and the subtrees below them as tasks, so no task ever waits on another.
+     * @return The root node.
+     */
+    uint32_t Build(ThreadPool* threadPool)
+    {
+        struct Subtree
+        {
+            uint32_t         parent;
+            bool             right;
+            Future<uint32_t> root;
+        };
+        std::vector<Subtree> subtrees;
+
+        auto root = BuildTop(0, static_cast<uint32_t>(primitives.size()), threadPool, subtrees, InvalidMask, false);
+        for (auto& subtree : subtrees) {
+            auto& parent = buildNodes[subtree.parent];
+            (subtree.right ? parent.right : parent.left) = subtree.root.get();
+        }
+        return root;
+    }
+
+    const std::vector<BuildNode>& GetBuildNodes() const { return buildNodes; }
+
+private:
+    // Primitives are moved by the partitions, so every range stays contiguous in memory.
+    struct Primitive
+    {
+        BVH::AABB bounds;
+        glm::vec3 center;
+        uint32_t  index;
+    };
+
+    template<typename Subtrees>
+    uint32_t BuildTop(uint32_t start, uint32_t end, ThreadPool* threadPool, Subtrees& subtrees, uint32_t parent, bool right)
+    {
+        if (!threadPool || end - start < BVH::ParallelThreshold) {
+            if (parent == InvalidMask) return BuildRecursive(start, end);
+
+            auto root = threadPool->Enqueue(Task::Priority::Critical, [this, start, end]() { return BuildRecursive(start, end); });
+            subtrees.push_back({parent, right, std::move(root)});
+            return InvalidMask;
+        }
+
+        auto node  = nodeCount++;
+        auto split = Split(node, start, end);
+
+        auto& buildNode = buildNodes[node];
+        buildNode.left  = BuildTop(start, split, threadPool, subtrees, node, false);
+        buildNode.right = BuildTop(split, end, threadPool, subtrees, node, true);
+        return node;
+    }
+
+    uint32_t BuildRecursive(uint32_t start, uint32_t end)
+    {
+        auto node = nodeCount++;
+        if (end - start == 1) {
+            buildNodes[node].bounds    = primitives[start].bounds;
+            buildNodes[node].primitive = primitives[start].index;
+            return node;
+        }
+
+        auto split = Split(node, start, end);
+        auto left  = BuildRecursive(start, split);
+        auto right = BuildRecursive(split, end);
+
+        buildNodes[node].left  = left;
+        buildNodes[node].right = right;
+        return node;
+    }
+
+    /**
+     * Sets the bounds of the node and partitions its primitives at the binned split of the lowest surface area heuristic cost.
+     * @return The first primitive of the right child.
+     */
+    uint32_t Split(uint32_t node, uint32_t start, uint32_t end)
+    {
+        auto nodeBounds = EmptyBounds(), centerBounds = EmptyBounds();
+        for (auto i = start; i < end; i++) {
+            Grow(nodeBounds, primitives[i].bounds);
+            Grow(centerBounds, {primitives[i].center, primitives[i].center});
+        }
+        buildNodes[node].bounds = nodeBounds;
+
+        if (end - start == 2) return start + 1;
+
+        struct Bin
+        {
+            BVH::AABB bounds = EmptyBounds();
+            uint32_t  count  = 0;
+        };
+
+        // All three axes are binned in one pass over the primitives, flat axes of the centers end up in the first bin only.
+        std::array<std::array<Bin, BVH::BinCount>, 3> bins;
+        glm::vec3                                     extent = centerBounds.second - centerBounds.first;
+        glm::vec3                                     scale;
+        for (uint32_t axis = 0; axis < 3; axis++) scale[axis] = extent[axis] > 0.0f ? BVH::BinCount / extent[axis] : 0.0f;
+
+        for (auto i = start; i < end; i++) {
+            for (uint32_t axis = 0; axis < 3; axis++) {
+                auto& bin = bins[axis][BinIndex(primitives[i].center[axis], centerBounds.first[axis], scale[axis])];
+                Grow(bin.bounds, primitives[i].bounds);
+                bin.count++;
+            }
+        }
+
+        float    bestCost = std::numeric_limits<float>::max();
+        uint32_t bestAxis = 0, bestBin = 0;
+
+        for (uint32_t axis = 0; axis < 3; axis++) {
+            if (extent[axis] <= 0.0f) continue;
+
+            // Costs of splitting after every bin, the left side sweeps forwards and the right side backwards.
+            std::array<float, BVH::BinCount - 1> leftCosts;
+            auto                                 sweep = EmptyBounds();
+            uint32_t                             count = 0;
+            for (uint32_t i = 0; i + 1 < BVH::BinCount; i++) {
+                Grow(sweep, bins[axis][i].bounds);
+                count += bins[axis][i].count;
+                leftCosts[i] = count > 0 ? HalfArea(sweep.first, sweep.second) * count : std::numeric_limits<float>::max();
+            }
+
+            sweep = EmptyBounds();
+            count = 0;
+            for (uint32_t i = BVH::BinCount - 1; i > 0; i--) {
+                Grow(sweep, bins[axis][i].bounds);
+                count += bins[axis][i].count;
+                if (count == 0 || count == end - start) continue;
+
+                auto cost = leftCosts[i - 1] + HalfArea(sweep.first, sweep.second) * count;
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin  = i;
+                }
+            }
+        }
+
+        // Every center is at the same point, any split is as good as another.
+        if (bestCost == std::numeric_limits<float>::max()) return start + (end - start) / 2;
+
+        auto split = std::partition(primitives.begin() + start, primitives.begin() + end, [&](const Primitive& primitive) {
+            return BinIndex(primitive.center[bestAxis], centerBounds.first[bestAxis], scale[bestAxis]) < bestBin;
+        });
+        return static_cast<uint32_t>(split - primitives.begin());
+    }
+
+    static uint32_t BinIndex(float center, float min, float scale)
+    {
+        return std::min(static_cast<uint32_t>((center - min) * scale), BVH::BinCount - 1);
+    }
+
+    std::vector<Primitive> primitives;
+    std::vector<BuildNode> buildNodes;
+    std::atomic<uint32_t>  nodeCount = 0;
+};
+}   // namespace
+
+void BVH::Build(const std::vector<AABB>& bounds, const std::vector<uint32_t>& ids, ThreadPool* threadPool)
+{
+    nodes.clear();
+    parents.clear();
+    leaves.assign(bounds.size(), InvalidMask);
+    refittedNodes.clear();
+    buildSahCost = 0.0f;
+    if (bounds.empty()) return;
+
+    Builder builder(bounds);
+    auto    root       = builder.Build(threadPool);
+    auto&   buildNodes = builder.GetBuildNodes();
+
+    // Depth first order, the left child of an internal node directly follows it.
+    std::vector<uint32_t> order(buildNodes.size()), visits;
+    std::vector<uint32_t> stack = {root};
+    visits.reserve(buildNodes.size());
+    while (!stack.empty()) {
+        auto buildNode = stack.back();
+        stack.pop_back();
+
+        order[buildNode] = static_cast<uint32_t>(visits.size());
+        visits.push_back(buildNode);
+        if (buildNodes[buildNode].left == InvalidMask) continue;
+
+        stack.push_back(buildNodes[buildNode].right);
+        stack.push_back(buildNodes[buildNode].left);
+    }
+
+    nodes.resize(buildNodes.size());
+    parents.assign(buildNodes.size(), InvalidMask);
+    for (auto buildNode : visits) {
+        const auto& source = buildNodes[buildNode];
+        auto&       node   = nodes[order[buildNode]];
+        node.SetBounds(source.bounds);
+
+        if (source.left == InvalidMask) {
+            node.instanceID          = ids[source.primitive];
+            leaves[source.primitive] = order[buildNode];
+            continue;
+        }
+
+        // The miss link of the left child skips to its sibling, the right child inherits the one of its parent.
+        auto left = order[source.left], right = order[source.right];
+        nodes[left].next  = right;
+        nodes[right].next = node.next;
+        parents[left] = parents[right] = order[buildNode];
+    }
+
+    buildSahCost = GetSahCost();
+}
+
+void BVH::Refit(const std::vector<uint32_t>& primitives, const std::vector<AABB>& bounds)
+{
+    refittedNodes.clear();
+    if (nodes.empty()) return;
+
+    std::vector<uint8_t> marks(nodes.size(), 0);
+    for (auto primitive : primitives) {
+        auto leaf = leaves[primitive];
+        nodes[leaf].SetBounds(bounds[primitive]);
+        if (!marks[leaf]) refittedNodes.push_back(leaf);
+        marks[leaf] = 1;
+
+        // Stops at the first ancestor another moved primitive already marked.
+        for (auto node = parents[leaf]; node != InvalidMask && !marks[node]; node = parents[node]) {
+            marks[node] = 1;
+            refittedNodes.push_back(node);
+        }
+    }
+
+    // Children come after their parent, so a backwards pass sees both children of a node refitted before the node itself.
+    std::sort(refittedNodes.begin(), refittedNodes.end());
+    for (auto it = refittedNodes.rbegin(); it != refittedNodes.rend(); ++it) {
+        auto& node = nodes[*it];
+        if (node.IsLeaf()) continue;
+
+        const auto& left  = nodes[*it + 1];
+        const auto& right = nodes[left.next];
+        node.min          = glm::min(left.min, right.min);
+        node.max          = glm::max(left.max, right.max);
+    }
+}
+
+float BVH::GetSahCost() const
+{
+    if (nodes.empty()) return 0.0f;
+
+    float rootArea = HalfArea(nodes[0].min, nodes[0].max);
+    if (rootArea <= 0.0f) return static_cast<float>(nodes.size());
+
+    double area = 0.0;
+    for (const auto& node : nodes) area += HalfArea(node.min, node.max);
+    return static_cast<float>(area / rootArea);
+}
+
+BVH::Statistics BVH::GetStatistics() const
+{
+    Statistics statistics;
+    statistics.sahCost      = GetSahCost();
+    statistics.buildSahCost = buildSahCost;
+    statistics.nodeCount    = static_cast<uint32_t>(nodes.size());
+    if (nodes.empty()) return statistics;
+
+    // Parents come before their children, so one forward pass has every depth.
+    std::vector<uint32_t> depths(nodes.size(), 0);
+    uint64_t              leafDepthSum = 0;
+    for (uint32_t i = 1; i < nodes.size(); i++) {
+        depths[i]           = depths[parents[i]] + 1;
+        statistics.maxDepth = std::max(statistics.maxDepth, depths[i]);
+        if (nodes[i].IsLeaf()) leafDepthSum += depths[i];
+    }
+    statistics.averageLeafDepth = static_cast<float>(leafDepthSum) / leaves.size();
+    return statistics;
+}
+}   // namespace MapleLeaf
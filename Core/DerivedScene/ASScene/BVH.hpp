@@ -0,0 +1,96 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace MapleLeaf {
+class ThreadPool;
+
+/**
+ * A bounding volume hierarchy with one primitive per leaf, built by the binned surface area heuristic and refitted as primitives move.
+ * Nodes are stored depth first with a miss link, so it is traversed without a stack: a hit internal node continues with the node after it,
+ * a leaf or a missed node with its next node. Runs on the CPU only.
+ */
+class BVH
+{
+public:
+    using AABB = std::pair<glm::vec3, glm::vec3>;
+
+    struct Node
+    {
+        static const uint32_t InvalidMask = 0xFFFFFFFF;
+
+        glm::vec3 min;
+        uint32_t  instanceID = InvalidMask;   // or proxyID
+        glm::vec3 max;
+        uint32_t  next = InvalidMask;
+
+        Node() = default;
+
+        void SetBounds(const AABB& bounds)
+        {
+            this->min = bounds.first;
+            this->max = bounds.second;
+        }
+
+        bool IsLeaf() const { return instanceID != InvalidMask; }
+    };
+
+    struct Statistics
+    {
+        // Expected cost of a ray through the root, traversing a node and intersecting a leaf both cost 1.
+        float    sahCost = 0.0f;
+        // The cost right after the last build, the refits since degrade it.
+        float    buildSahCost     = 0.0f;
+        uint32_t nodeCount        = 0;
+        uint32_t maxDepth         = 0;
+        float    averageLeafDepth = 0.0f;
+    };
+
+    static constexpr uint32_t BinCount = 16;
+    // Rebuilds once traversal is expected to be a quarter slower than right after the build.
+    static constexpr float DefaultRebuildThreshold = 0.25f;
+    // Ranges with fewer primitives are built as one task.
+    static constexpr uint32_t ParallelThreshold = 2048;
+
+    /**
+     * Builds the hierarchy from scratch.
+     * @param bounds The bounds of every primitive.
+     * @param ids The id every leaf stores for its primitive, in the same order.
+     * @param threadPool If not null, the subtrees of large ranges are built on it as frame critical tasks.
+     */
+    void Build(const std::vector<AABB>& bounds, const std::vector<uint32_t>& ids, ThreadPool* threadPool = nullptr);
+
+    /**
+     * Updates the bounds of moved primitives and of their ancestors, keeping the topology.
+     * @param primitives The indices of the moved primitives in the bounds the hierarchy was built from.
+     * @param bounds The current bounds of every primitive.
+     */
+    void Refit(const std::vector<uint32_t>& primitives, const std::vector<AABB>& bounds);
+
+    /**
+     * Checks if refits degraded the tree enough that a build would pay off.
+     * @param threshold The relative SAH cost increase over the last build that is tolerated.
+     * @return If the tree should be rebuilt.
+     */
+    bool NeedsRebuild(float threshold) const { return GetSahCost() > buildSahCost * (1.0f + threshold); }
+
+    float      GetSahCost() const;
+    Statistics GetStatistics() const;
+
+    const std::vector<Node>& GetNodes() const { return nodes; }
+    // Nodes whose bounds changed in the last refit, in ascending order.
+    const std::vector<uint32_t>& GetRefittedNodes() const { return refittedNodes; }
+    std::size_t                  GetPrimitiveCount() const { return leaves.size(); }
+
+private:
+    std::vector<Node>     nodes;
+    std::vector<uint32_t> parents;
+    // The leaf node of every primitive.
+    std::vector<uint32_t> leaves;
+    std::vector<uint32_t> refittedNodes;
+    float                 buildSahCost = 0.0f;
+};
+}   // namespace MapleLeaf
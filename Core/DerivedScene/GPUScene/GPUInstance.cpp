@@ -3,31 +3,32 @@
 #include "AnimationController.hpp"
 #include "Entity.hpp"
 #include "Light.hpp"
+#include "Log.hpp"
+#include "ShadowRender.hpp"
 #include "Transform.hpp"
 
 namespace MapleLeaf {
-std::unordered_map<std::shared_ptr<Model>, std::pair<uint32_t, uint32_t>> GPUInstance::modelOffset{};
-std::vector<Vertex3D>                                                     GPUInstance::verticesArray{};
-std::vector<uint32_t>                                                     GPUInstance::indicesArray{};
+std::unordered_map<std::shared_ptr<Model>, GPUInstance::ModelOffset> GPUInstance::modelOffset{};
+std::vector<Vertex3D>                                                GPUInstance::verticesArray{};
+std::vector<VertexCompact>                                           GPUInstance::compactVerticesArray{};
+std::vector<uint32_t>                                                GPUInstance::indicesArray{};
+std::vector<Meshlet>                                                 GPUInstance::meshletsArray{};
+std::vector<GPUInstance::LodData>                                    GPUInstance::lodsArray{};
+uint32_t                                                             GPUInstance::maxModelVertexCount = 0;
 
 GPUInstance::GPUInstance(Mesh* mesh, uint32_t instanceID, uint32_t materialID)
     : mesh(mesh)
     , instanceStatus(Status::ModelChanged)
 {
-    model = mesh->GetModel();
-
     instanceData.instanceID = instanceID;
     instanceData.materialID = materialID;
 
     instanceData.modelMatrix     = mesh->GetEntity()->GetComponent<Transform>()->GetWorldMatrix();
     instanceData.prevModelMatrix = instanceData.modelMatrix;   // maybe not correct, but the first frame is not important
-    instanceData.AABBLocalMin    = model->GetMinExtents();
-    instanceData.AABBLocalMax    = model->GetMaxExtents();
-    instanceData.indexCount      = model->GetIndexCount();
-    instanceData.vertexCount     = model->GetVertexCount();
-    instanceData.isThin          = model->IsThin();
+    transformGeneration          = Transform::GetCurrentGeneration();
     instanceData.isUpdate        = 0;
     instanceData.isAreaLight     = 0;
+    instanceData.castShadow      = mesh->GetEntity()->GetComponent<ShadowRender>() != nullptr;
 
     Entity* entity = mesh->GetEntity();
     while (entity != nullptr) {
@@ -37,47 +38,109 @@ GPUInstance::GPUInstance(Mesh* mesh, uint32_t instanceID, uint32_t materialID)
 
     if (const auto light = mesh->GetEntity()->GetComponent<Light>(); light != nullptr && light->type == LightType::Area) instanceData.isAreaLight = 1;
 
-    if (!modelOffset.count(model)) {
-        instanceData.indexOffset  = indicesArray.size();
-        instanceData.vertexOffset = verticesArray.size();
-
-        std::copy(model->GetIndices().begin(), model->GetIndices().end(), std::back_inserter(indicesArray));
-        std::copy(model->GetVertices().begin(), model->GetVertices().end(), std::back_inserter(verticesArray));
-        modelOffset.emplace(model, std::make_pair(instanceData.indexOffset, instanceData.vertexOffset));
-    }
-    else {
-        instanceData.indexOffset  = modelOffset[model].first;
-        instanceData.vertexOffset = modelOffset[model].second;
-    }
+    SetModel(mesh->GetModel());
 }
 
 void GPUInstance::Update()
 {
     instanceStatus = Status::None;
 
-    if (mesh->GetEntity()->GetComponent<Transform>()->GetUpdateStatus() == Transform::UpdateStatus::Transformation) {
+    // Any change to the transform or one of its ancestors since the last update, including moves through the setters.
+    const auto transform = mesh->GetEntity()->GetComponent<Transform>();
+    if (transform->HasChangedSince(transformGeneration)) {
         instanceStatus               = Status::MatrixChanged;
-        instanceData.modelMatrix     = mesh->GetEntity()->GetComponent<Transform>()->GetWorldMatrix();
-        instanceData.prevModelMatrix = mesh->GetEntity()->GetComponent<Transform>()->GetPrevWorldMatrix();
+        instanceData.modelMatrix     = transform->GetWorldMatrix();
+        instanceData.prevModelMatrix = transform->GetPrevWorldMatrix();
+    }
+    transformGeneration = Transform::GetCurrentGeneration();
+
+    // A ShadowRender can be added or removed after the instance was created, the instance data is uploaded again like a moved one.
+    uint32_t castShadow = mesh->GetEntity()->GetComponent<ShadowRender>() != nullptr;
+    castShadowChanged   = castShadow != instanceData.castShadow;
+    if (castShadowChanged) {
+        instanceData.castShadow = castShadow;
+        if (instanceStatus == Status::None) instanceStatus = Status::MatrixChanged;
     }
 
     if (mesh->GetUpdateStatus() == Mesh::UpdateStatus::MeshAlter) {
-        // Need to be optimal
-        if (mesh->GetModel() != model) {
-            model                     = mesh->GetModel();
-            instanceData.indexOffset  = indicesArray.size();
-            instanceData.vertexOffset = verticesArray.size();
-
-            std::copy(model->GetIndices().begin(), model->GetIndices().end(), indicesArray.end());
-            std::copy(model->GetVertices().begin(), model->GetVertices().end(), verticesArray.end());
-            modelOffset.emplace(model, std::make_pair(instanceData.indexOffset, instanceData.vertexOffset));
-        }
+        if (mesh->GetModel() != model) SetModel(mesh->GetModel());
         instanceStatus = Status::ModelChanged;
 
         // MaterialId Update if material add? or delete
     }
 }
 
+void GPUInstance::SetModel(const std::shared_ptr<Model>& model)
+{
+    this->model = model;
+
+    // New models are appended to the shared arrays, GPUScene then only uploads the appended tail.
+    auto it = modelOffset.find(model);
+    if (it == modelOffset.end()) {
+        ModelOffset offset = {static_cast<uint32_t>(indicesArray.size()),
+                              static_cast<uint32_t>(vertexLayout == VertexLayout::Compact ? compactVerticesArray.size() : verticesArray.size()),
+                              static_cast<uint32_t>(meshletsArray.size()),
+                              0,
+                              static_cast<uint32_t>(lodsArray.size()),
+                              0};
+
+        // The coarser levels were simplified when the model was imported and index the same vertices, level 0 is the model itself.
+        std::vector<MeshSimplifier::Level> levels = {{model->GetIndices(), 0.0f}};
+        levels.insert(levels.end(), model->GetLods().begin(), model->GetLods().end());
+
+        // The meshlets were clustered when the model was created, level by level, and only need their index offsets moved.
+        const auto& meshlets = model->GetMeshlets();
+        auto        meshlet  = meshlets.begin();
+        if (meshlets.empty()) Log::Warning("Model without meshlets added to the GPU scene, it is skipped by meshlet culling\n");
+
+        for (uint32_t level = 0; level < levels.size(); level++) {
+            const auto& indices = levels[level].indices;
+            LodData     lod     = {static_cast<uint32_t>(indicesArray.size()),
+                                   static_cast<uint32_t>(indices.size()),
+                                   static_cast<uint32_t>(meshletsArray.size()),
+                                   0,
+                                   levels[level].error,
+                                   {}};
+
+            for (; meshlet != meshlets.end() && meshlet->lod == level; ++meshlet) {
+                meshletsArray.push_back(*meshlet);
+                meshletsArray.back().indexOffset += lod.indexOffset;
+            }
+            lod.meshletCount = static_cast<uint32_t>(meshletsArray.size()) - lod.meshletOffset;
+
+            indicesArray.insert(indicesArray.end(), indices.begin(), indices.end());
+            lodsArray.push_back(lod);
+        }
+
+        offset.meshletCount = static_cast<uint32_t>(meshletsArray.size()) - offset.meshletOffset;
+        offset.lodCount     = static_cast<uint32_t>(levels.size());
+
+        if (vertexLayout == VertexLayout::Compact) {
+            compactVerticesArray.reserve(compactVerticesArray.size() + model->GetVertexCount());
+            for (const auto& vertex : model->GetVertices())
+                compactVerticesArray.push_back(VertexCompact::Encode(vertex, model->GetMinExtents(), model->GetMaxExtents()));
+        }
+        else {
+            verticesArray.insert(verticesArray.end(), model->GetVertices().begin(), model->GetVertices().end());
+        }
+        maxModelVertexCount = std::max(maxModelVertexCount, model->GetVertexCount());
+
+        it = modelOffset.emplace(model, offset).first;
+    }
+
+    instanceData.indexOffset   = it->second.indexOffset;
+    instanceData.vertexOffset  = it->second.vertexOffset;
+    instanceData.meshletOffset = it->second.meshletOffset;
+    instanceData.meshletCount  = it->second.meshletCount;
+    instanceData.lodOffset     = it->second.lodOffset;
+    instanceData.lodCount      = it->second.lodCount;
+    instanceData.AABBLocalMin  = model->GetMinExtents();
+    instanceData.AABBLocalMax  = model->GetMaxExtents();
+    instanceData.indexCount    = model->GetIndexCount();
+    instanceData.vertexCount   = model->GetVertexCount();
+    instanceData.isThin        = model->IsThin();
+}
+
 bool GPUInstance::HasFlag(const std::string& flagName) const
 {
     if (const auto& entity = mesh->GetEntity()) {
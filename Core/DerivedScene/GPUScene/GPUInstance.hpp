@@ -1,6 +1,10 @@
 #pragma once
 
 #include "Mesh.hpp"
+#include "Meshlet.hpp"
+#include "VertexCompact.hpp"
+
+#include "config.h"
 
 namespace MapleLeaf {
 class GPUInstance
@@ -30,9 +34,43 @@ public:
         uint32_t  isAreaLight;
         uint32_t  isThin;
         uint32_t  isUpdate;
-        uint32_t  padding1;
+        uint32_t  meshletOffset;
+        uint32_t  meshletCount;
+        uint32_t  lodOffset;
+        uint32_t  lodCount;
+        // Set for meshes of entities with a ShadowRender, only those are drawn into the shadow cascades.
+        uint32_t  castShadow;
+    };
+
+    // One level of detail of a model, mirrors LodData in Misc/Parameters.glsl. Level 0 is the model itself.
+    struct LodData
+    {
+        uint32_t indexOffset;
+        uint32_t indexCount;
+        uint32_t meshletOffset;
+        uint32_t meshletCount;
+        // The largest estimated distance to the full detail surface, in model space.
+        float    error;
+        uint32_t padding[3];
+    };
+
+    // Where the geometry of a model starts in the shared arrays.
+    struct ModelOffset
+    {
+        uint32_t indexOffset;
+        uint32_t vertexOffset;
+        uint32_t meshletOffset;
+        uint32_t meshletCount;
+        uint32_t lodOffset;
+        uint32_t lodCount;
     };
 
+#ifdef MAPLELEAF_COMPACT_VERTICES
+    static constexpr VertexLayout vertexLayout = VertexLayout::Compact;
+#else
+    static constexpr VertexLayout vertexLayout = VertexLayout::Full;
+#endif
+
     GPUInstance() = default;
 
     explicit GPUInstance(Mesh* mesh, uint32_t instanceID, uint32_t materialID);
@@ -43,6 +81,8 @@ public:
     Status       GetInstanceStatus() const { return instanceStatus; }
     InstanceData GetInstanceData() const { return instanceData; }
     Mesh*        GetMesh() const { return mesh; }
+    // If the instance started or stopped casting shadows in the last Update, the cascades it overlaps have to be drawn again.
+    bool IsCastShadowChanged() const { return castShadowChanged; }
 
     VkDrawIndexedIndirectCommand GetDrawIndexedIndirectCommand() const
     {
@@ -56,12 +96,23 @@ private:
     Mesh*                  mesh;   // relevant mesh
     std::shared_ptr<Model> model;
     Status                 instanceStatus;
+    bool                   castShadowChanged = false;
+
+    // Transform generation the model matrix was last read at.
+    uint64_t transformGeneration = 0;
 
     InstanceData instanceData;
 
-    // offset first is indexOffset, offset second is vertexOffset
-    static std::unordered_map<std::shared_ptr<Model>, std::pair<uint32_t, uint32_t>> modelOffset;
-    static std::vector<Vertex3D>                                                     verticesArray;
-    static std::vector<uint32_t>                                                     indicesArray;
+    void SetModel(const std::shared_ptr<Model>& model);
+
+    static std::unordered_map<std::shared_ptr<Model>, ModelOffset> modelOffset;
+    // Only the array of the vertex layout in use is filled.
+    static std::vector<Vertex3D>                                   verticesArray;
+    static std::vector<VertexCompact>                              compactVerticesArray;
+    static std::vector<uint32_t>                                   indicesArray;
+    // The indices of every level of a model are stored meshlet by meshlet, meshlet index offsets point into indicesArray.
+    static std::vector<Meshlet> meshletsArray;
+    static std::vector<LodData> lodsArray;
+    static uint32_t             maxModelVertexCount;
 };
 }   // namespace MapleLeaf
\ No newline at end of file
@@ -58,4 +58,20 @@ GPUMaterial::GPUMaterial(const std::shared_ptr<Material>& material)
     materialArray.push_back(material);
 }
 
+bool GPUMaterial::Update()
+{
+    if (const DefaultMaterial* defaultMaterial = dynamic_cast<const DefaultMaterial*>(material.get())) {
+        if (defaultMaterial->GetBaseDiffuse() == materialData.baseColor && defaultMaterial->GetRoughness() == materialData.roughness &&
+            defaultMaterial->GetMetallic() == materialData.metalic)
+            return false;
+
+        materialData.baseColor = defaultMaterial->GetBaseDiffuse();
+        materialData.roughness = defaultMaterial->GetRoughness();
+        materialData.metalic   = defaultMaterial->GetMetallic();
+        return true;
+    }
+
+    return false;
+}
+
 }   // namespace MapleLeaf
\ No newline at end of file
@@ -24,6 +24,12 @@ public:
     GPUMaterial() = default;
     explicit GPUMaterial(const std::shared_ptr<Material>& material);
 
+    /**
+     * Reads back the material parameters, textures are resolved once when the GPUMaterial is created.
+     * @return If the material data changed.
+     */
+    bool Update();
+
     MaterialData GetMaterialData() const { return materialData; }
 
     static std::optional<uint32_t>               GetMaterialID(const std::shared_ptr<Material>& material);
@@ -1,8 +1,12 @@
 #include "GPUScene.hpp"
+#include "Graphics.hpp"
+#include "Profiler.hpp"
 #include "Scenes.hpp"
 #include "StorageBuffer.hpp"
 
 #include "config.h"
+#include <algorithm>
+#include <limits>
 
 namespace MapleLeaf {
 GPUScene::GPUScene() {}
@@ -13,21 +17,26 @@ GPUScene::~GPUScene()
     GPUMaterial::images.clear();
     GPUInstance::indicesArray.clear();
     GPUInstance::verticesArray.clear();
+    GPUInstance::compactVerticesArray.clear();
+    GPUInstance::maxModelVertexCount = 0;
     GPUInstance::modelOffset.clear();
+    GPUInstance::meshletsArray.clear();
+    GPUInstance::lodsArray.clear();
 }
 
 void GPUScene::Start()
 {
-    const auto& meshes = Scenes::Get()->GetScene()->GetComponents<Mesh>();
+    auto meshes = Scenes::Get()->GetScene()->GetComponentView<Mesh>();
 
-    for (const auto& mesh : meshes) {
+    for (auto mesh : meshes) {
         const auto& material = mesh->GetMaterial();
         if (GPUMaterial::GetMaterialID(material)) continue;
 
         materials.push_back(GPUMaterial(material));
     }
 
-    for (const auto& mesh : meshes) {
+    instances.reserve(meshes.GetPoolSize());
+    for (auto mesh : meshes) {
         const auto& material = mesh->GetMaterial();
         instances.push_back(GPUInstance(mesh, mesh->GetInstanceId(), GPUMaterial::GetMaterialID(material).value()));
     }
@@ -42,8 +51,10 @@ void GPUScene::Start()
         materialsDatas.push_back(material.GetMaterialData());
     }
 
-    SetIndices(GPUInstance::indicesArray);
-    SetVertices(GPUInstance::verticesArray);
+    uploadedBytes = 0;
+    UploadGeometry();
+    UpdateLods();
+    UpdateClusters();
 
     instancesBuffer = std::make_unique<StorageBuffer>(sizeof(GPUInstance::InstanceData) * instancesDatas.size(), instancesDatas.data());
     materialsBuffer = std::make_unique<StorageBuffer>(sizeof(GPUMaterial::MaterialData) * materialsDatas.size(), materialsDatas.data());
@@ -52,53 +63,79 @@ void GPUScene::Start()
     drawAllMeshIndirectBuffer =
         std::make_unique<IndirectBuffer>(drawAllMeshCommands.size() * sizeof(VkDrawIndexedIndirectCommand), drawAllMeshCommands.data(), true);
 
+    uploadedBytes += instancesBuffer->GetSize() + materialsBuffer->GetSize() + drawAllMeshIndirectBuffer->GetSize();
     updateStatus = UpdateStatus::AllChanged;
 }
 
 // Now only instance alter, e.g. instance update but not add or remove
-// TODO UpdateMaterial and instance Add or Delete
+// TODO instance Add or Delete
 void GPUScene::Update()
 {
+    MAPLELEAF_PROFILE_SCOPE("GPUScene::Update");
+
 #ifdef MAPLELEAF_GPUSCENE_DEBUG
     auto debugStart = Time::Now();
 #endif
-    GPUInstance::Status InstanceUpdateStatus = GPUInstance::Status::None;
+    uploadedBytes = 0;
 
+    bool modelChanged = false;
     for (uint32_t i = 0; i < instances.size(); i++) {
         GPUInstance& instance = instances[i];
         instance.Update();
 
-        const auto& status   = instance.GetInstanceStatus();
-        InstanceUpdateStatus = std::max(InstanceUpdateStatus, status);
-
-        switch (status) {
-        case GPUInstance::Status::ModelChanged: drawAllMeshCommands[i] = instance.GetDrawIndexedIndirectCommand();
-        case GPUInstance::Status::MatrixChanged: instancesDatas[i] = instance.GetInstanceData(); break;
+        switch (instance.GetInstanceStatus()) {
+        case GPUInstance::Status::ModelChanged:
+            drawAllMeshCommands[i] = instance.GetDrawIndexedIndirectCommand();
+            dirtyCommands.push_back(i);
+            modelChanged = true;
+            [[fallthrough]];
+        case GPUInstance::Status::MatrixChanged:
+            instancesDatas[i] = instance.GetInstanceData();
+            dirtyInstances.push_back(i);
+            break;
         case GPUInstance::Status::None: break;
         default: break;
         }
     }
 
-    switch (InstanceUpdateStatus) {
-    case GPUInstance::Status::ModelChanged:
-        SetIndices(GPUInstance::indicesArray);
-        SetVertices(GPUInstance::verticesArray);
-        instancesBuffer->Update(instancesDatas.data(), sizeof(GPUInstance::InstanceData) * instancesDatas.size());
-        materialsBuffer->Update(materialsDatas.data(), sizeof(GPUMaterial::MaterialData) * materialsDatas.size());
-        drawCullingIndirectBuffer->Update(drawAllMeshCommands.data(), drawAllMeshCommands.size() * sizeof(VkDrawIndexedIndirectCommand));
-        drawAllMeshIndirectBuffer->Update(drawAllMeshCommands.data(), drawAllMeshCommands.size() * sizeof(VkDrawIndexedIndirectCommand));
+    for (uint32_t i = 0; i < materials.size(); i++) {
+        if (!materials[i].Update()) continue;
+
+        materialsDatas[i] = materials[i].GetMaterialData();
+        dirtyMaterials.push_back(i);
+    }
+
+    if (modelChanged) {
+        UploadGeometry();
+        UpdateLods();
+        UpdateClusters();
         updateStatus = UpdateStatus::AllChanged;
-        break;
-    case GPUInstance::Status::MatrixChanged:
-        instancesBuffer->Update(instancesDatas.data(), sizeof(GPUInstance::InstanceData) * instancesDatas.size());
-        materialsBuffer->Update(materialsDatas.data(), sizeof(GPUMaterial::MaterialData) * materialsDatas.size());
+    }
+    else if (!dirtyInstances.empty() || !dirtyMaterials.empty()) {
         updateStatus = UpdateStatus::InstanceChanged;
-        break;
-    case GPUInstance::Status::None: updateStatus = UpdateStatus::NoneChanged; break;
-    default: break;
+    }
+    else {
+        updateStatus = UpdateStatus::NoneChanged;
+    }
+
+    auto upload = [this](auto& buffer, const void* data, std::vector<uint32_t>& indices, VkDeviceSize stride) {
+        if (indices.empty()) return;
+
+        auto regions = Buffer::CoalesceRanges(indices, stride);
+        buffer.Update(data, regions);
+        for (const auto& region : regions) uploadedBytes += region.size;
+    };
+
+    upload(*instancesBuffer, instancesDatas.data(), dirtyInstances, sizeof(GPUInstance::InstanceData));
+    upload(*materialsBuffer, materialsDatas.data(), dirtyMaterials, sizeof(GPUMaterial::MaterialData));
+    if (!dirtyCommands.empty()) {
+        // The culling pass rewrites its own buffer every frame, both get the new commands so the first culled frame starts valid.
+        auto commands = dirtyCommands;
+        upload(*drawCullingIndirectBuffer, drawAllMeshCommands.data(), commands, sizeof(VkDrawIndexedIndirectCommand));
+        upload(*drawAllMeshIndirectBuffer, drawAllMeshCommands.data(), dirtyCommands, sizeof(VkDrawIndexedIndirectCommand));
     }
 #ifdef MAPLELEAF_GPUSCENE_DEBUG
-    Log::Out("Update GPU Scene: ", (Time::Now() - debugStart).AsMilliseconds<float>(), "ms\n");
+    Log::Out("Update GPU Scene: ", (Time::Now() - debugStart).AsMilliseconds<float>(), "ms, uploaded ", uploadedBytes, " bytes\n");
     debugStart = Time::Now();
 #endif
 }
@@ -127,14 +164,14 @@ bool GPUScene::CmdRender(const CommandBuffer& commandBuffer, bool DrawCulling)
         VkBuffer     vertexBuffers[1] = {vertexBuffer->GetBuffer()};
         VkDeviceSize offsets[1]       = {0};
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-        vkCmdBindIndexBuffer(commandBuffer, indexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer->GetBuffer(), 0, indexType);
         vkCmdDrawIndexedIndirect(commandBuffer, drawCullingIndirectBuffer->GetBuffer(), 0, drawCount, sizeof(VkDrawIndexedIndirectCommand));
     }
     else if (vertexBuffer && indexBuffer && !DrawCulling) {
         VkBuffer     vertexBuffers[1] = {vertexBuffer->GetBuffer()};
         VkDeviceSize offsets[1]       = {0};
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-        vkCmdBindIndexBuffer(commandBuffer, indexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer->GetBuffer(), 0, indexType);
         vkCmdDrawIndexedIndirect(commandBuffer, drawAllMeshIndirectBuffer->GetBuffer(), 0, drawCount, sizeof(VkDrawIndexedIndirectCommand));
     }
     else {
@@ -144,51 +181,138 @@ bool GPUScene::CmdRender(const CommandBuffer& commandBuffer, bool DrawCulling)
     return true;
 }
 
-void GPUScene::SetVertices(const std::vector<Vertex3D>& vertices)
+bool GPUScene::CmdRenderClusters(const CommandBuffer& commandBuffer)
 {
-    vertexBuffer = nullptr;
+    if (!vertexBuffer || !indexBuffer || !drawClusterIndirectBuffer) return false;
 
-    if (vertices.empty()) return;
+    VkBuffer     vertexBuffers[1] = {vertexBuffer->GetBuffer()};
+    VkDeviceSize offsets[1]       = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, indexBuffer->GetBuffer(), 0, indexType);
+    vkCmdDrawIndexedIndirect(commandBuffer, drawClusterIndirectBuffer->GetBuffer(), 0, GetClusterCount(), sizeof(VkDrawIndexedIndirectCommand));
 
-    Buffer vertexStaging(sizeof(Vertex3D) * vertices.size(),
-                         VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                         vertices.data());
-    vertexBuffer = std::make_unique<Buffer>(
-        vertexStaging.GetSize(),
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    return true;
+}
 
-    CommandBuffer commandBuffer;
+bool GPUScene::CmdRenderIndirectCount(const CommandBuffer& commandBuffer, const IndirectBuffer& commands, VkDeviceSize offset,
+                                      const IndirectBuffer& counts, VkDeviceSize countOffset, uint32_t maxDrawCount) const
+{
+    if (!vertexBuffer || !indexBuffer || maxDrawCount == 0) return false;
 
-    VkBufferCopy copyRegion = {};
-    copyRegion.size         = vertexStaging.GetSize();
-    vkCmdCopyBuffer(commandBuffer, vertexStaging.GetBuffer(), vertexBuffer->GetBuffer(), 1, &copyRegion);
+    VkBuffer     vertexBuffers[1] = {vertexBuffer->GetBuffer()};
+    VkDeviceSize offsets[1]       = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, indexBuffer->GetBuffer(), 0, indexType);
+    vkCmdDrawIndexedIndirectCountKHR(
+        commandBuffer, commands.GetBuffer(), offset, counts.GetBuffer(), countOffset, maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
 
-    commandBuffer.SubmitIdle();
+    return true;
 }
 
-void GPUScene::SetIndices(const std::vector<uint32_t>& indices)
+void GPUScene::UploadGeometry()
 {
-    indexBuffer = nullptr;
+    const auto& indices = GPUInstance::indicesArray;
+
+    auto compact     = GPUInstance::vertexLayout == VertexLayout::Compact;
+    auto vertexCount = compact ? GPUInstance::compactVerticesArray.size() : GPUInstance::verticesArray.size();
+    auto vertexSize  = compact ? sizeof(VertexCompact) : sizeof(Vertex3D);
+    auto vertices    = compact ? static_cast<const void*>(GPUInstance::compactVerticesArray.data()) : GPUInstance::verticesArray.data();
+
+    uploadedBytes += AppendBuffer(vertexBuffer,
+                                  vertexUploadToken,
+                                  VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                  vertices,
+                                  vertexSize * uploadedVertexCount,
+                                  vertexSize * vertexCount);
+
+    // A model too large for 16 bit indices switches the whole buffer to 32 bits, it is uploaded again from the start.
+    auto type = GPUInstance::maxModelVertexCount <= std::numeric_limits<uint16_t>::max() ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    if (type != indexType) {
+        if (indexBuffer) Graphics::Get()->ReleaseBuffer(std::move(indexBuffer), indexUploadToken);
+        indexType          = type;
+        uploadedIndexCount = 0;
+        shortIndices.clear();
+        shortIndices.shrink_to_fit();
+    }
 
-    if (indices.empty()) return;
+    auto indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    if (indexType == VK_INDEX_TYPE_UINT16)
+        VertexCompact::AppendShortIndices(indices.data() + shortIndices.size(), indices.data() + indices.size(), shortIndices);
 
-    Buffer indexStaging(sizeof(uint32_t) * indices.size(),
-                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                        indices.data());
-    indexBuffer = std::make_unique<Buffer>(
-        indexStaging.GetSize(),
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    uploadedBytes += AppendBuffer(indexBuffer,
+                                  indexUploadToken,
+                                  VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                  indexType == VK_INDEX_TYPE_UINT16 ? static_cast<const void*>(shortIndices.data()) : indices.data(),
+                                  indexSize * uploadedIndexCount,
+                                  indexSize * indices.size());
 
-    CommandBuffer commandBuffer;
+    uploadedVertexCount = vertexCount;
+    uploadedIndexCount  = indices.size();
+}
+
+void GPUScene::UpdateLods()
+{
+    const auto& lods = GPUInstance::lodsArray;
 
-    VkBufferCopy copyRegion = {};
-    copyRegion.size         = indexStaging.GetSize();
-    vkCmdCopyBuffer(commandBuffer, indexStaging.GetBuffer(), indexBuffer->GetBuffer(), 1, &copyRegion);
+    if (lods.empty()) return;
+
+    // Levels are only appended with new models, the buffer is replaced when it no longer matches.
+    if (!lodsBuffer || lodsBuffer->GetSize() != sizeof(GPUInstance::LodData) * lods.size()) {
+        lodsBuffer = std::make_unique<StorageBuffer>(sizeof(GPUInstance::LodData) * lods.size(), lods.data());
+        uploadedBytes += lodsBuffer->GetSize();
+    }
+}
+
+void GPUScene::UpdateClusters()
+{
+    const auto& meshlets = GPUInstance::meshletsArray;
+
+    if (meshlets.empty()) return;
+
+    // Meshlets are only appended with new models, the buffer is replaced when it no longer matches.
+    if (!meshletsBuffer || meshletsBuffer->GetSize() != sizeof(Meshlet) * meshlets.size()) {
+        meshletsBuffer = std::make_unique<StorageBuffer>(sizeof(Meshlet) * meshlets.size(), meshlets.data());
+        uploadedBytes += meshletsBuffer->GetSize();
+    }
+
+    clusterInstances.clear();
+    for (uint32_t i = 0; i < instances.size(); i++) {
+        const auto& instanceData = instancesDatas[i];
+        for (uint32_t m = 0; m < instanceData.meshletCount; m++) clusterInstances.push_back({i, instanceData.meshletOffset + m});
+    }
+
+    if (clusterInstances.empty()) return;
+
+    clusterInstancesBuffer = std::make_unique<StorageBuffer>(sizeof(ClusterInstance) * clusterInstances.size(), clusterInstances.data());
+    if (!drawClusterIndirectBuffer || drawClusterIndirectBuffer->GetSize() != sizeof(VkDrawIndexedIndirectCommand) * clusterInstances.size())
+        drawClusterIndirectBuffer = std::make_unique<IndirectBuffer>(sizeof(VkDrawIndexedIndirectCommand) * clusterInstances.size(), nullptr, true);
+    uploadedBytes += clusterInstancesBuffer->GetSize();
+}
+
+VkDeviceSize GPUScene::AppendBuffer(std::unique_ptr<Buffer>& buffer, StagingRing::Token& uploadToken, VkBufferUsageFlags usage, const void* data,
+                                    VkDeviceSize uploadedSize, VkDeviceSize size)
+{
+    // The shared arrays only grow, anything before uploadedSize is already on the GPU.
+    if (size <= uploadedSize) return 0;
+
+    auto stagingRing = Graphics::Get()->GetStagingRing();
+    if (!buffer || buffer->GetSize() < size) {
+        // Grows geometrically, so appending models one at a time doesn't copy the whole buffer every time.
+        VkDeviceSize capacity = buffer ? std::max(size, buffer->GetSize() + buffer->GetSize() / 2) : size;
+
+        auto previous = std::move(buffer);
+        buffer        = std::make_unique<Buffer>(capacity, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        // The old buffer is copied in the same batch as the new tail, and destroyed once that batch and the frames using it are done.
+        if (previous) {
+            auto copyToken = stagingRing->Copy(*previous, *buffer, uploadedSize);
+            Graphics::Get()->ReleaseBuffer(std::move(previous), std::max(uploadToken, copyToken));
+        }
+    }
 
-    commandBuffer.SubmitIdle();
+    uploadToken = stagingRing->Upload(*buffer, uploadedSize, static_cast<const char*>(data) + uploadedSize, size - uploadedSize);
+    return size - uploadedSize;
 }
-}   // namespace MapleLeaf
\ No newline at end of file
+}   // namespace MapleLeaf
@@ -5,6 +5,7 @@
 #include "GPUInstance.hpp"
 #include "GPUMaterial.hpp"
 #include "Scene.hpp"
+#include "StagingRing.hpp"
 #include "StorageBuffer.hpp"
 
 namespace MapleLeaf {
@@ -28,27 +29,73 @@ public:
     void Start() override;
     void Update() override;
 
-    void SetVertices(const std::vector<Vertex3D>& vertices);
-    void SetIndices(const std::vector<uint32_t>& indices);
-
     void PushDescriptors(DescriptorsHandler& descriptorSet, bool DrawCulling = true);
     bool CmdRender(const CommandBuffer& commandBuffer, bool DrawCulling = true);
 
+    /**
+     * Draws the meshlet clusters of every instance with the commands the cluster culling pass wrote, one command per cluster.
+     * @param commandBuffer The command buffer to record to.
+     * @return If anything was drawn.
+     */
+    bool CmdRenderClusters(const CommandBuffer& commandBuffer);
+
+    /**
+     * Draws commands a compute pass wrote along with their count, such as the cascade draw lists of the shadow culling pass.
+     * @param commandBuffer The command buffer to record to.
+     * @param commands The buffer of the commands.
+     * @param offset The byte offset of the first command.
+     * @param counts The buffer of the draw count.
+     * @param countOffset The byte offset of the draw count.
+     * @param maxDrawCount The draw count is clamped to it.
+     * @return If anything was drawn.
+     */
+    bool CmdRenderIndirectCount(const CommandBuffer& commandBuffer, const IndirectBuffer& commands, VkDeviceSize offset, const IndirectBuffer& counts,
+                                VkDeviceSize countOffset, uint32_t maxDrawCount) const;
+
     std::vector<GPUInstance>& GetInstances() { return instances; }
     std::vector<GPUMaterial>& GetMaterials() { return materials; }
 
     const Buffer* GetVertexBuffer() const { return vertexBuffer.get(); }
     const Buffer* GetIndexBuffer() const { return indexBuffer.get(); }
+    VkIndexType   GetIndexType() const { return indexType; }
+
+    /**
+     * Gets the vertex input of the shared vertex buffer, in the layout selected by MAPLELEAF_COMPACT_VERTICES.
+     * @return The vertex input.
+     */
+    static Shader::VertexInput GetVertexInput()
+    {
+        return GPUInstance::vertexLayout == VertexLayout::Compact ? VertexCompact::GetVertexInput() : Vertex3D::GetVertexInput();
+    }
 
     const StorageBuffer* GetInstanceDatasHandler() const { return instancesBuffer.get(); }
     const StorageBuffer* GetMaterialDatasHandler() const { return materialsBuffer.get(); }
 
     const IndirectBuffer* GetIndirectBuffer() const { return drawCullingIndirectBuffer.get(); }
 
+    const StorageBuffer*  GetLodDatasHandler() const { return lodsBuffer.get(); }
+    const StorageBuffer*  GetMeshletDatasHandler() const { return meshletsBuffer.get(); }
+    const StorageBuffer*  GetClusterInstancesHandler() const { return clusterInstancesBuffer.get(); }
+    const IndirectBuffer* GetClusterIndirectBuffer() const { return drawClusterIndirectBuffer.get(); }
+
     uint32_t     GetInstanceCount() const { return instances.size(); }
+    uint32_t     GetClusterCount() const { return static_cast<uint32_t>(clusterInstances.size()); }
     UpdateStatus GetUpdateStatus() const { return updateStatus; }
 
+    /**
+     * Gets the bytes written to GPU buffers by the last Start or Update, only changed ranges are uploaded.
+     * @return The uploaded byte count.
+     */
+    VkDeviceSize GetUploadedBytes() const { return uploadedBytes; }
+
 private:
+    // One meshlet of one instance, mirrors ClusterInstance in GPUDriven/ClusterCulling.comp.
+    struct ClusterInstance
+    {
+        uint32_t instanceIndex;
+        uint32_t meshletIndex;
+    };
+
     std::vector<GPUInstance> instances;
     std::vector<GPUMaterial> materials;
 
@@ -60,10 +107,51 @@ private:
 
     std::unique_ptr<StorageBuffer> instancesBuffer;
     std::unique_ptr<StorageBuffer> materialsBuffer;
+    std::unique_ptr<StorageBuffer> lodsBuffer;
 
     std::unique_ptr<IndirectBuffer> drawCullingIndirectBuffer;
     std::unique_ptr<IndirectBuffer> drawAllMeshIndirectBuffer;
 
+    std::vector<ClusterInstance>    clusterInstances;
+    std::unique_ptr<StorageBuffer>  meshletsBuffer;
+    std::unique_ptr<StorageBuffer>  clusterInstancesBuffer;
+    std::unique_ptr<IndirectBuffer> drawClusterIndirectBuffer;
+
     UpdateStatus updateStatus;
+
+    // Elements changed since the last upload, coalesced into copy regions by Buffer::CoalesceRanges.
+    std::vector<uint32_t> dirtyInstances;
+    std::vector<uint32_t> dirtyMaterials;
+    std::vector<uint32_t> dirtyCommands;
+
+    // Prefix of the shared vertex and index arrays already living in vertexBuffer and indexBuffer.
+    std::size_t uploadedVertexCount = 0;
+    std::size_t uploadedIndexCount  = 0;
+    // The last staging ring uploads into the buffers, a replaced buffer is released once they complete.
+    StagingRing::Token vertexUploadToken = 0;
+    StagingRing::Token indexUploadToken  = 0;
+
+    // Indices are relative to the vertex offset of their model, 16 bits hold them while no model has more than 65535 vertices.
+    VkIndexType           indexType = VK_INDEX_TYPE_UINT32;
+    std::vector<uint16_t> shortIndices;
+
+    VkDeviceSize uploadedBytes = 0;
+
+    void UploadGeometry();
+    void UpdateLods();
+    void UpdateClusters();
+
+    /**
+     * Uploads the part of a growing array not yet in its buffer through the staging ring, replacing the buffer by a larger one if needed.
+     * @param buffer The buffer, created or replaced when it is too small.
+     * @param uploadToken The token of the last upload into the buffer, updated to the new one.
+     * @param usage The usage of the buffer.
+     * @param data The whole array.
+     * @param uploadedSize The bytes of the array already in the buffer.
+     * @param size The bytes of the whole array.
+     * @return The uploaded byte count.
+     */
+    static VkDeviceSize AppendBuffer(std::unique_ptr<Buffer>& buffer, StagingRing::Token& uploadToken, VkBufferUsageFlags usage, const void* data,
+                                     VkDeviceSize uploadedSize, VkDeviceSize size);
 };
 }   // namespace MapleLeaf
\ No newline at end of file
@@ -8,6 +8,11 @@
 namespace MapleLeaf {
 Devices::Devices()
 {
+    if (Engine::Get()->IsHeadless()) {
+        CreateWindow();
+        return;
+    }
+
     if (glfwInit() == GLFW_FALSE) throw std::runtime_error("GLFW failed to initialize");
     if (glfwVulkanSupported() == GLFW_FALSE) throw std::runtime_error("GLFW failed to find Vulkan support");
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -19,12 +24,12 @@ Devices::Devices()
 
 Devices::~Devices()
 {
-    glfwTerminate();   // include ImGui::DestroyContext();
+    if (!window->IsHeadless()) glfwTerminate();   // include ImGui::DestroyContext();
 }
 
 void Devices::Update()
 {
-    glfwPollEvents();
+    if (!window->IsHeadless()) glfwPollEvents();
     window->Update();
 }
 
@@ -44,6 +49,9 @@ Window* Devices::GetWindow()
 
 std::pair<const char**, uint32_t> Devices::GetInstanceExtensions() const
 {
+    // Offscreen rendering needs no surface extensions.
+    if (window->IsHeadless()) return std::make_pair(nullptr, 0u);
+
     uint32_t glfwExtensionCount;
     auto     glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
     return std::make_pair(glfwExtensions, glfwExtensionCount);
@@ -74,6 +74,11 @@ Window::Window(std::size_t id)
     , resizable(true)
     , focused(true)
 {
+    if (const auto& headless = Engine::Get()->GetHeadlessSettings()) {
+        size = {headless->width, headless->height};
+        return;
+    }
+
     window = glfwCreateWindow(size.x, size.y, title.c_str(), nullptr, nullptr);
 
     if (!window) {
@@ -100,7 +105,7 @@ Window::Window(std::size_t id)
 }
 Window::~Window()
 {
-    glfwDestroyWindow(window);
+    if (window) glfwDestroyWindow(window);
     closed = true;
 }
 
@@ -131,7 +136,7 @@ void Window::SetSize(const glm::uvec2& size)
 {
     if (size.x != -1) this->size.x = size.x;
     if (size.y != -1) this->size.y = size.y;
-    glfwSetWindowSize(window, size.x, size.y);
+    if (window) glfwSetWindowSize(window, size.x, size.y);
 }
 
 float Window::GetAspectRatio() const
@@ -151,7 +156,7 @@ const std::string& Window::GetTitle()
 void Window::SetTitle(const std::string& title)
 {
     this->title = title;
-    glfwSetWindowTitle(window, title.c_str());
+    if (window) glfwSetWindowTitle(window, title.c_str());
 }
 
 bool Window::IsResizable() const
@@ -161,7 +166,7 @@ bool Window::IsResizable() const
 void Window::SetResizable(bool resizable)
 {
     this->resizable = resizable;
-    glfwSetWindowAttrib(window, GLFW_RESIZABLE, resizable);
+    if (window) glfwSetWindowAttrib(window, GLFW_RESIZABLE, resizable);
 }
 
 bool Window::IsFullscreen() const
@@ -196,7 +201,7 @@ bool Window::IsCursorHidden() const
 }
 void Window::SetCursorHidden(bool hidden)
 {
-    if (cursorHidden != hidden) {
+    if (window && cursorHidden != hidden) {
         glfwSetInputMode(window, GLFW_CURSOR, hidden ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
 
         if (!hidden && cursorHidden) SetMousePosition(mousePosition);
@@ -213,7 +218,7 @@ void Window::SetMousePosition(const glm::vec2& mousePosition)
 {
     this->mouseLastPosition = mousePosition;
     this->mousePosition     = mousePosition;
-    glfwSetCursorPos(window, mousePosition.x, mousePosition.y);
+    if (window) glfwSetCursorPos(window, mousePosition.x, mousePosition.y);
 }
 const glm::vec2& Window::GetMousePositionDelta() const
 {
@@ -241,6 +246,7 @@ GLFWwindow* Window::GetWindow() const
 
 VkResult Window::CreateSurface(const VkInstance& instance, const VkAllocationCallbacks* allocator, VkSurfaceKHR* surface) const
 {
+    if (!window) return VK_ERROR_INITIALIZATION_FAILED;
     return glfwCreateWindowSurface(instance, window, allocator, surface);
 }
 }   // namespace MapleLeaf
\ No newline at end of file
@@ -54,6 +54,11 @@ public:
 
     GLFWwindow* GetWindow() const;
 
+    /**
+     * Gets if the window was created for a headless engine, it has a fixed size and no GLFW window, surface or input.
+     */
+    bool IsHeadless() const { return !window; }
+
     VkResult CreateSurface(const VkInstance& instance, const VkAllocationCallbacks* allocator, VkSurfaceKHR* surface) const;
 
     boost::signals2::signal<void(glm::vec2)>&                          OnMousePosition() { return onMousePosition; }
@@ -1,14 +1,16 @@
 #include "Engine.hpp"
 #include "Log.hpp"
 #include "Module.hpp"
+#include "Profiler.hpp"
 
 namespace MapleLeaf {
 Engine* Engine::Instance = nullptr;
 
-Engine::Engine(std::string argv0, ModuleFilter&& moduleFilter)
+Engine::Engine(std::string argv0, ModuleFilter&& moduleFilter, std::optional<HeadlessSettings> headless)
     : argv0(std::move(argv0))
     , engineVersion(1, 0, 0)
     , running(true)
+    , headless(std::move(headless))
     , elapsedUpdate(15.77ms)
     , elapsedRender(-1s)
     , fpsLimit(-1.0f)
@@ -38,14 +40,21 @@ int32_t Engine::Run()
             }
         }
 
-        elapsedRender.SetInterval(Time::Seconds(1.0f / fpsLimit));
-
         UpdateStage(Module::Stage::Always);
 
+        if (headless) {
+            StepHeadless();
+            continue;
+        }
+
+        elapsedRender.SetInterval(Time::Seconds(1.0f / fpsLimit));
+
         if (elapsedUpdate.GetElapsed() != 0) {
             // Resets the timer.
             ups.Update(Time::Now());
 
+            MAPLELEAF_PROFILE_SCOPE("Engine::Update");
+
             // Pre-Update.
             UpdateStage(Module::Stage::Pre);
             // Update.
@@ -62,6 +71,10 @@ int32_t Engine::Run()
             // Resets the timer.
             fps.Update(Time::Now());
 
+            // Each rendered frame starts a profiler frame, the updates run before it are accounted to the previous one.
+            Profiler::BeginFrame();
+            MAPLELEAF_PROFILE_SCOPE("Engine::Render");
+
             // Render
             UpdateStage(Module::Stage::Render);
 
@@ -74,6 +87,31 @@ int32_t Engine::Run()
     return EXIT_SUCCESS;
 }
 
+void Engine::StepHeadless()
+{
+    // The deltas advance before the stages run so the first frame already sees the timestep, whatever the wall clock says.
+    deltaUpdate.Step(headless->timestep);
+    deltaRender.Step(headless->timestep);
+    ups.Update(deltaUpdate.currentFrameTime);
+    fps.Update(deltaRender.currentFrameTime);
+
+    {
+        MAPLELEAF_PROFILE_SCOPE("Engine::Update");
+
+        UpdateStage(Module::Stage::Pre);
+        UpdateStage(Module::Stage::Normal);
+        UpdateStage(Module::Stage::Post);
+    }
+
+    Profiler::BeginFrame();
+    {
+        MAPLELEAF_PROFILE_SCOPE("Engine::Render");
+        UpdateStage(Module::Stage::Render);
+    }
+
+    if (headless->frameCount != 0 && ++headlessFrames >= headless->frameCount) running = false;
+}
+
 void Engine::CreateModule(Module::TRegistryMap::const_iterator it, const ModuleFilter& filter)
 {
     if (modules.find(it->first) != modules.end()) return;
@@ -6,8 +6,11 @@
 #include "Time.hpp"
 #include "TypeInfo.hpp"
 #include <cmath>
+#include <filesystem>
 #include <map>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace MapleLeaf {
 class Delta
@@ -23,6 +26,17 @@ public:
         change           = currentFrameTime - lastFrameTime;
         lastFrameTime    = currentFrameTime;
     }
+
+    /**
+     * Advances by a fixed simulated time instead of the wall clock.
+     * @param timestep The time between this frame and the last.
+     */
+    void Step(const Time& timestep)
+    {
+        currentFrameTime = lastFrameTime + timestep;
+        change           = timestep;
+        lastFrameTime    = currentFrameTime;
+    }
 };
 
 class ChangePerSecond
@@ -44,12 +58,28 @@ public:
     }
 };
 
+/**
+ * Runs the engine without a window, frames are rendered into offscreen images and stepped at a fixed timestep.
+ */
+struct HeadlessSettings
+{
+    uint32_t width  = 1280;
+    uint32_t height = 720;
+    // Simulated time of one frame, every frame runs one update and one render.
+    Time timestep = Time::Seconds(1.0f / 60.0f);
+    // Frames rendered before the engine closes, 0 runs until RequestClose.
+    uint32_t frameCount = 0;
+    // Attachments written to the dump directory after every frame.
+    std::vector<std::string> dumpAttachments;
+    std::filesystem::path    dumpDirectory = "Dumps";
+};
+
 class Engine : NonCopyable
 {
 public:
     static Engine* Get() { return Instance; }
 
-    explicit Engine(std::string argv0, ModuleFilter&& moduleFilter = {});
+    explicit Engine(std::string argv0, ModuleFilter&& moduleFilter = {}, std::optional<HeadlessSettings> headless = std::nullopt);
     ~Engine();
 
     int32_t Run();
@@ -68,10 +98,14 @@ public:
 
     void RequestClose() { running = false; }
 
+    bool                                   IsHeadless() const { return headless.has_value(); }
+    const std::optional<HeadlessSettings>& GetHeadlessSettings() const { return headless; }
+
 private:
     void CreateModule(Module::TRegistryMap::const_iterator it, const ModuleFilter& filter);
     void DestroyModule(TypeId id);
     void UpdateStage(Module::Stage stage);
+    void StepHeadless();
 
     static Engine* Instance;
 
@@ -86,6 +120,9 @@ private:
     float fpsLimit;
     bool  running;
 
+    std::optional<HeadlessSettings> headless;
+    uint32_t                        headlessFrames = 0;
+
     Delta           deltaUpdate, deltaRender;
     ElapsedTime     elapsedUpdate, elapsedRender;
     ChangePerSecond ups, fps;
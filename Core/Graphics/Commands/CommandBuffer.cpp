@@ -25,13 +25,14 @@ CommandBuffer::~CommandBuffer()
     vkFreeCommandBuffers(*logicalDevice, commandPool->GetCommandPool(), 1, &commandBuffer);
 }
 
-void CommandBuffer::Begin(VkCommandBufferUsageFlags usage)
+void CommandBuffer::Begin(VkCommandBufferUsageFlags usage, const VkCommandBufferInheritanceInfo* inheritanceInfo)
 {
     if (running) return;
 
     VkCommandBufferBeginInfo beginInfo = {};
     beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.flags                    = usage;
+    beginInfo.pInheritanceInfo         = inheritanceInfo;
     Graphics::CheckVk(vkBeginCommandBuffer(commandBuffer, &beginInfo));
     running = true;
 }
@@ -49,6 +50,9 @@ void CommandBuffer::SubmitIdle()
     auto logicalDevice = Graphics::Get()->GetLogicalDevice();
     auto queueSelected = GetQueue(SubmitType::Idle);
 
+    // One-shot work may read resources whose uploads are still batched in the staging ring.
+    Graphics::Get()->GetStagingRing()->WaitIdle();
+
     if (running) End();
 
     VkFenceCreateInfo fenceCreateInfo = {};
@@ -18,7 +18,13 @@ public:
                            VkCommandBufferLevel bufferLevel = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
     ~CommandBuffer();
 
-    void Begin(VkCommandBufferUsageFlags usage = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    /**
+     * Begins recording.
+     * @param usage The usage flags.
+     * @param inheritanceInfo The render pass state a secondary command buffer continues, nullptr for primary ones.
+     */
+    void Begin(VkCommandBufferUsageFlags usage = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+               const VkCommandBufferInheritanceInfo* inheritanceInfo = nullptr);
     void End();
 
     void SubmitIdle();
@@ -0,0 +1,146 @@
+#include "GpuProfiler.hpp"
+#include "Graphics.hpp"
+#include "Log.hpp"
+
+namespace MapleLeaf {
+GpuProfiler::GpuProfiler(const LogicalDevice& logicalDevice, const PhysicalDevice& physicalDevice)
+    : logicalDevice(logicalDevice)
+    , timestampPeriod(physicalDevice.GetProperties().limits.timestampPeriod)
+{
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    auto validBits = queueFamilies[logicalDevice.GetGraphicsFamily()].timestampValidBits;
+    supported      = validBits > 0 && timestampPeriod > 0.0f;
+    timestampMask  = validBits >= 64 ? UINT64_MAX : (uint64_t(1) << validBits) - 1;
+
+    if (!supported) Log::Warning("Graphics queue does not support timestamps, GPU zones are not profiled\n");
+}
+
+GpuProfiler::~GpuProfiler()
+{
+    for (auto& frameSlot : frameSlots) vkDestroyQueryPool(logicalDevice, frameSlot.queryPool, nullptr);
+}
+
+void GpuProfiler::BeginFrame(const CommandBuffer& commandBuffer, uint32_t frameSlot)
+{
+    recording = nullptr;
+    openZones.clear();
+
+    if (!supported) return;
+
+    if (frameSlot >= frameSlots.size()) frameSlots.resize(frameSlot + 1);
+    auto& slot = frameSlots[frameSlot];
+
+    if (slot.queryPool == VK_NULL_HANDLE) {
+        VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+        queryPoolCreateInfo.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolCreateInfo.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolCreateInfo.queryCount            = MaxQueries;
+        Graphics::CheckVk(vkCreateQueryPool(logicalDevice, &queryPoolCreateInfo, nullptr, &slot.queryPool));
+    }
+    else if (slot.queryCount > 0) {
+        ReadBack(slot);
+    }
+
+    if (!Profiler::IsEnabled()) return;
+
+    vkCmdResetQueryPool(commandBuffer, slot.queryPool, 0, MaxQueries);
+    slot.queryCount  = 0;
+    slot.frameIndex  = Profiler::GetFrameIndex();
+    slot.recordStart = Time::Now();
+    slot.zones.clear();
+    recording = &slot;
+}
+
+void GpuProfiler::BeginZone(const CommandBuffer& commandBuffer, std::string_view name)
+{
+    if (!recording) return;
+
+    if (recording->queryCount + 2 > MaxQueries) {
+        openZones.emplace_back(UINT32_MAX);
+        return;
+    }
+
+    auto beginQuery = recording->queryCount;
+    recording->queryCount += 2;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, recording->queryPool, beginQuery);
+
+    openZones.emplace_back(static_cast<uint32_t>(recording->zones.size()));
+    recording->zones.push_back({std::string(name), beginQuery, beginQuery + 1, static_cast<uint32_t>(openZones.size() - 1)});
+}
+
+void GpuProfiler::EndZone(const CommandBuffer& commandBuffer)
+{
+    if (!recording || openZones.empty()) return;
+
+    auto zoneIndex = openZones.back();
+    openZones.pop_back();
+    if (zoneIndex == UINT32_MAX) return;
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, recording->queryPool, recording->zones[zoneIndex].endQuery);
+}
+
+GpuProfiler::ReservedZone GpuProfiler::ReserveZone(std::string_view name)
+{
+    if (!recording || recording->queryCount + 2 > MaxQueries) return {};
+
+    auto beginQuery = recording->queryCount;
+    recording->queryCount += 2;
+    recording->zones.push_back({std::string(name), beginQuery, beginQuery + 1, static_cast<uint32_t>(openZones.size())});
+    return {recording->queryPool, beginQuery};
+}
+
+void GpuProfiler::BeginReservedZone(const CommandBuffer& commandBuffer, const ReservedZone& zone)
+{
+    if (zone.queryPool == VK_NULL_HANDLE) return;
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, zone.queryPool, zone.beginQuery);
+}
+
+void GpuProfiler::EndReservedZone(const CommandBuffer& commandBuffer, const ReservedZone& zone)
+{
+    if (zone.queryPool == VK_NULL_HANDLE) return;
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, zone.queryPool, zone.beginQuery + 1);
+}
+
+void GpuProfiler::ReadBack(FrameSlot& frameSlot)
+{
+    std::vector<uint64_t> timestamps(frameSlot.queryCount);
+    auto                  result = vkGetQueryPoolResults(logicalDevice,
+                                        frameSlot.queryPool,
+                                        0,
+                                        frameSlot.queryCount,
+                                        timestamps.size() * sizeof(uint64_t),
+                                        timestamps.data(),
+                                        sizeof(uint64_t),
+                                        VK_QUERY_RESULT_64_BIT);
+    frameSlot.queryCount = 0;
+
+    // A zone left open when the command buffer ended never wrote its end query, the frame is dropped rather than waited on.
+    if (result != VK_SUCCESS || frameSlot.zones.empty()) return;
+
+    auto first = timestamps[frameSlot.zones.front().beginQuery] & timestampMask;
+
+    // Durations are exact, zones are placed on the CPU timeline relative to the start of recording, not to when the GPU ran them.
+    std::vector<Profiler::Zone> zones;
+    zones.reserve(frameSlot.zones.size());
+    for (auto& pendingZone : frameSlot.zones) {
+        auto begin = static_cast<int64_t>((timestamps[pendingZone.beginQuery] & timestampMask) - first);
+        auto end   = static_cast<int64_t>((timestamps[pendingZone.endQuery] & timestampMask) - first);
+
+        Profiler::Zone zone = {};
+        zone.name           = std::move(pendingZone.name);
+        zone.thread         = Profiler::GpuThread;
+        zone.depth          = pendingZone.depth;
+        zone.start          = frameSlot.recordStart + Time::Microseconds(static_cast<int64_t>(begin * timestampPeriod / 1000.0));
+        zone.end            = frameSlot.recordStart + Time::Microseconds(static_cast<int64_t>(end * timestampPeriod / 1000.0));
+        zones.emplace_back(std::move(zone));
+    }
+
+    Profiler::AddGpuZones(frameSlot.frameIndex, std::move(zones));
+}
+}   // namespace MapleLeaf
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "CommandBuffer.hpp"
+#include "NonCopyable.hpp"
+#include "Profiler.hpp"
+#include "volk.h"
+#include <string_view>
+#include <vector>
+
+namespace MapleLeaf {
+class LogicalDevice;
+class PhysicalDevice;
+
+/**
+ * Wraps zones of a frame command buffer in timestamp queries, each frame in flight has a query pool read back once its fence has signalled.
+ * The timestamps are handed to the Profiler as GPU zones of the frame they were recorded in.
+ */
+class GpuProfiler : NonCopyable
+{
+public:
+    static constexpr uint32_t MaxQueries = 1024;
+
+    class Scope : NonCopyable
+    {
+    public:
+        Scope(GpuProfiler* profiler, const CommandBuffer& commandBuffer, std::string_view name)
+            : profiler(profiler)
+            , commandBuffer(commandBuffer)
+        {
+            if (profiler) profiler->BeginZone(commandBuffer, name);
+        }
+        ~Scope()
+        {
+            if (profiler) profiler->EndZone(commandBuffer);
+        }
+
+    private:
+        GpuProfiler*         profiler;
+        const CommandBuffer& commandBuffer;
+    };
+
+    // Queries of a zone whose timestamps another thread writes, into a secondary command buffer.
+    struct ReservedZone
+    {
+        VkQueryPool queryPool  = VK_NULL_HANDLE;
+        uint32_t    beginQuery = UINT32_MAX;
+    };
+
+    GpuProfiler(const LogicalDevice& logicalDevice, const PhysicalDevice& physicalDevice);
+    ~GpuProfiler();
+
+    /**
+     * Reads back the timestamps recorded the last time the frame slot was used and resets its queries.
+     * @param commandBuffer The frame command buffer, it must have just begun recording.
+     * @param frameSlot The frame in flight index, its fence must have been waited on.
+     */
+    void BeginFrame(const CommandBuffer& commandBuffer, uint32_t frameSlot);
+
+    void BeginZone(const CommandBuffer& commandBuffer, std::string_view name);
+    void EndZone(const CommandBuffer& commandBuffer);
+
+    /**
+     * Reserves the queries of a zone nested in the open ones, the profiler itself is only used from the thread recording the frame.
+     * @param name The zone name.
+     * @return The queries, to write with BeginReservedZone and EndReservedZone from any thread.
+     */
+    ReservedZone ReserveZone(std::string_view name);
+
+    static void BeginReservedZone(const CommandBuffer& commandBuffer, const ReservedZone& zone);
+    static void EndReservedZone(const CommandBuffer& commandBuffer, const ReservedZone& zone);
+
+    bool IsSupported() const { return supported; }
+
+private:
+    struct PendingZone
+    {
+        std::string name;
+        uint32_t    beginQuery;
+        uint32_t    endQuery;
+        uint32_t    depth;
+    };
+
+    struct FrameSlot
+    {
+        VkQueryPool              queryPool  = VK_NULL_HANDLE;
+        uint32_t                 queryCount = 0;
+        uint64_t                 frameIndex = 0;
+        Time                     recordStart;
+        std::vector<PendingZone> zones;
+    };
+
+    const LogicalDevice& logicalDevice;
+    bool                 supported;
+    float                timestampPeriod;
+    uint64_t             timestampMask;
+
+    std::vector<FrameSlot> frameSlots;
+    FrameSlot*             recording = nullptr;
+    // Zones of the recording slot not ended yet, UINT32_MAX for zones dropped because the pool was full.
+    std::vector<uint32_t> openZones;
+
+    void ReadBack(FrameSlot& frameSlot);
+};
+}   // namespace MapleLeaf
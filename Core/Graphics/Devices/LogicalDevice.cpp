@@ -13,6 +13,7 @@ const std::vector<const char*> LogicalDevice::DeviceExtensions = {VK_KHR_SWAPCHA
                                                                   VK_KHR_MAINTENANCE_4_EXTENSION_NAME,
                                                                   VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME,
                                                                   VK_EXT_SHADER_ATOMIC_FLOAT_EXTENSION_NAME,
+                                                                  VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME,
 #ifdef MAPLELEAF_RAY_TRACING
                                                                   VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
                                                                   VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
@@ -3,6 +3,7 @@
 #include "Instance.hpp"
 #include "LogicalDevice.hpp"
 #include "PhysicalDevice.hpp"
+#include "Window.hpp"
 #include "vulkan/vulkan_core.h"
 
 namespace MapleLeaf {
@@ -12,6 +13,12 @@ Surface::Surface(const Instance& instance, const PhysicalDevice& physicalDevice,
     , logicalDevice(logicalDevice)
     , window(window)
 {
+    // Headless frames render into offscreen images of the format a surface would usually offer.
+    if (window.IsHeadless()) {
+        format = {VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+        return;
+    }
+
     Graphics::CheckVk(window.CreateSurface(instance, nullptr, &surface));
     Graphics::CheckVk(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities));
 
@@ -50,7 +57,7 @@ Surface::Surface(const Instance& instance, const PhysicalDevice& physicalDevice,
 
 Surface::~Surface()
 {
-    vkDestroySurfaceKHR(instance, surface, nullptr);
+    if (surface != VK_NULL_HANDLE) vkDestroySurfaceKHR(instance, surface, nullptr);
 
     for (std::size_t i = 0; i < flightFences.size(); i++) {
         vkDestroyFence(logicalDevice, flightFences[i], nullptr);
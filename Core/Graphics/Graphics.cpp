@@ -9,7 +9,12 @@
 #include "Surface.hpp"
 #include "Window.hpp"
 #include "glslang/Public/ShaderLang.h"
+#include <cstring>
+#include <fstream>
 #include <functional>
+#include <iomanip>
+#include <string_view>
+#include <tuple>
 
 
 #include "config.h"
@@ -19,6 +24,9 @@ Graphics::Graphics()
     : instance(std::make_unique<Instance>())
     , physicalDevice(std::make_unique<PhysicalDevice>(*instance))
     , logicalDevice(std::make_unique<LogicalDevice>(*instance, *physicalDevice))
+    , memoryAllocator(std::make_unique<MemoryAllocator>(*logicalDevice, *physicalDevice))
+    , gpuProfiler(std::make_unique<GpuProfiler>(*logicalDevice, *physicalDevice))
+    , elapsedPipelineCacheFlush(60s)
 {
     Window* window = Devices::Get()->GetWindow();
     surface        = std::make_unique<Surface>(*instance, *physicalDevice, *logicalDevice, *window);
@@ -34,16 +42,22 @@ Graphics::~Graphics()
     CheckVk(vkQueueWaitIdle(graphicsQueue));
     CheckVk(vkQueueWaitIdle(computeQueue));
 
-    renderer  = nullptr;
-    swapchain = nullptr;
-    surface   = nullptr;
+    renderer = nullptr;
+    releasedBuffers.clear();
+    stagingRing = nullptr;
+    swapchain   = nullptr;
+    surface     = nullptr;
 
     glslang::FinalizeProcess();
+    SavePipelineCache();
     vkDestroyPipelineCache(*logicalDevice, pipelineCache, nullptr);
 
+    secondaryCommandBuffers.clear();
     commandPools.clear();
-    logicalDevice  = nullptr;
-    physicalDevice = nullptr;
+    gpuProfiler     = nullptr;
+    memoryAllocator = nullptr;
+    logicalDevice   = nullptr;
+    physicalDevice  = nullptr;
 }
 
 void Graphics::RegisterImGui()
@@ -54,21 +68,181 @@ void Graphics::RegisterImGui()
                         VK_API_VERSION_MAJOR(GetPhysicalDevice()->GetProperties().apiVersion),
                         VK_API_VERSION_MINOR(GetPhysicalDevice()->GetProperties().apiVersion),
                         VK_API_VERSION_PATCH(GetPhysicalDevice()->GetProperties().apiVersion));
+            if (stagingRing) ImGui::Text("Staging submits :%llu", static_cast<unsigned long long>(stagingRing->GetSubmitCount()));
+            ImGui::Text("Device allocations :%u / %u",
+                        memoryAllocator->GetDeviceAllocationCount(),
+                        GetPhysicalDevice()->GetProperties().limits.maxMemoryAllocationCount);
+            auto heapStats = memoryAllocator->GetHeapStats();
+            for (uint32_t i = 0; i < heapStats.size(); i++) {
+                const auto& stats = heapStats[i];
+                if (stats.reservedBytes == 0) continue;
+                ImGui::Text("Heap %u :%.1f / %.1f MB, %u blocks, %u dedicated, %u allocations, fragmentation %.2f",
+                            i,
+                            stats.usedBytes / (1024.0 * 1024.0),
+                            stats.reservedBytes / (1024.0 * 1024.0),
+                            stats.blockCount,
+                            stats.dedicatedCount,
+                            stats.allocationCount,
+                            stats.fragmentation);
+            }
+        });
+
+        imgui->RegisterCustomWindow("Profiler", [this]() {
+            bool enabled = Profiler::IsEnabled();
+            if (ImGui::Checkbox("Enabled", &enabled)) Profiler::SetEnabled(enabled);
+            ImGui::SameLine();
+            if (ImGui::Button("Export trace"))
+                Profiler::ExportChromeTrace(std::filesystem::path(CONFIG_PROJECT_DIR) / "Profiles" / Time::GetDateTime("%Y%m%d%H%M%S.json"));
+
+            // GPU zones are read back once the frame slot comes around again, older frames are complete.
+            auto latency = static_cast<uint64_t>(swapchain ? swapchain->GetImageCount() : 0) + 1;
+            auto index   = Profiler::GetFrameIndex();
+            if (index <= latency) return;
+
+            auto frame = Profiler::GetFrame(index - latency);
+            if (!frame) return;
+
+            // Zones are stored as they end, children before their parent.
+            std::sort(frame->zones.begin(), frame->zones.end(), [](const Profiler::Zone& a, const Profiler::Zone& b) {
+                return std::make_tuple(a.thread, a.start.AsMicroseconds<int64_t>(), a.depth) <
+                       std::make_tuple(b.thread, b.start.AsMicroseconds<int64_t>(), b.depth);
+            });
+
+            ImGui::Text("Frame %llu :%.2f ms", static_cast<unsigned long long>(frame->index), (frame->end - frame->start).AsMilliseconds<float>());
+            for (const auto& zone : frame->zones) {
+                ImGui::Text("%s%*s%s :%.3f ms",
+                            zone.thread == Profiler::GpuThread ? "GPU " : "CPU ",
+                            static_cast<int>(zone.depth * 2),
+                            "",
+                            zone.name.c_str(),
+                            (zone.end - zone.start).AsMicroseconds<float>() / 1000.0f);
+            }
         });
     }
 }
 
 const std::shared_ptr<CommandPool>& Graphics::GetCommandPool(const std::thread::id& threadId)
 {
+    std::lock_guard<std::mutex> lock(commandPoolsMutex);
     if (auto it = commandPools.find(threadId); it != commandPools.end()) return it->second;
     return commandPools.emplace(threadId, std::make_shared<CommandPool>(threadId)).first->second;
 }
 
+StagingRing* Graphics::GetStagingRing()
+{
+    std::call_once(stagingRingFlag, [this]() { stagingRing = std::make_unique<StagingRing>(); });
+    return stagingRing.get();
+}
+
+void Graphics::ReleaseBuffer(std::unique_ptr<Buffer>&& buffer, StagingRing::Token uploadToken)
+{
+    std::lock_guard<std::mutex> lock(releasedBuffersMutex);
+    releasedBuffers.push_back({std::move(buffer), uploadToken, submittedFrames});
+}
+
+void Graphics::DestroyReleasedBuffers()
+{
+    std::lock_guard<std::mutex> lock(releasedBuffersMutex);
+
+    // The fence of the current frame slot has been waited on, every frame submitted an image count ago or earlier has finished.
+    auto imageCount = static_cast<uint64_t>(swapchain->GetImageCount());
+    while (!releasedBuffers.empty()) {
+        const auto& released = releasedBuffers.front();
+        if (released.frame + imageCount > submittedFrames) break;
+        if (released.uploadToken != 0 && stagingRing && !stagingRing->IsComplete(released.uploadToken)) break;
+        releasedBuffers.pop_front();
+    }
+}
+
 void Graphics::CreatePipelineCache()
 {
+    std::vector<char> initialData;
+
+    if (std::ifstream file(GetPipelineCachePath(), std::ios::binary | std::ios::ate); file.is_open()) {
+        initialData.resize(static_cast<std::size_t>(file.tellg()));
+        file.seekg(0);
+        if (!file.read(initialData.data(), initialData.size())) initialData.clear();
+    }
+
+    // A blob from another driver or device is rejected up front, some drivers do not validate it themselves.
+    if (!initialData.empty() && !IsPipelineCacheValid(initialData, physicalDevice->GetProperties())) {
+        Log::Warning("Pipeline cache ", GetPipelineCachePath(), " does not match this device, ignoring it\n");
+        initialData.clear();
+    }
+
     VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
     pipelineCacheCreateInfo.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    pipelineCacheCreateInfo.initialDataSize           = initialData.size();
+    pipelineCacheCreateInfo.pInitialData              = initialData.empty() ? nullptr : initialData.data();
     CheckVk(vkCreatePipelineCache(*logicalDevice, &pipelineCacheCreateInfo, nullptr, &pipelineCache));
+
+    pipelineCacheHash = HashPipelineCache(initialData);
+}
+
+void Graphics::SavePipelineCache()
+{
+    if (pipelineCache == VK_NULL_HANDLE) return;
+
+    std::size_t dataSize = 0;
+    CheckVk(vkGetPipelineCacheData(*logicalDevice, pipelineCache, &dataSize, nullptr));
+    if (dataSize == 0) return;
+
+    std::vector<char> data(dataSize);
+    CheckVk(vkGetPipelineCacheData(*logicalDevice, pipelineCache, &dataSize, data.data()));
+    data.resize(dataSize);
+
+    // Nothing new was compiled since the last flush, a changed cache may keep its size so the contents are compared.
+    auto dataHash = HashPipelineCache(data);
+    if (dataHash == pipelineCacheHash) return;
+
+    auto path     = GetPipelineCachePath();
+    auto tempPath = std::filesystem::path(path).concat(".tmp");
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            Log::Warning("Failed to write pipeline cache ", tempPath, '\n');
+            return;
+        }
+        file.write(data.data(), data.size());
+    }
+
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        Log::Warning("Failed to write pipeline cache ", path, ": ", error.message(), '\n');
+        return;
+    }
+
+    pipelineCacheHash = dataHash;
+
+#ifdef MAPLELEAF_GRAPHIC_DEBUG
+    Log::Out("Pipeline cache ", path, " saved, ", dataSize, " bytes\n");
+#endif
+}
+
+bool Graphics::IsPipelineCacheValid(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties)
+{
+    if (data.size() < sizeof(VkPipelineCacheHeaderVersionOne)) return false;
+
+    VkPipelineCacheHeaderVersionOne header = {};
+    std::memcpy(&header, data.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+
+    return header.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne) && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+           std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+std::size_t Graphics::HashPipelineCache(const std::vector<char>& data)
+{
+    return std::hash<std::string_view>()(std::string_view(data.data(), data.size()));
+}
+
+std::filesystem::path Graphics::GetPipelineCachePath()
+{
+    return std::filesystem::path(CONFIG_PROJECT_DIR) / "Cache" / "PipelineCache.bin";
 }
 
 void Graphics::SetRenderer(std::unique_ptr<Renderer>&& renderer)
@@ -94,6 +268,8 @@ void Graphics::Update()
 {
     if (!renderer || Devices::Get()->GetWindow()->IsIconified()) return;
 
+    MAPLELEAF_PROFILE_SCOPE("Graphics::Update");
+
     if (!renderer->started) {
         ResetRenderStages();
         renderer->Start();
@@ -101,7 +277,13 @@ void Graphics::Update()
     }
 
     RegisterImGui();
-    renderer->Update();
+    {
+        MAPLELEAF_PROFILE_SCOPE("Renderer::Update");
+        renderer->Update();
+    }
+
+    // Uploads recorded this frame are submitted ahead of the frame, the frame command buffers are ordered after them.
+    if (stagingRing) stagingRing->Flush();
 
     if (swapchain) {
         auto acquireResult =
@@ -117,6 +299,8 @@ void Graphics::Update()
             return;
         }
 
+        DestroyReleasedBuffers();
+
         Pipeline::Stage stage;
 
         for (auto& renderStage : renderer->renderStages) {
@@ -128,6 +312,12 @@ void Graphics::Update()
 
             auto& commandBuffer = surface->commandBuffers[surface->currentFrameIndex];
 
+            // Zone names are only built while profiling.
+            std::string stageName;
+            if (Profiler::IsEnabled()) stageName = "RenderStage " + std::to_string(stage.first);
+            Profiler::Scope cpuZone(stageName);
+            gpuProfiler->BeginZone(*commandBuffer, stageName);
+
             // preRender
             for (const auto& subpass : renderStage->GetSubpasses()) {
                 stage.second = subpass.GetBinding();
@@ -136,17 +326,48 @@ void Graphics::Update()
                 renderer->subrenderHolder.PreRenderStage(stage, *commandBuffer);
             }
 
-            StartRenderpass(*renderStage);
-            for (const auto& subpass : renderStage->GetSubpasses()) {
-                stage.second = subpass.GetBinding();
-
-                // Renders subpass subrender pipelines.
-                renderer->subrenderHolder.RenderStage(stage, *commandBuffer);
-
-                if (subpass.GetBinding() != renderStage->GetSubpasses().back().GetBinding())
-                    vkCmdNextSubpass(*commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+            if (renderer->IsParallelRecording()) {
+                std::vector<Pipeline::Stage> subpassStages;
+                for (const auto& subpass : renderStage->GetSubpasses()) subpassStages.emplace_back(stage.first, subpass.GetBinding());
+
+                // Every subpass is recorded before the render pass begins, timestamps can't be written between secondary command buffers.
+                std::vector<std::vector<VkCommandBuffer>> secondaries;
+                {
+                    Profiler::Scope cpuRecordZone("Record secondaries");
+                    secondaries = renderer->subrenderHolder.RecordStages(subpassStages, [&renderStage, this](uint32_t subpass) -> CommandBuffer& {
+                        return BeginSecondaryCommandBuffer(*renderStage, subpass);
+                    });
+                }
+
+                StartRenderpass(*renderStage, false, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                for (std::size_t i = 0; i < secondaries.size(); i++) {
+                    if (!secondaries[i].empty())
+                        vkCmdExecuteCommands(*commandBuffer, static_cast<uint32_t>(secondaries[i].size()), secondaries[i].data());
+
+                    if (i + 1 < secondaries.size()) vkCmdNextSubpass(*commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                }
+                EndRenderpass(*renderStage);
+            }
+            else {
+                StartRenderpass(*renderStage);
+                for (const auto& subpass : renderStage->GetSubpasses()) {
+                    stage.second = subpass.GetBinding();
+
+                    {
+                        std::string subpassName;
+                        if (Profiler::IsEnabled()) subpassName = "Subpass " + std::to_string(stage.second);
+                        Profiler::Scope    cpuSubpassZone(subpassName);
+                        GpuProfiler::Scope gpuSubpassZone(gpuProfiler.get(), *commandBuffer, subpassName);
+
+                        // Renders subpass subrender pipelines.
+                        renderer->subrenderHolder.RenderStage(stage, *commandBuffer);
+                    }
+
+                    if (subpass.GetBinding() != renderStage->GetSubpasses().back().GetBinding())
+                        vkCmdNextSubpass(*commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+                }
+                EndRenderpass(*renderStage);
             }
-            EndRenderpass(*renderStage);
 
             // now postRender only support compute pass, TODO add support of default pipeline render
             for (const auto& subpass : renderStage->GetSubpasses()) {
@@ -155,13 +376,17 @@ void Graphics::Update()
                 // Compute Pass.
                 renderer->subrenderHolder.PostRenderStage(stage, *commandBuffer);
             }
+            gpuProfiler->EndZone(*commandBuffer);
             EndRecordCommandBuffer(*renderStage);
             stage.first++;
         }
     }
 
+    if (elapsedPipelineCacheFlush.GetElapsed() != 0) SavePipelineCache();
+
     // Purges unused command pools.
     if (elapsedPurge.GetElapsed() != 0) {
+        std::lock_guard<std::mutex> lock(commandPoolsMutex);
         for (auto it = commandPools.begin(); it != commandPools.end();) {
             if ((*it).second.use_count() <= 1) {
                 it = commandPools.erase(it);
@@ -211,6 +436,9 @@ void Graphics::RecreateSwapchain()
 
 void Graphics::RecreateCommandBuffers()
 {
+    // The frame slots are recreated, the device is idle.
+    secondaryCommandBuffers.clear();
+
     for (std::size_t i = 0; i < surface->flightFences.size(); i++) {
         vkDestroyFence(*logicalDevice, surface->flightFences[i], nullptr);
         vkDestroySemaphore(*logicalDevice, surface->presentCompletes[i], nullptr);
@@ -273,12 +501,52 @@ bool Graphics::StartRecordCommandBuffer(RenderStage& renderStage)
 
     auto& commandBuffer = surface->commandBuffers[surface->currentFrameIndex];
 
-    if (!commandBuffer->IsRunning()) commandBuffer->Begin(VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+    if (!commandBuffer->IsRunning()) {
+        commandBuffer->Begin(VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+
+        // The frame fence has signalled, the secondary command buffers of the slot are no longer pending.
+        for (auto& [key, commandBuffers] : secondaryCommandBuffers) {
+            if (key.first == surface->currentFrameIndex) commandBuffers.usedCount = 0;
+        }
+
+        // The acquire has waited on the frame fence, the timestamps the frame slot recorded last time are available.
+        gpuProfiler->BeginFrame(*commandBuffer, surface->currentFrameIndex);
+    }
 
     return true;
 }
 
-void Graphics::StartRenderpass(RenderStage& renderStage)
+void Graphics::ContinueRenderpass(const RenderStage& renderStage)
+{
+    StartRenderpass(renderStage, true);
+}
+
+CommandBuffer& Graphics::BeginSecondaryCommandBuffer(const RenderStage& renderStage, uint32_t subpass)
+{
+    SecondaryCommandBuffers* commandBuffers;
+    {
+        // Entries are only erased while nothing records, each thread then works on its own entry.
+        std::lock_guard<std::mutex> lock(secondaryCommandBuffersMutex);
+        commandBuffers = &secondaryCommandBuffers[{surface->currentFrameIndex, std::this_thread::get_id()}];
+    }
+
+    if (commandBuffers->usedCount == commandBuffers->commandBuffers.size())
+        commandBuffers->commandBuffers.emplace_back(std::make_unique<CommandBuffer>(false, VK_QUEUE_GRAPHICS_BIT, VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+    auto& commandBuffer = *commandBuffers->commandBuffers[commandBuffers->usedCount++];
+
+    VkCommandBufferInheritanceInfo inheritanceInfo = {};
+    inheritanceInfo.sType                          = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass                     = *renderStage.GetRenderpass();
+    inheritanceInfo.subpass                        = subpass;
+    inheritanceInfo.framebuffer                    = renderStage.GetActiveFramebuffer(swapchain->GetActiveImageIndex());
+    commandBuffer.Begin(VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, &inheritanceInfo);
+
+    // Dynamic state is not inherited from the primary command buffer.
+    SetViewportAndScissor(commandBuffer, renderStage);
+    return commandBuffer;
+}
+
+void Graphics::StartRenderpass(const RenderStage& renderStage, bool load, VkSubpassContents contents)
 {
     auto& commandBuffer = surface->commandBuffers[surface->currentFrameIndex];
 
@@ -286,6 +554,27 @@ void Graphics::StartRenderpass(RenderStage& renderStage)
     renderArea.offset   = {renderStage.GetRenderArea().GetOffset().x, renderStage.GetRenderArea().GetOffset().y};
     renderArea.extent   = {renderStage.GetRenderArea().GetExtent().x, renderStage.GetRenderArea().GetExtent().y};
 
+    SetViewportAndScissor(*commandBuffer, renderStage);
+
+    auto clearValues = renderStage.GetClearValues();
+    auto renderpass  = load || renderStage.IsContentsLoaded() ? renderStage.GetLoadRenderpass() : renderStage.GetRenderpass();
+
+    VkRenderPassBeginInfo renderPassBeginInfo = {};
+    renderPassBeginInfo.sType                 = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassBeginInfo.renderPass            = *renderpass;
+    renderPassBeginInfo.framebuffer           = renderStage.GetActiveFramebuffer(swapchain->GetActiveImageIndex());
+    renderPassBeginInfo.renderArea            = renderArea;
+    renderPassBeginInfo.clearValueCount       = static_cast<uint32_t>(clearValues.size());
+    renderPassBeginInfo.pClearValues          = clearValues.data();
+    vkCmdBeginRenderPass(*commandBuffer, &renderPassBeginInfo, contents);
+}
+
+void Graphics::SetViewportAndScissor(const CommandBuffer& commandBuffer, const RenderStage& renderStage)
+{
+    VkRect2D renderArea = {};
+    renderArea.offset   = {renderStage.GetRenderArea().GetOffset().x, renderStage.GetRenderArea().GetOffset().y};
+    renderArea.extent   = {renderStage.GetRenderArea().GetExtent().x, renderStage.GetRenderArea().GetExtent().y};
+
     if (renderStage.GetRenderStageType() == RenderStage::Type::MONO) {
         VkViewport viewport = {};
         viewport.x          = 0.0f;
@@ -294,13 +583,13 @@ void Graphics::StartRenderpass(RenderStage& renderStage)
         viewport.height     = -static_cast<float>(renderArea.extent.height);
         viewport.minDepth   = 0.0f;
         viewport.maxDepth   = 1.0f;
-        vkCmdSetViewport(*commandBuffer, 0, 1, &viewport);
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
         VkRect2D scissor = {};
         scissor.offset   = renderArea.offset;
         scissor.extent   = renderArea.extent;
 
-        vkCmdSetScissor(*commandBuffer, 0, 1, &scissor);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
     }
     else if (renderStage.GetRenderStageType() == RenderStage::Type::STEREO) {
         std::array<VkRect2D, 2> renderArea = {};
@@ -324,7 +613,7 @@ void Graphics::StartRenderpass(RenderStage& renderStage)
         viewport[1].height   = -static_cast<float>(renderArea[1].extent.height);
         viewport[1].minDepth = 0.0f;
         viewport[1].maxDepth = 1.0f;
-        vkCmdSetViewport(*commandBuffer, 0, 2, viewport.data());
+        vkCmdSetViewport(commandBuffer, 0, 2, viewport.data());
 
         std::array<VkRect2D, 2> scissor{};
         scissor[0].offset = renderArea[0].offset;
@@ -332,25 +621,16 @@ void Graphics::StartRenderpass(RenderStage& renderStage)
 
         scissor[1].offset = renderArea[1].offset;
         scissor[1].extent = renderArea[1].extent;
-        vkCmdSetScissor(*commandBuffer, 0, 2, scissor.data());
+        vkCmdSetScissor(commandBuffer, 0, 2, scissor.data());
     }
-
-    auto clearValues = renderStage.GetClearValues();
-
-    VkRenderPassBeginInfo renderPassBeginInfo = {};
-    renderPassBeginInfo.sType                 = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassBeginInfo.renderPass            = *renderStage.GetRenderpass();
-    renderPassBeginInfo.framebuffer           = renderStage.GetActiveFramebuffer(swapchain->GetActiveImageIndex());
-    renderPassBeginInfo.renderArea            = renderArea;
-    renderPassBeginInfo.clearValueCount       = static_cast<uint32_t>(clearValues.size());
-    renderPassBeginInfo.pClearValues          = clearValues.data();
-    vkCmdBeginRenderPass(*commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 }
 
 void Graphics::EndRenderpass(RenderStage& renderStage)
 {
     auto& commandBuffer = surface->commandBuffers[surface->currentFrameIndex];
     vkCmdEndRenderPass(*commandBuffer);
+
+    renderStage.contentsValid = true;
 }
 
 void Graphics::EndRecordCommandBuffer(RenderStage& renderStage)
@@ -361,22 +641,63 @@ void Graphics::EndRecordCommandBuffer(RenderStage& renderStage)
     if (!renderStage.HasSwapchain()) return;
 
     commandBuffer->End();
-    commandBuffer->Submit(surface->presentCompletes[surface->currentFrameIndex],
-                          surface->renderCompletes[surface->currentFrameIndex],
-                          surface->flightFences[surface->currentFrameIndex]);
 
-    auto presentResult = swapchain->QueuePresent(presentQueue, surface->renderCompletes[surface->currentFrameIndex]);
-    if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR) {
-        surface->framebufferResized = true;
+    if (swapchain->IsOffscreen()) {
+        // Offscreen images are never acquired from or presented to the surface, the frame only signals its fence.
+        commandBuffer->Submit(VK_NULL_HANDLE, VK_NULL_HANDLE, surface->flightFences[surface->currentFrameIndex]);
+        submittedFrames++;
+        DumpAttachments();
     }
-    else if (presentResult != VK_SUCCESS) {
-        CheckVk(presentResult);
-        Log::Error("Failed to present swap chain image!\n");
+    else {
+        commandBuffer->Submit(surface->presentCompletes[surface->currentFrameIndex],
+                              surface->renderCompletes[surface->currentFrameIndex],
+                              surface->flightFences[surface->currentFrameIndex]);
+        submittedFrames++;
+
+        auto presentResult = swapchain->QueuePresent(presentQueue, surface->renderCompletes[surface->currentFrameIndex]);
+        if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR) {
+            surface->framebufferResized = true;
+        }
+        else if (presentResult != VK_SUCCESS) {
+            CheckVk(presentResult);
+            Log::Error("Failed to present swap chain image!\n");
+        }
     }
 
     surface->currentFrameIndex = (surface->currentFrameIndex + 1) % swapchain->GetImageCount();
 }
 
+void Graphics::DumpAttachments()
+{
+    const auto& headless = Engine::Get()->GetHeadlessSettings();
+    auto        frame    = dumpedFrames++;
+    if (!headless || headless->dumpAttachments.empty()) return;
+
+    // The attachments are read back once the frame has finished, dumping serialises the frames in flight.
+    CheckVk(vkWaitForFences(*logicalDevice, 1, &surface->flightFences[surface->currentFrameIndex], VK_TRUE, std::numeric_limits<uint64_t>::max()));
+
+    auto frameName = std::to_string(frame);
+    frameName.insert(0, frameName.size() < 6 ? 6 - frameName.size() : 0, '0');
+
+    for (const auto& name : headless->dumpAttachments) {
+        auto filename = headless->dumpDirectory / (name + "_" + frameName + ".png");
+
+        if (auto image = dynamic_cast<const Image*>(GetAttachment(name))) {
+            CaptureImage2d(filename, image);
+            continue;
+        }
+
+        auto isSwapchain = std::any_of(renderer->renderStages.begin(), renderer->renderStages.end(), [&name](const auto& renderStage) {
+            auto attachment = renderStage->GetAttachment(name);
+            return attachment && attachment->GetType() == Attachment::Type::Swapchain;
+        });
+        if (isSwapchain)
+            CaptureScreenshot(filename);
+        else if (frame == 0)
+            Log::Warning("Attachment ", std::quoted(name), " can not be dumped, it is not an image attachment of the renderer\n");
+    }
+}
+
 std::string Graphics::StringifyResultVk(VkResult result)
 {
     switch (result) {
@@ -426,13 +747,13 @@ void Graphics::CaptureScreenshot(const std::filesystem::path& filename)
 
     auto size = Devices::Get()->GetWindow()->GetSize();
 
-    VkImage        dstImage;
-    VkDeviceMemory dstImageMemory;
-    auto           supportsBlit = Image::CopyImage(swapchain->GetActiveImage(),
+    VkImage          dstImage;
+    MemoryAllocation dstImageMemory;
+    auto             supportsBlit = Image::CopyImage(swapchain->GetActiveImage(),
                                          dstImage,
                                          dstImageMemory,
                                          surface->GetFormat().format,
-                                                   {size.x, size.y, 1},
+                                                     {size.x, size.y, 1},
                                          VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
                                          0,
                                          0);
@@ -448,14 +769,13 @@ void Graphics::CaptureScreenshot(const std::filesystem::path& filename)
 
     Bitmap bitmap(std::make_unique<uint8_t[]>(dstSubresourceLayout.size), size);
 
-    void* data;
-    vkMapMemory(*logicalDevice, dstImageMemory, dstSubresourceLayout.offset, dstSubresourceLayout.size, 0, &data);
+    // The linear destination image is host visible, its memory stays mapped.
+    auto data = static_cast<uint8_t*>(dstImageMemory.mapped) + dstSubresourceLayout.offset;
     std::memcpy(bitmap.GetData().get(), data, static_cast<size_t>(dstSubresourceLayout.size));
-    vkUnmapMemory(*logicalDevice, dstImageMemory);
 
     // Frees temp image and memory.
-    vkFreeMemory(*logicalDevice, dstImageMemory, nullptr);
     vkDestroyImage(*logicalDevice, dstImage, nullptr);
+    memoryAllocator->Free(dstImageMemory);
 
     // Writes the screenshot bitmap to the file.
     bitmap.Write(filename);
@@ -467,10 +787,10 @@ void Graphics::CaptureScreenshot(const std::filesystem::path& filename)
 
 void Graphics::CaptureImage2d(const std::filesystem::path filename, const Image* image, int mipLevel, int arrayLayer, bool exportAlpha)
 {
-    VkImage        dstImage;
-    VkDeviceMemory dstImageMemory;
-    VkExtent3D     extent = {image->GetExtent().width >> mipLevel, image->GetExtent().height >> mipLevel, 1};
-    auto           supportsBlit =
+    VkImage          dstImage;
+    MemoryAllocation dstImageMemory;
+    VkExtent3D       extent = {image->GetExtent().width >> mipLevel, image->GetExtent().height >> mipLevel, 1};
+    auto             supportsBlit =
         Image::CopyImage(image->GetImage(), dstImage, dstImageMemory, image->GetFormat(), extent, image->GetLayout(), mipLevel, arrayLayer);
 
     VkImageSubresource imageSubresource = {};
@@ -481,8 +801,7 @@ void Graphics::CaptureImage2d(const std::filesystem::path filename, const Image*
     VkSubresourceLayout dstSubresourceLayout;
     vkGetImageSubresourceLayout(*logicalDevice, dstImage, &imageSubresource, &dstSubresourceLayout);
 
-    void* data;
-    vkMapMemory(*logicalDevice, dstImageMemory, dstSubresourceLayout.offset, dstSubresourceLayout.size, 0, &data);
+    auto data = static_cast<uint8_t*>(dstImageMemory.mapped) + dstSubresourceLayout.offset;
 
     Bitmap::SaveImage(filename,
                       extent.width,
@@ -493,9 +812,7 @@ void Graphics::CaptureImage2d(const std::filesystem::path filename, const Image*
                       true,
                       data);
 
-    vkUnmapMemory(*logicalDevice, dstImageMemory);
-
-    vkFreeMemory(*logicalDevice, dstImageMemory, nullptr);
     vkDestroyImage(*logicalDevice, dstImage, nullptr);
+    memoryAllocator->Free(dstImageMemory);
 }
 }   // namespace MapleLeaf
\ No newline at end of file
@@ -2,11 +2,14 @@
 
 #include "CommandPool.hpp"
 #include "Devices.hpp"
+#include "GpuProfiler.hpp"
 #include "Instance.hpp"
 #include "LogicalDevice.hpp"
+#include "MemoryAllocator.hpp"
 #include "PhysicalDevice.hpp"
 #include "RenderStage.hpp"
 #include "Renderer.hpp"
+#include "StagingRing.hpp"
 #include "Surface.hpp"
 #include "Swapchain.hpp"
 
@@ -24,10 +27,21 @@ public:
 
     const PhysicalDevice*  GetPhysicalDevice() const { return physicalDevice.get(); }
     const LogicalDevice*   GetLogicalDevice() const { return logicalDevice.get(); }
+    MemoryAllocator*       GetMemoryAllocator() const { return memoryAllocator.get(); }
+    GpuProfiler*           GetGpuProfiler() const { return gpuProfiler.get(); }
     const Surface*         GetSurface() const { return surface.get(); }
+    const Swapchain*       GetSwapchain() const { return swapchain.get(); }
     const VkPipelineCache& GetPipelineCache() const { return pipelineCache; }
 
     const std::shared_ptr<CommandPool>& GetCommandPool(const std::thread::id& threadId = std::this_thread::get_id());
+    StagingRing*                        GetStagingRing();
+
+    /**
+     * Destroys a buffer once the GPU is done with it, after the staging ring batch that last copied into it and the frames in flight.
+     * @param buffer The buffer to release.
+     * @param uploadToken The token of the last upload into the buffer, 0 if there was none.
+     */
+    void ReleaseBuffer(std::unique_ptr<Buffer>&& buffer, StagingRing::Token uploadToken = 0);
 
     Renderer* GetRenderer() const { return renderer.get(); }
     void      SetRenderer(std::unique_ptr<Renderer>&& renderer);
@@ -35,6 +49,22 @@ public:
     const RenderStage* GetRenderStage(uint32_t index) const;
     const Descriptor*  GetAttachment(const std::string& name) const;
 
+    /**
+     * Begins the render pass of a render stage again after it ended, from a PostRender of that stage.
+     * The attachments are loaded instead of cleared so draws continue on what the stage already rendered, end it with vkCmdEndRenderPass.
+     * @param renderStage The render stage to continue.
+     */
+    void ContinueRenderpass(const RenderStage& renderStage);
+
+    /**
+     * Begins a secondary command buffer of the calling thread that continues a subpass of the render stage being recorded.
+     * Safe to call from thread pool tasks while the main thread waits for them, the buffer is reused once the frame slot comes around again.
+     * @param renderStage The render stage being recorded.
+     * @param subpass The subpass the command buffer continues.
+     * @return The command buffer, with the viewport and scissor of the render stage set.
+     */
+    CommandBuffer& BeginSecondaryCommandBuffer(const RenderStage& renderStage, uint32_t subpass);
+
     static std::string StringifyResultVk(VkResult result);
     static void        CheckVk(VkResult result);
 
@@ -47,28 +77,73 @@ private:
     std::map<std::string, const Descriptor*> attachments;
     std::unique_ptr<Instance>                instance;
 
-    std::unique_ptr<PhysicalDevice> physicalDevice;
-    std::unique_ptr<LogicalDevice>  logicalDevice;
-    std::unique_ptr<Swapchain>      swapchain;
-    std::unique_ptr<Surface>        surface;
+    std::unique_ptr<PhysicalDevice>  physicalDevice;
+    std::unique_ptr<LogicalDevice>   logicalDevice;
+    std::unique_ptr<MemoryAllocator> memoryAllocator;
+    std::unique_ptr<GpuProfiler>     gpuProfiler;
+    std::unique_ptr<Swapchain>       swapchain;
+    std::unique_ptr<Surface>         surface;
 
     std::map<std::thread::id, std::shared_ptr<CommandPool>> commandPools;
+    std::mutex                                              commandPoolsMutex;
+
+    struct SecondaryCommandBuffers
+    {
+        std::vector<std::unique_ptr<CommandBuffer>> commandBuffers;
+        std::size_t                                 usedCount = 0;
+    };
+
+    // Secondary command buffers by frame slot and recording thread, each thread allocates from its own command pool.
+    std::map<std::pair<std::size_t, std::thread::id>, SecondaryCommandBuffers> secondaryCommandBuffers;
+    std::mutex                                                                 secondaryCommandBuffersMutex;
+
+    struct ReleasedBuffer
+    {
+        std::unique_ptr<Buffer> buffer;
+        StagingRing::Token      uploadToken;
+        uint64_t                frame;
+    };
+
+    // Buffers waiting for the GPU, released during the frame numbered frame, and the number of frames submitted so far.
+    std::deque<ReleasedBuffer> releasedBuffers;
+    std::mutex                 releasedBuffersMutex;
+    uint64_t                   submittedFrames = 0;
+
+    // Created on first use, buffers can't be created before the module is registered.
+    std::unique_ptr<StagingRing> stagingRing;
+    std::once_flag               stagingRingFlag;
+
     // Timer used to remove unused command pools.
     ElapsedTime elapsedPurge;
+    // Timer used to flush the pipeline cache to disk.
+    ElapsedTime elapsedPipelineCacheFlush;
 
     VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    // Hash of the cache contents last loaded or saved.
+    std::size_t pipelineCacheHash = 0;
 
+    // Frames submitted to an offscreen swapchain, names the attachments dumped in headless mode.
+    uint64_t dumpedFrames = 0;
+
+    void DestroyReleasedBuffers();
     void CreatePipelineCache();
+    void SavePipelineCache();
     void ResetRenderStages();
     void RecreateSwapchain();
     void RecreateCommandBuffers();
     void RecreatePass(RenderStage& renderStage);
     void RecreateAttachmentsMap();
     bool StartRecordCommandBuffer(RenderStage& renderStage);
-    void StartRenderpass(RenderStage& renderStage);
+    void StartRenderpass(const RenderStage& renderStage, bool load = false, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+    static void SetViewportAndScissor(const CommandBuffer& commandBuffer, const RenderStage& renderStage);
     void EndRenderpass(RenderStage& renderStage);
     void EndRecordCommandBuffer(RenderStage& renderStage);
+    void DumpAttachments();
 
     void RegisterImGui();
+
+    static bool                  IsPipelineCacheValid(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties);
+    static std::size_t           HashPipelineCache(const std::vector<char>& data);
+    static std::filesystem::path GetPipelineCachePath();
 };
 }   // namespace MapleLeaf
\ No newline at end of file
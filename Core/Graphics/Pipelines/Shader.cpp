@@ -3,6 +3,7 @@
 #include "Files.hpp"
 #include "Graphics.hpp"
 #include "Log.hpp"
+#include "ShaderCache.hpp"
 #include "StorageBuffer.hpp"
 #include "UniformBuffer.hpp"
 
@@ -361,10 +362,10 @@ VkShaderModule Shader::CreateShaderModule(const std::filesystem::path& moduleNam
     shader.setPreamble(preamble.c_str());
 
     auto defaultVersion = glslang::EShTargetVulkan_1_4;
+    auto targetSpv      = volkGetInstanceVersion() >= VK_API_VERSION_1_3 ? glslang::EShTargetSpv_1_6 : glslang::EShTargetSpv_1_3;
     shader.setEnvInput(glslang::EShSourceGlsl, language, glslang::EShClientVulkan, 460);
     shader.setEnvClient(glslang::EShClientVulkan, defaultVersion);
-    shader.setEnvTarget(glslang::EShTargetSpv,
-                        volkGetInstanceVersion() >= VK_API_VERSION_1_3 ? glslang::EShTargetSpv_1_6 : glslang::EShTargetSpv_1_3);
+    shader.setEnvTarget(glslang::EShTargetSpv, targetSpv);
 
     ShaderIncluder includer;
 
@@ -376,18 +377,6 @@ VkShaderModule Shader::CreateShaderModule(const std::filesystem::path& moduleNam
         Log::Error("SPRIV shader preprocess failed!\n");
     }
 
-    if (!shader.parse(&resources, defaultVersion, true, messages, includer)) {
-        Log::Out(shader.getInfoLog(), '\n');
-        Log::Out(shader.getInfoDebugLog(), '\n');
-        Log::Error("SPRIV shader parse failed!\n");
-    }
-
-    program.addShader(&shader);
-
-    if (!program.link(messages) || !program.mapIO()) {
-        Log::Error("Error while linking shader program.\n");
-    }
-
     glslang::SpvOptions spvOptions;
 
 #ifdef MAPLELEAF_SHADER_DEBUG
@@ -400,9 +389,36 @@ VkShaderModule Shader::CreateShaderModule(const std::filesystem::path& moduleNam
     spvOptions.optimizeSize      = true;
 #endif
 
-    spv::SpvBuildLogger   logger;
     std::vector<uint32_t> spirv;
-    GlslangToSpv(*program.getIntermediate(static_cast<EShLanguage>(language)), spirv, &logger, &spvOptions);
+
+#ifdef MAPLELEAF_SHADER_CACHE
+    // The preprocessed source has every include and define expanded, so together with the compile options it identifies the module.
+    auto cacheKey = ShaderCache::GetKey(str, preamble, moduleFlag, targetSpv, spvOptions.generateDebugInfo);
+    bool cached   = ShaderCache::Load(cacheKey, spirv);
+#else
+    bool cached = false;
+#endif
+
+    if (!cached) {
+        if (!shader.parse(&resources, defaultVersion, true, messages, includer)) {
+            Log::Out(shader.getInfoLog(), '\n');
+            Log::Out(shader.getInfoDebugLog(), '\n');
+            Log::Error("SPRIV shader parse failed!\n");
+        }
+
+        program.addShader(&shader);
+
+        if (!program.link(messages) || !program.mapIO()) {
+            Log::Error("Error while linking shader program.\n");
+        }
+
+        spv::SpvBuildLogger logger;
+        GlslangToSpv(*program.getIntermediate(static_cast<EShLanguage>(language)), spirv, &logger, &spvOptions);
+
+#ifdef MAPLELEAF_SHADER_CACHE
+        ShaderCache::Save(cacheKey, spirv);
+#endif
+    }
 
     SpvReflectShaderModule module;
     SpvReflectResult       result = spvReflectCreateShaderModule(spirv.size() * sizeof(uint32_t), spirv.data(), &module);
@@ -0,0 +1,104 @@
+#include "ShaderCache.hpp"
+#include "Log.hpp"
+#include "Maths.hpp"
+
+#include "glslang/Public/ShaderLang.h"
+
+#include "config.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace MapleLeaf {
+uint64_t ShaderCache::GetKey(const std::string& preprocessed, const std::string& preamble, VkShaderStageFlags stageFlag, uint32_t targetSpv,
+                             bool debugInfo)
+{
+    auto glslangVersion = glslang::GetVersion();
+
+    uint64_t key = Maths::HashFNV1a(&Version, sizeof(Version));
+    key          = Maths::HashFNV1a(&glslangVersion.major, sizeof(glslangVersion.major), key);
+    key          = Maths::HashFNV1a(&glslangVersion.minor, sizeof(glslangVersion.minor), key);
+    key          = Maths::HashFNV1a(&glslangVersion.patch, sizeof(glslangVersion.patch), key);
+    key          = Maths::HashFNV1a(&stageFlag, sizeof(stageFlag), key);
+    key          = Maths::HashFNV1a(&targetSpv, sizeof(targetSpv), key);
+    key          = Maths::HashFNV1a(&debugInfo, sizeof(debugInfo), key);
+    key          = Maths::HashFNV1a(preamble.data(), preamble.size(), key);
+    key          = Maths::HashFNV1a(preprocessed.data(), preprocessed.size(), key);
+    return key;
+}
+
+bool ShaderCache::Load(uint64_t key, std::vector<uint32_t>& spirv)
+{
+    auto path = GetPath(key);
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    Header header = {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(Header))) return false;
+    if (header.magic != Magic || header.version != Version || header.key != key || header.codeSize == 0) {
+        Log::Warning("Shader cache ", path, " is stale, recompiling\n");
+        return false;
+    }
+
+    spirv.resize(header.codeSize);
+    if (!file.read(reinterpret_cast<char*>(spirv.data()), header.codeSize * sizeof(uint32_t)) ||
+        Maths::HashFNV1a(spirv.data(), spirv.size() * sizeof(uint32_t)) != header.codeHash || spirv.front() != 0x07230203) {
+        Log::Warning("Shader cache ", path, " is corrupted, recompiling\n");
+        spirv.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void ShaderCache::Save(uint64_t key, const std::vector<uint32_t>& spirv)
+{
+    if (spirv.empty()) return;
+
+    auto path = GetPath(key);
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    std::stringstream tempName;
+    tempName << path.filename().string() << '.' << std::this_thread::get_id() << ".tmp";
+    auto tempPath = path.parent_path() / tempName.str();
+
+    Header header   = {};
+    header.magic    = Magic;
+    header.version  = Version;
+    header.key      = key;
+    header.codeSize = spirv.size();
+    header.codeHash = Maths::HashFNV1a(spirv.data(), spirv.size() * sizeof(uint32_t));
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            Log::Warning("Failed to write shader cache ", tempPath, '\n');
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        file.write(reinterpret_cast<const char*>(spirv.data()), spirv.size() * sizeof(uint32_t));
+    }
+
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        Log::Warning("Failed to write shader cache ", path, ": ", error.message(), '\n');
+        std::filesystem::remove(tempPath, error);
+    }
+}
+
+std::filesystem::path ShaderCache::GetDirectory()
+{
+    return std::filesystem::path(CONFIG_PROJECT_DIR) / "Cache" / "Shaders";
+}
+
+std::filesystem::path ShaderCache::GetPath(uint64_t key)
+{
+    std::stringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << key << ".spv";
+    return GetDirectory() / name.str();
+}
+}   // namespace MapleLeaf
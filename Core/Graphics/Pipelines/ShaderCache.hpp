@@ -0,0 +1,60 @@
+#pragma once
+
+#include "volk.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace MapleLeaf {
+/**
+ * Content addressed on-disk cache of compiled SPIR-V, keyed on the preprocessed shader source so that every include and define is covered.
+ */
+class ShaderCache
+{
+public:
+    /**
+     * Builds the cache key of a shader module.
+     * @param preprocessed The glslang preprocessed source, with every include expanded.
+     * @param preamble The define block prepended to the source.
+     * @param stageFlag The shader stage.
+     * @param targetSpv The SPIR-V target version.
+     * @param debugInfo If the SPIR-V is generated with debug info and without optimization.
+     * @return The key.
+     */
+    static uint64_t GetKey(const std::string& preprocessed, const std::string& preamble, VkShaderStageFlags stageFlag, uint32_t targetSpv,
+                           bool debugInfo);
+
+    /**
+     * Loads the SPIR-V stored for a key, the file is rejected if its header, size or checksum does not match.
+     * @param key The cache key.
+     * @param spirv The SPIR-V code read.
+     * @return If the SPIR-V was found and valid.
+     */
+    static bool Load(uint64_t key, std::vector<uint32_t>& spirv);
+
+    /**
+     * Stores the SPIR-V of a key, written to a temporary file first so concurrent readers never see a partial file.
+     * @param key The cache key.
+     * @param spirv The SPIR-V code.
+     */
+    static void Save(uint64_t key, const std::vector<uint32_t>& spirv);
+
+    static std::filesystem::path GetDirectory();
+
+private:
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint64_t codeSize;
+        uint64_t codeHash;
+    };
+
+    static constexpr uint32_t Magic   = 0x43534c4d;   // "MLSC"
+    static constexpr uint32_t Version = 1;
+
+    static std::filesystem::path GetPath(uint64_t key);
+};
+}   // namespace MapleLeaf
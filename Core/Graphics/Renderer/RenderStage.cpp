@@ -82,13 +82,19 @@ void RenderStage::Rebuild(const Swapchain& swapchain)
     if (depthAttachment)
         depthStencil = std::make_unique<ImageDepth>(renderArea.GetExtent(), depthAttachment->IsMultisampled() ? msaaSamples : VK_SAMPLE_COUNT_1_BIT);
 
-    if (!renderpass)
-        renderpass = std::make_unique<Renderpass>(
-            *logicalDevice, *this, depthStencil ? depthStencil->GetFormat() : VK_FORMAT_UNDEFINED, surface->GetFormat().format, msaaSamples);
+    if (!renderpass) {
+        auto depthFormat = depthStencil ? depthStencil->GetFormat() : VK_FORMAT_UNDEFINED;
+        renderpass       = std::make_unique<Renderpass>(*logicalDevice, *this, depthFormat, surface->GetFormat().format, msaaSamples);
+        loadRenderpass =
+            std::make_unique<Renderpass>(*logicalDevice, *this, depthFormat, surface->GetFormat().format, msaaSamples, VK_ATTACHMENT_LOAD_OP_LOAD);
+    }
 
     framebuffers = std::make_unique<Framebuffers>(*logicalDevice, swapchain, *this, *renderpass, *depthStencil, renderArea.GetExtent(), msaaSamples);
     outOfDate    = false;
 
+    // The attachments were recreated, there is nothing to load.
+    contentsValid = false;
+
     descriptors.clear();
     auto where = descriptors.end();
 
@@ -178,7 +178,20 @@ public:
     bool IsOutOfDate() const { return outOfDate; }
     Type GetRenderStageType() const { return stageType; }
 
+    /**
+     * Keeps the attachments across frames, the render pass then loads what the stage rendered last time instead of clearing it.
+     * Subrenders clear the regions they draw again themselves.
+     * @param keepContents If the attachments are kept.
+     */
+    void SetKeepContents(bool keepContents) { this->keepContents = keepContents; }
+    /**
+     * Checks if the render pass of this frame loads the attachments, they are cleared on the first frame after a rebuild.
+     * @return If the attachments hold what the stage rendered last time.
+     */
+    bool IsContentsLoaded() const { return keepContents && contentsValid; }
+
     const Renderpass*   GetRenderpass() const { return renderpass.get(); }
+    const Renderpass*   GetLoadRenderpass() const { return loadRenderpass.get(); }
     const ImageDepth*   GetDepthStencil() const { return depthStencil.get(); }
     const Framebuffers* GetFramebuffers() const { return framebuffers.get(); }
 
@@ -196,6 +209,7 @@ private:
     Viewport viewport;
 
     std::unique_ptr<Renderpass>   renderpass;
+    std::unique_ptr<Renderpass>   loadRenderpass;
     std::unique_ptr<ImageDepth>   depthStencil;
     std::unique_ptr<Framebuffers> framebuffers;
 
@@ -211,6 +225,8 @@ private:
     RenderArea renderArea;
 
     Type stageType;
-    bool outOfDate = false;
+    bool outOfDate     = false;
+    bool keepContents  = false;
+    bool contentsValid = false;
 };
 }   // namespace MapleLeaf
\ No newline at end of file
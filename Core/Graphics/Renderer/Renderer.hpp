@@ -52,8 +52,17 @@ public:
 
     void ClearSubrenders() { subrenderHolder.Clear(); }
 
+    bool IsParallelRecording() const { return parallelRecording; }
+    /**
+     * Records the Subrenders of a render stage into secondary command buffers on the thread pool, each Subrender on its own task.
+     * Off by default, the Render of every Subrender must then be safe to run alongside the others of its render stage.
+     * @param parallelRecording If Subrenders are recorded in parallel.
+     */
+    void SetParallelRecording(bool parallelRecording) { this->parallelRecording = parallelRecording; }
+
 private:
-    bool                                      started = false;
+    bool                                      started           = false;
+    bool                                      parallelRecording = false;
     std::vector<std::unique_ptr<RenderStage>> renderStages;
     SubrenderHolder                           subrenderHolder;
 };
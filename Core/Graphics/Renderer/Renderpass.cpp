@@ -7,7 +7,7 @@
 
 namespace MapleLeaf {
 Renderpass::Renderpass(const LogicalDevice& logicalDevice, const RenderStage& renderStage, VkFormat depthFormat, VkFormat surfaceFormat,
-                       VkSampleCountFlagBits samples)
+                       VkSampleCountFlagBits samples, VkAttachmentLoadOp loadOp)
     : logicalDevice(logicalDevice)
 {
     std::vector<VkAttachmentDescription> attachmentDescriptions;
@@ -17,7 +17,7 @@ Renderpass::Renderpass(const LogicalDevice& logicalDevice, const RenderStage& re
 
         VkAttachmentDescription attachmentDescription = {};
         attachmentDescription.samples                 = attachmentSamples;
-        attachmentDescription.loadOp                  = VK_ATTACHMENT_LOAD_OP_CLEAR;   // Clear at beginning of the render pass.
+        attachmentDescription.loadOp                  = loadOp;   // Clear at beginning of the render pass unless continuing the stage.
         // The image can be read from so it's important to store the attachment results
         attachmentDescription.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
         attachmentDescription.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
@@ -39,6 +39,9 @@ Renderpass::Renderpass(const LogicalDevice& logicalDevice, const RenderStage& re
             break;
         }
 
+        // Loaded contents must keep their layout, the stage left them in the final layout.
+        if (loadOp == VK_ATTACHMENT_LOAD_OP_LOAD) attachmentDescription.initialLayout = attachmentDescription.finalLayout;
+
         attachmentDescriptions.emplace_back(attachmentDescription);
     }
 
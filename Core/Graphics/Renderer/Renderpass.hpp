@@ -45,8 +45,13 @@ public:
         VkAttachmentReference              depthStencilAttachment = {};
     };
 
+    /**
+     * Creates the render pass of a render stage.
+     * @param loadOp VK_ATTACHMENT_LOAD_OP_LOAD creates a pass compatible with the stage's framebuffers that continues on what the stage has already
+     * rendered, the attachments are expected in the layouts the stage leaves them in.
+     */
     Renderpass(const LogicalDevice& logicalDevice, const RenderStage& renderStage, VkFormat depthFormat, VkFormat surfaceFormat,
-               VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT);
+               VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT, VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR);
     ~Renderpass();
 
     operator const VkRenderPass&() const { return renderpass; }
@@ -1,4 +1,6 @@
 #include "SubrenderHolder.hpp"
+#include "Graphics.hpp"
+#include "Resources.hpp"
 
 namespace MapleLeaf {
 void SubrenderHolder::Clear()
@@ -27,6 +29,9 @@ void SubrenderHolder::PreRenderStage(const Pipeline::Stage& stage, const Command
 
         if (auto& subrender = subrenders[typeId]) {
             if (subrender->IsEnabled()) {
+                const auto&        zoneName = zoneNames[typeId].preRender;
+                Profiler::Scope    cpuZone(zoneName);
+                GpuProfiler::Scope gpuZone(Graphics::Get()->GetGpuProfiler(), commandBuffer, zoneName);
                 subrender->PreRender(commandBuffer);
             }
         }
@@ -42,6 +47,9 @@ void SubrenderHolder::RenderStage(const Pipeline::Stage& stage, const CommandBuf
 
         if (auto& subrender = subrenders[typeId]) {
             if (subrender->IsEnabled()) {
+                const auto&        zoneName = zoneNames[typeId].render;
+                Profiler::Scope    cpuZone(zoneName);
+                GpuProfiler::Scope gpuZone(Graphics::Get()->GetGpuProfiler(), commandBuffer, zoneName);
                 subrender->Render(commandBuffer);
                 subrender->RegisterImGui();
             }
@@ -49,6 +57,59 @@ void SubrenderHolder::RenderStage(const Pipeline::Stage& stage, const CommandBuf
     }
 }
 
+std::vector<std::vector<VkCommandBuffer>> SubrenderHolder::RecordStages(const std::vector<Pipeline::Stage>&             stages,
+                                                                        const std::function<CommandBuffer&(uint32_t)>& beginSecondary)
+{
+    struct Recording
+    {
+        std::size_t            subpass;
+        Subrender*             subrender;
+        Future<CommandBuffer*> commandBuffer;
+    };
+
+    auto&                  threadPool  = Resources::Get()->GetThreadPool();
+    auto*                  gpuProfiler = Graphics::Get()->GetGpuProfiler();
+    std::vector<Recording> recordings;
+
+    // Zones and tasks are created in Subrender order, the tasks only touch their Subrender and their command buffer.
+    for (std::size_t i = 0; i < stages.size(); i++) {
+        for (const auto& [stageIndex, typeId] : this->stages) {
+            if (stageIndex.first != stages[i]) {
+                continue;
+            }
+
+            auto& subrender = subrenders[typeId];
+            if (!subrender || !subrender->IsEnabled()) continue;
+
+            // The names outlive the tasks, Subrenders are not added or removed while recording.
+            auto zoneName = std::string_view(zoneNames[typeId].render);
+            auto gpuZone  = gpuProfiler->ReserveZone(zoneName);
+            auto subpass  = stages[i].second;
+
+            auto commandBuffer = threadPool.Enqueue(
+                Task::Priority::Critical, [&beginSecondary, subrender = subrender.get(), zoneName, gpuZone, subpass]() -> CommandBuffer* {
+                    Profiler::Scope cpuZone(zoneName);
+                    auto&           secondary = beginSecondary(subpass);
+                    GpuProfiler::BeginReservedZone(secondary, gpuZone);
+                    subrender->Render(secondary);
+                    GpuProfiler::EndReservedZone(secondary, gpuZone);
+                    secondary.End();
+                    return &secondary;
+                });
+            recordings.push_back({i, subrender.get(), std::move(commandBuffer)});
+        }
+    }
+
+    std::vector<std::vector<VkCommandBuffer>> commandBuffers(stages.size());
+    for (auto& recording : recordings) {
+        commandBuffers[recording.subpass].push_back(*recording.commandBuffer.get());
+
+        // ImGui is only used from the main thread.
+        recording.subrender->RegisterImGui();
+    }
+    return commandBuffers;
+}
+
 void SubrenderHolder::PostRenderStage(const Pipeline::Stage& stage, const CommandBuffer& commandBuffer)
 {
     for (const auto& [stageIndex, typeId] : stages) {
@@ -58,6 +119,9 @@ void SubrenderHolder::PostRenderStage(const Pipeline::Stage& stage, const Comman
 
         if (auto& subrender = subrenders[typeId]) {
             if (subrender->IsEnabled()) {
+                const auto&        zoneName = zoneNames[typeId].postRender;
+                Profiler::Scope    cpuZone(zoneName);
+                GpuProfiler::Scope gpuZone(Graphics::Get()->GetGpuProfiler(), commandBuffer, zoneName);
                 subrender->PostRender(commandBuffer);
             }
         }
@@ -3,7 +3,10 @@
 #include "NonCopyable.hpp"
 #include "Pipeline.hpp"
 #include "Subrender.hpp"
+#include <functional>
 #include <map>
+#include <string>
+#include <typeinfo>
 
 namespace MapleLeaf {
 class SubrenderHolder : NonCopyable
@@ -60,6 +63,9 @@ public:
 
         // Then, add the Subrender
         subrenders[typeId] = std::move(subrender);
+
+        auto name         = std::string(typeid(*subrenders[typeId]).name());
+        zoneNames[typeId] = {name + "::PreRender", name + "::Render", name + "::PostRender"};
         return static_cast<T*>(subrenders[typeId].get());
     }
 
@@ -77,6 +83,7 @@ public:
 
         // Then, remove the Subrender.
         subrenders.erase(typeId);
+        zoneNames.erase(typeId);
     }
 
     /**
@@ -102,11 +109,29 @@ private:
      */
     void RenderStage(const Pipeline::Stage& stage, const CommandBuffer& commandBuffer);
 
+    /**
+     * Records the Subrenders of every subpass of a render stage on the thread pool, each into its own secondary command buffer.
+     * @param stages The Subrender stage of every subpass, in subpass order.
+     * @param beginSecondary Begins a secondary command buffer of the calling thread that continues the given subpass.
+     * @return The secondary command buffers of every subpass in Subrender order, to execute in the primary command buffer.
+     */
+    std::vector<std::vector<VkCommandBuffer>> RecordStages(const std::vector<Pipeline::Stage>&             stages,
+                                                           const std::function<CommandBuffer&(uint32_t)>& beginSecondary);
+
     void PostRenderStage(const Pipeline::Stage& stage, const CommandBuffer& commandBuffer);
 
     /// List of all Subrenders.
     std::unordered_map<TypeId, std::unique_ptr<Subrender>> subrenders;
     /// List of subrender stages.
     std::multimap<StageIndex, TypeId> stages;
+
+    // Profiler zone names of every Subrender, built once when it is added instead of every frame.
+    struct ZoneNames
+    {
+        std::string preRender;
+        std::string render;
+        std::string postRender;
+    };
+    std::unordered_map<TypeId, ZoneNames> zoneNames;
 };
 }   // namespace MapleLeaf
\ No newline at end of file
@@ -1,9 +1,11 @@
 #include "Buffer.hpp"
 #include "Graphics.hpp"
+#include <algorithm>
 #include <array>
+#include <cstring>
 
 namespace MapleLeaf {
-Buffer::Buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, const void* data, bool align)
+Buffer::Buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, const void* data, bool align, bool transient)
 {
     auto logicalDevice  = Graphics::Get()->GetLogicalDevice();
     auto physicalDevice = Graphics::Get()->GetPhysicalDevice();
@@ -28,40 +30,19 @@ Buffer::Buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlag
     bufferCreateInfo.pQueueFamilyIndices   = queueFamily.data();
     Graphics::CheckVk(vkCreateBuffer(*logicalDevice, &bufferCreateInfo, nullptr, &buffer));
 
-    // Create the memory backing up the buffer handle.
-    VkMemoryAllocateFlagsInfo memoryAllocateFlagsInfo = {};
-    memoryAllocateFlagsInfo.sType                     = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
-    memoryAllocateFlagsInfo.flags                     = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
-
-    VkMemoryRequirements memoryRequirements;
-    vkGetBufferMemoryRequirements(*logicalDevice, buffer, &memoryRequirements);
-    VkMemoryAllocateInfo memoryAllocateInfo = {};
-    memoryAllocateInfo.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memoryAllocateInfo.allocationSize       = memoryRequirements.size;
-    memoryAllocateInfo.memoryTypeIndex      = FindMemoryType(memoryRequirements.memoryTypeBits, properties);
-    memoryAllocateInfo.pNext                = &memoryAllocateFlagsInfo;
-    Graphics::CheckVk(vkAllocateMemory(*logicalDevice, &memoryAllocateInfo, nullptr, &bufferMemory));
-
-    // If a pointer to the buffer data has been passed, map the buffer and copy over the data.
+    // Sub-allocate the memory backing up the buffer handle, staging buffers are short lived and go to a linear pool.
+    auto memoryAllocator = Graphics::Get()->GetMemoryAllocator();
+    allocation           = memoryAllocator->AllocateBuffer(buffer, properties, transient);
+
+    // If a pointer to the buffer data has been passed, copy over the data into the persistently mapped memory.
     if (data) {
-        void* mapped;
-        MapMemory(&mapped);
-        std::memcpy(mapped, data, size);
+        std::memcpy(allocation.mapped, data, size);
 
         // If host coherency hasn't been requested, do a manual flush to make writes visible.
-        if ((properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == 0) {
-            VkMappedMemoryRange mappedMemoryRange = {};
-            mappedMemoryRange.sType               = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-            mappedMemoryRange.memory              = bufferMemory;
-            mappedMemoryRange.offset              = 0;
-            mappedMemoryRange.size                = size;
-            vkFlushMappedMemoryRanges(*logicalDevice, 1, &mappedMemoryRange);
-        }
-
-        UnmapMemory();
+        if ((properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == 0) memoryAllocator->FlushMappedMemory(allocation, 0, size);
     }
     // Attach the memory to the buffer object.
-    Graphics::CheckVk(vkBindBufferMemory(*logicalDevice, buffer, bufferMemory, 0));
+    Graphics::CheckVk(vkBindBufferMemory(*logicalDevice, buffer, allocation.memory, allocation.offset));
 
     VkBufferDeviceAddressInfo bufferDeviceAddressInfo = {};
     bufferDeviceAddressInfo.sType                     = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
@@ -84,44 +65,39 @@ Buffer::~Buffer()
     // Graphics::CheckVk(vkDeviceWaitIdle(*logicalDevice));
 
     vkDestroyBuffer(*logicalDevice, buffer, nullptr);
-    vkFreeMemory(*logicalDevice, bufferMemory, nullptr);
+    Graphics::Get()->GetMemoryAllocator()->Free(allocation);
 }
 
 void Buffer::MapMemory(void** data) const
 {
-    auto logicalDevice = Graphics::Get()->GetLogicalDevice();
-    Graphics::CheckVk(vkMapMemory(*logicalDevice, bufferMemory, 0, size, 0, data));
+    // Host visible allocations stay mapped for their whole lifetime.
+    *data = allocation.mapped;
 }
 
-void Buffer::UnmapMemory() const
+void Buffer::UnmapMemory() const {}
+
+void Buffer::FlushMappedMemory(VkDeviceSize size) const
 {
-    auto logicalDevice = Graphics::Get()->GetLogicalDevice();
-    vkUnmapMemory(*logicalDevice, bufferMemory);
+    Graphics::Get()->GetMemoryAllocator()->FlushMappedMemory(allocation, 0, size);
 }
 
-void Buffer::FlushMappedMemory(VkDeviceSize size) const
+void Buffer::Update(const void* newData, const std::vector<VkBufferCopy>& regions)
 {
-    auto                logicalDevice     = Graphics::Get()->GetLogicalDevice();
-    VkMappedMemoryRange mappedMemoryRange = {};
-    mappedMemoryRange.sType               = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    mappedMemoryRange.memory              = bufferMemory;
-    mappedMemoryRange.offset              = 0;
-    mappedMemoryRange.size                = size;
-    vkFlushMappedMemoryRanges(*logicalDevice, 1, &mappedMemoryRange);
+    if (regions.empty()) return;
+
+    void* data = nullptr;
+    MapMemory(&data);
+    for (const auto& region : regions)
+        std::memcpy(static_cast<char*>(data) + region.dstOffset, static_cast<const char*>(newData) + region.srcOffset, region.size);
+    FlushMappedMemory();
+    UnmapMemory();
 }
 
 uint32_t Buffer::FindMemoryType(uint32_t typeFilter, const VkMemoryPropertyFlags& requiredProperties)
 {
-    auto physicalDevice   = Graphics::Get()->GetPhysicalDevice();
-    auto memoryProperties = physicalDevice->GetMemoryProperties();
-
-    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
-        uint32_t memoryTypeBits = 1 << i;
+    auto physicalDevice = Graphics::Get()->GetPhysicalDevice();
 
-        if (typeFilter & memoryTypeBits && (memoryProperties.memoryTypes[i].propertyFlags & requiredProperties) == requiredProperties) {
-            return i;
-        }
-    }
+    if (auto memoryType = MemoryAllocator::FindMemoryType(physicalDevice->GetMemoryProperties(), typeFilter, requiredProperties)) return *memoryType;
 
     throw std::runtime_error("Failed to find a valid memory type for buffer");
 }
@@ -141,4 +117,32 @@ void Buffer::InsertBufferMemoryBarrier(const CommandBuffer& commandBuffer, const
     bufferMemoryBarrier.size                  = size;
     vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
 }
+
+std::vector<VkBufferCopy> Buffer::CoalesceRanges(std::vector<uint32_t>& indices, VkDeviceSize stride)
+{
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    auto regions = CoalesceSortedRanges(indices, stride);
+    indices.clear();
+    return regions;
+}
+
+std::vector<VkBufferCopy> Buffer::CoalesceSortedRanges(const std::vector<uint32_t>& indices, VkDeviceSize stride)
+{
+    std::vector<VkBufferCopy> regions;
+    for (std::size_t first = 0; first < indices.size();) {
+        std::size_t last = first;
+        while (last + 1 < indices.size() && indices[last + 1] == indices[last] + 1) last++;
+
+        VkBufferCopy region = {};
+        region.srcOffset    = indices[first] * stride;
+        region.dstOffset    = region.srcOffset;
+        region.size         = (last - first + 1) * stride;
+        regions.push_back(region);
+
+        first = last + 1;
+    }
+    return regions;
+}
 }   // namespace MapleLeaf
\ No newline at end of file
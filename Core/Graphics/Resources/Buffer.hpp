@@ -1,8 +1,11 @@
 #pragma once
 
 #include "CommandBuffer.hpp"
+#include "MemoryAllocator.hpp"
 #include "volk.h"
 
+#include <vector>
+
 namespace MapleLeaf {
 class Buffer
 {
@@ -14,27 +17,60 @@ public:
         Normal
     };
 
-    Buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, const void* data = nullptr, bool align = false);
+    /**
+     * Creates a buffer with memory sub-allocated from the memory allocator.
+     * @param size The size in bytes.
+     * @param usage The usage flags.
+     * @param properties The memory properties.
+     * @param data Data copied into the buffer if it is host visible.
+     * @param align If the size is rounded up to the non coherent atom size.
+     * @param transient If the buffer is short lived, such as a staging buffer, its memory then comes from a linear pool.
+     */
+    Buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, const void* data = nullptr, bool align = false,
+           bool transient = false);
     virtual ~Buffer();
 
     void MapMemory(void** data) const;
     void UnmapMemory() const;
     void FlushMappedMemory(VkDeviceSize size = VK_WHOLE_SIZE) const;
 
-    VkDeviceSize          GetSize() const { return size; }
-    const VkBuffer&       GetBuffer() const { return buffer; }
-    const VkDeviceMemory& GetBufferMemory() const { return bufferMemory; }
-    VkDeviceAddress       GetDeviceAddress() const { return deviceAddress; }
+    /**
+     * Copies regions of an array into the host visible buffer, such as the ones built by CoalesceRanges.
+     * @param newData The source array.
+     * @param regions The regions to copy, offsets are in bytes into the source and the buffer.
+     */
+    void Update(const void* newData, const std::vector<VkBufferCopy>& regions);
+
+    VkDeviceSize            GetSize() const { return size; }
+    const VkBuffer&         GetBuffer() const { return buffer; }
+    const MemoryAllocation& GetAllocation() const { return allocation; }
+    VkDeviceAddress         GetDeviceAddress() const { return deviceAddress; }
 
     static uint32_t FindMemoryType(uint32_t typeFilter, const VkMemoryPropertyFlags& requiredProperties);
     static void     InsertBufferMemoryBarrier(const CommandBuffer& commandBuffer, const VkBuffer& buffer, VkAccessFlags srcAccessMask,
                                               VkAccessFlags dstAccessMask, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask,
                                               VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
 
+    /**
+     * Merges changed elements of an array into as few copy regions as possible, with the same offsets in the source and the buffer.
+     * @param indices The changed element indices, in any order and with duplicates. Cleared once the regions are built.
+     * @param stride The size of one element.
+     * @return The regions of consecutive changed elements.
+     */
+    static std::vector<VkBufferCopy> CoalesceRanges(std::vector<uint32_t>& indices, VkDeviceSize stride);
+
+    /**
+     * Merges changed elements of an array into copy regions like CoalesceRanges, for indices that are already in order.
+     * @param indices The changed element indices, ascending and without duplicates.
+     * @param stride The size of one element.
+     * @return The regions of consecutive changed elements.
+     */
+    static std::vector<VkBufferCopy> CoalesceSortedRanges(const std::vector<uint32_t>& indices, VkDeviceSize stride);
+
 protected:
-    VkDeviceSize    size;
-    VkDeviceAddress deviceAddress = 0;
-    VkBuffer        buffer        = VK_NULL_HANDLE;
-    VkDeviceMemory  bufferMemory  = VK_NULL_HANDLE;
+    VkDeviceSize     size;
+    VkDeviceAddress  deviceAddress = 0;
+    VkBuffer         buffer        = VK_NULL_HANDLE;
+    MemoryAllocation allocation;
 };
 }   // namespace MapleLeaf
\ No newline at end of file
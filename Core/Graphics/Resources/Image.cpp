@@ -24,8 +24,8 @@ Image::~Image()
     vkDestroyImageView(*logicalDevice, view, nullptr);
     for (auto mipView : mipViews) vkDestroyImageView(*logicalDevice, mipView, nullptr);
     vkDestroySampler(*logicalDevice, sampler, nullptr);
-    vkFreeMemory(*logicalDevice, memory, nullptr);
     vkDestroyImage(*logicalDevice, image, nullptr);
+    Graphics::Get()->GetMemoryAllocator()->Free(memory);
 }
 
 WriteDescriptorSet Image::GetWriteDescriptor(uint32_t binding, VkDescriptorType descriptorType, const std::optional<OffsetSize>& offsetSize) const
@@ -123,7 +123,7 @@ bool Image::HasStencil(VkFormat format)
     return std::find(STENCIL_FORMATS.begin(), STENCIL_FORMATS.end(), format) != std::end(STENCIL_FORMATS);
 }
 
-void Image::CreateImage(VkImage& image, VkDeviceMemory& memory, const VkExtent3D& extent, VkFormat format, VkSampleCountFlagBits samples,
+void Image::CreateImage(VkImage& image, MemoryAllocation& memory, const VkExtent3D& extent, VkFormat format, VkSampleCountFlagBits samples,
                         VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, uint32_t mipLevels, uint32_t arrayLayers,
                         VkImageType type)
 {
@@ -143,16 +143,8 @@ void Image::CreateImage(VkImage& image, VkDeviceMemory& memory, const VkExtent3D
     imageCreateInfo.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
     Graphics::CheckVk(vkCreateImage(*logicalDevice, &imageCreateInfo, nullptr, &image));
 
-    VkMemoryRequirements memoryRequirements;
-    vkGetImageMemoryRequirements(*logicalDevice, image, &memoryRequirements);
-
-    VkMemoryAllocateInfo memoryAllocateInfo = {};
-    memoryAllocateInfo.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memoryAllocateInfo.allocationSize       = memoryRequirements.size;
-    memoryAllocateInfo.memoryTypeIndex      = FindMemoryType(memoryRequirements.memoryTypeBits, properties);
-    Graphics::CheckVk(vkAllocateMemory(*logicalDevice, &memoryAllocateInfo, nullptr, &memory));
-
-    Graphics::CheckVk(vkBindImageMemory(*logicalDevice, image, memory, 0));
+    memory = Graphics::Get()->GetMemoryAllocator()->AllocateImage(image, properties, tiling == VK_IMAGE_TILING_LINEAR);
+    Graphics::CheckVk(vkBindImageMemory(*logicalDevice, image, memory.memory, memory.offset));
 }
 
 void Image::CreateImageSampler(VkSampler& sampler, VkFilter filter, VkSamplerAddressMode addressMode, bool anisotropic, uint32_t mipLevels)
@@ -202,6 +194,14 @@ void Image::CreateImageView(const VkImage& image, VkImageView& imageView, VkImag
 
 void Image::CreateMipmaps(const VkImage& image, const VkExtent3D& extent, VkFormat format, VkImageLayout dstImageLayout, uint32_t mipLevels,
                           uint32_t baseArrayLayer, uint32_t layerCount)
+{
+    CommandBuffer commandBuffer;
+    CreateMipmaps(commandBuffer, image, extent, format, dstImageLayout, mipLevels, baseArrayLayer, layerCount);
+    commandBuffer.SubmitIdle();
+}
+
+void Image::CreateMipmaps(const VkCommandBuffer& commandBuffer, const VkImage& image, const VkExtent3D& extent, VkFormat format,
+                          VkImageLayout dstImageLayout, uint32_t mipLevels, uint32_t baseArrayLayer, uint32_t layerCount)
 {
     auto physicalDevice = Graphics::Get()->GetPhysicalDevice();
 
@@ -215,8 +215,6 @@ void Image::CreateMipmaps(const VkImage& image, const VkExtent3D& extent, VkForm
     VkFilter filter =
         formatProperties.linearTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
 
-    CommandBuffer commandBuffer;
-
     for (uint32_t i = 1; i < mipLevels; i++) {
         VkImageMemoryBarrier barrier0            = {};
         barrier0.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -282,8 +280,6 @@ void Image::CreateMipmaps(const VkImage& image, const VkExtent3D& extent, VkForm
     barrier.subresourceRange.layerCount     = layerCount;
     vkCmdPipelineBarrier(
         commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-    commandBuffer.SubmitIdle();
 }
 
 void Image::TransitionImageLayout(const VkImage& image, VkFormat format, VkImageLayout srcImageLayout, VkImageLayout dstImageLayout,
@@ -381,7 +377,7 @@ void Image::CopyBufferToImage(const VkBuffer& buffer, const VkImage& image, cons
     commandBuffer.SubmitIdle();
 }
 
-bool Image::CopyImage(const VkImage& srcImage, VkImage& dstImage, VkDeviceMemory& dstImageMemory, VkFormat srcFormat, const VkExtent3D& extent,
+bool Image::CopyImage(const VkImage& srcImage, VkImage& dstImage, MemoryAllocation& dstImageMemory, VkFormat srcFormat, const VkExtent3D& extent,
                       VkImageLayout srcImageLayout, uint32_t mipLevel, uint32_t arrayLayer)
 {
     auto physicalDevice = Graphics::Get()->GetPhysicalDevice();
@@ -2,6 +2,7 @@
 
 #include "CommandBuffer.hpp"
 #include "Descriptor.hpp"
+#include "MemoryAllocator.hpp"
 #include "volk.h"
 #include <glm/glm.hpp>
 #include <vector>
@@ -21,21 +22,21 @@ public:
                                                                uint32_t count);
 
 
-    const VkExtent3D&     GetExtent() const { return extent; }
-    glm::uvec2            GetSize() const { return {extent.width, extent.height}; }
-    VkFormat              GetFormat() const { return format; }
-    VkSampleCountFlagBits GetSamples() const { return samples; }
-    VkImageUsageFlags     GetUsage() const { return usage; }
-    uint32_t              GetMipLevels() const { return mipLevels; }
-    uint32_t              GetArrayLaylers() const { return arrayLayers; }
-    VkFilter              GetFilter() const { return filter; }
-    VkSamplerAddressMode  GetAddressMode() const { return addressMode; }
-    VkImageLayout         GetLayout() const { return layout; }
-    const VkImage&        GetImage() const { return image; }
-    const VkDeviceMemory& GetMemory() { return memory; }
-    const VkSampler&      GetSampler() const { return sampler; }
-    const VkImageView&    GetView(int mipLevel = 0) const { return view; }
-    const VkImageView&    GetMipView(uint32_t mipLevel) const { return mipViews[mipLevel]; }
+    const VkExtent3D&       GetExtent() const { return extent; }
+    glm::uvec2              GetSize() const { return {extent.width, extent.height}; }
+    VkFormat                GetFormat() const { return format; }
+    VkSampleCountFlagBits   GetSamples() const { return samples; }
+    VkImageUsageFlags       GetUsage() const { return usage; }
+    uint32_t                GetMipLevels() const { return mipLevels; }
+    uint32_t                GetArrayLaylers() const { return arrayLayers; }
+    VkFilter                GetFilter() const { return filter; }
+    VkSamplerAddressMode    GetAddressMode() const { return addressMode; }
+    VkImageLayout           GetLayout() const { return layout; }
+    const VkImage&          GetImage() const { return image; }
+    const MemoryAllocation& GetMemory() const { return memory; }
+    const VkSampler&        GetSampler() const { return sampler; }
+    const VkImageView&      GetView(int mipLevel = 0) const { return view; }
+    const VkImageView&      GetMipView(uint32_t mipLevel) const { return mipViews[mipLevel]; }
 
     static uint32_t            GetMipLevels(const VkExtent3D& extent);
     static uint32_t            FindMemoryType(uint32_t typeFilter, const VkMemoryPropertyFlags& requiredProperties);
@@ -45,7 +46,7 @@ public:
     static bool HasDepth(VkFormat format);
     static bool HasStencil(VkFormat format);
 
-    static void CreateImage(VkImage& image, VkDeviceMemory& memory, const VkExtent3D& extent, VkFormat format, VkSampleCountFlagBits samples,
+    static void CreateImage(VkImage& image, MemoryAllocation& memory, const VkExtent3D& extent, VkFormat format, VkSampleCountFlagBits samples,
                             VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, uint32_t mipLevels, uint32_t arrayLayers,
                             VkImageType type);
     static void CreateImageSampler(VkSampler& sampler, VkFilter filter, VkSamplerAddressMode addressMode, bool anisotropic, uint32_t mipLevels);
@@ -53,6 +54,8 @@ public:
                                 uint32_t mipLevels, uint32_t baseMipLevel, uint32_t layerCount, uint32_t baseArrayLayer);
     static void CreateMipmaps(const VkImage& image, const VkExtent3D& extent, VkFormat format, VkImageLayout dstImageLayout, uint32_t mipLevels,
                               uint32_t baseArrayLayer, uint32_t layerCount);
+    static void CreateMipmaps(const VkCommandBuffer& commandBuffer, const VkImage& image, const VkExtent3D& extent, VkFormat format,
+                              VkImageLayout dstImageLayout, uint32_t mipLevels, uint32_t baseArrayLayer, uint32_t layerCount);
     static void TransitionImageLayout(const VkImage& image, VkFormat format, VkImageLayout srcImageLayout, VkImageLayout dstImageLayout,
                                       VkImageAspectFlags imageAspect, uint32_t mipLevels, uint32_t baseMipLevel, uint32_t layerCount,
                                       uint32_t baseArrayLayer);
@@ -62,7 +65,7 @@ public:
                                          uint32_t mipLevels, uint32_t baseMipLevel, uint32_t layerCount, uint32_t baseArrayLayer);
     static void CopyBufferToImage(const VkBuffer& buffer, const VkImage& image, const VkExtent3D& extent, uint32_t layerCount,
                                   uint32_t baseArrayLayer);
-    static bool CopyImage(const VkImage& srcImage, VkImage& dstImage, VkDeviceMemory& dstImageMemory, VkFormat srcFormat, const VkExtent3D& extent,
+    static bool CopyImage(const VkImage& srcImage, VkImage& dstImage, MemoryAllocation& dstImageMemory, VkFormat srcFormat, const VkExtent3D& extent,
                           VkImageLayout srcImageLayout, uint32_t mipLevel, uint32_t arrayLayer);
     static bool CopyImage(const CommandBuffer& commandBuffer, const Image& srcImage, const Image& dstImage, int srcMipLevel = 0, int dstMipLevel = 0);
 
@@ -79,10 +82,10 @@ protected:
 
     VkImageLayout layout;
 
-    VkImage        image   = VK_NULL_HANDLE;
-    VkDeviceMemory memory  = VK_NULL_HANDLE;
-    VkSampler      sampler = VK_NULL_HANDLE;
-    VkImageView    view    = VK_NULL_HANDLE;
+    VkImage          image   = VK_NULL_HANDLE;
+    MemoryAllocation memory;
+    VkSampler        sampler = VK_NULL_HANDLE;
+    VkImageView      view    = VK_NULL_HANDLE;
 
     std::vector<VkImageView> mipViews;
 };
@@ -1,5 +1,6 @@
 #include "Image2d.hpp"
 #include "Buffer.hpp"
+#include "Graphics.hpp"
 #include "ResourceFormat.h"
 
 namespace MapleLeaf {
@@ -11,6 +12,14 @@ std::shared_ptr<Image2d> Image2d::Create(const std::filesystem::path& filename,
     return result;
 }
 
+std::shared_ptr<Image2d> Image2d::Create(std::unique_ptr<Bitmap>&& bitmap, VkFilter filter, VkSamplerAddressMode addressMode, bool anisotropic,
+                                         bool mipmap)
+{
+    auto result = std::make_shared<Image2d>(bitmap->GetFilename(), filter, addressMode, anisotropic, mipmap, false);
+    result->Load(std::move(bitmap));
+    return result;
+}
+
 Image2d::Image2d(const glm::uvec2& extent, VkFormat format, VkImageLayout layout, VkImageUsageFlags usage, VkFilter filter,
                  VkSamplerAddressMode addressMode, VkSampleCountFlagBits samples, bool anisotropic, bool mipmap)
     : Image(filter, addressMode, samples, layout,
@@ -150,9 +159,10 @@ void Image2d::ClearImage2d(const CommandBuffer& commandBuffer, const glm::vec4&
 
 void Image2d::Load(std::unique_ptr<Bitmap> loadBitmap)
 {
-    if (!filename.empty() && !loadBitmap) {
-        loadBitmap = std::make_unique<Bitmap>(filename);
-        format = GetVulkanFormat(loadBitmap->GetFormat());
+    if (!filename.empty()) {
+        // The bitmap may have been decoded ahead of time from the same file.
+        if (!loadBitmap) loadBitmap = std::make_unique<Bitmap>(filename);
+        format     = GetVulkanFormat(loadBitmap->GetFormat());
         extent     = {loadBitmap->GetSize().x, loadBitmap->GetSize().y, 1};
         components = loadBitmap->GetComponentCount();
     }
@@ -181,29 +191,16 @@ void Image2d::Load(std::unique_ptr<Bitmap> loadBitmap)
             CreateImageView(image, mipViews[i], VK_IMAGE_VIEW_TYPE_2D, format, VK_IMAGE_ASPECT_COLOR_BIT, 1, i, arrayLayers, 0);
     }
 
-    if (loadBitmap || mipmap) {
-        TransitionImageLayout(
-            image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, 0, arrayLayers, 0);
-    }
-
     if (loadBitmap) {
-        Buffer bufferStaging(
-            loadBitmap->GetLength(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-        uint8_t* data;
-        bufferStaging.MapMemory(reinterpret_cast<void**>(&data));
-        std::memcpy(data, loadBitmap->GetData().get(), bufferStaging.GetSize());
-        bufferStaging.UnmapMemory();
-
-        CopyBufferToImage(bufferStaging.GetBuffer(), image, extent, arrayLayers, 0);
+        // The copy is batched on the transfer queue, the mip chain and the final layout are recorded when the batch is flushed.
+        Graphics::Get()->GetStagingRing()->UploadImage(
+            image, extent, format, layout, mipLevels, arrayLayers, mipmap, loadBitmap->GetData().get(), loadBitmap->GetLength());
     }
-
-    if (mipmap) {
+    else if (mipmap) {
+        TransitionImageLayout(
+            image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, 0, arrayLayers, 0);
         CreateMipmaps(image, extent, format, layout, mipLevels, 0, arrayLayers);
     }
-    else if (loadBitmap) {
-        TransitionImageLayout(image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layout, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, 0, arrayLayers, 0);
-    }
     else {
         TransitionImageLayout(image, format, VK_IMAGE_LAYOUT_UNDEFINED, layout, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, 0, arrayLayers, 0);
     }
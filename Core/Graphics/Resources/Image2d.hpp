@@ -13,6 +13,14 @@ public:
                                            VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT, bool anisotropic = true,
                                            bool mipmap = false);
 
+    /**
+     * Creates a 2D image from a bitmap that was already decoded from a file, so decoding can happen on a loader thread.
+     * @param bitmap The decoded bitmap, its filename is kept as the image filename.
+     */
+    static std::shared_ptr<Image2d> Create(std::unique_ptr<Bitmap>&& bitmap, VkFilter filter = VK_FILTER_LINEAR,
+                                           VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT, bool anisotropic = true,
+                                           bool mipmap = false);
+
     /**
      * Creates a new 2D image.
      * @param extent The images extent in pixels.
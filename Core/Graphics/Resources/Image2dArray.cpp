@@ -52,7 +52,10 @@ Image2dArray::Image2dArray(std::unique_ptr<Bitmap>&& bitmap, uint32_t arrayLayer
 
     Buffer bufferStaging(bitmap->GetLength() * arrayLayers,
                          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                         nullptr,
+                         false,
+                         true);
 
     uint8_t* data;
     bufferStaging.MapMemory(reinterpret_cast<void**>(&data));
@@ -115,8 +118,12 @@ void Image2dArray::Load(std::unique_ptr<Bitmap> loadBitmap)
     }
 
     if (loadBitmap) {
-        Buffer bufferStaging(
-            loadBitmap->GetLength(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        Buffer bufferStaging(loadBitmap->GetLength(),
+                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                             nullptr,
+                             false,
+                             true);
 
         uint8_t* data;
         bufferStaging.MapMemory(reinterpret_cast<void**>(&data));
@@ -141,7 +148,10 @@ void Image2dArray::SetPixels(const float* pixels, uint32_t arrayLayer)
 {
     Buffer bufferStaging(extent.width * extent.height * 3,
                          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                         nullptr,
+                         false,
+                         true);
 
     void* data;
     bufferStaging.MapMemory(&data);
@@ -1,6 +1,7 @@
 #include "ImageCube.hpp"
 #include "Bitmap.hpp"
 #include "Buffer.hpp"
+#include "Graphics.hpp"
 #include "Image.hpp"
 #include <cassert>
 
@@ -85,30 +86,16 @@ void ImageCube::Load(std::unique_ptr<Bitmap> loadBitmap)
             CreateImageView(image, mipViews[i], VK_IMAGE_VIEW_TYPE_CUBE, format, VK_IMAGE_ASPECT_COLOR_BIT, 1, i, arrayLayers, 0);
     }
 
-    if (loadBitmap || mipmap) {
-        TransitionImageLayout(
-            image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, 0, arrayLayers, 0);
-    }
-
     if (loadBitmap) {
-        Buffer bufferStaging(loadBitmap->GetLength() * arrayLayers,
-                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-        uint8_t* data;
-        bufferStaging.MapMemory(reinterpret_cast<void**>(&data));
-        std::memcpy(data, loadBitmap->GetData().get(), bufferStaging.GetSize());
-        bufferStaging.UnmapMemory();
-
-        CopyBufferToImage(bufferStaging.GetBuffer(), image, extent, arrayLayers, 0);
+        // The copy is batched on the transfer queue, the mip chain and the final layout are recorded when the batch is flushed.
+        Graphics::Get()->GetStagingRing()->UploadImage(
+            image, extent, format, layout, mipLevels, arrayLayers, mipmap, loadBitmap->GetData().get(), loadBitmap->GetLength() * arrayLayers);
     }
-
-    if (mipmap) {
+    else if (mipmap) {
+        TransitionImageLayout(
+            image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, 0, arrayLayers, 0);
         CreateMipmaps(image, extent, format, layout, mipLevels, 0, arrayLayers);
     }
-    else if (loadBitmap) {
-        TransitionImageLayout(image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layout, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, 0, arrayLayers, 0);
-    }
     else {
         TransitionImageLayout(image, format, VK_IMAGE_LAYOUT_UNDEFINED, layout, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, 0, arrayLayers, 0);
     }
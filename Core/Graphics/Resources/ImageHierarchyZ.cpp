@@ -8,9 +8,9 @@
 
 namespace MapleLeaf {
 ImageHierarchyZ::ImageHierarchyZ(const glm::uvec2& extent, VkSampleCountFlagBits samples)
-    : Image(VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, samples, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_FORMAT_R32_SFLOAT,
-            Image::GetMipLevels({extent.x, extent.y, 1}), 1, {extent.x, extent.y, 1})
+    : Image(VK_FILTER_NEAREST, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, samples, VK_IMAGE_LAYOUT_GENERAL,
+            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            VK_FORMAT_R32_SFLOAT, Image::GetMipLevels({extent.x, extent.y, 1}), 1, {extent.x, extent.y, 1})
 {
     VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 
@@ -28,9 +28,25 @@ ImageHierarchyZ::ImageHierarchyZ(const glm::uvec2& extent, VkSampleCountFlagBits
     CreateImageSampler(sampler, filter, addressMode, false, mipLevels);
     CreateImageView(image, view, VK_IMAGE_VIEW_TYPE_2D, format, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, 0, 1, 0);
 
+    mipViews.resize(mipLevels, VK_NULL_HANDLE);
+    for (uint32_t i = 0; i < mipLevels; i++) {
+        CreateImageView(image, mipViews[i], VK_IMAGE_VIEW_TYPE_2D, format, VK_IMAGE_ASPECT_COLOR_BIT, 1, i, 1, 0);
+    }
+
     TransitionImageLayout(image, format, VK_IMAGE_LAYOUT_UNDEFINED, layout, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, 0, arrayLayers, 0);
 }
 
+glm::uvec2 ImageHierarchyZ::GetPyramidSize(const glm::uvec2& depthSize)
+{
+    auto previousPowerOfTwo = [](uint32_t value) {
+        uint32_t result = 1;
+        while (result * 2 <= value) result *= 2;
+        return result;
+    };
+
+    return {previousPowerOfTwo(depthSize.x), previousPowerOfTwo(depthSize.y)};
+}
+
 void ImageHierarchyZ::AddHierarchicalDepth(const CommandBuffer& commandBuffer, const VkImage& depth, const VkExtent3D& depthExtent,
                                            VkFormat depthFormat, VkImageLayout depthLayout, uint32_t hizMipLevel, uint32_t hizArrayLayer) const
 {
@@ -3,11 +3,23 @@
 #include "Image.hpp"
 
 namespace MapleLeaf {
+/**
+ * A depth pyramid, every texel holds the farthest depth of the texels it covers in the mip level above.
+ * Kept in the general layout so compute shaders write a level through its mip view while reading the previous one.
+ */
 class ImageHierarchyZ : public Image
 {
 public:
     explicit ImageHierarchyZ(const glm::uvec2& extent, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT);
 
+    /**
+     * Gets the size of the pyramid built from a depth image, the largest power of two extent that fits in it.
+     * Every level then covers exactly 2x2 texels of the previous one.
+     * @param depthSize The depth image size.
+     * @return The level 0 size.
+     */
+    static glm::uvec2 GetPyramidSize(const glm::uvec2& depthSize);
+
     void AddHierarchicalDepth(const CommandBuffer& commandBuffer, const VkImage& depth, const VkExtent3D& depthExtent, VkFormat depthFormat,
                               VkImageLayout depthLayout, uint32_t hizMipLevel, uint32_t hizArrayLayer) const;
 
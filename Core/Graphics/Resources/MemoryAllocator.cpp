@@ -0,0 +1,561 @@
+#include "MemoryAllocator.hpp"
+#include "Graphics.hpp"
+#include "Log.hpp"
+#include <algorithm>
+
+namespace MapleLeaf {
+namespace {
+VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+uint32_t HighestBit(uint64_t value)
+{
+    uint32_t result = 0;
+    while (value >>= 1) result++;
+    return result;
+}
+
+uint32_t LowestBit(uint64_t value)
+{
+    uint32_t result = 0;
+    while (value && !(value & 1)) {
+        value >>= 1;
+        result++;
+    }
+    return result;
+}
+}   // namespace
+
+MemoryBlock::MemoryBlock(VkDeviceSize size, Strategy strategy)
+    : size(size)
+    , strategy(strategy)
+{
+    if (strategy == Strategy::TLSF) {
+        secondLevelBitmaps.resize(FirstLevelCount, 0);
+        freeLists.resize(FirstLevelCount * SecondLevelCount);
+
+        ranges.emplace(0, Range{size, true});
+        InsertFree(0, size);
+    }
+}
+
+std::optional<VkDeviceSize> MemoryBlock::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    if (size == 0) return std::nullopt;
+    alignment = std::max<VkDeviceSize>(alignment, 1);
+
+    if (strategy == Strategy::Linear) {
+        VkDeviceSize offset = AlignUp(linearHead, alignment);
+        if (offset + size > this->size) return std::nullopt;
+
+        ranges.emplace(offset, Range{size, false});
+        linearHead = offset + size;
+        usedSize += size;
+        allocationCount++;
+        return offset;
+    }
+
+    // Searching for the size plus the worst case padding guarantees any range found fits once aligned.
+    auto found = FindFree(size + alignment - 1);
+    if (!found) return std::nullopt;
+
+    VkDeviceSize start = *found;
+    auto         it    = ranges.find(start);
+    VkDeviceSize end   = start + it->second.size;
+    RemoveFree(start, it->second.size);
+    ranges.erase(it);
+
+    VkDeviceSize offset = AlignUp(start, alignment);
+    if (offset > start) {
+        ranges.emplace(start, Range{offset - start, true});
+        InsertFree(start, offset - start);
+    }
+
+    ranges.emplace(offset, Range{size, false});
+
+    if (offset + size < end) {
+        ranges.emplace(offset + size, Range{end - offset - size, true});
+        InsertFree(offset + size, end - offset - size);
+    }
+
+    usedSize += size;
+    allocationCount++;
+    return offset;
+}
+
+void MemoryBlock::Free(VkDeviceSize offset)
+{
+    auto it = ranges.find(offset);
+    if (it == ranges.end() || it->second.free) {
+        Log::Error("Freeing memory block offset ", offset, " that is not allocated\n");
+        return;
+    }
+
+    usedSize -= it->second.size;
+    allocationCount--;
+
+    if (strategy == Strategy::Linear) {
+        ranges.erase(it);
+
+        // Only the top of the block can be handed out again, everything below waits for the block to drain.
+        if (ranges.empty()) {
+            linearHead = 0;
+        }
+        else {
+            auto last  = std::prev(ranges.end());
+            linearHead = last->first + last->second.size;
+        }
+        return;
+    }
+
+    VkDeviceSize start     = offset;
+    VkDeviceSize rangeSize = it->second.size;
+
+    if (auto next = std::next(it); next != ranges.end() && next->second.free) {
+        RemoveFree(next->first, next->second.size);
+        rangeSize += next->second.size;
+        ranges.erase(next);
+    }
+
+    if (it != ranges.begin()) {
+        if (auto prev = std::prev(it); prev->second.free) {
+            RemoveFree(prev->first, prev->second.size);
+            start = prev->first;
+            rangeSize += prev->second.size;
+            ranges.erase(it);
+            it = prev;
+        }
+    }
+
+    it->second = Range{rangeSize, true};
+    InsertFree(start, rangeSize);
+}
+
+VkDeviceSize MemoryBlock::GetLargestFreeRange() const
+{
+    if (strategy == Strategy::Linear) return size - linearHead;
+    if (!firstLevelBitmap) return 0;
+
+    uint32_t firstLevel  = HighestBit(firstLevelBitmap);
+    uint32_t secondLevel = HighestBit(secondLevelBitmaps[firstLevel]);
+
+    VkDeviceSize largest = 0;
+    for (auto offset : freeLists[firstLevel * SecondLevelCount + secondLevel]) largest = std::max(largest, ranges.at(offset).size);
+    return largest;
+}
+
+float MemoryBlock::GetFragmentation() const
+{
+    VkDeviceSize freeSize = size - usedSize;
+    if (freeSize == 0) return 0.0f;
+    return 1.0f - static_cast<float>(GetLargestFreeRange()) / static_cast<float>(freeSize);
+}
+
+std::vector<std::pair<VkDeviceSize, VkDeviceSize>> MemoryBlock::GetAllocations() const
+{
+    std::vector<std::pair<VkDeviceSize, VkDeviceSize>> allocations;
+    allocations.reserve(allocationCount);
+
+    for (const auto& [offset, range] : ranges) {
+        if (!range.free) allocations.emplace_back(offset, range.size);
+    }
+    return allocations;
+}
+
+std::pair<uint32_t, uint32_t> MemoryBlock::MapSize(VkDeviceSize size)
+{
+    if (size < SmallSize) return {0, static_cast<uint32_t>(size / (SmallSize / SecondLevelCount))};
+
+    uint32_t firstLevel  = HighestBit(size);
+    uint32_t secondLevel = static_cast<uint32_t>(size >> (firstLevel - SecondLevelBits)) & (SecondLevelCount - 1);
+    return {firstLevel - SmallSizeBits + 1, secondLevel};
+}
+
+void MemoryBlock::InsertFree(VkDeviceSize offset, VkDeviceSize size)
+{
+    auto [firstLevel, secondLevel] = MapSize(size);
+
+    freeLists[firstLevel * SecondLevelCount + secondLevel].insert(offset);
+    firstLevelBitmap |= uint64_t(1) << firstLevel;
+    secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+}
+
+void MemoryBlock::RemoveFree(VkDeviceSize offset, VkDeviceSize size)
+{
+    auto [firstLevel, secondLevel] = MapSize(size);
+
+    auto& freeList = freeLists[firstLevel * SecondLevelCount + secondLevel];
+    freeList.erase(offset);
+
+    if (freeList.empty()) {
+        secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+        if (!secondLevelBitmaps[firstLevel]) firstLevelBitmap &= ~(uint64_t(1) << firstLevel);
+    }
+}
+
+std::optional<VkDeviceSize> MemoryBlock::FindFree(VkDeviceSize size) const
+{
+    // Rounds up to the next bin boundary, every range in the bin found is then at least the requested size.
+    if (size < SmallSize)
+        size = AlignUp(size, SmallSize / SecondLevelCount);
+    else
+        size += (VkDeviceSize(1) << (HighestBit(size) - SecondLevelBits)) - 1;
+
+    auto [firstLevel, secondLevel] = MapSize(size);
+    if (firstLevel >= FirstLevelCount) return std::nullopt;
+
+    uint32_t secondLevelMap = secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+    if (!secondLevelMap) {
+        uint64_t firstLevelMap = firstLevel + 1 < 64 ? firstLevelBitmap & (~uint64_t(0) << (firstLevel + 1)) : 0;
+        if (!firstLevelMap) return std::nullopt;
+
+        firstLevel     = LowestBit(firstLevelMap);
+        secondLevelMap = secondLevelBitmaps[firstLevel];
+    }
+
+    secondLevel = LowestBit(secondLevelMap);
+    return *freeLists[firstLevel * SecondLevelCount + secondLevel].begin();
+}
+
+MemoryAllocator::MemoryAllocator(const LogicalDevice& logicalDevice, const PhysicalDevice& physicalDevice, VkDeviceSize blockSize)
+    : logicalDevice(logicalDevice)
+    , memoryProperties(physicalDevice.GetMemoryProperties())
+    , blockSize(blockSize)
+    , nonCoherentAtomSize(physicalDevice.GetProperties().limits.nonCoherentAtomSize)
+{
+    for (uint32_t memoryType = 0; memoryType < memoryProperties.memoryTypeCount; memoryType++) {
+        for (uint32_t kind = 0; kind < static_cast<uint32_t>(PoolKind::Count); kind++) {
+            pools.push_back(Pool{memoryType, static_cast<PoolKind>(kind), {}});
+        }
+    }
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+    uint32_t liveAllocations = static_cast<uint32_t>(dedicatedAllocations.size());
+
+    for (auto& pool : pools) {
+        for (auto& block : pool.blocks) {
+            liveAllocations += block->GetAllocationCount();
+            FreeBlock(*block);
+        }
+    }
+
+    for (const auto& [memory, allocation] : dedicatedAllocations) vkFreeMemory(logicalDevice, memory, nullptr);
+
+    if (liveAllocations > 0) Log::Warning("Memory allocator destroyed with ", liveAllocations, " live allocations\n");
+}
+
+MemoryAllocation MemoryAllocator::AllocateBuffer(const VkBuffer& buffer, VkMemoryPropertyFlags properties, bool transient)
+{
+    VkMemoryDedicatedRequirements dedicatedRequirements = {};
+    dedicatedRequirements.sType                         = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+    VkMemoryRequirements2 memoryRequirements = {};
+    memoryRequirements.sType                 = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    memoryRequirements.pNext                 = &dedicatedRequirements;
+
+    VkBufferMemoryRequirementsInfo2 memoryRequirementsInfo = {};
+    memoryRequirementsInfo.sType                           = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+    memoryRequirementsInfo.buffer                          = buffer;
+    vkGetBufferMemoryRequirements2(logicalDevice, &memoryRequirementsInfo, &memoryRequirements);
+
+    VkMemoryDedicatedAllocateInfo dedicatedAllocateInfo = {};
+    dedicatedAllocateInfo.sType                         = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicatedAllocateInfo.buffer                        = buffer;
+
+    return Allocate(memoryRequirements.memoryRequirements,
+                    properties,
+                    transient ? PoolKind::Transient : PoolKind::Linear,
+                    dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation,
+                    dedicatedAllocateInfo);
+}
+
+MemoryAllocation MemoryAllocator::AllocateImage(const VkImage& image, VkMemoryPropertyFlags properties, bool linearTiling)
+{
+    VkMemoryDedicatedRequirements dedicatedRequirements = {};
+    dedicatedRequirements.sType                         = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+    VkMemoryRequirements2 memoryRequirements = {};
+    memoryRequirements.sType                 = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    memoryRequirements.pNext                 = &dedicatedRequirements;
+
+    VkImageMemoryRequirementsInfo2 memoryRequirementsInfo = {};
+    memoryRequirementsInfo.sType                          = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+    memoryRequirementsInfo.image                          = image;
+    vkGetImageMemoryRequirements2(logicalDevice, &memoryRequirementsInfo, &memoryRequirements);
+
+    VkMemoryDedicatedAllocateInfo dedicatedAllocateInfo = {};
+    dedicatedAllocateInfo.sType                         = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicatedAllocateInfo.image                         = image;
+
+    return Allocate(memoryRequirements.memoryRequirements,
+                    properties,
+                    linearTiling ? PoolKind::Linear : PoolKind::Optimal,
+                    dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation,
+                    dedicatedAllocateInfo);
+}
+
+void MemoryAllocator::Free(MemoryAllocation& allocation)
+{
+    if (allocation.memory == VK_NULL_HANDLE) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!allocation.block) {
+        if (dedicatedAllocations.erase(allocation.memory)) vkFreeMemory(logicalDevice, allocation.memory, nullptr);
+        allocation = {};
+        return;
+    }
+
+    auto& pool  = pools[allocation.pool];
+    auto* block = allocation.block;
+    block->Free(allocation.offset);
+    allocation = {};
+
+    // One empty block is kept per pool, so resources recreated every frame don't allocate device memory each time.
+    if (block->IsEmpty() && std::count_if(pool.blocks.begin(), pool.blocks.end(), [](const auto& other) { return other->IsEmpty(); }) > 1) {
+        auto it = std::find_if(pool.blocks.begin(), pool.blocks.end(), [block](const auto& other) { return other.get() == block; });
+        FreeBlock(**it);
+        pool.blocks.erase(it);
+    }
+}
+
+void MemoryAllocator::FlushMappedMemory(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const
+{
+    if (!allocation.mapped || IsHostCoherent(allocation.memoryType)) return;
+
+    // Flushed ranges have to cover whole atoms, non coherent allocations are padded to atoms so this never reaches a neighbour.
+    VkDeviceSize memorySize = allocation.block ? allocation.block->GetSize() : allocation.size;
+    VkDeviceSize start      = (allocation.offset + offset) / nonCoherentAtomSize * nonCoherentAtomSize;
+    VkDeviceSize end        = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : allocation.offset + offset + size;
+    end                     = AlignUp(end, nonCoherentAtomSize);
+
+    VkMappedMemoryRange mappedMemoryRange = {};
+    mappedMemoryRange.sType               = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    mappedMemoryRange.memory              = allocation.memory;
+    mappedMemoryRange.offset              = start;
+    mappedMemoryRange.size                = end >= memorySize ? VK_WHOLE_SIZE : end - start;
+    Graphics::CheckVk(vkFlushMappedMemoryRanges(logicalDevice, 1, &mappedMemoryRange));
+}
+
+uint32_t MemoryAllocator::GetDeviceAllocationCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto count = static_cast<uint32_t>(dedicatedAllocations.size());
+    for (const auto& pool : pools) count += static_cast<uint32_t>(pool.blocks.size());
+    return count;
+}
+
+std::vector<MemoryAllocator::HeapStats> MemoryAllocator::GetHeapStats() const
+{
+    std::vector<HeapStats>    stats(memoryProperties.memoryHeapCount);
+    std::vector<VkDeviceSize> freeBytes(memoryProperties.memoryHeapCount, 0);
+    std::vector<VkDeviceSize> largestFreeBytes(memoryProperties.memoryHeapCount, 0);
+
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) stats[i].heapSize = memoryProperties.memoryHeaps[i].size;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (const auto& pool : pools) {
+        auto heap = memoryProperties.memoryTypes[pool.memoryType].heapIndex;
+
+        for (const auto& block : pool.blocks) {
+            stats[heap].reservedBytes += block->GetSize();
+            stats[heap].usedBytes += block->GetUsedSize();
+            stats[heap].blockCount++;
+            stats[heap].allocationCount += block->GetAllocationCount();
+            freeBytes[heap] += block->GetSize() - block->GetUsedSize();
+            largestFreeBytes[heap] += block->GetLargestFreeRange();
+        }
+    }
+
+    for (const auto& [memory, allocation] : dedicatedAllocations) {
+        auto heap = memoryProperties.memoryTypes[allocation.memoryType].heapIndex;
+
+        stats[heap].reservedBytes += allocation.size;
+        stats[heap].usedBytes += allocation.size;
+        stats[heap].dedicatedCount++;
+        stats[heap].allocationCount++;
+    }
+
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+        if (freeBytes[i] > 0) stats[i].fragmentation = 1.0f - static_cast<float>(largestFreeBytes[i]) / static_cast<float>(freeBytes[i]);
+    }
+
+    return stats;
+}
+
+uint32_t MemoryAllocator::ReleaseEmptyBlocks()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint32_t released = 0;
+    for (auto& pool : pools) {
+        auto it = std::remove_if(pool.blocks.begin(), pool.blocks.end(), [this](const auto& block) {
+            if (!block->IsEmpty()) return false;
+            FreeBlock(*block);
+            return true;
+        });
+        released += static_cast<uint32_t>(std::distance(it, pool.blocks.end()));
+        pool.blocks.erase(it, pool.blocks.end());
+    }
+    return released;
+}
+
+std::vector<MemoryAllocation> MemoryAllocator::GetDefragmentationCandidates(float fragmentationThreshold) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<MemoryAllocation> candidates;
+    for (uint32_t poolIndex = 0; poolIndex < pools.size(); poolIndex++) {
+        for (const auto& block : pools[poolIndex].blocks) {
+            if (block->GetStrategy() != MemoryBlock::Strategy::TLSF || block->GetFragmentation() < fragmentationThreshold ||
+                block->GetUsedSize() > block->GetSize() / 2)
+                continue;
+
+            for (const auto& [offset, size] : block->GetAllocations()) {
+                MemoryAllocation allocation = {};
+                allocation.memory           = block->memory;
+                allocation.offset           = offset;
+                allocation.size             = size;
+                allocation.memoryType       = pools[poolIndex].memoryType;
+                allocation.mapped           = block->mapped ? block->mapped + offset : nullptr;
+                allocation.block            = block.get();
+                allocation.pool             = poolIndex;
+                candidates.emplace_back(allocation);
+            }
+        }
+    }
+    return candidates;
+}
+
+std::optional<uint32_t> MemoryAllocator::FindMemoryType(const VkPhysicalDeviceMemoryProperties& memoryProperties, uint32_t typeFilter,
+                                                        VkMemoryPropertyFlags requiredProperties)
+{
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        uint32_t memoryTypeBits = 1 << i;
+
+        if (typeFilter & memoryTypeBits && (memoryProperties.memoryTypes[i].propertyFlags & requiredProperties) == requiredProperties) {
+            return i;
+        }
+    }
+
+    return std::nullopt;
+}
+
+MemoryAllocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, PoolKind kind, bool dedicated,
+                                           const VkMemoryDedicatedAllocateInfo& dedicatedInfo)
+{
+    auto memoryType = FindMemoryType(memoryProperties, requirements.memoryTypeBits, properties);
+    if (!memoryType) throw std::runtime_error("Failed to find a valid memory type for allocation");
+
+    bool hostVisible   = memoryProperties.memoryTypes[*memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    bool deviceAddress = kind != PoolKind::Optimal;
+
+    VkDeviceSize size      = requirements.size;
+    VkDeviceSize alignment = requirements.alignment;
+    if (hostVisible && !IsHostCoherent(*memoryType)) {
+        size      = AlignUp(size, nonCoherentAtomSize);
+        alignment = std::max(alignment, nonCoherentAtomSize);
+    }
+
+    MemoryAllocation allocation = {};
+    allocation.memoryType       = *memoryType;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (dedicated || size > GetBlockSize(*memoryType) / 2) {
+        allocation.size   = requirements.size;
+        allocation.memory = AllocateDeviceMemory(*memoryType, requirements.size, deviceAddress, &dedicatedInfo, &allocation.mapped);
+        dedicatedAllocations.emplace(allocation.memory, allocation);
+        return allocation;
+    }
+
+    auto  poolIndex = *memoryType * static_cast<uint32_t>(PoolKind::Count) + static_cast<uint32_t>(kind);
+    auto& pool      = pools[poolIndex];
+
+    MemoryBlock*                block = nullptr;
+    std::optional<VkDeviceSize> offset;
+
+    for (auto& candidate : pool.blocks) {
+        if (offset = candidate->Allocate(size, alignment); offset) {
+            block = candidate.get();
+            break;
+        }
+    }
+
+    if (!block) {
+        auto strategy = kind == PoolKind::Transient ? MemoryBlock::Strategy::Linear : MemoryBlock::Strategy::TLSF;
+        // Alignment padding can make a request that fits half a block still miss the default size, the block is grown to hold it.
+        auto newBlock = std::make_unique<MemoryBlock>(std::max(GetBlockSize(*memoryType), size + alignment), strategy);
+
+        void* mapped     = nullptr;
+        newBlock->memory = AllocateDeviceMemory(*memoryType, newBlock->GetSize(), deviceAddress, nullptr, &mapped);
+        newBlock->mapped = static_cast<uint8_t*>(mapped);
+
+        offset = newBlock->Allocate(size, alignment);
+        if (!offset) {
+            vkFreeMemory(logicalDevice, newBlock->memory, nullptr);
+            throw std::runtime_error("Failed to sub-allocate memory from a new block");
+        }
+        block = pool.blocks.emplace_back(std::move(newBlock)).get();
+    }
+
+    allocation.memory = block->memory;
+    allocation.offset = *offset;
+    allocation.size   = size;
+    allocation.mapped = block->mapped ? block->mapped + *offset : nullptr;
+    allocation.block  = block;
+    allocation.pool   = poolIndex;
+    return allocation;
+}
+
+VkDeviceMemory MemoryAllocator::AllocateDeviceMemory(uint32_t memoryType, VkDeviceSize size, bool deviceAddress, const void* next,
+                                                     void** mapped) const
+{
+    VkMemoryAllocateFlagsInfo memoryAllocateFlagsInfo = {};
+    memoryAllocateFlagsInfo.sType                     = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+    memoryAllocateFlagsInfo.flags                     = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+    memoryAllocateFlagsInfo.pNext                     = next;
+
+    VkMemoryAllocateInfo memoryAllocateInfo = {};
+    memoryAllocateInfo.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memoryAllocateInfo.allocationSize       = size;
+    memoryAllocateInfo.memoryTypeIndex      = memoryType;
+    memoryAllocateInfo.pNext                = deviceAddress ? &memoryAllocateFlagsInfo : next;
+
+    VkDeviceMemory memory;
+    Graphics::CheckVk(vkAllocateMemory(logicalDevice, &memoryAllocateInfo, nullptr, &memory));
+
+    *mapped = nullptr;
+    if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        Graphics::CheckVk(vkMapMemory(logicalDevice, memory, 0, VK_WHOLE_SIZE, 0, mapped));
+    }
+
+    return memory;
+}
+
+void MemoryAllocator::FreeBlock(MemoryBlock& block) const
+{
+    // Freeing mapped memory unmaps it.
+    vkFreeMemory(logicalDevice, block.memory, nullptr);
+    block.memory = VK_NULL_HANDLE;
+    block.mapped = nullptr;
+}
+
+VkDeviceSize MemoryAllocator::GetBlockSize(uint32_t memoryType) const
+{
+    // Small heaps, such as the host visible device local window, would be exhausted by a few default sized blocks.
+    auto heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+    return std::min(blockSize, heapSize / 8);
+}
+
+bool MemoryAllocator::IsHostCoherent(uint32_t memoryType) const
+{
+    return memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
+}   // namespace MapleLeaf
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "NonCopyable.hpp"
+#include "volk.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace MapleLeaf {
+class LogicalDevice;
+class PhysicalDevice;
+
+/**
+ * Offset bookkeeping of one device memory block, it makes no Vulkan calls so the strategies can be exercised without a device.
+ */
+class MemoryBlock
+{
+public:
+    enum class Strategy
+    {
+        // Bump allocation, the space is reused once every allocation of the block is freed.
+        Linear,
+        // Two level segregated fit, constant time allocation and free with neighbour coalescing.
+        TLSF
+    };
+
+    MemoryBlock(VkDeviceSize size, Strategy strategy);
+
+    /**
+     * Reserves a range of the block.
+     * @param size The size of the range.
+     * @param alignment The alignment of the range offset.
+     * @return The offset of the range, nullopt if the block has no room for it.
+     */
+    std::optional<VkDeviceSize> Allocate(VkDeviceSize size, VkDeviceSize alignment);
+    void                        Free(VkDeviceSize offset);
+
+    VkDeviceSize GetSize() const { return size; }
+    VkDeviceSize GetUsedSize() const { return usedSize; }
+    uint32_t     GetAllocationCount() const { return allocationCount; }
+    bool         IsEmpty() const { return allocationCount == 0; }
+    Strategy     GetStrategy() const { return strategy; }
+
+    VkDeviceSize GetLargestFreeRange() const;
+
+    /**
+     * Gets how scattered the free space is.
+     * @return 0 when all free space is contiguous, close to 1 when it is split in many small ranges.
+     */
+    float GetFragmentation() const;
+
+    /**
+     * Gets every live allocation as offset and size pairs.
+     */
+    std::vector<std::pair<VkDeviceSize, VkDeviceSize>> GetAllocations() const;
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    uint8_t*       mapped = nullptr;
+
+private:
+    struct Range
+    {
+        VkDeviceSize size;
+        bool         free;
+    };
+
+    static constexpr uint32_t     SecondLevelBits  = 4;
+    static constexpr uint32_t     SecondLevelCount = 1 << SecondLevelBits;
+    static constexpr uint32_t     SmallSizeBits    = 8;
+    static constexpr VkDeviceSize SmallSize        = 1 << SmallSizeBits;
+    static constexpr uint32_t     FirstLevelCount  = 64 - SmallSizeBits + 1;
+
+    VkDeviceSize size;
+    Strategy     strategy;
+    VkDeviceSize usedSize        = 0;
+    uint32_t     allocationCount = 0;
+
+    // Every allocated and free range by offset, neighbours are found here when coalescing.
+    std::map<VkDeviceSize, Range> ranges;
+
+    uint64_t                            firstLevelBitmap = 0;
+    std::vector<uint32_t>               secondLevelBitmaps;
+    std::vector<std::set<VkDeviceSize>> freeLists;
+
+    VkDeviceSize linearHead = 0;
+
+    static std::pair<uint32_t, uint32_t> MapSize(VkDeviceSize size);
+
+    void                        InsertFree(VkDeviceSize offset, VkDeviceSize size);
+    void                        RemoveFree(VkDeviceSize offset, VkDeviceSize size);
+    std::optional<VkDeviceSize> FindFree(VkDeviceSize size) const;
+};
+
+/**
+ * A range of device memory handed out by the MemoryAllocator.
+ */
+struct MemoryAllocation
+{
+    VkDeviceMemory memory     = VK_NULL_HANDLE;
+    VkDeviceSize   offset     = 0;
+    VkDeviceSize   size       = 0;
+    uint32_t       memoryType = 0;
+    // Host pointer to the start of the range, set when the memory is host visible.
+    void* mapped = nullptr;
+
+    MemoryBlock* block = nullptr;   // nullptr for dedicated allocations.
+    uint32_t     pool  = 0;
+};
+
+/**
+ * Sub-allocates buffers and images from large blocks, one pool of blocks per memory type and resource kind.
+ * Host visible memory stays mapped for the lifetime of its block.
+ */
+class MemoryAllocator : NonCopyable
+{
+public:
+    struct HeapStats
+    {
+        VkDeviceSize heapSize        = 0;
+        VkDeviceSize reservedBytes   = 0;
+        VkDeviceSize usedBytes       = 0;
+        uint32_t     blockCount      = 0;
+        uint32_t     dedicatedCount  = 0;
+        uint32_t     allocationCount = 0;
+        float        fragmentation   = 0.0f;
+    };
+
+    static constexpr VkDeviceSize DefaultBlockSize = 64 * 1024 * 1024;
+
+    MemoryAllocator(const LogicalDevice& logicalDevice, const PhysicalDevice& physicalDevice, VkDeviceSize blockSize = DefaultBlockSize);
+    ~MemoryAllocator();
+
+    /**
+     * Allocates the memory backing a buffer, binding it is left to the caller.
+     * @param transient If the buffer is short lived, such as a staging buffer, it is placed in a linear pool.
+     */
+    MemoryAllocation AllocateBuffer(const VkBuffer& buffer, VkMemoryPropertyFlags properties, bool transient = false);
+
+    /**
+     * Allocates the memory backing an image, large images and images the driver asks for get a dedicated allocation.
+     * @param linearTiling If the image uses linear tiling, linear and optimal resources never share a block.
+     */
+    MemoryAllocation AllocateImage(const VkImage& image, VkMemoryPropertyFlags properties, bool linearTiling = false);
+
+    void Free(MemoryAllocation& allocation);
+
+    /**
+     * Flushes host writes to a range of an allocation, does nothing for host coherent memory.
+     * @param offset The offset from the start of the allocation.
+     */
+    void FlushMappedMemory(const MemoryAllocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
+
+    /**
+     * Gets the number of live vkAllocateMemory allocations, bounded by maxMemoryAllocationCount.
+     */
+    uint32_t               GetDeviceAllocationCount() const;
+    std::vector<HeapStats> GetHeapStats() const;
+
+    /**
+     * Defragmentation hook, frees every empty block including the one kept around per pool to avoid reallocation churn.
+     * @return The number of blocks released.
+     */
+    uint32_t ReleaseEmptyBlocks();
+
+    /**
+     * Defragmentation hook, gets the allocations of sparsely used fragmented blocks.
+     * Their owners can recreate them, once a block has no allocation left it is released.
+     * @param fragmentationThreshold The minimum fragmentation of a block to consider it.
+     */
+    std::vector<MemoryAllocation> GetDefragmentationCandidates(float fragmentationThreshold = 0.5f) const;
+
+    static std::optional<uint32_t> FindMemoryType(const VkPhysicalDeviceMemoryProperties& memoryProperties, uint32_t typeFilter,
+                                                  VkMemoryPropertyFlags requiredProperties);
+
+private:
+    enum class PoolKind : uint32_t
+    {
+        // Buffers and linear images.
+        Linear,
+        // Optimal tiled images, kept apart so bufferImageGranularity never has to be honoured inside a block.
+        Optimal,
+        // Short lived buffers.
+        Transient,
+        Count
+    };
+
+    struct Pool
+    {
+        uint32_t                                  memoryType;
+        PoolKind                                  kind;
+        std::vector<std::unique_ptr<MemoryBlock>> blocks;
+    };
+
+    const LogicalDevice&             logicalDevice;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    VkDeviceSize                     blockSize;
+    VkDeviceSize                     nonCoherentAtomSize;
+
+    mutable std::mutex                                   mutex;
+    std::vector<Pool>                                    pools;
+    std::unordered_map<VkDeviceMemory, MemoryAllocation> dedicatedAllocations;
+
+    MemoryAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, PoolKind kind, bool dedicated,
+                              const VkMemoryDedicatedAllocateInfo& dedicatedInfo);
+    VkDeviceMemory   AllocateDeviceMemory(uint32_t memoryType, VkDeviceSize size, bool deviceAddress, const void* next, void** mapped) const;
+    void             FreeBlock(MemoryBlock& block) const;
+    VkDeviceSize     GetBlockSize(uint32_t memoryType) const;
+    bool             IsHostCoherent(uint32_t memoryType) const;
+};
+}   // namespace MapleLeaf
@@ -0,0 +1,466 @@
+#include "StagingRing.hpp"
+#include "Graphics.hpp"
+#include "Image.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+namespace MapleLeaf {
+namespace {
+VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// When the transfer family is the compute family, both submit queues are the same VkQueue and must share a lock.
+std::mutex& GetTransferQueueMutex(const LogicalDevice& logicalDevice)
+{
+    if (logicalDevice.GetSubmitTransferQueue() == logicalDevice.GetSubmitComputeQueue()) return logicalDevice.GetSubmitComputeQueueMutex();
+    return logicalDevice.GetSubmitTransferQueueMutex();
+}
+}   // namespace
+
+StagingRing::StagingRing(VkDeviceSize capacity)
+    : capacity(capacity)
+    , buffer(std::make_unique<Buffer>(capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+{
+    buffer->MapMemory(reinterpret_cast<void**>(&mapped));
+}
+
+StagingRing::~StagingRing()
+{
+    WaitIdle();
+
+    buffer->UnmapMemory();
+
+    for (auto& batch : freeBatches) DestroyBatch(*batch);
+}
+
+StagingRing::Token StagingRing::Upload(const Buffer& dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (size == 0) return nextToken - 1;
+
+    auto [source, sourceOffset] = Stage(data, size, 16);
+    auto& batch                 = GetRecording();
+
+    VkBufferCopy copyRegion = {};
+    copyRegion.srcOffset    = sourceOffset;
+    copyRegion.dstOffset    = dstOffset;
+    copyRegion.size         = size;
+    vkCmdCopyBuffer(batch.transferCommandBuffer, source, dst.GetBuffer(), 1, &copyRegion);
+
+    if (!SharesQueueFamily()) {
+        auto logicalDevice = Graphics::Get()->GetLogicalDevice();
+
+        // The buffer is exclusive, ownership is released by the transfer family and acquired by the graphics family.
+        VkBufferMemoryBarrier bufferMemoryBarrier = {};
+        bufferMemoryBarrier.sType                 = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        bufferMemoryBarrier.srcAccessMask         = VK_ACCESS_TRANSFER_WRITE_BIT;
+        bufferMemoryBarrier.dstAccessMask         = 0;
+        bufferMemoryBarrier.srcQueueFamilyIndex   = logicalDevice->GetTransferFamily();
+        bufferMemoryBarrier.dstQueueFamilyIndex   = logicalDevice->GetGraphicsFamily();
+        bufferMemoryBarrier.buffer                = dst.GetBuffer();
+        bufferMemoryBarrier.offset                = dstOffset;
+        bufferMemoryBarrier.size                  = size;
+        vkCmdPipelineBarrier(batch.transferCommandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0,
+                             0,
+                             nullptr,
+                             1,
+                             &bufferMemoryBarrier,
+                             0,
+                             nullptr);
+
+        bufferMemoryBarrier.srcAccessMask = 0;
+        bufferMemoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        vkCmdPipelineBarrier(batch.graphicsCommandBuffer,
+                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             0,
+                             0,
+                             nullptr,
+                             1,
+                             &bufferMemoryBarrier,
+                             0,
+                             nullptr);
+    }
+
+    return batch.token;
+}
+
+StagingRing::Token StagingRing::Copy(const Buffer& src, const Buffer& dst, VkDeviceSize size)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (size == 0) return nextToken - 1;
+
+    auto& batch = GetRecording();
+
+    // The source is owned by the graphics family once its uploads were acquired, copying there needs no ownership transfer.
+    VkBufferMemoryBarrier bufferMemoryBarrier = {};
+    bufferMemoryBarrier.sType                 = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferMemoryBarrier.srcAccessMask         = VK_ACCESS_MEMORY_WRITE_BIT;
+    bufferMemoryBarrier.dstAccessMask         = VK_ACCESS_TRANSFER_READ_BIT;
+    bufferMemoryBarrier.srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+    bufferMemoryBarrier.dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+    bufferMemoryBarrier.buffer                = src.GetBuffer();
+    bufferMemoryBarrier.offset                = 0;
+    bufferMemoryBarrier.size                  = size;
+    vkCmdPipelineBarrier(batch.graphicsCommandBuffer,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         1,
+                         &bufferMemoryBarrier,
+                         0,
+                         nullptr);
+
+    VkBufferCopy copyRegion = {};
+    copyRegion.size         = size;
+    vkCmdCopyBuffer(batch.graphicsCommandBuffer, src.GetBuffer(), dst.GetBuffer(), 1, &copyRegion);
+
+    bufferMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferMemoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    bufferMemoryBarrier.buffer        = dst.GetBuffer();
+    vkCmdPipelineBarrier(batch.graphicsCommandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         1,
+                         &bufferMemoryBarrier,
+                         0,
+                         nullptr);
+
+    return batch.token;
+}
+
+StagingRing::Token StagingRing::UploadImage(const VkImage& image, const VkExtent3D& extent, VkFormat format, VkImageLayout dstImageLayout,
+                                            uint32_t mipLevels, uint32_t layerCount, bool mipmap, const void* data, VkDeviceSize size)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (size == 0) return nextToken - 1;
+
+    // The buffer offset of an image copy must be a multiple of the texel size, and of 4 on transfer only queues.
+    VkDeviceSize texelSize =
+        std::max<VkDeviceSize>(size / (static_cast<VkDeviceSize>(extent.width) * extent.height * extent.depth * layerCount), 1);
+
+    auto [source, sourceOffset] = Stage(data, size, std::lcm<VkDeviceSize>(16, texelSize));
+    auto& batch                 = GetRecording();
+    auto  logicalDevice         = Graphics::Get()->GetLogicalDevice();
+
+    VkImageMemoryBarrier imageMemoryBarrier            = {};
+    imageMemoryBarrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    imageMemoryBarrier.srcAccessMask                   = 0;
+    imageMemoryBarrier.dstAccessMask                   = VK_ACCESS_TRANSFER_WRITE_BIT;
+    imageMemoryBarrier.oldLayout                       = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageMemoryBarrier.newLayout                       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    imageMemoryBarrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    imageMemoryBarrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    imageMemoryBarrier.image                           = image;
+    imageMemoryBarrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    imageMemoryBarrier.subresourceRange.baseMipLevel   = 0;
+    imageMemoryBarrier.subresourceRange.levelCount     = mipLevels;
+    imageMemoryBarrier.subresourceRange.baseArrayLayer = 0;
+    imageMemoryBarrier.subresourceRange.layerCount     = layerCount;
+    vkCmdPipelineBarrier(batch.transferCommandBuffer,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         1,
+                         &imageMemoryBarrier);
+
+    VkBufferImageCopy region               = {};
+    region.bufferOffset                    = sourceOffset;
+    region.bufferRowLength                 = 0;
+    region.bufferImageHeight               = 0;
+    region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel       = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount     = layerCount;
+    region.imageOffset                     = {0, 0, 0};
+    region.imageExtent                     = extent;
+    vkCmdCopyBufferToImage(batch.transferCommandBuffer, source, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    if (!SharesQueueFamily()) {
+        imageMemoryBarrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageMemoryBarrier.dstAccessMask       = 0;
+        imageMemoryBarrier.oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imageMemoryBarrier.newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imageMemoryBarrier.srcQueueFamilyIndex = logicalDevice->GetTransferFamily();
+        imageMemoryBarrier.dstQueueFamilyIndex = logicalDevice->GetGraphicsFamily();
+        vkCmdPipelineBarrier(batch.transferCommandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0,
+                             0,
+                             nullptr,
+                             0,
+                             nullptr,
+                             1,
+                             &imageMemoryBarrier);
+
+        imageMemoryBarrier.srcAccessMask = 0;
+        imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(batch.graphicsCommandBuffer,
+                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0,
+                             0,
+                             nullptr,
+                             0,
+                             nullptr,
+                             1,
+                             &imageMemoryBarrier);
+    }
+
+    // Blits need a graphics queue, the mip chain and the final layout are recorded on the graphics side of the batch.
+    if (mipmap) {
+        Image::CreateMipmaps(batch.graphicsCommandBuffer, image, extent, format, dstImageLayout, mipLevels, 0, layerCount);
+    }
+    else {
+        imageMemoryBarrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageMemoryBarrier.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+        imageMemoryBarrier.oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imageMemoryBarrier.newLayout           = dstImageLayout;
+        imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        vkCmdPipelineBarrier(batch.graphicsCommandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             0,
+                             0,
+                             nullptr,
+                             0,
+                             nullptr,
+                             1,
+                             &imageMemoryBarrier);
+    }
+
+    return batch.token;
+}
+
+StagingRing::Token StagingRing::Flush()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Reclaim();
+    return FlushBatch();
+}
+
+bool StagingRing::IsComplete(Token token)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Reclaim();
+    return token <= completedToken;
+}
+
+void StagingRing::Wait(Token token)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (recording && token >= recording->token) FlushBatch();
+    while (completedToken < token && !inFlight.empty()) WaitOldest();
+}
+
+void StagingRing::WaitIdle()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    FlushBatch();
+    while (!inFlight.empty()) WaitOldest();
+}
+
+StagingRing::Batch& StagingRing::GetRecording()
+{
+    if (recording) return *recording;
+
+    if (freeBatches.empty()) {
+        recording = CreateBatch();
+    }
+    else {
+        recording = std::move(freeBatches.back());
+        freeBatches.pop_back();
+    }
+
+    recording->token = nextToken++;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    Graphics::CheckVk(vkBeginCommandBuffer(recording->transferCommandBuffer, &beginInfo));
+    Graphics::CheckVk(vkBeginCommandBuffer(recording->graphicsCommandBuffer, &beginInfo));
+
+    return *recording;
+}
+
+std::pair<VkBuffer, VkDeviceSize> StagingRing::Stage(const void* data, VkDeviceSize size, VkDeviceSize alignment)
+{
+    if (size > capacity) {
+        auto& dedicated = GetRecording().dedicated.emplace_back(std::make_unique<Buffer>(
+            size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, data, false, true));
+        return {dedicated->GetBuffer(), 0};
+    }
+
+    while (true) {
+        Reclaim();
+
+        // Nothing is in use, restart at the beginning of the ring so the whole capacity is available.
+        if (head == tail) head = tail = AlignUp(head, capacity);
+
+        VkDeviceSize position = head % capacity;
+        VkDeviceSize offset   = AlignUp(position, alignment);
+
+        // Allocations never straddle the end of the ring, the bytes left before it are skipped.
+        if (offset + size > capacity) offset = capacity;
+
+        uint64_t start = head + (offset - position);
+        if (start + size - tail <= capacity) {
+            head = start + size;
+            std::memcpy(mapped + start % capacity, data, size);
+            return {buffer->GetBuffer(), start % capacity};
+        }
+
+        // The ring is full, the batch being recorded is submitted once nothing older is left to free.
+        if (inFlight.empty()) FlushBatch();
+        WaitOldest();
+    }
+}
+
+StagingRing::Token StagingRing::FlushBatch()
+{
+    if (!recording) return nextToken - 1;
+
+    auto logicalDevice = Graphics::Get()->GetLogicalDevice();
+
+    Graphics::CheckVk(vkEndCommandBuffer(recording->transferCommandBuffer));
+    Graphics::CheckVk(vkEndCommandBuffer(recording->graphicsCommandBuffer));
+    recording->ringEnd = head;
+
+    VkSubmitInfo transferSubmitInfo         = {};
+    transferSubmitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    transferSubmitInfo.commandBufferCount   = 1;
+    transferSubmitInfo.pCommandBuffers      = &recording->transferCommandBuffer;
+    transferSubmitInfo.signalSemaphoreCount = 1;
+    transferSubmitInfo.pSignalSemaphores    = &recording->transferComplete;
+
+    {
+        std::lock_guard<std::mutex> lock(GetTransferQueueMutex(*logicalDevice));
+        Graphics::CheckVk(vkQueueSubmit(logicalDevice->GetSubmitTransferQueue(), 1, &transferSubmitInfo, VK_NULL_HANDLE));
+    }
+
+    // The semaphore wait also orders every later submission to the graphics queue, frames use the uploads without waiting on the fence.
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+    VkSubmitInfo graphicsSubmitInfo       = {};
+    graphicsSubmitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    graphicsSubmitInfo.waitSemaphoreCount = 1;
+    graphicsSubmitInfo.pWaitSemaphores    = &recording->transferComplete;
+    graphicsSubmitInfo.pWaitDstStageMask  = &waitStage;
+    graphicsSubmitInfo.commandBufferCount = 1;
+    graphicsSubmitInfo.pCommandBuffers    = &recording->graphicsCommandBuffer;
+
+    {
+        std::lock_guard<std::mutex> lock(logicalDevice->GetSubmitGraphicsQueueMutex());
+        Graphics::CheckVk(vkResetFences(*logicalDevice, 1, &recording->fence));
+        Graphics::CheckVk(vkQueueSubmit(logicalDevice->GetSubmitGraphicsQueue(), 1, &graphicsSubmitInfo, recording->fence));
+    }
+
+    submitCount += 2;
+
+    auto token = recording->token;
+    inFlight.emplace_back(std::move(recording));
+    return token;
+}
+
+void StagingRing::Reclaim()
+{
+    auto logicalDevice = Graphics::Get()->GetLogicalDevice();
+
+    while (!inFlight.empty() && vkGetFenceStatus(*logicalDevice, inFlight.front()->fence) == VK_SUCCESS) {
+        auto batch = std::move(inFlight.front());
+        inFlight.pop_front();
+
+        tail           = batch->ringEnd;
+        completedToken = batch->token;
+
+        batch->dedicated.clear();
+        Graphics::CheckVk(vkResetCommandPool(*logicalDevice, batch->transferCommandPool, 0));
+        Graphics::CheckVk(vkResetCommandPool(*logicalDevice, batch->graphicsCommandPool, 0));
+        freeBatches.emplace_back(std::move(batch));
+    }
+}
+
+void StagingRing::WaitOldest()
+{
+    if (inFlight.empty()) return;
+
+    auto logicalDevice = Graphics::Get()->GetLogicalDevice();
+    Graphics::CheckVk(vkWaitForFences(*logicalDevice, 1, &inFlight.front()->fence, VK_TRUE, std::numeric_limits<uint64_t>::max()));
+    Reclaim();
+}
+
+std::unique_ptr<StagingRing::Batch> StagingRing::CreateBatch() const
+{
+    auto logicalDevice = Graphics::Get()->GetLogicalDevice();
+    auto batch         = std::make_unique<Batch>();
+
+    VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+    commandPoolCreateInfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolCreateInfo.flags                   = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    commandPoolCreateInfo.queueFamilyIndex        = logicalDevice->GetTransferFamily();
+    Graphics::CheckVk(vkCreateCommandPool(*logicalDevice, &commandPoolCreateInfo, nullptr, &batch->transferCommandPool));
+    commandPoolCreateInfo.queueFamilyIndex = logicalDevice->GetGraphicsFamily();
+    Graphics::CheckVk(vkCreateCommandPool(*logicalDevice, &commandPoolCreateInfo, nullptr, &batch->graphicsCommandPool));
+
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+    commandBufferAllocateInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferAllocateInfo.commandPool                 = batch->transferCommandPool;
+    commandBufferAllocateInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferAllocateInfo.commandBufferCount          = 1;
+    Graphics::CheckVk(vkAllocateCommandBuffers(*logicalDevice, &commandBufferAllocateInfo, &batch->transferCommandBuffer));
+    commandBufferAllocateInfo.commandPool = batch->graphicsCommandPool;
+    Graphics::CheckVk(vkAllocateCommandBuffers(*logicalDevice, &commandBufferAllocateInfo, &batch->graphicsCommandBuffer));
+
+    VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+    semaphoreCreateInfo.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    Graphics::CheckVk(vkCreateSemaphore(*logicalDevice, &semaphoreCreateInfo, nullptr, &batch->transferComplete));
+
+    VkFenceCreateInfo fenceCreateInfo = {};
+    fenceCreateInfo.sType             = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    Graphics::CheckVk(vkCreateFence(*logicalDevice, &fenceCreateInfo, nullptr, &batch->fence));
+
+    return batch;
+}
+
+void StagingRing::DestroyBatch(Batch& batch) const
+{
+    auto logicalDevice = Graphics::Get()->GetLogicalDevice();
+
+    vkDestroyFence(*logicalDevice, batch.fence, nullptr);
+    vkDestroySemaphore(*logicalDevice, batch.transferComplete, nullptr);
+    vkDestroyCommandPool(*logicalDevice, batch.transferCommandPool, nullptr);
+    vkDestroyCommandPool(*logicalDevice, batch.graphicsCommandPool, nullptr);
+}
+
+bool StagingRing::SharesQueueFamily() const
+{
+    auto logicalDevice = Graphics::Get()->GetLogicalDevice();
+    return logicalDevice->GetTransferFamily() == logicalDevice->GetGraphicsFamily();
+}
+}   // namespace MapleLeaf
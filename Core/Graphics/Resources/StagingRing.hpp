@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "NonCopyable.hpp"
+#include "volk.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace MapleLeaf {
+/**
+ * Persistently mapped staging memory shared by every upload, copies are batched on the transfer queue instead of one blocking submit each.
+ * Each flushed batch owns the ring segment written since the previous flush, the segment is reused once the batch fence signals.
+ */
+class StagingRing : NonCopyable
+{
+public:
+    /**
+     * Identifies the batch an upload was recorded in, batches complete in order.
+     */
+    using Token = uint64_t;
+
+    static constexpr VkDeviceSize DefaultCapacity = 64 * 1024 * 1024;
+
+    explicit StagingRing(VkDeviceSize capacity = DefaultCapacity);
+    ~StagingRing();
+
+    /**
+     * Copies data into a device buffer, the buffer must not be read by other submissions until the token completes.
+     * Flushed batches are made visible to the graphics queue, the frame command buffers can use the buffer without waiting.
+     * @param dst The destination buffer.
+     * @param dstOffset The byte offset into the destination.
+     * @param data The data to copy, only read during the call.
+     * @param size The number of bytes to copy.
+     * @return The token of the batch holding the copy.
+     */
+    Token Upload(const Buffer& dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+
+    /**
+     * Copies the start of one device buffer into another, such as the content of a buffer being replaced by a larger one.
+     * The copy is recorded on the graphics side of the batch, after the writes of every earlier submission to the source.
+     * @param src The source buffer, it must stay alive until the token completes.
+     * @param dst The destination buffer.
+     * @param size The number of bytes to copy from the start of the source.
+     * @return The token of the batch holding the copy.
+     */
+    Token Copy(const Buffer& src, const Buffer& dst, VkDeviceSize size);
+
+    /**
+     * Copies the first mip of every layer of an image, the image is left in dstImageLayout once the batch is flushed.
+     * @param image The destination image, its current content is discarded.
+     * @param mipmap If the rest of the mip chain is generated from the first mip, on the graphics queue.
+     * @param data The tightly packed layers, only read during the call.
+     * @param size The number of bytes of data.
+     * @return The token of the batch holding the copy.
+     */
+    Token UploadImage(const VkImage& image, const VkExtent3D& extent, VkFormat format, VkImageLayout dstImageLayout, uint32_t mipLevels,
+                      uint32_t layerCount, bool mipmap, const void* data, VkDeviceSize size);
+
+    /**
+     * Submits the batch being recorded, does nothing if it is empty.
+     * @return The token of the last submitted batch.
+     */
+    Token Flush();
+
+    bool IsComplete(Token token);
+    void Wait(Token token);
+
+    /**
+     * Submits the batch being recorded and blocks until every batch has completed.
+     */
+    void WaitIdle();
+
+    uint64_t     GetSubmitCount() const { return submitCount; }
+    VkDeviceSize GetCapacity() const { return capacity; }
+
+private:
+    struct Batch
+    {
+        Token           token                 = 0;
+        VkCommandPool   transferCommandPool   = VK_NULL_HANDLE;
+        VkCommandPool   graphicsCommandPool   = VK_NULL_HANDLE;
+        VkCommandBuffer transferCommandBuffer = VK_NULL_HANDLE;
+        VkCommandBuffer graphicsCommandBuffer = VK_NULL_HANDLE;
+        VkSemaphore     transferComplete      = VK_NULL_HANDLE;
+        VkFence         fence                 = VK_NULL_HANDLE;
+        uint64_t        ringEnd               = 0;
+        // Uploads larger than the whole ring get a staging buffer of their own.
+        std::vector<std::unique_ptr<Buffer>> dedicated;
+    };
+
+    std::mutex mutex;
+
+    VkDeviceSize            capacity;
+    std::unique_ptr<Buffer> buffer;
+    uint8_t*                mapped = nullptr;
+
+    // Offsets only ever grow, the ring position is the offset modulo the capacity. Bytes in [tail, head) are still used by the GPU.
+    uint64_t head = 0;
+    uint64_t tail = 0;
+
+    std::unique_ptr<Batch>              recording;
+    std::deque<std::unique_ptr<Batch>>  inFlight;
+    std::vector<std::unique_ptr<Batch>> freeBatches;
+
+    Token                 nextToken      = 1;
+    Token                 completedToken = 0;
+    std::atomic<uint64_t> submitCount    = 0;
+
+    Batch& GetRecording();
+    std::pair<VkBuffer, VkDeviceSize> Stage(const void* data, VkDeviceSize size, VkDeviceSize alignment);
+
+    Token FlushBatch();
+    void  Reclaim();
+    void  WaitOldest();
+
+    std::unique_ptr<Batch> CreateBatch() const;
+    void                   DestroyBatch(Batch& batch) const;
+
+    bool SharesQueueFamily() const;
+};
+}   // namespace MapleLeaf
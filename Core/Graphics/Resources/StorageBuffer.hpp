@@ -11,6 +11,7 @@ public:
 
     void Update(const void* newData);
     void Update(const void* newData, VkDeviceSize size);
+    using Buffer::Update;
 
     WriteDescriptorSet GetWriteDescriptor(uint32_t binding, VkDescriptorType descriptorType,
                                           const std::optional<OffsetSize>& offsetSize) const override;
@@ -13,16 +13,21 @@ Framebuffers::Framebuffers(const LogicalDevice& logicalDevice, const Swapchain&
         auto attachmentSamples = attachment.IsMultisampled() ? samples : VK_SAMPLE_COUNT_1_BIT;
 
         switch (attachment.GetType()) {
-        case Attachment::Type::Image:
-            imageAttachments.emplace_back(
-                std::make_unique<Image2d>(extent,
-                                          attachment.GetFormat(),
-                                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                                          VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-                                          attachment.GetFilter(),
-                                          VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
-                                          attachmentSamples));
+        case Attachment::Type::Image: {
+            // Packed formats such as sRGB ones can not be storage images on most devices.
+            VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+            auto storageFormat = Image::FindSupportedFormat({attachment.GetFormat()}, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT);
+            if (storageFormat != VK_FORMAT_UNDEFINED) usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+
+            imageAttachments.emplace_back(std::make_unique<Image2d>(extent,
+                                                                    attachment.GetFormat(),
+                                                                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                                                    usage,
+                                                                    attachment.GetFilter(),
+                                                                    VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                                                                    attachmentSamples));
             break;
+        }
         case Attachment::Type::Depth: imageAttachments.emplace_back(nullptr); break;
         case Attachment::Type::Swapchain: imageAttachments.emplace_back(nullptr); break;
         }
@@ -23,6 +23,11 @@ Swapchain::Swapchain(const PhysicalDevice& physicalDevice, const Surface& surfac
     , compositeAlpha(VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR)
     , activeImageIndex(std::numeric_limits<uint32_t>::max())
 {
+    if (surface.GetSurface() == VK_NULL_HANDLE) {
+        CreateOffscreenImages(surface.GetFormat().format);
+        return;
+    }
+
     auto surfaceFormat       = surface.GetFormat();
     auto surfaceCapabilities = surface.GetCapabilities();
     auto graphicsFamily      = logicalDevice.GetGraphicsFamily();
@@ -108,19 +113,53 @@ Swapchain::Swapchain(const PhysicalDevice& physicalDevice, const Surface& surfac
 
 Swapchain::~Swapchain()
 {
-    vkDestroySwapchainKHR(logicalDevice, swapchain, nullptr);
+    if (swapchain != VK_NULL_HANDLE) vkDestroySwapchainKHR(logicalDevice, swapchain, nullptr);
 
     for (const auto& imageView : imageViews) {
         vkDestroyImageView(logicalDevice, imageView, nullptr);
     }
 
+    for (std::size_t i = 0; i < offscreenMemories.size(); i++) {
+        vkDestroyImage(logicalDevice, images[i], nullptr);
+        Graphics::Get()->GetMemoryAllocator()->Free(offscreenMemories[i]);
+    }
+
     vkDestroyFence(logicalDevice, fenceImage, nullptr);
 }
 
+void Swapchain::CreateOffscreenImages(VkFormat format)
+{
+    imageCount = OffscreenImageCount;
+    images.resize(imageCount);
+    imageViews.resize(imageCount);
+    offscreenMemories.resize(imageCount);
+
+    for (uint32_t i = 0; i < imageCount; i++) {
+        Image::CreateImage(images[i],
+                           offscreenMemories[i],
+                           {extent.width, extent.height, 1},
+                           format,
+                           VK_SAMPLE_COUNT_1_BIT,
+                           VK_IMAGE_TILING_OPTIMAL,
+                           VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                           1,
+                           1,
+                           VK_IMAGE_TYPE_2D);
+        Image::CreateImageView(images[i], imageViews[i], VK_IMAGE_VIEW_TYPE_2D, format, VK_IMAGE_ASPECT_COLOR_BIT, 1, 0, 1, 0);
+    }
+}
+
 VkResult Swapchain::AcquireNextImage(const VkSemaphore& presentCompleteSemaphore, VkFence fence)
 {
     if (fence != VK_NULL_HANDLE) Graphics::CheckVk(vkWaitForFences(logicalDevice, 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max()));
 
+    // Offscreen images are free once the fence of the frame that last rendered them has signalled, the semaphore is left unsignalled.
+    if (IsOffscreen()) {
+        activeImageIndex = (activeImageIndex + 1) % imageCount;
+        return VK_SUCCESS;
+    }
+
     auto acquireResult = vkAcquireNextImageKHR(
         logicalDevice, swapchain, std::numeric_limits<uint64_t>::max(), presentCompleteSemaphore, VK_NULL_HANDLE, &activeImageIndex);
 
@@ -132,6 +171,8 @@ VkResult Swapchain::AcquireNextImage(const VkSemaphore& presentCompleteSemaphore
 
 VkResult Swapchain::QueuePresent(const VkQueue& presentQueue, const VkSemaphore& waitSemaphore)
 {
+    if (IsOffscreen()) return VK_SUCCESS;
+
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType            = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     presentInfo.swapchainCount   = 1;
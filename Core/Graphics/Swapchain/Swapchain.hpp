@@ -1,5 +1,6 @@
 #pragma once
 
+#include "MemoryAllocator.hpp"
 #include "volk.h"
 #include <vector>
 
@@ -11,6 +12,9 @@ class LogicalDevice;
 class Swapchain
 {
 public:
+    // A headless surface has no swapchain, images are created offscreen, acquired in turn and never presented.
+    static constexpr uint32_t OffscreenImageCount = 2;
+
     Swapchain(const PhysicalDevice& physicalDevice, const Surface& surface, const LogicalDevice& logicalDevice, const VkExtent2D& extent,
               const Swapchain* oldSwapchain = nullptr);
     ~Swapchain();
@@ -18,6 +22,7 @@ public:
     VkResult AcquireNextImage(const VkSemaphore& presentCompleteSemaphore = VK_NULL_HANDLE, VkFence fence = VK_NULL_HANDLE);
     VkResult QueuePresent(const VkQueue& presentQueue, const VkSemaphore& waitSemaphore = VK_NULL_HANDLE);
 
+    bool IsOffscreen() const { return swapchain == VK_NULL_HANDLE; }
     bool IsSameExtent(const VkExtent2D& extent2D) { return extent.width == extent2D.width && extent.height == extent2D.height; }
 
     operator const VkSwapchainKHR&() const { return swapchain; }
@@ -46,8 +51,12 @@ private:
     std::vector<VkImage>     images;
     std::vector<VkImageView> imageViews;
     VkSwapchainKHR           swapchain = VK_NULL_HANDLE;
+    // Memory of the images of an offscreen swapchain, the swapchain owns its images otherwise.
+    std::vector<MemoryAllocation> offscreenMemories;
 
     VkFence  fenceImage = VK_NULL_HANDLE;
     uint32_t activeImageIndex;
+
+    void CreateOffscreenImages(VkFormat format);
 };
 }   // namespace MapleLeaf
\ No newline at end of file
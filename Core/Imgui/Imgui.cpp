@@ -9,7 +9,8 @@ Imgui::Imgui()
 {
     ImGui::CreateContext();
 
-    ImGui_ImplGlfw_InitForVulkan(Devices::Get()->GetWindow()->GetWindow(), true);
+    // A headless window has no GLFW window to take input from, frames are still built so the overlay renders the same.
+    if (!Devices::Get()->GetWindow()->IsHeadless()) ImGui_ImplGlfw_InitForVulkan(Devices::Get()->GetWindow()->GetWindow(), true);
 
     ImGuiIO& io = ImGui::GetIO();
     // ImFont* font = io.Fonts->AddFontFromFileTTF("Fonts/DroidSans.ttf", 18.0f);
@@ -40,7 +41,7 @@ Imgui::Imgui()
 
 Imgui::~Imgui()
 {
-    ImGui_ImplGlfw_Shutdown();
+    if (!Devices::Get()->GetWindow()->IsHeadless()) ImGui_ImplGlfw_Shutdown();
     // if only one createContext don't need destroy context
 }
 
@@ -101,7 +102,10 @@ void Imgui::Update()
     ImGuiIO& io    = ImGui::GetIO();
     io.DisplaySize = ImVec2(Devices::Get()->GetWindow()->GetSize().x, Devices::Get()->GetWindow()->GetSize().y);
 
-    ImGui_ImplGlfw_NewFrame();
+    if (Devices::Get()->GetWindow()->IsHeadless())
+        io.DeltaTime = Engine::Get()->GetDeltaRender().AsSeconds();
+    else
+        ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
     ImGui::SetWindowPos(ImVec2(20, 20), ImGuiCond_FirstUseEver);
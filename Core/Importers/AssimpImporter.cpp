@@ -4,11 +4,16 @@
 #include "Devices.hpp"
 #include "Files.hpp"
 #include "Light.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "Resources.hpp"
 #include "SceneGraph.hpp"
 #include "Transform.hpp"
 
+#include "assimp/DefaultIOSystem.h"
 #include "assimp/mesh.h"
 #include "assimp/metadata.h"
+#include "assimp/version.h"
 #include "config.h"
 
 namespace MapleLeaf {
@@ -44,6 +49,21 @@ static const std::vector<TextureMapping> kTextureMappings[3] = {
         {AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLICROUGHNESS_TEXTURE, Material::TextureSlot::Material},
     }};
 
+// How the meshes are processed after conversion, it is part of the baked scene key as it changes the baked content. Only 32 bit members, so
+// the struct has no padding and hashes as it is.
+struct MeshProcessingOptions
+{
+    uint32_t optimizeOverdraw;
+    uint32_t lodLevels;
+    float    lodReduction;
+};
+
+#ifdef MAPLELEAF_OPTIMIZE_OVERDRAW
+static constexpr MeshProcessingOptions kMeshProcessingOptions = {true, MeshSimplifier::MaxLevels, 0.5f};
+#else
+static constexpr MeshProcessingOptions kMeshProcessingOptions = {false, MeshSimplifier::MaxLevels, 0.5f};
+#endif
+
 glm::mat4 AiCast(const aiMatrix4x4& aiMat)
 {
     glm::mat4 ret{aiMat.a1,
@@ -77,6 +97,25 @@ glm::quat AiCast(const aiQuaternion& q)
     return glm::quat(q.w, q.x, q.y, q.z);
 }
 
+// Records every file Assimp opens, they become dependencies of the baked scene.
+class RecordingIOSystem : public Assimp::DefaultIOSystem
+{
+public:
+    explicit RecordingIOSystem(std::set<std::filesystem::path>& openedFiles)
+        : openedFiles(openedFiles)
+    {}
+
+    Assimp::IOStream* Open(const char* file, const char* mode) override
+    {
+        auto stream = Assimp::DefaultIOSystem::Open(file, mode);
+        if (stream) openedFiles.emplace(file);
+        return stream;
+    }
+
+private:
+    std::set<std::filesystem::path>& openedFiles;
+};
+
 template<typename T>
 void AssimpImporter<T>::Import(const std::filesystem::path& path, Builder& builder)
 {
@@ -89,6 +128,26 @@ void AssimpImporter<T>::Import(const std::filesystem::path& path, Builder& build
         return;
     }
 
+#ifdef MAPLELEAF_SCENE_CACHE
+    // The Assimp version and the processing options are part of the key, either may produce a different scene from the same file.
+    auto sourceHash = SceneCache::HashFile(*exisitPath);
+    if (sourceHash) {
+        const uint32_t assimpVersion[] = {aiGetVersionMajor(), aiGetVersionMinor(), aiGetVersionRevision()};
+        sourceHash                     = Maths::HashFNV1a(assimpVersion, sizeof(assimpVersion), *sourceHash);
+        sourceHash                     = Maths::HashFNV1a(&kMeshProcessingOptions, sizeof(kMeshProcessingOptions), *sourceHash);
+
+        SceneCache::SceneData baked;
+        if (SceneCache::Load(*exisitPath, *sourceHash, baked)) {
+            ImporterData data(exisitPath.value(), nullptr, builder);
+            LoadBaked(data, baked);
+#ifdef MAPLELEAF_SCENE_DEBUG
+            Log::Out("Load baked scene cost: ", (Time::Now() - debugStart).AsMilliseconds<float>(), "ms\n");
+#endif
+            return;
+        }
+    }
+#endif
+
     uint32_t assimpFlags = aiProcessPreset_TargetRealtime_MaxQuality | aiProcess_FlipUVs | aiProcess_RemoveComponent | aiProcess_Triangulate;
 
     assimpFlags &= ~(aiProcess_CalcTangentSpace);           // Never use Assimp's tangent gen code
@@ -98,18 +157,23 @@ void AssimpImporter<T>::Import(const std::filesystem::path& path, Builder& build
                                                             // 'SceneBuilder' instead.
     assimpFlags &= ~(aiProcess_SplitLargeMeshes);           // Avoid splitting large meshes
     assimpFlags &= ~(aiProcess_OptimizeMeshes);             // Avoid merging original meshes
+    assimpFlags &= ~(aiProcess_ImproveCacheLocality);       // 'MeshOptimizer' reorders triangles and vertices in 'CreateMeshes' instead
 
     int removeFlags = aiComponent_COLORS;
     for (uint32_t uvLayer = 1; uvLayer < AI_MAX_NUMBER_OF_TEXTURECOORDS; uvLayer++) removeFlags |= aiComponent_TEXCOORDSn(uvLayer);
     removeFlags |= aiComponent_TANGENTS_AND_BITANGENTS;
 
-    Assimp::Importer importer;
+    std::set<std::filesystem::path> openedFiles;
+    Assimp::Importer                importer;
     importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, removeFlags);
+    importer.SetIOHandler(new RecordingIOSystem(openedFiles));   // Owned by the importer.
 
     const aiScene* pScene = importer.ReadFile(exisitPath->string().c_str(), assimpFlags);
     if (!pScene) Log::Error("Failed to open scene: ", importer.GetErrorString());
 
     ImporterData data(exisitPath.value(), pScene, builder);
+    data.openedFiles = std::move(openedFiles);
+    data.openedFiles.erase(*exisitPath);
 
     auto searchPath = exisitPath->parent_path();
 
@@ -152,6 +216,13 @@ void AssimpImporter<T>::Import(const std::filesystem::path& path, Builder& build
     Log::Out("Create lights cost: ", (Time::Now() - debugStart).AsMilliseconds<float>(), "ms\n");
     debugStart = Time::Now();
 #endif
+
+#ifdef MAPLELEAF_SCENE_CACHE
+    if (SceneCache::SceneData baked; sourceHash && Bake(data, baked)) SceneCache::Save(*exisitPath, *sourceHash, baked);
+#ifdef MAPLELEAF_SCENE_DEBUG
+    Log::Out("Bake scene cost: ", (Time::Now() - debugStart).AsMilliseconds<float>(), "ms\n");
+#endif
+#endif
 }
 
 template<typename T>
@@ -173,8 +244,8 @@ void AssimpImporter<T>::LoadTextures(ImporterData& data, const aiMaterial* pAiMa
                 Log::Warning("AssimpImporter: Texture has empty file name, ignoring.");
                 continue;
             }
-            auto fullPath = searchPath / path;
-            data.builder.loadMaterialTexture(pMaterial, source.targetType, fullPath);
+            // Decoded later by LoadAllTextures, together with every other texture of the scene.
+            data.textureLoads.push_back({pMaterial, source.targetType, searchPath / path});
         }
         break;
     case ImportMode::OBJ: break;       // TODO
@@ -190,6 +261,43 @@ void AssimpImporter<T>::CreateAllMaterials(ImporterData& data, const std::filesy
         data.materialMap[i]           = std::move(CreateMaterial(data, pAiMaterial, searchPath, importMode));
         // data.builder.AddMaterial(std::move(data.materialMap[i]));
     }
+
+    LoadAllTextures(data);
+}
+
+template<typename T>
+void AssimpImporter<T>::LoadAllTextures(ImporterData& data)
+{
+    auto& threadPool = Resources::Get()->GetThreadPool();
+
+    // Each file is decoded once on the loader threads, images are then created in request order so the result matches a serial load.
+    std::map<std::filesystem::path, Future<std::unique_ptr<Bitmap>>> bitmaps;
+    for (const auto& textureLoad : data.textureLoads) {
+        if (bitmaps.find(textureLoad.path) != bitmaps.end()) continue;
+        bitmaps.emplace(textureLoad.path, threadPool.Enqueue([](const std::filesystem::path& path) { return std::make_unique<Bitmap>(path); },
+                                                             textureLoad.path));
+    }
+
+    std::map<std::filesystem::path, uint32_t> remainingUses;
+    for (const auto& textureLoad : data.textureLoads) remainingUses[textureLoad.path]++;
+
+    for (auto& textureLoad : data.textureLoads) {
+        auto& bitmap = bitmaps[textureLoad.path].get();
+
+        // Every material slot still owns its own image, the last user takes the decoded bitmap and the others copy it.
+        std::unique_ptr<Bitmap> imageBitmap;
+        if (--remainingUses[textureLoad.path] == 0) {
+            imageBitmap = std::move(bitmap);
+        }
+        else {
+            auto pixels = std::make_unique<uint8_t[]>(bitmap->GetLength());
+            if (bitmap->GetData()) std::memcpy(pixels.get(), bitmap->GetData().get(), bitmap->GetLength());
+            imageBitmap = std::make_unique<Bitmap>(std::move(pixels), bitmap->GetSize(), bitmap->GetFormat());
+            imageBitmap->SetFilename(bitmap->GetFilename());
+        }
+
+        data.builder.setMaterialTexture(textureLoad.material, textureLoad.slot, Image2d::Create(std::move(imageBitmap)));
+    }
 }
 
 template<typename T>
@@ -307,81 +415,134 @@ void AssimpImporter<T>::CreateMeshes(ImporterData& data)
         meshes.push_back(pMesh);
     }
 
+    struct MeshBuffers
+    {
+        std::vector<Vertex3D>              vertexBuffer;
+        std::vector<uint32_t>              indexBuffer;
+        MeshOptimizer::Result              statistics;
+        std::vector<MeshSimplifier::Level> lods;
+        std::vector<Meshlet>               meshlets;
+    };
+
+    // Conversion, optimization, level of detail simplification and meshlet clustering of each mesh are independent, so they run on the loader
+    // threads.
+    auto&                            threadPool = Resources::Get()->GetThreadPool();
+    std::vector<Future<MeshBuffers>> meshBuffers;
+    meshBuffers.reserve(meshes.size());
     for (const auto& pAiMesh : meshes) {
-        std::vector<uint32_t> indexBuffer;
-        std::vector<Vertex3D> vertexBuffer;
+        meshBuffers.emplace_back(threadPool.Enqueue([pAiMesh]() {
+            MeshBuffers buffers;
+            ConvertMesh(pAiMesh, buffers.vertexBuffer, buffers.indexBuffer);
+            buffers.statistics = MeshOptimizer::Optimize(buffers.vertexBuffer, buffers.indexBuffer, kMeshProcessingOptions.optimizeOverdraw);
+            buffers.lods       = MeshSimplifier::BuildLevels(buffers.vertexBuffer, buffers.indexBuffer, kMeshProcessingOptions.lodLevels,
+                                                             kMeshProcessingOptions.lodReduction);
+            buffers.meshlets   = MeshletBuilder::BuildLevels(buffers.vertexBuffer, buffers.indexBuffer, buffers.lods);
+            return buffers;
+        }));
+    }
 
-        // index buffer read
-        const uint32_t perFaceIndexCount = pAiMesh->mFaces[0].mNumIndices;
-        const uint32_t indexCount        = pAiMesh->mNumFaces * perFaceIndexCount;
-        indexBuffer.resize(indexCount);
+    // Statistics of all meshes weighted by their triangles and vertices, the fetch optimization drops unreferenced vertices.
+    MeshOptimizer::Result total;
+    std::size_t           triangleCount = 0, vertexCount = 0;
+
+    // Models are created in scene order, which keeps the mesh list identical to a serial import.
+    for (uint32_t i = 0; i < meshes.size(); i++) {
+        auto& buffers = meshBuffers[i].get();
+
+        auto triangles = buffers.indexBuffer.size() / 3;
+        auto vertices  = buffers.vertexBuffer.size();
+        total.before.acmr += buffers.statistics.before.acmr * triangles;
+        total.before.atvr += buffers.statistics.before.atvr * vertices;
+        total.after.acmr += buffers.statistics.after.acmr * triangles;
+        total.after.atvr += buffers.statistics.after.atvr * vertices;
+        triangleCount += triangles;
+        vertexCount += vertices;
+
+        auto model = std::make_shared<Model>(buffers.vertexBuffer, buffers.indexBuffer);
+        model->SetLods(std::move(buffers.lods));
+        model->SetMeshlets(std::move(buffers.meshlets));
+        data.builder.AddMesh(std::move(model), data.materialMap[meshes[i]->mMaterialIndex]);
+    }
 
-        for (uint32_t i = 0; i < pAiMesh->mNumFaces; i++) {
-            assert(pAiMesh->mFaces[i].mNumIndices == perFaceIndexCount);
-            for (uint32_t j = 0; j < perFaceIndexCount; j++) indexBuffer[i * perFaceIndexCount + j] = (uint32_t)(pAiMesh->mFaces[i].mIndices[j]);
-        }
+#ifdef MAPLELEAF_SCENE_DEBUG
+    if (triangleCount > 0) {
+        Log::Out("Mesh optimization ACMR ", total.before.acmr / triangleCount, " -> ", total.after.acmr / triangleCount, ", ATVR ",
+                 total.before.atvr / vertexCount, " -> ", total.after.atvr / vertexCount, "\n");
+    }
+#endif
+}
 
-        assert(indexBuffer.size() <= std::numeric_limits<uint32_t>::max());
-        // vertex buffer read
-        assert(pAiMesh->mVertices);
-        vertexBuffer.resize(pAiMesh->mNumVertices);
-        static_assert(sizeof(pAiMesh->mVertices[0]) == sizeof(vertexBuffer[0].position));
-        static_assert(sizeof(pAiMesh->mNormals[0]) == sizeof(vertexBuffer[0].normal));
-
-        for (uint32_t i = 0; i < pAiMesh->mNumVertices; i++) {
-            glm::vec3 position = glm::vec3(pAiMesh->mVertices[i].x, pAiMesh->mVertices[i].y, pAiMesh->mVertices[i].z);
-            glm::vec3 normal   = glm::vec3(pAiMesh->mNormals[i].x, pAiMesh->mNormals[i].y, pAiMesh->mNormals[i].z);
-            glm::vec2 uv       = glm::vec2(0.0f);
-            glm::vec3 tangent  = glm::vec3(0.0f);
-            if (pAiMesh->HasTextureCoords(0)) uv = glm::vec2(pAiMesh->mTextureCoords[0][i].x, pAiMesh->mTextureCoords[0][i].y);
-            if (pAiMesh->HasTangentsAndBitangents()) tangent = glm::vec3(pAiMesh->mTangents[i].x, pAiMesh->mTangents[i].y, pAiMesh->mTangents[i].z);
-
-            vertexBuffer[i] = std::move(Vertex3D(position, uv, normal, tangent));
-        }
+template<typename T>
+void AssimpImporter<T>::ConvertMesh(const aiMesh* pAiMesh, std::vector<Vertex3D>& vertexBuffer, std::vector<uint32_t>& indexBuffer)
+{
+    // index buffer read
+    const uint32_t perFaceIndexCount = pAiMesh->mFaces[0].mNumIndices;
+    const uint32_t indexCount        = pAiMesh->mNumFaces * perFaceIndexCount;
+    indexBuffer.resize(indexCount);
+
+    for (uint32_t i = 0; i < pAiMesh->mNumFaces; i++) {
+        assert(pAiMesh->mFaces[i].mNumIndices == perFaceIndexCount);
+        for (uint32_t j = 0; j < perFaceIndexCount; j++) indexBuffer[i * perFaceIndexCount + j] = (uint32_t)(pAiMesh->mFaces[i].mIndices[j]);
+    }
+
+    assert(indexBuffer.size() <= std::numeric_limits<uint32_t>::max());
+    // vertex buffer read
+    assert(pAiMesh->mVertices);
+    vertexBuffer.resize(pAiMesh->mNumVertices);
+    static_assert(sizeof(pAiMesh->mVertices[0]) == sizeof(vertexBuffer[0].position));
+    static_assert(sizeof(pAiMesh->mNormals[0]) == sizeof(vertexBuffer[0].normal));
+
+    for (uint32_t i = 0; i < pAiMesh->mNumVertices; i++) {
+        glm::vec3 position = glm::vec3(pAiMesh->mVertices[i].x, pAiMesh->mVertices[i].y, pAiMesh->mVertices[i].z);
+        glm::vec3 normal   = glm::vec3(pAiMesh->mNormals[i].x, pAiMesh->mNormals[i].y, pAiMesh->mNormals[i].z);
+        glm::vec2 uv       = glm::vec2(0.0f);
+        glm::vec3 tangent  = glm::vec3(0.0f);
+        if (pAiMesh->HasTextureCoords(0)) uv = glm::vec2(pAiMesh->mTextureCoords[0][i].x, pAiMesh->mTextureCoords[0][i].y);
+        if (pAiMesh->HasTangentsAndBitangents()) tangent = glm::vec3(pAiMesh->mTangents[i].x, pAiMesh->mTangents[i].y, pAiMesh->mTangents[i].z);
+
+        vertexBuffer[i] = std::move(Vertex3D(position, uv, normal, tangent));
+    }
 
-        if (!pAiMesh->HasTangentsAndBitangents() && pAiMesh->HasTextureCoords(0)) {
-            // Calculate tangents
-            for (uint32_t i = 0; i < indexBuffer.size(); i += 3) {
-                const Vertex3D& v0 = vertexBuffer[indexBuffer[i]];
-                const Vertex3D& v1 = vertexBuffer[indexBuffer[i + 1]];
-                const Vertex3D& v2 = vertexBuffer[indexBuffer[i + 2]];
+    if (!pAiMesh->HasTangentsAndBitangents() && pAiMesh->HasTextureCoords(0)) {
+        // Calculate tangents
+        for (uint32_t i = 0; i < indexBuffer.size(); i += 3) {
+            const Vertex3D& v0 = vertexBuffer[indexBuffer[i]];
+            const Vertex3D& v1 = vertexBuffer[indexBuffer[i + 1]];
+            const Vertex3D& v2 = vertexBuffer[indexBuffer[i + 2]];
 
-                glm::vec3 edge1 = v1.position - v0.position;
-                glm::vec3 edge2 = v2.position - v0.position;
+            glm::vec3 edge1 = v1.position - v0.position;
+            glm::vec3 edge2 = v2.position - v0.position;
 
-                glm::vec2 deltaUV1 = v1.uv - v0.uv;
-                glm::vec2 deltaUV2 = v2.uv - v0.uv;
+            glm::vec2 deltaUV1 = v1.uv - v0.uv;
+            glm::vec2 deltaUV2 = v2.uv - v0.uv;
 
-                float det = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
-                if (std::fabs(det) < 1e-6f) continue;
+            float det = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+            if (std::fabs(det) < 1e-6f) continue;
 
-                float f = 1.0f / det;
+            float f = 1.0f / det;
 
-                glm::vec3 tangent;
-                tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-                tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-                tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
+            glm::vec3 tangent;
+            tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
+            tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
+            tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
 
-                for (uint32_t j = 0; j < 3; j++) {
-                    vertexBuffer[indexBuffer[i + j]].tangent += tangent;
-                }
+            for (uint32_t j = 0; j < 3; j++) {
+                vertexBuffer[indexBuffer[i + j]].tangent += tangent;
             }
-            for (auto& vertex : vertexBuffer) {
-                if (glm::length(vertex.tangent) < 1e-6f || glm::any(glm::isnan(vertex.tangent))) {
-                    vertex.tangent = glm::vec3(1.0f, 0.0f, 0.0f);
-
-                    if (glm::length(vertex.normal) > 0.0f) {
-                        glm::vec3 temp = glm::cross(vertex.normal, vertex.tangent);
-                        temp           = glm::length(temp) < 1e-6f ? glm::vec3(0.0f, 1.0f, 0.0f) : temp;
-                        vertex.tangent = glm::normalize(glm::cross(temp, vertex.normal));
-                    }
+        }
+        for (auto& vertex : vertexBuffer) {
+            if (glm::length(vertex.tangent) < 1e-6f || glm::any(glm::isnan(vertex.tangent))) {
+                vertex.tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+
+                if (glm::length(vertex.normal) > 0.0f) {
+                    glm::vec3 temp = glm::cross(vertex.normal, vertex.tangent);
+                    temp           = glm::length(temp) < 1e-6f ? glm::vec3(0.0f, 1.0f, 0.0f) : temp;
+                    vertex.tangent = glm::normalize(glm::cross(temp, vertex.normal));
                 }
-                vertex.tangent = glm::normalize(vertex.tangent);
-                vertex.tangent = glm::normalize(vertex.tangent - glm::dot(vertex.tangent, vertex.normal) * vertex.normal);
             }
+            vertex.tangent = glm::normalize(vertex.tangent);
+            vertex.tangent = glm::normalize(vertex.tangent - glm::dot(vertex.tangent, vertex.normal) * vertex.normal);
         }
-
-        data.builder.AddMesh(std::make_shared<Model>(vertexBuffer, indexBuffer), data.materialMap[pAiMesh->mMaterialIndex]);
     }
 }
 
@@ -574,5 +735,161 @@ void AssimpImporter<T>::ParseAnimation(ImporterData& data, const aiAnimation* pA
     }
 }
 
+template<typename T>
+bool AssimpImporter<T>::Bake(ImporterData& data, SceneCache::SceneData& scene)
+{
+    const Builder& builder = data.builder;
+
+    std::map<const Material*, uint32_t> materialIndices;
+    for (const auto& [index, material] : data.materialMap) {
+        // Materials of formats the importer doesn't handle yet are left empty, such scenes are not baked.
+        if (!material) return false;
+
+        materialIndices[material.get()] = static_cast<uint32_t>(scene.materials.size());
+        scene.materials.push_back({material->GetBaseDiffuse(), material->GetMetallic(), material->GetRoughness(), {}});
+    }
+
+    // Editing any file the import read makes the bake stale, not only the scene file the cache key hashes.
+    std::set<std::filesystem::path> dependencies = data.openedFiles;
+    for (const auto& textureLoad : data.textureLoads) {
+        auto& textures = scene.materials[materialIndices.at(textureLoad.material.get())].textures;
+        textures.push_back({static_cast<uint32_t>(textureLoad.slot), textureLoad.path.string()});
+        dependencies.emplace(textureLoad.path);
+    }
+    for (const auto& dependency : dependencies) scene.dependencies.push_back(SceneCache::GetDependency(dependency));
+
+    for (const auto& node : builder.sceneGraph) {
+        scene.nodes.push_back({node.name,
+                               node.transform->GetLocalPosition(),
+                               node.transform->GetLocalRotation(),
+                               node.transform->GetLocalScale(),
+                               node.parent.get(),
+                               node.meshes,
+                               node.flags});
+    }
+
+    for (const auto& mesh : builder.meshes) {
+        auto material = materialIndices.find(mesh->GetMaterial().get());
+        if (material == materialIndices.end()) return false;
+
+        const auto& model = mesh->GetModel();
+        auto&       baked = scene.meshes.emplace_back(
+            SceneCache::MeshData{material->second, model->GetVertices(), model->GetIndices(), {}, model->GetMeshlets()});
+        for (const auto& lod : model->GetLods()) baked.lods.push_back({lod.error, lod.indices});
+    }
+
+    for (const auto& [nodeID, animation] : builder.animations) {
+        scene.animations.push_back({nodeID.get(),
+                                    animation->getName(),
+                                    animation->getDuration(),
+                                    static_cast<uint32_t>(animation->getPreInfinityBehavior()),
+                                    static_cast<uint32_t>(animation->getPostInfinityBehavior()),
+                                    static_cast<uint32_t>(animation->getInterpolationMode()),
+                                    animation->isWarpingEnabled(),
+                                    animation->getKeyframes()});
+    }
+    // The builder keeps animations in a hash map, sorting them keeps the baked file stable between runs.
+    std::sort(scene.animations.begin(), scene.animations.end(), [](const auto& lhs, const auto& rhs) { return lhs.node < rhs.node; });
+
+    for (const auto& camera : builder.cameras) {
+        scene.cameras.push_back({camera->GetName(),
+                                 camera->GetPosition(),
+                                 camera->GetUpVector(),
+                                 camera->GetFieldOfView(),
+                                 camera->GetAspectRatio(),
+                                 camera->GetNearPlane(),
+                                 camera->GetFarPlane()});
+    }
+
+    for (const auto& light : builder.lights) {
+        scene.lights.push_back({static_cast<uint32_t>(light->type),
+                                light->GetName(),
+                                light->GetColor(),
+                                light->GetPosition(),
+                                light->GetDirection(),
+                                light->GetAttenuation(),
+                                light->GetPoints(),
+                                light->GetTwoSide(),
+                                light->GetIntensity()});
+    }
+
+    return true;
+}
+
+template<typename T>
+void AssimpImporter<T>::LoadBaked(ImporterData& data, const SceneCache::SceneData& scene)
+{
+    for (uint32_t i = 0; i < scene.materials.size(); i++) {
+        const auto& baked    = scene.materials[i];
+        auto        material = std::make_shared<DefaultMaterial>(baked.baseDiffuse, nullptr, baked.metallic, baked.roughness);
+
+        for (const auto& texture : baked.textures)
+            data.textureLoads.push_back({material, static_cast<Material::TextureSlot>(texture.slot), texture.path});
+        data.materialMap[i] = std::move(material);
+    }
+
+    LoadAllTextures(data);
+
+    for (const auto& baked : scene.nodes) {
+        SceneNode node;
+        node.name      = baked.name;
+        node.transform = new Transform(baked.position, baked.rotation, baked.scale);
+        node.parent    = NodeID(baked.parent);
+        node.meshes    = baked.meshes;
+        node.flags     = baked.flags;
+        data.builder.AddSceneNode(std::move(node));
+    }
+
+    for (const auto& baked : scene.meshes) {
+        auto model = std::make_shared<Model>(baked.vertices, baked.indices);
+
+        std::vector<MeshSimplifier::Level> lods;
+        lods.reserve(baked.lods.size());
+        for (const auto& lod : baked.lods) lods.push_back({lod.indices, lod.error});
+        model->SetLods(std::move(lods));
+        model->SetMeshlets(std::vector<Meshlet>(baked.meshlets));
+
+        data.builder.AddMesh(std::move(model), data.materialMap[baked.material]);
+    }
+
+    for (const auto& baked : scene.animations) {
+        auto animation = Animation::create(baked.name, NodeID(baked.node), baked.duration);
+        animation->setPreInfinityBehavior(static_cast<Animation::Behavior>(baked.preInfinity));
+        animation->setPostInfinityBehavior(static_cast<Animation::Behavior>(baked.postInfinity));
+        animation->setInterpolationMode(static_cast<Animation::InterpolationMode>(baked.interpolation));
+        animation->setEnableWarping(baked.warping);
+        for (const auto& keyframe : baked.keyframes) animation->addKeyframe(keyframe);
+
+        data.builder.AddAnimation(NodeID(baked.node), animation);
+    }
+
+    for (const auto& baked : scene.cameras) {
+        auto camera = std::make_unique<Camera>();
+        camera->SetName(baked.name);
+        camera->SetPosition(baked.position);
+        camera->SetUpVector(baked.up);
+        camera->SetFieldOfView(baked.fieldOfView);
+        camera->SetAspectRatio(baked.aspectRatio);
+        camera->SetNearPlane(baked.nearPlane);
+        camera->SetFarPlane(baked.farPlane);
+
+        data.builder.AddCamera(std::move(camera));
+    }
+
+    for (const auto& baked : scene.lights) {
+        auto light = std::make_unique<Light>(static_cast<LightType>(baked.type));
+        light->SetName(baked.name);
+        light->SetColor(baked.color);
+        light->SetPosition(baked.position);
+        light->SetDirection(baked.direction);
+        light->SetAttenuation(baked.attenuation);
+        light->SetPoints(baked.points);
+        light->SetTwoSide(baked.twoSide);
+        light->SetIntensity(baked.intensity);
+
+        data.builder.AddLight(std::move(light));
+    }
+}
+
 template class AssimpImporter<DefaultMaterial>;
 }   // namespace MapleLeaf
\ No newline at end of file
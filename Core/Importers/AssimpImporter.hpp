@@ -3,6 +3,7 @@
 #include "DefaultBuilder.hpp"
 #include "DefaultMaterial.hpp"
 #include "NonCopyable.hpp"
+#include "SceneCache.hpp"
 #include "SceneGraph.hpp"
 #include "assimp/Importer.hpp"
 #include "assimp/material.h"
@@ -11,6 +12,7 @@
 #include "assimp/scene.h"
 #include <filesystem>
 #include <map>
+#include <set>
 
 namespace MapleLeaf {
 class ImporterData;
@@ -41,6 +43,18 @@ public:
         std::map<uint32_t, std::shared_ptr<T>> materialMap;
         std::vector<const aiNode*>             areaLights;
 
+        // Textures referenced by materials, in the order the serial importer used to load them.
+        struct TextureLoad
+        {
+            std::shared_ptr<T>    material;
+            Material::TextureSlot slot;
+            std::filesystem::path path;
+        };
+        std::vector<TextureLoad> textureLoads;
+
+        // Files Assimp read besides the scene file, such as the buffers of a glTF.
+        std::set<std::filesystem::path> openedFiles;
+
         ImporterData(const std::filesystem::path& path, const aiScene* pAiScene, Builder& builder)
             : path(path)
             , pScene(pAiScene)
@@ -83,6 +97,7 @@ private:
     void LoadTextures(ImporterData& data, const aiMaterial* pAiMaterial, const std::filesystem::path& searchPath, std::shared_ptr<T>& pMaterial,
                       ImportMode importMode);
     void CreateAllMaterials(ImporterData& data, const std::filesystem::path& searchPath, ImportMode importMode);
+    void LoadAllTextures(ImporterData& data);
     std::shared_ptr<T> CreateMaterial(ImporterData& data, const aiMaterial* pAiMaterial, const std::filesystem::path& searchPath,
                                       ImportMode importMode);
 
@@ -90,7 +105,8 @@ private:
     void ParseNode(ImporterData& data, const aiNode* pCurrent, bool hasBoneAncestor);
     void ParseAnimation(ImporterData& data, const aiAnimation* pAiAnimation, ImportMode importMode);
 
-    void CreateMeshes(ImporterData& data);
+    void        CreateMeshes(ImporterData& data);
+    static void ConvertMesh(const aiMesh* pAiMesh, std::vector<Vertex3D>& vertexBuffer, std::vector<uint32_t>& indexBuffer);
 
     void CreateLights(ImporterData& data);
     void CreateCameras(ImporterData& data, ImportMode importMode);
@@ -98,5 +114,8 @@ private:
     void CreatePointLight(ImporterData& data, const aiLight* pAiLight);
     void CreateAreaLights(ImporterData& data, const aiNode* pAiNode);
     void CreateAnimations(ImporterData& data, ImportMode importMode);
+
+    bool Bake(ImporterData& data, SceneCache::SceneData& scene);
+    void LoadBaked(ImporterData& data, const SceneCache::SceneData& scene);
 };
 }   // namespace MapleLeaf
\ No newline at end of file
@@ -13,6 +13,8 @@ namespace MapleLeaf {
 class Builder
 {
     friend class SceneBuilder;
+    template<typename T>
+    friend class AssimpImporter;
 
 public:
     Builder() = default;
@@ -36,7 +38,13 @@ public:
     {
         if (material == nullptr) return false;
 
-        auto image = Image2d::Create(path);
+        return setMaterialTexture(material, textureType, Image2d::Create(path));
+    }
+
+    template<typename T, typename = std::enable_if_t<std::is_convertible_v<T*, Material*>>>
+    bool setMaterialTexture(std::shared_ptr<T>& material, Material::TextureSlot textureType, std::shared_ptr<Image2d>&& image)
+    {
+        if (material == nullptr) return false;
 
         if (textureType == Material::TextureSlot::BaseColor)
             material->SetImageDiffuse(std::move(image));
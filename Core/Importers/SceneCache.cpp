@@ -0,0 +1,445 @@
+#include "SceneCache.hpp"
+#include "Log.hpp"
+#include "Maths.hpp"
+
+#include "config.h"
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+
+namespace MapleLeaf {
+namespace {
+constexpr std::size_t kArrayAlignment = 8;
+
+class Writer
+{
+public:
+    template<typename T>
+    void Write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto offset = buffer.size();
+        buffer.resize(offset + sizeof(T));
+        std::memcpy(buffer.data() + offset, &value, sizeof(T));
+    }
+
+    void Write(const std::string& value)
+    {
+        Write(static_cast<uint64_t>(value.size()));
+        buffer.insert(buffer.end(), value.begin(), value.end());
+    }
+
+    template<typename T>
+    void WriteArray(const std::vector<T>& values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Write(static_cast<uint64_t>(values.size()));
+        buffer.resize((buffer.size() + kArrayAlignment - 1) / kArrayAlignment * kArrayAlignment, 0);
+
+        auto offset = buffer.size();
+        buffer.resize(offset + values.size() * sizeof(T));
+        if (!values.empty()) std::memcpy(buffer.data() + offset, values.data(), values.size() * sizeof(T));
+    }
+
+    void WriteStrings(const std::vector<std::string>& values)
+    {
+        Write(static_cast<uint64_t>(values.size()));
+        for (const auto& value : values) Write(value);
+    }
+
+    const std::vector<char>& GetBuffer() const { return buffer; }
+
+private:
+    std::vector<char> buffer;
+};
+
+class Reader
+{
+public:
+    Reader(const char* data, std::size_t size)
+        : data(data)
+        , size(size)
+    {}
+
+    template<typename T>
+    bool Read(T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (size - offset < sizeof(T)) return false;
+        std::memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    bool Read(std::string& value)
+    {
+        uint64_t length;
+        if (!Read(length) || size - offset < length) return false;
+        value.assign(data + offset, length);
+        offset += length;
+        return true;
+    }
+
+    template<typename T>
+    bool ReadArray(std::vector<T>& values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        uint64_t count;
+        if (!Read(count)) return false;
+
+        offset = (offset + kArrayAlignment - 1) / kArrayAlignment * kArrayAlignment;
+        if (offset > size || (size - offset) / sizeof(T) < count) return false;
+
+        values.resize(count);
+        if (count > 0) std::memcpy(values.data(), data + offset, count * sizeof(T));
+        offset += count * sizeof(T);
+        return true;
+    }
+
+    bool ReadStrings(std::vector<std::string>& values)
+    {
+        uint64_t count;
+        if (!Read(count) || count > size - offset) return false;
+
+        values.resize(count);
+        for (auto& value : values) {
+            if (!Read(value)) return false;
+        }
+        return true;
+    }
+
+    // Element counts are checked against the bytes left, so a corrupted count can't trigger a huge allocation.
+    template<typename T>
+    bool ReadCount(std::vector<T>& values)
+    {
+        uint64_t count;
+        if (!Read(count) || count > size - offset) return false;
+        values.resize(count);
+        return true;
+    }
+
+    bool IsEnd() const { return offset == size; }
+
+private:
+    const char* data;
+    std::size_t size;
+    std::size_t offset = 0;
+};
+
+void WriteScene(Writer& writer, const SceneCache::SceneData& scene)
+{
+    writer.Write(static_cast<uint64_t>(scene.nodes.size()));
+    for (const auto& node : scene.nodes) {
+        writer.Write(node.name);
+        writer.Write(node.position);
+        writer.Write(node.rotation);
+        writer.Write(node.scale);
+        writer.Write(node.parent);
+        writer.WriteArray(node.meshes);
+        writer.WriteStrings(node.flags);
+    }
+
+    writer.Write(static_cast<uint64_t>(scene.materials.size()));
+    for (const auto& material : scene.materials) {
+        writer.Write(material.baseDiffuse);
+        writer.Write(material.metallic);
+        writer.Write(material.roughness);
+        writer.Write(static_cast<uint64_t>(material.textures.size()));
+        for (const auto& texture : material.textures) {
+            writer.Write(texture.slot);
+            writer.Write(texture.path);
+        }
+    }
+
+    writer.Write(static_cast<uint64_t>(scene.meshes.size()));
+    for (const auto& mesh : scene.meshes) {
+        writer.Write(mesh.material);
+        writer.WriteArray(mesh.vertices);
+        writer.WriteArray(mesh.indices);
+        writer.Write(static_cast<uint64_t>(mesh.lods.size()));
+        for (const auto& lod : mesh.lods) {
+            writer.Write(lod.error);
+            writer.WriteArray(lod.indices);
+        }
+        writer.WriteArray(mesh.meshlets);
+    }
+
+    writer.Write(static_cast<uint64_t>(scene.animations.size()));
+    for (const auto& animation : scene.animations) {
+        writer.Write(animation.node);
+        writer.Write(animation.name);
+        writer.Write(animation.duration);
+        writer.Write(animation.preInfinity);
+        writer.Write(animation.postInfinity);
+        writer.Write(animation.interpolation);
+        writer.Write(animation.warping);
+        writer.WriteArray(animation.keyframes);
+    }
+
+    writer.Write(static_cast<uint64_t>(scene.cameras.size()));
+    for (const auto& camera : scene.cameras) {
+        writer.Write(camera.name);
+        writer.Write(camera.position);
+        writer.Write(camera.up);
+        writer.Write(camera.fieldOfView);
+        writer.Write(camera.aspectRatio);
+        writer.Write(camera.nearPlane);
+        writer.Write(camera.farPlane);
+    }
+
+    writer.Write(static_cast<uint64_t>(scene.lights.size()));
+    for (const auto& light : scene.lights) {
+        writer.Write(light.type);
+        writer.Write(light.name);
+        writer.Write(light.color);
+        writer.Write(light.position);
+        writer.Write(light.direction);
+        writer.Write(light.attenuation);
+        writer.Write(light.points);
+        writer.Write(light.twoSide);
+        writer.Write(light.intensity);
+    }
+
+    writer.Write(static_cast<uint64_t>(scene.dependencies.size()));
+    for (const auto& dependency : scene.dependencies) {
+        writer.Write(dependency.path);
+        writer.Write(dependency.size);
+        writer.Write(dependency.writeTime);
+    }
+}
+
+bool ReadScene(Reader& reader, SceneCache::SceneData& scene)
+{
+    if (!reader.ReadCount(scene.nodes)) return false;
+    for (auto& node : scene.nodes) {
+        if (!reader.Read(node.name) || !reader.Read(node.position) || !reader.Read(node.rotation) || !reader.Read(node.scale) ||
+            !reader.Read(node.parent) || !reader.ReadArray(node.meshes) || !reader.ReadStrings(node.flags))
+            return false;
+    }
+
+    if (!reader.ReadCount(scene.materials)) return false;
+    for (auto& material : scene.materials) {
+        if (!reader.Read(material.baseDiffuse) || !reader.Read(material.metallic) || !reader.Read(material.roughness) ||
+            !reader.ReadCount(material.textures))
+            return false;
+        for (auto& texture : material.textures) {
+            if (!reader.Read(texture.slot) || !reader.Read(texture.path)) return false;
+        }
+    }
+
+    if (!reader.ReadCount(scene.meshes)) return false;
+    for (auto& mesh : scene.meshes) {
+        if (!reader.Read(mesh.material) || !reader.ReadArray(mesh.vertices) || !reader.ReadArray(mesh.indices) || !reader.ReadCount(mesh.lods))
+            return false;
+        for (auto& lod : mesh.lods) {
+            if (!reader.Read(lod.error) || !reader.ReadArray(lod.indices)) return false;
+        }
+        if (!reader.ReadArray(mesh.meshlets)) return false;
+    }
+
+    if (!reader.ReadCount(scene.animations)) return false;
+    for (auto& animation : scene.animations) {
+        if (!reader.Read(animation.node) || !reader.Read(animation.name) || !reader.Read(animation.duration) || !reader.Read(animation.preInfinity) ||
+            !reader.Read(animation.postInfinity) || !reader.Read(animation.interpolation) || !reader.Read(animation.warping) ||
+            !reader.ReadArray(animation.keyframes))
+            return false;
+    }
+
+    if (!reader.ReadCount(scene.cameras)) return false;
+    for (auto& camera : scene.cameras) {
+        if (!reader.Read(camera.name) || !reader.Read(camera.position) || !reader.Read(camera.up) || !reader.Read(camera.fieldOfView) ||
+            !reader.Read(camera.aspectRatio) || !reader.Read(camera.nearPlane) || !reader.Read(camera.farPlane))
+            return false;
+    }
+
+    if (!reader.ReadCount(scene.lights)) return false;
+    for (auto& light : scene.lights) {
+        if (!reader.Read(light.type) || !reader.Read(light.name) || !reader.Read(light.color) || !reader.Read(light.position) ||
+            !reader.Read(light.direction) || !reader.Read(light.attenuation) || !reader.Read(light.points) || !reader.Read(light.twoSide) ||
+            !reader.Read(light.intensity))
+            return false;
+    }
+
+    if (!reader.ReadCount(scene.dependencies)) return false;
+    for (auto& dependency : scene.dependencies) {
+        if (!reader.Read(dependency.path) || !reader.Read(dependency.size) || !reader.Read(dependency.writeTime)) return false;
+    }
+
+    return reader.IsEnd();
+}
+
+bool ValidateScene(const SceneCache::SceneData& scene)
+{
+    // Parents always come before their children, the builder relies on it when linking transforms.
+    for (uint32_t i = 0; i < scene.nodes.size(); i++) {
+        const auto& node = scene.nodes[i];
+        if (node.parent != NodeID::kInvalidID && node.parent >= i) return false;
+        for (auto mesh : node.meshes) {
+            if (mesh >= scene.meshes.size()) return false;
+        }
+    }
+
+    for (const auto& mesh : scene.meshes) {
+        if (mesh.material >= scene.materials.size()) return false;
+        for (auto index : mesh.indices) {
+            if (index >= mesh.vertices.size()) return false;
+        }
+        for (const auto& lod : mesh.lods) {
+            for (auto index : lod.indices) {
+                if (index >= mesh.vertices.size()) return false;
+            }
+        }
+        // Meshlets are drawn straight from the index lists, so every range has to lie inside the list of its level.
+        for (const auto& meshlet : mesh.meshlets) {
+            if (meshlet.lod > mesh.lods.size()) return false;
+            auto indexCount = meshlet.lod == 0 ? mesh.indices.size() : mesh.lods[meshlet.lod - 1].indices.size();
+            if (meshlet.indexOffset > indexCount || meshlet.indexCount > indexCount - meshlet.indexOffset) return false;
+        }
+    }
+
+    for (const auto& animation : scene.animations) {
+        if (animation.node >= scene.nodes.size()) return false;
+    }
+
+    return true;
+}
+}   // namespace
+
+std::optional<uint64_t> SceneCache::HashFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return std::nullopt;
+
+    uint64_t          hash = Maths::HashFNV1a(nullptr, 0);
+    std::vector<char> chunk(1 << 20);
+    while (file) {
+        file.read(chunk.data(), chunk.size());
+        hash = Maths::HashFNV1a(chunk.data(), static_cast<std::size_t>(file.gcount()), hash);
+    }
+
+    if (!file.eof()) return std::nullopt;
+    return hash;
+}
+
+SceneCache::DependencyData SceneCache::GetDependency(const std::filesystem::path& path)
+{
+    DependencyData dependency = {path.generic_string(), 0, 0};
+
+    std::error_code error;
+    auto            size = std::filesystem::file_size(path, error);
+    if (error) return dependency;
+    auto writeTime = std::filesystem::last_write_time(path, error);
+    if (error) return dependency;
+
+    dependency.size      = size;
+    dependency.writeTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+    return dependency;
+}
+
+bool SceneCache::Load(const std::filesystem::path& source, uint64_t sourceHash, SceneData& scene)
+{
+    auto path = GetPath(source);
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    Header header = {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(Header))) return false;
+    if (header.magic != Magic || header.version != Version || header.endianness != Endianness || header.sourceHash != sourceHash) {
+        Log::Warning("Baked scene ", path, " is stale, importing ", source, '\n');
+        return false;
+    }
+
+    // The payload is everything after the header, a size from a truncated or corrupted header is rejected before allocating it.
+    std::error_code error;
+    auto            fileSize = std::filesystem::file_size(path, error);
+    if (error || fileSize < sizeof(Header) || header.payloadSize != fileSize - sizeof(Header)) {
+        Log::Warning("Baked scene ", path, " is corrupted, importing ", source, '\n');
+        return false;
+    }
+
+    std::vector<char> payload(header.payloadSize);
+    if (!file.read(payload.data(), payload.size()) || Maths::HashFNV1a(payload.data(), payload.size()) != header.payloadHash) {
+        Log::Warning("Baked scene ", path, " is corrupted, importing ", source, '\n');
+        return false;
+    }
+
+    Reader reader(payload.data(), payload.size());
+    if (!ReadScene(reader, scene) || !ValidateScene(scene)) {
+        Log::Warning("Baked scene ", path, " is malformed, importing ", source, '\n');
+        scene = {};
+        return false;
+    }
+
+    for (const auto& dependency : scene.dependencies) {
+        auto current = GetDependency(dependency.path);
+        if (current.size != dependency.size || current.writeTime != dependency.writeTime) {
+            Log::Warning("Baked scene ", path, " is stale, ", dependency.path, " changed, importing ", source, '\n');
+            scene = {};
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void SceneCache::Save(const std::filesystem::path& source, uint64_t sourceHash, const SceneData& scene)
+{
+    auto path = GetPath(source);
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    std::stringstream tempName;
+    tempName << path.filename().string() << '.' << std::this_thread::get_id() << ".tmp";
+    auto tempPath = path.parent_path() / tempName.str();
+
+    Writer writer;
+    WriteScene(writer, scene);
+    const auto& payload = writer.GetBuffer();
+
+    Header header      = {};
+    header.magic       = Magic;
+    header.version     = Version;
+    header.endianness  = Endianness;
+    header.sourceHash  = sourceHash;
+    header.payloadSize = payload.size();
+    header.payloadHash = Maths::HashFNV1a(payload.data(), payload.size());
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            Log::Warning("Failed to write baked scene ", tempPath, '\n');
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        file.write(payload.data(), payload.size());
+    }
+
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        Log::Warning("Failed to write baked scene ", path, ": ", error.message(), '\n');
+        std::filesystem::remove(tempPath, error);
+    }
+}
+
+std::filesystem::path SceneCache::GetDirectory()
+{
+    return std::filesystem::path(CONFIG_PROJECT_DIR) / "Cache" / "Scenes";
+}
+
+std::filesystem::path SceneCache::GetPath(const std::filesystem::path& source)
+{
+    // Named after the source location, the stem keeps the cache directory readable.
+    std::error_code error;
+    auto            absolute = std::filesystem::absolute(source, error).generic_string();
+
+    std::stringstream name;
+    name << source.stem().string() << '-' << std::hex << std::setw(16) << std::setfill('0') << Maths::HashFNV1a(absolute.data(), absolute.size())
+         << ".mlscene";
+    return GetDirectory() / name.str();
+}
+}   // namespace MapleLeaf
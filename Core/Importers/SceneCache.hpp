@@ -0,0 +1,171 @@
+#pragma once
+
+#include "Animation.hpp"
+#include "Color.hpp"
+#include "Meshlet.hpp"
+#include "Vertex.hpp"
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace MapleLeaf {
+/**
+ * Engine native baked scene, stores everything the importer produces so a scene loads again without going through Assimp.
+ * The file is little-endian with every bulk array 8 byte aligned, so it can be mapped and the arrays used in place.
+ */
+class SceneCache
+{
+public:
+    struct NodeData
+    {
+        std::string              name;
+        glm::vec3                position;
+        glm::quat                rotation;
+        glm::vec3                scale;
+        uint32_t                 parent;
+        std::vector<uint32_t>    meshes;
+        std::vector<std::string> flags;
+    };
+
+    // A coarser level of detail of a mesh, indexing the vertices of the mesh.
+    struct LodData
+    {
+        float                 error;
+        std::vector<uint32_t> indices;
+    };
+
+    struct MeshData
+    {
+        uint32_t              material;
+        std::vector<Vertex3D> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<LodData>  lods;
+        // Meshlets of the mesh and its levels, the indices of every level are stored in the meshlet order.
+        std::vector<Meshlet> meshlets;
+    };
+
+    struct TextureData
+    {
+        uint32_t    slot;
+        std::string path;
+    };
+
+    struct MaterialData
+    {
+        Color                    baseDiffuse;
+        float                    metallic;
+        float                    roughness;
+        std::vector<TextureData> textures;
+    };
+
+    struct AnimationData
+    {
+        uint32_t                         node;
+        std::string                      name;
+        double                           duration;
+        uint32_t                         preInfinity;
+        uint32_t                         postInfinity;
+        uint32_t                         interpolation;
+        bool                             warping;
+        std::vector<Animation::Keyframe> keyframes;
+    };
+
+    struct CameraData
+    {
+        std::string name;
+        glm::vec3   position;
+        glm::vec3   up;
+        float       fieldOfView;
+        float       aspectRatio;
+        float       nearPlane;
+        float       farPlane;
+    };
+
+    struct LightData
+    {
+        uint32_t                 type;
+        std::string              name;
+        Color                    color;
+        glm::vec3                position;
+        glm::vec3                direction;
+        glm::vec3                attenuation;
+        std::array<glm::vec3, 4> points;
+        bool                     twoSide;
+        float                    intensity;
+    };
+
+    // A file the scene was imported from besides the source, such as a glTF buffer or a texture.
+    struct DependencyData
+    {
+        std::string path;
+        uint64_t    size;
+        int64_t     writeTime;
+    };
+
+    struct SceneData
+    {
+        std::vector<NodeData>       nodes;
+        std::vector<MeshData>       meshes;
+        std::vector<MaterialData>   materials;
+        std::vector<AnimationData>  animations;
+        std::vector<CameraData>     cameras;
+        std::vector<LightData>      lights;
+        std::vector<DependencyData> dependencies;
+    };
+
+    /**
+     * Hashes the content of a source file.
+     * @param path The source file.
+     * @return The hash, nullopt if the file can't be read.
+     */
+    static std::optional<uint64_t> HashFile(const std::filesystem::path& path);
+
+    /**
+     * Gets the size and write time of a file the scene depends on, a missing file gets 0 for both so it appearing later invalidates the bake too.
+     * @param path The dependency file.
+     * @return The dependency.
+     */
+    static DependencyData GetDependency(const std::filesystem::path& path);
+
+    /**
+     * Loads the baked scene of a source file, only CPU work is done here so load times can be measured without a device.
+     * Dependencies are compared by size and write time, hashing every buffer and texture would cost as much as importing.
+     * @param source The source scene file.
+     * @param sourceHash The content hash of the source, the baked file is rejected if it was baked from different content.
+     * @param scene The scene read.
+     * @return If a valid baked scene was found.
+     */
+    static bool Load(const std::filesystem::path& source, uint64_t sourceHash, SceneData& scene);
+
+    /**
+     * Bakes a scene, written to a temporary file first so concurrent readers never see a partial file.
+     * @param source The source scene file.
+     * @param sourceHash The content hash of the source.
+     * @param scene The scene to store.
+     */
+    static void Save(const std::filesystem::path& source, uint64_t sourceHash, const SceneData& scene);
+
+    static std::filesystem::path GetDirectory();
+
+private:
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t endianness;
+        uint32_t reserved;
+        uint64_t sourceHash;
+        uint64_t payloadSize;
+        uint64_t payloadHash;
+    };
+
+    static constexpr uint32_t Magic      = 0x53424c4d;   // "MLBS"
+    static constexpr uint32_t Version    = 5;
+    static constexpr uint32_t Endianness = 0x01020304;
+
+    static std::filesystem::path GetPath(const std::filesystem::path& source);
+};
+}   // namespace MapleLeaf
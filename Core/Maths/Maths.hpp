@@ -24,6 +24,23 @@ public:
         seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
     }
 
+    /**
+     * Hashes a block of bytes with 64-bit FNV-1a, stable across runs and platforms, so it can be used as an on-disk key.
+     * @param data The bytes to hash.
+     * @param size The number of bytes.
+     * @param seed The running hash, pass a previous result to chain several blocks.
+     * @return The new hash.
+     */
+    static uint64_t HashFNV1a(const void* data, std::size_t size, uint64_t seed = 0xcbf29ce484222325ull) noexcept
+    {
+        auto bytes = static_cast<const uint8_t*>(data);
+        for (std::size_t i = 0; i < size; i++) {
+            seed ^= bytes[i];
+            seed *= 0x100000001b3ull;
+        }
+        return seed;
+    }
+
     template<class integral>
     static constexpr integral AlignUp(integral x, size_t a) noexcept
     {
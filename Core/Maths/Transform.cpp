@@ -15,6 +15,7 @@ Transform::Transform(const glm::vec3& position, const glm::quat& quaternion, con
     , prevScale(scale)
 {
     updateStatus = UpdateStatus::Transformation;
+    Invalidate();
 }
 
 Transform::Transform(const glm::mat4 modelMatrix)
@@ -35,6 +36,7 @@ Transform::Transform(const glm::mat4 modelMatrix)
     this->prevScale     = scale;
 
     updateStatus = UpdateStatus::Transformation;
+    Invalidate();
 }
 
 Transform::Transform(const glm::vec3 position, const glm::quat quaternion, const glm::vec3 scale, const glm::vec3 prevPosition,
@@ -43,21 +45,27 @@ Transform::Transform(const glm::vec3 position, const glm::quat quaternion, const
     , quaternion(quaternion)
     , scale(scale)
     , prevPosition(prevPosition)
-    , prevQuaterion(quaternion)
+    , prevQuaterion(prevQuaternion)
     , prevScale(prevScale)
-{}
+{
+    Invalidate();
+}
 
 Transform::~Transform()
 {
-    if (worldTransform) delete worldTransform;
-
-    for (auto& child : children) child->parent = nullptr;
+    for (auto& child : children) {
+        child->parent = nullptr;
+        child->Invalidate();
+    }
 
     if (parent) parent->RemoveChild(this);
 }
 
 void Transform::Update()
 {
+    // The previous state only changes if the transform moved during the last frame.
+    bool changed = prevPosition != position || prevQuaterion != quaternion || prevScale != scale;
+
     prevPosition  = position;
     prevQuaterion = quaternion;
     prevScale     = scale;
@@ -79,6 +87,7 @@ void Transform::Update()
         this->scale      = scale;
 
         updateStatus = UpdateStatus::Transformation;
+        changed      = true;
     }
     else {
         if (this->parent != nullptr && this->parent->GetUpdateStatus() == UpdateStatus::Transformation)
@@ -86,33 +95,23 @@ void Transform::Update()
         else
             updateStatus = UpdateStatus::None;
     }
+
+    if (changed) Invalidate();
 }
 
 glm::mat4 Transform::GetWorldMatrix() const
 {
-    auto worldTransform = GetWorldTransform();
-
-    glm::mat4 scaleMatrix       = glm::scale(glm::mat4(1.0f), worldTransform->scale);
-    glm::mat4 rotationMatrix    = glm::mat4_cast(worldTransform->quaternion);
-    glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), worldTransform->position);
-
-    return translationMatrix * rotationMatrix * scaleMatrix;
+    return GetWorldState().matrix;
 }
 
 glm::mat4 Transform::GetPrevWorldMatrix() const
 {
-    auto worldTransform = GetWorldTransform();
-
-    glm::mat4 scaleMatrix       = glm::scale(glm::mat4(1.0f), worldTransform->prevScale);
-    glm::mat4 rotationMatrix    = glm::mat4_cast(worldTransform->prevQuaterion);
-    glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), worldTransform->prevPosition);
-
-    return translationMatrix * rotationMatrix * scaleMatrix;
+    return GetWorldState().prevMatrix;
 }
 
 glm::vec3 Transform::GetPosition() const
 {
-    return GetWorldTransform()->position;
+    return GetWorldState().position;
 }
 
 glm::vec3 Transform::GetRotation() const
@@ -122,12 +121,12 @@ glm::vec3 Transform::GetRotation() const
 
 glm::vec3 Transform::GetScale() const
 {
-    return GetWorldTransform()->scale;
+    return GetWorldState().scale;
 }
 
 glm::vec3 Transform::GetPrevPosition() const
 {
-    return GetWorldTransform()->prevPosition;
+    return GetWorldState().prevPosition;
 }
 
 glm::vec3 Transform::GetPrevRotation() const
@@ -137,7 +136,25 @@ glm::vec3 Transform::GetPrevRotation() const
 
 glm::vec3 Transform::GetPrevScale() const
 {
-    return GetWorldTransform()->prevScale;
+    return GetWorldState().prevScale;
+}
+
+void Transform::SetLocalPosition(const glm::vec3& localPosition)
+{
+    position = localPosition;
+    Invalidate();
+}
+
+void Transform::SetLocalRotation(const glm::quat quaternion)
+{
+    this->quaternion = quaternion;
+    Invalidate();
+}
+
+void Transform::SetLocalScale(const glm::vec3& localScale)
+{
+    scale = localScale;
+    Invalidate();
 }
 
 void Transform::SetParent(Transform* parent)
@@ -147,6 +164,8 @@ void Transform::SetParent(Transform* parent)
     this->parent = parent;
 
     if (this->parent) this->parent->AddChild(this);
+
+    Invalidate();
 }
 
 void Transform::SetParent(Entity* parent)
@@ -186,7 +205,9 @@ Transform operator*(const Transform& lhs, const Transform& rhs)
 
 Transform& Transform::operator*=(const Transform& rhs)
 {
-    return *this = *this * rhs;
+    *this = *this * rhs;
+    Invalidate();
+    return *this;
 }
 
 std::ostream& operator<<(std::ostream& stream, const Transform& transform)
@@ -195,23 +216,60 @@ std::ostream& operator<<(std::ostream& stream, const Transform& transform)
                   << transform.GetPrevRotation() << ", " << transform.prevScale;
 }
 
-const Transform* Transform::GetWorldTransform() const
+const Transform::WorldState& Transform::GetWorldState() const
 {
-    if (!parent) {
-        if (worldTransform) {
-            delete worldTransform;
-            worldTransform = nullptr;
-        }
+    // The release store after a rebuild publishes the state to every thread that sees the flag cleared.
+    if (!worldDirty.dirty.load(std::memory_order_acquire)) return worldState;
 
-        return this;
-    }
+    std::lock_guard<std::mutex> lock(WorldStateMutex);
+    return ResolveWorldState();
+}
 
-    if (!worldTransform) {
-        worldTransform = new Transform();
+const Transform::WorldState& Transform::ResolveWorldState() const
+{
+    // Another thread may have rebuilt it while this one waited for the lock.
+    if (!worldDirty.dirty.load(std::memory_order_relaxed)) return worldState;
+
+    if (parent) {
+        // Same composition as operator*, the parent's world state is itself cached so a clean chain costs a single step.
+        const auto& parentState   = parent->ResolveWorldState();
+        worldState.position       = glm::vec3(parentState.matrix * glm::vec4(position, 1.0f));
+        worldState.quaternion     = parentState.quaternion * quaternion;
+        worldState.scale          = parentState.scale * scale;
+        worldState.prevPosition   = glm::vec3(parentState.prevMatrix * glm::vec4(prevPosition, 1.0f));
+        worldState.prevQuaternion = parentState.prevQuaternion * prevQuaterion;
+        worldState.prevScale      = parentState.prevScale * prevScale;
+    }
+    else {
+        worldState.position       = position;
+        worldState.quaternion     = quaternion;
+        worldState.scale          = scale;
+        worldState.prevPosition   = prevPosition;
+        worldState.prevQuaternion = prevQuaterion;
+        worldState.prevScale      = prevScale;
     }
 
-    *worldTransform = *parent->GetWorldTransform() * *this;
-    return worldTransform;
+    worldState.matrix = glm::translate(glm::mat4(1.0f), worldState.position) * glm::mat4_cast(worldState.quaternion) *
+                        glm::scale(glm::mat4(1.0f), worldState.scale);
+    worldState.prevMatrix = glm::translate(glm::mat4(1.0f), worldState.prevPosition) * glm::mat4_cast(worldState.prevQuaternion) *
+                            glm::scale(glm::mat4(1.0f), worldState.prevScale);
+
+    worldDirty.dirty.store(false, std::memory_order_release);
+    return worldState;
+}
+
+void Transform::Invalidate()
+{
+    MarkDirty(++CurrentGeneration);
+}
+
+void Transform::MarkDirty(uint64_t generation)
+{
+    // Descendants inherit the world state, so they are marked with the same generation.
+    worldDirty.dirty.store(true, std::memory_order_relaxed);
+    this->generation = generation;
+
+    for (auto& child : children) child->MarkDirty(generation);
 }
 
 void Transform::AddChild(Transform* child)
@@ -5,8 +5,15 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <atomic>
+#include <mutex>
 
 namespace MapleLeaf {
+/**
+ * A local position, rotation and scale below an optional parent. The world state is cached and rebuilt on first use after a change.
+ * Setters, SetParent and Update must only run on the main thread while no other thread reads a transform of the same hierarchy, the world
+ * state getters may be called from any thread, such as the subrenders recording on the thread pool.
+ */
 class Transform : public Component::Registrar<Transform>
 {
     inline static const bool Registered = Register("transform");
@@ -36,13 +43,13 @@ public:
     glm::vec3 GetPrevScale() const;
 
     const glm::vec3& GetLocalPosition() const { return position; }
-    void             SetLocalPosition(const glm::vec3& localPosition) { position = localPosition; }
+    void             SetLocalPosition(const glm::vec3& localPosition);
 
-    void             SetLocalRotation(const glm::quat quaternion) { this->quaternion = quaternion; }
+    void             SetLocalRotation(const glm::quat quaternion);
     const glm::quat& GetLocalRotation() const { return quaternion; }
 
     const glm::vec3& GetLocalScale() const { return scale; }
-    void             SetLocalScale(const glm::vec3& localScale) { scale = localScale; }
+    void             SetLocalScale(const glm::vec3& localScale);
 
 
     Transform* GetParent() const { return parent; }
@@ -53,6 +60,15 @@ public:
 
     UpdateStatus GetUpdateStatus() const { return updateStatus; }
 
+    /**
+     * Gets the generation of the last change to this transform's world state, including changes inherited from a parent.
+     * @return The generation, compare it with a value of GetCurrentGeneration recorded earlier.
+     */
+    uint64_t GetGeneration() const { return generation; }
+    bool     HasChangedSince(uint64_t generation) const { return this->generation > generation; }
+
+    static uint64_t GetCurrentGeneration() { return CurrentGeneration.load(std::memory_order_relaxed); }
+
     bool operator==(const Transform& rhs) const;
     bool operator!=(const Transform& rhs) const;
 
@@ -66,7 +82,42 @@ private:
     Transform(const glm::vec3 position, const glm::quat quaternion, const glm::vec3 scale, const glm::vec3 prevPosition,
               const glm::quat prevQuaterion, const glm::vec3 prevScale);
 
-    const Transform* GetWorldTransform() const;
+    /**
+     * World space state, rebuilt lazily from the parent's once a change in this transform or one of its ancestors marks it dirty.
+     */
+    struct WorldState
+    {
+        glm::vec3 position;
+        glm::quat quaternion;
+        glm::vec3 scale;
+        glm::vec3 prevPosition;
+        glm::quat prevQuaternion;
+        glm::vec3 prevScale;
+        glm::mat4 matrix;
+        glm::mat4 prevMatrix;
+    };
+
+    /**
+     * Flags the world state for a rebuild, copies start dirty so a copied transform never shares the cache of the one it was copied from.
+     */
+    struct DirtyFlag
+    {
+        std::atomic<bool> dirty = true;
+
+        DirtyFlag() = default;
+        DirtyFlag(const DirtyFlag&) {}
+        DirtyFlag& operator=(const DirtyFlag&)
+        {
+            dirty.store(true, std::memory_order_relaxed);
+            return *this;
+        }
+    };
+
+    const WorldState& GetWorldState() const;
+    const WorldState& ResolveWorldState() const;
+
+    void Invalidate();
+    void MarkDirty(uint64_t generation);
 
     void AddChild(Transform* child);
     void RemoveChild(Transform* child);
@@ -81,8 +132,15 @@ private:
 
     Transform*              parent = nullptr;
     std::vector<Transform*> children;
-    mutable Transform*      worldTransform = nullptr;
+
+    mutable WorldState worldState;
+    mutable DirtyFlag  worldDirty;
+    uint64_t           generation = 0;
 
     UpdateStatus updateStatus;
+
+    inline static std::atomic<uint64_t> CurrentGeneration = 0;
+    // Serializes rebuilding dirty world states, clean ones are read without it.
+    inline static std::mutex WorldStateMutex;
 };
 }   // namespace MapleLeaf
\ No newline at end of file
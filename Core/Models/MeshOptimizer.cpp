@@ -0,0 +1,309 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace MapleLeaf {
+namespace {
+// Cache size Forsyth's scores are tuned for, the resulting order also holds up for smaller caches.
+constexpr uint32_t ScoreCacheSize    = 32;
+constexpr float    CacheDecayPower   = 1.5f;
+constexpr float    LastTriangleScore = 0.75f;
+constexpr float    ValenceBoostScale = 2.0f;
+constexpr uint32_t MaxValenceScore   = 32;
+
+struct ScoreTables
+{
+    ScoreTables()
+    {
+        for (uint32_t i = 0; i < ScoreCacheSize; i++) {
+            // The vertices of the last triangle score a bit lower, so strips do not just continue in one direction.
+            cache[i] = i < 3 ? LastTriangleScore : std::pow(1.0f - float(i - 3) / (ScoreCacheSize - 3), CacheDecayPower);
+        }
+        valence[0] = 0.0f;
+        for (uint32_t i = 1; i < MaxValenceScore; i++) valence[i] = ValenceBoostScale / std::sqrt(float(i));
+    }
+
+    std::array<float, ScoreCacheSize>  cache;
+    std::array<float, MaxValenceScore> valence;
+};
+
+// Vertices with few triangles left get a boost, so the order does not leave lone triangles behind.
+float VertexScore(const ScoreTables& tables, int32_t cachePosition, uint32_t remainingValence)
+{
+    if (remainingValence == 0) return -1.0f;
+
+    float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+    return score + (remainingValence < MaxValenceScore ? tables.valence[remainingValence] : ValenceBoostScale / std::sqrt(float(remainingValence)));
+}
+
+// A FIFO cache by the time vertices entered it, clearing it only advances the clock.
+class FifoCache
+{
+public:
+    FifoCache(std::size_t vertexCount, uint32_t cacheSize)
+        : timestamps(vertexCount, 0)
+        , cacheSize(cacheSize)
+        , timestamp(cacheSize + 1)
+    {}
+
+    // Returns 1 if the vertex missed the cache, 0 otherwise.
+    uint32_t Access(uint32_t vertex)
+    {
+        if (timestamp - timestamps[vertex] <= cacheSize) return 0;
+        timestamps[vertex] = timestamp++;
+        return 1;
+    }
+
+    uint32_t Access(const uint32_t* triangle) { return Access(triangle[0]) + Access(triangle[1]) + Access(triangle[2]); }
+
+    void Clear() { timestamp += cacheSize + 1; }
+
+private:
+    std::vector<uint32_t> timestamps;
+    uint32_t              cacheSize;
+    uint32_t              timestamp;
+};
+}   // namespace
+
+MeshOptimizer::Statistics MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, std::size_t vertexCount, uint32_t cacheSize)
+{
+    // Without a whole triangle both ratios would divide by zero.
+    Statistics statistics;
+    if (indices.size() / 3 == 0) return statistics;
+
+    FifoCache            cache(vertexCount, cacheSize);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+    uint32_t             misses = 0, referencedCount = 0;
+
+    for (auto index : indices) {
+        misses += cache.Access(index);
+        referencedCount += referenced[index] ? 0 : 1;
+        referenced[index] = 1;
+    }
+
+    statistics.acmr = float(misses) / (indices.size() / 3);
+    statistics.atvr = float(misses) / referencedCount;
+    return statistics;
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexCache(const std::vector<uint32_t>& indices, std::size_t vertexCount)
+{
+    static const ScoreTables tables;
+
+    const std::size_t     triangleCount = indices.size() / 3;
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+    if (triangleCount == 0) return result;
+
+    // Triangles around every vertex packed by vertex, the triangles still to emit are kept at the front of each range.
+    std::vector<uint32_t> valences(vertexCount, 0);
+    for (auto index : indices) valences[index]++;
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (std::size_t i = 0; i < vertexCount; i++) adjacencyOffsets[i + 1] = adjacencyOffsets[i] + valences[i];
+
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (std::size_t i = 0; i < indices.size(); i++) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+    std::vector<float> vertexScores(vertexCount);
+    for (std::size_t i = 0; i < vertexCount; i++) vertexScores[i] = VertexScore(tables, -1, valences[i]);
+
+    std::vector<float> triangleScores(triangleCount);
+    for (std::size_t i = 0; i < triangleCount; i++) {
+        triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+    }
+
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    // The triangle that last added each vertex to the cache being built, to skip duplicates.
+    std::vector<uint32_t> addedBy(vertexCount, std::numeric_limits<uint32_t>::max());
+    auto bestTriangle = static_cast<uint32_t>(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+
+    // Room for the cache plus the three vertices pushed in front of it before it is trimmed.
+    std::array<uint32_t, ScoreCacheSize + 3> cache, nextCache;
+    uint32_t                                 cacheCount = 0;
+    std::size_t                              cursor     = 0;
+
+    for (std::size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+        // Dead end, no triangle touches the cache, continue with the next one in input order.
+        if (bestTriangle == std::numeric_limits<uint32_t>::max()) {
+            while (emitted[cursor]) cursor++;
+            bestTriangle = static_cast<uint32_t>(cursor);
+        }
+
+        const uint32_t* triangle = &indices[bestTriangle * 3];
+        result.insert(result.end(), triangle, triangle + 3);
+        emitted[bestTriangle] = 1;
+
+        uint32_t nextCount = 0;
+        for (uint32_t i = 0; i < 3; i++) {
+            auto vertex = triangle[i];
+
+            // Moves the triangle past the triangles still to emit of the vertex.
+            auto begin = adjacency.begin() + adjacencyOffsets[vertex];
+            auto end   = begin + valences[vertex];
+            std::iter_swap(std::find(begin, end, bestTriangle), end - 1);
+            valences[vertex]--;
+
+            if (addedBy[vertex] != bestTriangle) nextCache[nextCount++] = vertex;
+            addedBy[vertex] = bestTriangle;
+        }
+        for (uint32_t i = 0; i < cacheCount; i++) {
+            if (addedBy[cache[i]] != bestTriangle) nextCache[nextCount++] = cache[i];
+        }
+
+        auto updateScore = [&](uint32_t vertex, int32_t cachePosition) {
+            auto score = VertexScore(tables, cachePosition, valences[vertex]);
+            auto delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+
+            auto offset = adjacencyOffsets[vertex];
+            for (uint32_t i = 0; i < valences[vertex]; i++) triangleScores[adjacency[offset + i]] += delta;
+        };
+
+        // Vertices pushed out of the cache lose their cache score.
+        for (uint32_t i = 0; i < nextCount; i++) updateScore(nextCache[i], i < ScoreCacheSize ? static_cast<int32_t>(i) : -1);
+
+        cacheCount = std::min(nextCount, ScoreCacheSize);
+        std::copy(nextCache.begin(), nextCache.begin() + cacheCount, cache.begin());
+
+        bestTriangle    = std::numeric_limits<uint32_t>::max();
+        float bestScore = -std::numeric_limits<float>::max();
+        for (uint32_t i = 0; i < cacheCount; i++) {
+            auto offset = adjacencyOffsets[cache[i]];
+            for (uint32_t j = 0; j < valences[cache[i]]; j++) {
+                auto candidate = adjacency[offset + j];
+                if (triangleScores[candidate] > bestScore) {
+                    bestScore    = triangleScores[candidate];
+                    bestTriangle = candidate;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeOverdraw(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices, float threshold)
+{
+    const std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) return indices;
+
+    // Hard boundaries are where the cache optimized order starts over with three new vertices, reordering there costs nothing.
+    std::vector<uint32_t> hardBoundaries;
+    {
+        FifoCache cache(vertices.size(), CacheSize);
+        for (std::size_t i = 0; i < triangleCount; i++) {
+            if (cache.Access(&indices[i * 3]) == 3) hardBoundaries.push_back(static_cast<uint32_t>(i));
+        }
+        hardBoundaries.push_back(static_cast<uint32_t>(triangleCount));
+    }
+
+    // Soft boundaries split a run once its clusters, each starting from a cold cache, reach the cache miss ratio the threshold allows.
+    std::vector<uint32_t> clusters;
+    FifoCache             cache(vertices.size(), CacheSize);
+    for (std::size_t run = 0; run + 1 < hardBoundaries.size(); run++) {
+        auto start = hardBoundaries[run], end = hardBoundaries[run + 1];
+
+        cache.Clear();
+        uint32_t runMisses = 0;
+        for (auto i = start; i < end; i++) runMisses += cache.Access(&indices[i * 3]);
+        auto thresholdAcmr = threshold * runMisses / (end - start);
+
+        cache.Clear();
+        uint32_t clusterStart = start, clusterMisses = 0;
+        clusters.push_back(start);
+        for (auto i = start; i < end; i++) {
+            clusterMisses += cache.Access(&indices[i * 3]);
+            if (i + 1 < end && float(clusterMisses) / (i + 1 - clusterStart) <= thresholdAcmr) {
+                cache.Clear();
+                clusterStart  = i + 1;
+                clusterMisses = 0;
+                clusters.push_back(clusterStart);
+            }
+        }
+    }
+    clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+    glm::vec3 meshCenter(0.0f);
+    float     meshArea = 0.0f;
+
+    struct Cluster
+    {
+        glm::vec3 center = glm::vec3(0.0f);
+        glm::vec3 normal = glm::vec3(0.0f);
+        float     area   = 0.0f;
+        float     sortKey;
+        uint32_t  start, end;
+    };
+    std::vector<Cluster> sortedClusters(clusters.size() - 1);
+
+    for (std::size_t i = 0; i + 1 < clusters.size(); i++) {
+        auto& cluster = sortedClusters[i];
+        cluster.start = clusters[i];
+        cluster.end   = clusters[i + 1];
+
+        for (auto j = cluster.start; j < cluster.end; j++) {
+            const auto& p0 = vertices[indices[j * 3]].position;
+            const auto& p1 = vertices[indices[j * 3 + 1]].position;
+            const auto& p2 = vertices[indices[j * 3 + 2]].position;
+
+            auto normal = glm::cross(p1 - p0, p2 - p0);
+            auto area   = glm::length(normal);
+            cluster.center += (p0 + p1 + p2) * (area / 3.0f);
+            cluster.normal += normal;
+            cluster.area += area;
+        }
+
+        meshCenter += cluster.center;
+        meshArea += cluster.area;
+        if (cluster.area > 0.0f) cluster.center /= cluster.area;
+    }
+    if (meshArea > 0.0f) meshCenter /= meshArea;
+
+    // Clusters facing away from the center of the mesh are more likely to occlude the others, so they are drawn first.
+    for (auto& cluster : sortedClusters) {
+        auto length     = glm::length(cluster.normal);
+        cluster.sortKey = length > 0.0f ? glm::dot(cluster.center - meshCenter, cluster.normal / length) : 0.0f;
+    }
+    std::stable_sort(sortedClusters.begin(), sortedClusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (const auto& cluster : sortedClusters) result.insert(result.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+    return result;
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices)
+{
+    std::vector<uint32_t> remap(vertices.size(), std::numeric_limits<uint32_t>::max());
+    std::vector<Vertex3D> fetchOrdered;
+    fetchOrdered.reserve(vertices.size());
+
+    for (auto& index : indices) {
+        if (remap[index] == std::numeric_limits<uint32_t>::max()) {
+            remap[index] = static_cast<uint32_t>(fetchOrdered.size());
+            fetchOrdered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices = std::move(fetchOrdered);
+}
+
+MeshOptimizer::Result MeshOptimizer::Optimize(std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices, bool overdraw)
+{
+    Result result;
+    result.before = AnalyzeVertexCache(indices, vertices.size());
+
+    indices = OptimizeVertexCache(indices, vertices.size());
+    if (overdraw) indices = OptimizeOverdraw(vertices, indices);
+    OptimizeVertexFetch(vertices, indices);
+
+    result.after = AnalyzeVertexCache(indices, vertices.size());
+    return result;
+}
+}   // namespace MapleLeaf
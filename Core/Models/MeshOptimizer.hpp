@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Vertex.hpp"
+#include <vector>
+
+namespace MapleLeaf {
+/**
+ * Reorders triangle lists for the post transform vertex cache and overdraw, and vertices for fetch locality.
+ * Runs on the CPU only, so importers can call it from loader threads.
+ */
+class MeshOptimizer
+{
+public:
+    // The FIFO cache size the statistics simulate, a conservative size for current hardware.
+    static constexpr uint32_t CacheSize = 16;
+
+    struct Statistics
+    {
+        // Average cache miss ratio, transformed vertices per triangle, 0.5 at best and 3 at worst.
+        float acmr = 0.0f;
+        // Average transform to vertex ratio, transformed vertices per referenced vertex, 1 at best.
+        float atvr = 0.0f;
+    };
+
+    struct Result
+    {
+        Statistics before;
+        Statistics after;
+    };
+
+    /**
+     * Simulates a FIFO post transform cache over a triangle list.
+     * @param indices The triangle list.
+     * @param vertexCount The number of vertices the indices refer to.
+     * @param cacheSize The number of vertices the cache holds.
+     * @return The statistics of the triangle order.
+     */
+    static Statistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, std::size_t vertexCount, uint32_t cacheSize = CacheSize);
+
+    /**
+     * Reorders triangles by Forsyth's linear speed vertex cache optimization, which suits any cache size.
+     * @param indices The triangle list.
+     * @param vertexCount The number of vertices the indices refer to.
+     * @return The reordered triangle list.
+     */
+    static std::vector<uint32_t> OptimizeVertexCache(const std::vector<uint32_t>& indices, std::size_t vertexCount);
+
+    /**
+     * Splits a cache optimized triangle list into clusters and sorts them front facing first from any view (Sander et al. 2007).
+     * @param vertices The vertices the indices refer to.
+     * @param indices The cache optimized triangle list.
+     * @param threshold How much a cluster may raise the cache miss ratio of its run, 1.05 keeps the ratio within 5 percent.
+     * @return The reordered triangle list.
+     */
+    static std::vector<uint32_t> OptimizeOverdraw(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices,
+                                                  float threshold = 1.05f);
+
+    /**
+     * Renumbers vertices in the order the triangles first use them and drops the unreferenced ones.
+     * @param vertices The vertices, reordered in place.
+     * @param indices The triangle list, remapped in place.
+     */
+    static void OptimizeVertexFetch(std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices);
+
+    /**
+     * Runs the cache, optionally the overdraw, and then the fetch optimization.
+     * @param vertices The vertices, reordered in place.
+     * @param indices The triangle list, reordered in place.
+     * @param overdraw If triangles are also ordered for overdraw.
+     * @return The statistics before and after.
+     */
+    static Result Optimize(std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices, bool overdraw);
+};
+}   // namespace MapleLeaf
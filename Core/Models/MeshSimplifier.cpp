@@ -0,0 +1,360 @@
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cstring>
+
+namespace MapleLeaf {
+namespace {
+// Sum of squared distances to a set of planes, weighted by the area of the triangles they come from.
+struct Quadric
+{
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+    double weight = 0;
+
+    void AddPlane(const glm::dvec3& normal, double d, double area)
+    {
+        a2 += area * normal.x * normal.x;
+        ab += area * normal.x * normal.y;
+        ac += area * normal.x * normal.z;
+        ad += area * normal.x * d;
+        b2 += area * normal.y * normal.y;
+        bc += area * normal.y * normal.z;
+        bd += area * normal.y * d;
+        c2 += area * normal.z * normal.z;
+        cd += area * normal.z * d;
+        d2 += area * d * d;
+        weight += area;
+    }
+
+    Quadric& operator+=(const Quadric& other)
+    {
+        a2 += other.a2, ab += other.ab, ac += other.ac, ad += other.ad, b2 += other.b2;
+        bc += other.bc, bd += other.bd, c2 += other.c2, cd += other.cd, d2 += other.d2;
+        weight += other.weight;
+        return *this;
+    }
+
+    // The weighted mean distance to the planes, so errors compare between dense and coarse regions.
+    float Error(const glm::vec3& position) const
+    {
+        double x = position.x, y = position.y, z = position.z;
+        double q = a2 * x * x + b2 * y * y + c2 * z * z + 2 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z) + d2;
+        return weight > 0 ? static_cast<float>(std::sqrt(std::max(q, 0.0) / weight)) : 0.0f;
+    }
+};
+
+struct Collapse
+{
+    float    cost;
+    uint32_t from, to;
+};
+
+class Collapser
+{
+public:
+    Collapser(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices);
+
+    /**
+     * Collapses edges in passes until at most the target triangles are left or no edge can collapse. Each pass collapses the cheapest edges
+     * in order, skipping edges of vertices an earlier collapse of the same pass has changed.
+     * @param targetTriangles The triangle count to stop at.
+     */
+    void Run(std::size_t targetTriangles);
+
+    std::vector<uint32_t> Extract() const;
+
+    std::size_t GetTriangleCount() const { return triangleCount; }
+    float       GetError() const { return error; }
+
+private:
+    const std::vector<Vertex3D>& vertices;
+
+    std::vector<uint32_t> triangles;
+    std::vector<uint8_t>  removedTriangles;
+    std::vector<Quadric>  quadrics;
+    std::vector<uint8_t>  locked;
+
+    // Triangles around every vertex packed by vertex, rebuilt every pass.
+    std::vector<uint32_t> adjacencyOffsets;
+    std::vector<uint32_t> adjacency;
+    std::vector<uint32_t> marks;
+    uint32_t              mark = 0;
+
+    std::size_t triangleCount = 0;
+    float       error         = 0.0f;
+
+    void     BuildAdjacency(const std::vector<uint32_t>& remap);
+    Collapse Evaluate(uint32_t a, uint32_t b) const;
+    bool     CanCollapse(uint32_t from, uint32_t to);
+    void     Apply(const Collapse& collapse);
+};
+
+Collapser::Collapser(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices)
+    : vertices(vertices)
+    , triangles(indices)
+    , removedTriangles(indices.size() / 3, 0)
+    , quadrics(vertices.size())
+    , locked(vertices.size(), 0)
+    , marks(vertices.size(), 0)
+{
+    // Vertices sharing a position but not their attributes are welded to find seams, an open addressing table keyed by the position.
+    std::size_t tableSize = 1;
+    while (tableSize < vertices.size() * 2) tableSize *= 2;
+    std::vector<uint32_t> table(tableSize, std::numeric_limits<uint32_t>::max());
+
+    std::vector<uint32_t> welded(vertices.size());
+    for (uint32_t v = 0; v < vertices.size(); v++) {
+        const auto& position = vertices[v].position;
+        uint32_t    bits[3];
+        std::memcpy(bits, &position, sizeof(bits));
+
+        auto slot = (bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u) & (tableSize - 1);
+        while (table[slot] != std::numeric_limits<uint32_t>::max() && vertices[table[slot]].position != position) slot = (slot + 1) & (tableSize - 1);
+
+        if (table[slot] == std::numeric_limits<uint32_t>::max()) {
+            table[slot] = v;
+            welded[v]   = v;
+        }
+        else {
+            welded[v]           = table[slot];
+            locked[v]           = 1;
+            locked[table[slot]] = 1;
+        }
+    }
+
+    for (std::size_t t = 0; t < removedTriangles.size(); t++) {
+        const uint32_t* triangle = &triangles[3 * t];
+        auto            a = welded[triangle[0]], b = welded[triangle[1]], c = welded[triangle[2]];
+        if (a == b || b == c || c == a) removedTriangles[t] = 1;
+    }
+
+    // Edges of the welded mesh without exactly two triangles are borders or non manifold, their vertices are kept.
+    BuildAdjacency(welded);
+    std::vector<uint8_t> lockedWelded(vertices.size(), 0);
+    for (uint32_t t = 0; t < removedTriangles.size(); t++) {
+        if (removedTriangles[t]) continue;
+
+        for (uint32_t k = 0; k < 3; k++) {
+            auto a = welded[triangles[3 * t + k]], b = welded[triangles[3 * t + (k + 1) % 3]];
+
+            uint32_t count = 0;
+            for (auto i = adjacencyOffsets[a]; i < adjacencyOffsets[a + 1]; i++) {
+                const uint32_t* other = &triangles[3 * adjacency[i]];
+                count += welded[other[0]] == b || welded[other[1]] == b || welded[other[2]] == b;
+            }
+            if (count != 2) lockedWelded[a] = lockedWelded[b] = 1;
+        }
+    }
+    for (uint32_t v = 0; v < vertices.size(); v++) locked[v] |= lockedWelded[welded[v]];
+
+    for (uint32_t t = 0; t < removedTriangles.size(); t++) {
+        if (removedTriangles[t]) continue;
+        triangleCount++;
+
+        const uint32_t* triangle = &triangles[3 * t];
+        glm::dvec3      p0       = vertices[triangle[0]].position;
+        auto            normal   = glm::cross(glm::dvec3(vertices[triangle[1]].position) - p0, glm::dvec3(vertices[triangle[2]].position) - p0);
+        auto            length   = glm::length(normal);
+        if (length <= 0.0) continue;
+
+        normal /= length;
+        for (uint32_t k = 0; k < 3; k++) quadrics[triangle[k]].AddPlane(normal, -glm::dot(normal, p0), 0.5 * length);
+    }
+}
+
+void Collapser::Run(std::size_t targetTriangles)
+{
+    std::vector<uint32_t> identity(vertices.size());
+    for (uint32_t v = 0; v < identity.size(); v++) identity[v] = v;
+
+    std::vector<Collapse> collapses;
+    std::vector<uint8_t>  changed(vertices.size());
+
+    while (triangleCount > targetTriangles) {
+        BuildAdjacency(identity);
+
+        // Interior edges appear once in each winding, taken from the triangle that has them in increasing order.
+        collapses.clear();
+        for (uint32_t t = 0; t < removedTriangles.size(); t++) {
+            if (removedTriangles[t]) continue;
+            for (uint32_t k = 0; k < 3; k++) {
+                auto a = triangles[3 * t + k], b = triangles[3 * t + (k + 1) % 3];
+                if (a < b && !(locked[a] && locked[b])) collapses.push_back(Evaluate(a, b));
+            }
+        }
+
+        // A collapse removes two triangles, only the cheapest edges with room for skipped ones are ordered.
+        auto costLess = [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; };
+        auto count    = std::min(collapses.size(), (triangleCount - targetTriangles) * 2 + 16);
+        std::nth_element(collapses.begin(), collapses.begin() + count - (count > 0), collapses.end(), costLess);
+        std::sort(collapses.begin(), collapses.begin() + count, costLess);
+
+        std::fill(changed.begin(), changed.end(), 0);
+        auto previous = triangleCount;
+        for (std::size_t i = 0; i < count && triangleCount > targetTriangles; i++) {
+            const auto& collapse = collapses[i];
+            if (changed[collapse.from] || changed[collapse.to] || !CanCollapse(collapse.from, collapse.to)) continue;
+
+            Apply(collapse);
+            changed[collapse.from] = changed[collapse.to] = 1;
+        }
+
+        if (triangleCount == previous) break;
+    }
+}
+
+std::vector<uint32_t> Collapser::Extract() const
+{
+    std::vector<uint32_t> indices;
+    indices.reserve(triangleCount * 3);
+    for (std::size_t t = 0; t < removedTriangles.size(); t++) {
+        if (!removedTriangles[t]) indices.insert(indices.end(), triangles.begin() + 3 * t, triangles.begin() + 3 * t + 3);
+    }
+    return indices;
+}
+
+Collapse Collapser::Evaluate(uint32_t a, uint32_t b) const
+{
+    // The cheaper direction of moving a onto b or b onto a.
+    auto quadric = quadrics[a];
+    quadric += quadrics[b];
+    float costA = locked[a] ? std::numeric_limits<float>::infinity() : quadric.Error(vertices[b].position);
+    float costB = locked[b] ? std::numeric_limits<float>::infinity() : quadric.Error(vertices[a].position);
+
+    return costA <= costB ? Collapse{costA, a, b} : Collapse{costB, b, a};
+}
+
+bool Collapser::CanCollapse(uint32_t from, uint32_t to)
+{
+    // Link condition: the only neighbours both ends share are the third vertices of the triangles on the edge, otherwise the surface pinches.
+    uint32_t shared = 0;
+    mark += 2;
+    for (auto i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++) {
+        auto t = adjacency[i];
+        if (removedTriangles[t]) continue;
+
+        const uint32_t* triangle = &triangles[3 * t];
+        shared += triangle[0] == to || triangle[1] == to || triangle[2] == to;
+        for (uint32_t k = 0; k < 3; k++) {
+            if (triangle[k] != from) marks[triangle[k]] = mark;
+        }
+    }
+
+    uint32_t common = 0;
+    for (auto i = adjacencyOffsets[to]; i < adjacencyOffsets[to + 1]; i++) {
+        auto t = adjacency[i];
+        if (removedTriangles[t]) continue;
+
+        for (uint32_t k = 0; k < 3; k++) {
+            auto v = triangles[3 * t + k];
+            if (v != to && marks[v] == mark) {
+                marks[v] = mark + 1;
+                common++;
+            }
+        }
+    }
+    if (shared == 0 || common != shared) return false;
+
+    // No remaining triangle may flip or collapse to a line.
+    const auto& target = vertices[to].position;
+    for (auto i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++) {
+        auto t = adjacency[i];
+        if (removedTriangles[t]) continue;
+
+        const uint32_t* triangle = &triangles[3 * t];
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to) continue;
+
+        glm::vec3 p[3], moved[3];
+        for (uint32_t k = 0; k < 3; k++) {
+            p[k]     = vertices[triangle[k]].position;
+            moved[k] = triangle[k] == from ? target : p[k];
+        }
+
+        auto before = glm::cross(p[1] - p[0], p[2] - p[0]);
+        auto after  = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+        if (glm::dot(before, after) <= 0.0f) return false;
+    }
+    return true;
+}
+
+void Collapser::Apply(const Collapse& collapse)
+{
+    auto from = collapse.from, to = collapse.to;
+
+    // The adjacency of the kept vertex is stale until the next pass, which is why it is not collapsed again in this one.
+    for (auto i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++) {
+        auto t = adjacency[i];
+        if (removedTriangles[t]) continue;
+
+        uint32_t* triangle = &triangles[3 * t];
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+            removedTriangles[t] = 1;
+            triangleCount--;
+            continue;
+        }
+
+        for (uint32_t k = 0; k < 3; k++) {
+            if (triangle[k] == from) triangle[k] = to;
+        }
+    }
+
+    quadrics[to] += quadrics[from];
+    error = std::max(error, collapse.cost);
+}
+
+void Collapser::BuildAdjacency(const std::vector<uint32_t>& remap)
+{
+    adjacencyOffsets.assign(vertices.size() + 1, 0);
+    for (uint32_t t = 0; t < removedTriangles.size(); t++) {
+        if (removedTriangles[t]) continue;
+        for (uint32_t k = 0; k < 3; k++) adjacencyOffsets[remap[triangles[3 * t + k]] + 1]++;
+    }
+    for (std::size_t i = 1; i < adjacencyOffsets.size(); i++) adjacencyOffsets[i] += adjacencyOffsets[i - 1];
+
+    adjacency.resize(adjacencyOffsets.back());
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (uint32_t t = 0; t < removedTriangles.size(); t++) {
+        if (removedTriangles[t]) continue;
+        for (uint32_t k = 0; k < 3; k++) adjacency[fill[remap[triangles[3 * t + k]]]++] = t;
+    }
+}
+}   // namespace
+
+std::vector<uint32_t> MeshSimplifier::Simplify(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices,
+                                               std::size_t targetIndexCount, float* error)
+{
+    if (error) *error = 0.0f;
+    if (indices.size() % 3 != 0 || indices.size() <= targetIndexCount) return indices;
+
+    Collapser collapser(vertices, indices);
+    collapser.Run(targetIndexCount / 3);
+
+    if (error) *error = collapser.GetError();
+    return collapser.Extract();
+}
+
+std::vector<MeshSimplifier::Level> MeshSimplifier::BuildLevels(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices,
+                                                               uint32_t maxLevels, float reduction)
+{
+    if (indices.empty() || indices.size() % 3 != 0 || maxLevels == 0) return {};
+
+    Collapser collapser(vertices, indices);
+
+    std::vector<Level> levels;
+    auto               previous = collapser.GetTriangleCount();
+    for (uint32_t level = 0; level < maxLevels; level++) {
+        auto target = static_cast<std::size_t>(static_cast<float>(previous) * reduction);
+        if (target == 0) break;
+
+        collapser.Run(target);
+        // Locked vertices stopped the collapses, later levels would be barely coarser.
+        if (collapser.GetTriangleCount() > previous * 4 / 5) break;
+
+        levels.push_back({collapser.Extract(), collapser.GetError()});
+        previous = collapser.GetTriangleCount();
+    }
+    return levels;
+}
+}   // namespace MapleLeaf
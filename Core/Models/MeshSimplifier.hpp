@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Vertex.hpp"
+#include <vector>
+
+namespace MapleLeaf {
+/**
+ * Reduces triangle lists by quadric error edge collapses onto existing vertices, so every result still indexes the original vertices.
+ * Vertices on borders and attribute seams never move, which keeps the simplified meshes free of cracks.
+ */
+class MeshSimplifier
+{
+public:
+    static constexpr uint32_t MaxLevels = 4;
+
+    // A simplified triangle list of one level of detail.
+    struct Level
+    {
+        std::vector<uint32_t> indices;
+        // The largest estimated distance to the original surface, in model space.
+        float error;
+    };
+
+    /**
+     * Simplifies a triangle list down to a target index count, or as close to it as the locked vertices allow.
+     * @param vertices The vertices the indices refer to.
+     * @param indices The triangle list.
+     * @param targetIndexCount The most indices of the result.
+     * @param error If not null, receives the largest estimated distance to the original surface.
+     * @return The simplified triangle list.
+     */
+    static std::vector<uint32_t> Simplify(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices, std::size_t targetIndexCount,
+                                          float* error = nullptr);
+
+    /**
+     * Builds coarser levels of detail from one collapse sequence, so the error never decreases from a level to the next.
+     * Stops early once a level would remove less than a fifth of the triangles of the previous one.
+     * @param vertices The vertices the indices refer to.
+     * @param indices The triangle list of the full detail model.
+     * @param maxLevels The most levels to build, not counting the full detail one.
+     * @param reduction The fraction of triangles each level keeps from the previous one.
+     * @return The levels, from the finest to the coarsest.
+     */
+    static std::vector<Level> BuildLevels(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices, uint32_t maxLevels = MaxLevels,
+                                          float reduction = 0.5f);
+};
+}   // namespace MapleLeaf
@@ -0,0 +1,166 @@
+#include "Meshlet.hpp"
+
+#include <array>
+#include <deque>
+#include <limits>
+
+namespace MapleLeaf {
+std::vector<Meshlet> MeshletBuilder::Build(const std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices, uint32_t maxVertices,
+                                           uint32_t maxTriangles)
+{
+    auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (triangleCount == 0 || indices.size() % 3 != 0 || maxVertices < 3 || maxTriangles == 0) return {};
+
+    // A degenerate triangle names a vertex more than once, only its first corner with that vertex counts so every vertex is counted once.
+    auto isRepeated = [&indices](uint32_t i) {
+        auto corner = i % 3;
+        return (corner > 0 && indices[i] == indices[i - 1]) || (corner == 2 && indices[i] == indices[i - 2]);
+    };
+
+    // Triangles around every vertex, packed by vertex.
+    std::vector<uint32_t> adjacencyOffsets(vertices.size() + 1, 0);
+    std::vector<uint32_t> adjacency(indices.size());
+    for (uint32_t i = 0; i < indices.size(); i++) adjacencyOffsets[indices[i] + 1] += !isRepeated(i);
+    for (std::size_t i = 1; i < adjacencyOffsets.size(); i++) adjacencyOffsets[i] += adjacencyOffsets[i - 1];
+
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (uint32_t i = 0; i < indices.size(); i++) {
+        if (!isRepeated(i)) adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    std::vector<bool>     emitted(triangleCount, false);
+    std::vector<uint32_t> vertexMeshlet(vertices.size(), std::numeric_limits<uint32_t>::max());
+    std::vector<uint32_t> candidateMeshlet(triangleCount, std::numeric_limits<uint32_t>::max());
+    std::vector<uint32_t> candidateCost(triangleCount, 0);
+    std::vector<uint32_t> reordered;
+    std::vector<Meshlet>  meshlets;
+    reordered.reserve(indices.size());
+
+    // Candidates by the number of vertices they would add, an entry is stale once emitted or its cost dropped.
+    std::array<std::deque<uint32_t>, 3> candidates;
+
+    uint32_t seed = 0;
+    while (true) {
+        // New meshlets start at the first triangle left in the original order, which keeps them close to the previous one.
+        while (seed < triangleCount && emitted[seed]) seed++;
+        if (seed == triangleCount) break;
+
+        auto     meshletIndex = static_cast<uint32_t>(meshlets.size());
+        auto     indexOffset  = static_cast<uint32_t>(reordered.size());
+        uint32_t vertexCount = 0, meshletTriangles = 0;
+        for (auto& bucket : candidates) bucket.clear();
+
+        auto emit = [&](uint32_t triangle) {
+            emitted[triangle] = true;
+            meshletTriangles++;
+
+            for (uint32_t k = 0; k < 3; k++) {
+                auto vertex = indices[3 * triangle + k];
+                reordered.push_back(vertex);
+                if (vertexMeshlet[vertex] == meshletIndex) continue;
+
+                vertexMeshlet[vertex] = meshletIndex;
+                vertexCount++;
+
+                // Every triangle around a new vertex needs one vertex less.
+                for (auto a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++) {
+                    auto candidate = adjacency[a];
+                    if (emitted[candidate]) continue;
+
+                    if (candidateMeshlet[candidate] != meshletIndex) {
+                        candidateMeshlet[candidate] = meshletIndex;
+                        candidateCost[candidate]    = 0;
+                        for (uint32_t c = 0; c < 3; c++) {
+                            if (!isRepeated(3 * candidate + c)) candidateCost[candidate] += vertexMeshlet[indices[3 * candidate + c]] != meshletIndex;
+                        }
+                    }
+                    else {
+                        candidateCost[candidate]--;
+                    }
+                    candidates[candidateCost[candidate]].push_back(candidate);
+                }
+            }
+        };
+
+        emit(seed);
+        while (meshletTriangles < maxTriangles) {
+            // The neighbour adding the fewest vertices keeps the meshlet compact, taking the oldest grows it evenly around the seed.
+            uint32_t best = triangleCount, bestCost = 0;
+            for (; bestCost < candidates.size() && best == triangleCount; bestCost++) {
+                auto& bucket = candidates[bestCost];
+                while (!bucket.empty() && (emitted[bucket.front()] || candidateCost[bucket.front()] != bestCost)) bucket.pop_front();
+                if (!bucket.empty()) best = bucket.front();
+            }
+
+            if (best == triangleCount || vertexCount + candidateCost[best] > maxVertices) break;
+            emit(best);
+        }
+
+        auto meshlet        = ComputeBounds(vertices, reordered.data() + indexOffset, meshletTriangles * 3);
+        meshlet.indexOffset = indexOffset;
+        meshlet.indexCount  = meshletTriangles * 3;
+        meshlets.emplace_back(meshlet);
+    }
+
+    indices.swap(reordered);
+    return meshlets;
+}
+
+std::vector<Meshlet> MeshletBuilder::BuildLevels(const std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices,
+                                                 std::vector<MeshSimplifier::Level>& lods)
+{
+    auto meshlets = Build(vertices, indices);
+    for (uint32_t level = 1; level <= lods.size(); level++) {
+        auto levelMeshlets = Build(vertices, lods[level - 1].indices);
+        for (auto& meshlet : levelMeshlets) meshlet.lod = level;
+        meshlets.insert(meshlets.end(), levelMeshlets.begin(), levelMeshlets.end());
+    }
+    return meshlets;
+}
+
+Meshlet MeshletBuilder::ComputeBounds(const std::vector<Vertex3D>& vertices, const uint32_t* indices, uint32_t indexCount)
+{
+    Meshlet meshlet = {};
+
+    // A sphere around the box of the vertices, looser than the minimal sphere but stable and cheap.
+    glm::vec3 minExtents(std::numeric_limits<float>::infinity());
+    glm::vec3 maxExtents(-std::numeric_limits<float>::infinity());
+    for (uint32_t i = 0; i < indexCount; i++) {
+        minExtents = glm::min(minExtents, vertices[indices[i]].position);
+        maxExtents = glm::max(maxExtents, vertices[indices[i]].position);
+    }
+
+    meshlet.center = (minExtents + maxExtents) * 0.5f;
+    for (uint32_t i = 0; i < indexCount; i++) meshlet.radius = std::max(meshlet.radius, glm::length(vertices[indices[i]].position - meshlet.center));
+
+    // A point and the unit normal of every non degenerate triangle.
+    std::vector<std::pair<glm::vec3, glm::vec3>> planes;
+    planes.reserve(indexCount / 3);
+    for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+        const auto& p0     = vertices[indices[i]].position;
+        auto        normal = glm::cross(vertices[indices[i + 1]].position - p0, vertices[indices[i + 2]].position - p0);
+        if (glm::length(normal) > 0.0f) planes.emplace_back(p0, glm::normalize(normal));
+    }
+
+    // The cone is disabled by default, backface culling a meshlet needs all its triangles to face within 84 degrees of the axis.
+    meshlet.coneCutoff = 2.0f;
+
+    glm::vec3 axis(0.0f);
+    for (const auto& [point, normal] : planes) axis += normal;
+    if (planes.empty() || glm::length(axis) <= 0.0f) return meshlet;
+    axis = glm::normalize(axis);
+
+    float minDot = 1.0f;
+    for (const auto& [point, normal] : planes) minDot = std::min(minDot, glm::dot(axis, normal));
+    if (minDot <= 0.1f) return meshlet;
+
+    // The apex is moved back along the axis until it is behind every triangle plane.
+    float maxT = 0.0f;
+    for (const auto& [point, normal] : planes) maxT = std::max(maxT, glm::dot(meshlet.center - point, normal) / glm::dot(axis, normal));
+
+    meshlet.coneAxis   = axis;
+    meshlet.coneApex   = meshlet.center - axis * maxT;
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    return meshlet;
+}
+}   // namespace MapleLeaf
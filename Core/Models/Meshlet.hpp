@@ -0,0 +1,57 @@
+#pragma once
+
+#include "MeshSimplifier.hpp"
+#include "Vertex.hpp"
+#include <vector>
+
+namespace MapleLeaf {
+/**
+ * A cluster of nearby triangles of one model with the bounds GPU culling tests it by.
+ * The triangles of a meshlet are contiguous in the index list, so one indexed draw renders it. Mirrors Meshlet in Misc/Parameters.glsl.
+ */
+struct Meshlet
+{
+    glm::vec3 center;
+    float     radius;
+    glm::vec3 coneApex;
+    // Every triangle faces away from a camera with dot(normalize(coneApex - camera), coneAxis) >= coneCutoff, above 1 if the cone is too wide.
+    float     coneCutoff;
+    glm::vec3 coneAxis;
+    uint32_t  indexOffset;
+    uint32_t  indexCount;
+    // The level of detail of the model the meshlet belongs to.
+    uint32_t  lod;
+    uint32_t  padding[2];
+};
+
+class MeshletBuilder
+{
+public:
+    static constexpr uint32_t MaxVertices  = 64;
+    static constexpr uint32_t MaxTriangles = 124;
+
+    /**
+     * Splits a triangle list into meshlets, each grown from a seed triangle by the neighbours adding the fewest new vertices.
+     * @param vertices The vertices the indices refer to.
+     * @param indices The triangle list, reordered in place so the triangles of each meshlet are contiguous.
+     * @param maxVertices The most unique vertices one meshlet references.
+     * @param maxTriangles The most triangles in one meshlet.
+     * @return The meshlets, their index offsets are relative to the start of indices.
+     */
+    static std::vector<Meshlet> Build(const std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices, uint32_t maxVertices = MaxVertices,
+                                      uint32_t maxTriangles = MaxTriangles);
+
+    /**
+     * Splits a model and each of its coarser levels of detail into meshlets, like importers do off the main thread.
+     * @param vertices The vertices the indices of every level refer to.
+     * @param indices The triangle list of the model, reordered in place.
+     * @param lods The coarser levels, their triangle lists reordered in place.
+     * @return The meshlets level by level with their level set, their index offsets are relative to the start of the indices of their level.
+     */
+    static std::vector<Meshlet> BuildLevels(const std::vector<Vertex3D>& vertices, std::vector<uint32_t>& indices,
+                                            std::vector<MeshSimplifier::Level>& lods);
+
+private:
+    static Meshlet ComputeBounds(const std::vector<Vertex3D>& vertices, const uint32_t* indices, uint32_t indexCount);
+};
+}   // namespace MapleLeaf
@@ -1,5 +1,8 @@
 #include "Model.hpp"
+#include "Graphics.hpp"
+#include "VertexCompact.hpp"
 #include "glm/ext/matrix_clip_space.hpp"
+#include <algorithm>
 
 namespace MapleLeaf {
 Model::Model(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& indices)
@@ -97,52 +100,40 @@ void Model::InitBLASInput()
 
 void Model::SetVertices(const std::vector<Vertex3D>& vertices)
 {
-    vertexBuffer = nullptr;
-    vertexCount  = static_cast<uint32_t>(vertices.size());
+    // Uploads into the old buffer or frames in flight may still use it.
+    if (vertexBuffer) Graphics::Get()->ReleaseBuffer(std::move(vertexBuffer), vertexUploadToken);
+    vertexCount = static_cast<uint32_t>(vertices.size());
 
     if (vertices.empty()) return;
 
-    Buffer vertexStaging(sizeof(Vertex3D) * vertices.size(),
-                         VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                         vertices.data());
-    vertexBuffer = std::make_unique<Buffer>(vertexStaging.GetSize(),
+    vertexBuffer = std::make_unique<Buffer>(sizeof(Vertex3D) * vertices.size(),
                                             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
                                                 VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-    CommandBuffer commandBuffer;
-
-    VkBufferCopy copyRegion = {};
-    copyRegion.size         = vertexStaging.GetSize();
-    vkCmdCopyBuffer(commandBuffer, vertexStaging.GetBuffer(), vertexBuffer->GetBuffer(), 1, &copyRegion);
-
-    commandBuffer.SubmitIdle();
+    vertexUploadToken = Graphics::Get()->GetStagingRing()->Upload(*vertexBuffer, 0, vertices.data(), vertexBuffer->GetSize());
 }
 
 void Model::SetIndices(const std::vector<uint32_t>& indices)
 {
-    indexBuffer = nullptr;
-    indexCount  = static_cast<uint32_t>(indices.size());
+    if (indexBuffer) Graphics::Get()->ReleaseBuffer(std::move(indexBuffer), indexUploadToken);
+    indexCount = static_cast<uint32_t>(indices.size());
 
-    if (indices.empty()) return;
-
-    Buffer indexStaging(sizeof(uint32_t) * indices.size(),
-                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                        indices.data());
-    indexBuffer = std::make_unique<Buffer>(indexStaging.GetSize(),
-                                           VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-                                               VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,   // ray tacing flag
-                                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    // Chosen from the indices themselves, so it doesn't depend on SetVertices being called first.
+    std::vector<uint16_t> shortIndices;
+    auto                  narrowed = VertexCompact::AppendShortIndices(indices.data(), indices.data() + indices.size(), shortIndices);
+    indexType                      = narrowed ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
 
-    CommandBuffer commandBuffer;
+    if (indices.empty()) return;
 
-    VkBufferCopy copyRegion = {};
-    copyRegion.size         = indexStaging.GetSize();
-    vkCmdCopyBuffer(commandBuffer, indexStaging.GetBuffer(), indexBuffer->GetBuffer(), 1, &copyRegion);
+    auto indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    indexBuffer    = std::make_unique<Buffer>(indexSize * indices.size(),
+                                              VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                                  VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,   // ray tacing flag
+                                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-    commandBuffer.SubmitIdle();
+    auto data        = narrowed ? static_cast<const void*>(shortIndices.data()) : indices.data();
+    indexUploadToken = Graphics::Get()->GetStagingRing()->Upload(*indexBuffer, 0, data, indexBuffer->GetSize());
 }
 
 bool Model::CmdRender(const CommandBuffer& commandBuffer, uint32_t instances)
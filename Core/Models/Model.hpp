@@ -1,7 +1,10 @@
 #pragma once
 
 #include "Buffer.hpp"
+#include "MeshSimplifier.hpp"
+#include "Meshlet.hpp"
 #include "Resource.hpp"
+#include "StagingRing.hpp"
 #include "Vertex.hpp"
 #include "glm/glm.hpp"
 #include <stdint.h>
@@ -50,8 +53,32 @@ public:
 
     std::type_index GetTypeIndex() const override { return typeid(Model); }
 
-    void                         SetVertices(const std::vector<Vertex3D>& vertices);
-    void                         SetIndices(const std::vector<uint32_t>& indices);
+    /**
+     * Uploads new vertices, the old buffer is released once the GPU no longer uses it.
+     * @param vertices The vertices.
+     */
+    void SetVertices(const std::vector<Vertex3D>& vertices);
+    /**
+     * Uploads new indices, 16 bit if every index fits. The old buffer is released once the GPU no longer uses it.
+     * @param indices The indices.
+     */
+    void SetIndices(const std::vector<uint32_t>& indices);
+
+    /**
+     * Sets the coarser levels of detail, built off the main thread by whoever creates the model.
+     * @param lods The levels from the finest to the coarsest, not counting the model itself.
+     */
+    void SetLods(std::vector<MeshSimplifier::Level>&& lods) { this->lods = std::move(lods); }
+    const std::vector<MeshSimplifier::Level>& GetLods() const { return lods; }
+
+    /**
+     * Sets the meshlets of the model and its levels of detail, built by MeshletBuilder::BuildLevels off the main thread by whoever creates the
+     * model, the indices of every level must be in the order it left them.
+     * @param meshlets The meshlets level by level.
+     */
+    void                        SetMeshlets(std::vector<Meshlet>&& meshlets) { this->meshlets = std::move(meshlets); }
+    const std::vector<Meshlet>& GetMeshlets() const { return meshlets; }
+
     const std::vector<Vertex3D>& GetVertices(std::size_t offset = 0) const { return vertices; }
     const std::vector<uint32_t>& GetIndices(std::size_t offset = 0) const { return indices; };
 
@@ -70,7 +97,7 @@ public:
     const Buffer*      GetIndexBuffer() const { return indexBuffer.get(); }
     uint32_t           GetVertexCount() const { return vertexCount; }
     uint32_t           GetIndexCount() const { return indexCount; }
-    static VkIndexType GetIndexType() { return VK_INDEX_TYPE_UINT32; }
+    VkIndexType        GetIndexType() const { return indexType; }
 
     bool IsThin() const { return isThin; }
 
@@ -82,15 +109,24 @@ protected:
 private:
     std::unique_ptr<Buffer> vertexBuffer;
     std::unique_ptr<Buffer> indexBuffer;
+    // The staging ring batches holding the last copies into the buffers.
+    StagingRing::Token vertexUploadToken = 0;
+    StagingRing::Token indexUploadToken  = 0;
 
     std::vector<Vertex3D> vertices;
     std::vector<uint32_t> indices;
+    // Coarser levels of detail indexing the same vertices, empty if none were built.
+    std::vector<MeshSimplifier::Level> lods;
+    // Meshlets of every level, each indexing into the triangle list of its level.
+    std::vector<Meshlet> meshlets;
 
     std::unique_ptr<BLASInput> blasInput;
 
     uint32_t vertexCount = 0;
     uint32_t indexCount  = 0;
     Status   status      = Status::None;
+    // 16 bit indices once every index fits, the index buffer is half the size.
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
 
     glm::vec3 minExtents;
     glm::vec3 maxExtents;
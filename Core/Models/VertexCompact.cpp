@@ -0,0 +1,76 @@
+#include "VertexCompact.hpp"
+
+#include "glm/gtc/packing.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace MapleLeaf {
+static_assert(sizeof(VertexCompact) == 20, "VertexCompact must match the COMPACT_VERTICES inputs of GBuffer.vert");
+
+VertexCompact VertexCompact::Encode(const Vertex3D& vertex, const glm::vec3& minExtents, const glm::vec3& maxExtents)
+{
+    VertexCompact compact;
+
+    // Flat axes of the bounds have no extent, any fraction decodes to the same coordinate.
+    auto extent   = maxExtents - minExtents;
+    auto fraction = glm::vec3(extent.x > 0.0f ? (vertex.position.x - minExtents.x) / extent.x : 0.0f,
+                              extent.y > 0.0f ? (vertex.position.y - minExtents.y) / extent.y : 0.0f,
+                              extent.z > 0.0f ? (vertex.position.z - minExtents.z) / extent.z : 0.0f);
+    for (uint32_t i = 0; i < 3; i++) compact.position[i] = glm::packUnorm1x16(fraction[i]);
+    compact.position[3] = 0;
+
+    for (uint32_t i = 0; i < 2; i++) compact.uv[i] = glm::packHalf1x16(vertex.uv[i]);
+
+    auto normal  = EncodeOctahedral(vertex.normal);
+    auto tangent = EncodeOctahedral(vertex.tangent);
+    for (uint32_t i = 0; i < 2; i++) {
+        compact.normal[i]  = static_cast<int16_t>(glm::packSnorm1x16(normal[i]));
+        compact.tangent[i] = static_cast<int16_t>(glm::packSnorm1x16(tangent[i]));
+    }
+
+    return compact;
+}
+
+Vertex3D VertexCompact::Decode(const glm::vec3& minExtents, const glm::vec3& maxExtents) const
+{
+    glm::vec3 fraction(glm::unpackUnorm1x16(position[0]), glm::unpackUnorm1x16(position[1]), glm::unpackUnorm1x16(position[2]));
+    glm::vec2 texCoord(glm::unpackHalf1x16(uv[0]), glm::unpackHalf1x16(uv[1]));
+    glm::vec2 octahedralNormal(glm::unpackSnorm1x16(static_cast<uint16_t>(normal[0])), glm::unpackSnorm1x16(static_cast<uint16_t>(normal[1])));
+    glm::vec2 octahedralTangent(glm::unpackSnorm1x16(static_cast<uint16_t>(tangent[0])), glm::unpackSnorm1x16(static_cast<uint16_t>(tangent[1])));
+
+    return Vertex3D(glm::mix(minExtents, maxExtents, fraction), texCoord, DecodeOctahedral(octahedralNormal), DecodeOctahedral(octahedralTangent));
+}
+
+glm::vec2 VertexCompact::EncodeOctahedral(const glm::vec3& direction)
+{
+    float sum = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    if (sum <= 0.0f) return glm::vec2(0.0f);
+
+    auto projected = direction / sum;
+    if (projected.z >= 0.0f) return glm::vec2(projected.x, projected.y);
+
+    // The lower half is folded over the diagonals of the square.
+    return glm::vec2((1.0f - std::abs(projected.y)) * (projected.x >= 0.0f ? 1.0f : -1.0f),
+                     (1.0f - std::abs(projected.x)) * (projected.y >= 0.0f ? 1.0f : -1.0f));
+}
+
+glm::vec3 VertexCompact::DecodeOctahedral(const glm::vec2& octahedral)
+{
+    glm::vec3 direction(octahedral.x, octahedral.y, 1.0f - std::abs(octahedral.x) - std::abs(octahedral.y));
+
+    float fold = std::max(-direction.z, 0.0f);
+    direction.x += direction.x >= 0.0f ? -fold : fold;
+    direction.y += direction.y >= 0.0f ? -fold : fold;
+    return glm::normalize(direction);
+}
+
+bool VertexCompact::AppendShortIndices(const uint32_t* begin, const uint32_t* end, std::vector<uint16_t>& shortIndices)
+{
+    if (std::any_of(begin, end, [](uint32_t index) { return index > std::numeric_limits<uint16_t>::max(); })) return false;
+
+    shortIndices.reserve(shortIndices.size() + (end - begin));
+    for (auto it = begin; it != end; ++it) shortIndices.push_back(static_cast<uint16_t>(*it));
+    return true;
+}
+}   // namespace MapleLeaf
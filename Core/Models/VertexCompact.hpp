@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Vertex.hpp"
+
+namespace MapleLeaf {
+enum class VertexLayout
+{
+    Full,
+    Compact
+};
+
+/**
+ * A 20 byte encoding of Vertex3D for vertex buffers shared by many models, mirrors the COMPACT_VERTICES inputs of GBuffer/GBuffer.vert.
+ * Positions are 16 bit fractions of the model bounds, normals and tangents octahedral 16 bit pairs and texture coordinates half floats.
+ */
+class VertexCompact
+{
+public:
+    VertexCompact() = default;
+
+    static Shader::VertexInput GetVertexInput(uint32_t baseBinding = 0)
+    {
+        std::vector<VkVertexInputBindingDescription>   bindingDescriptions   = {{baseBinding, sizeof(VertexCompact), VK_VERTEX_INPUT_RATE_VERTEX}};
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions = {
+            {0, baseBinding, VK_FORMAT_R16G16B16A16_UNORM, offsetof(VertexCompact, position)},
+            {1, baseBinding, VK_FORMAT_R16G16_SFLOAT, offsetof(VertexCompact, uv)},
+            {2, baseBinding, VK_FORMAT_R16G16_SNORM, offsetof(VertexCompact, normal)},
+            {3, baseBinding, VK_FORMAT_R16G16_SNORM, offsetof(VertexCompact, tangent)}};
+        return {bindingDescriptions, attributeDescriptions};
+    }
+
+    /**
+     * Encodes a vertex of a model.
+     * @param vertex The vertex.
+     * @param minExtents The minimum of the model bounds, the position is quantized inside them.
+     * @param maxExtents The maximum of the model bounds.
+     * @return The encoded vertex.
+     */
+    static VertexCompact Encode(const Vertex3D& vertex, const glm::vec3& minExtents, const glm::vec3& maxExtents);
+
+    /**
+     * Decodes the vertex the way the vertex input and shader do.
+     * @param minExtents The minimum of the model bounds it was encoded with.
+     * @param maxExtents The maximum of the model bounds it was encoded with.
+     * @return The decoded vertex, normal and tangent are unit length.
+     */
+    Vertex3D Decode(const glm::vec3& minExtents, const glm::vec3& maxExtents) const;
+
+    /**
+     * Maps a direction onto the octahedron unfolded into [-1, 1]^2, a zero direction maps to the +Z direction.
+     * @param direction The direction, need not be normalized.
+     * @return The octahedral coordinates.
+     */
+    static glm::vec2 EncodeOctahedral(const glm::vec3& direction);
+    static glm::vec3 DecodeOctahedral(const glm::vec2& octahedral);
+
+    /**
+     * Appends indices narrowed to 16 bits, for index buffers drawn with VK_INDEX_TYPE_UINT16.
+     * @param begin The first index.
+     * @param end The end of the indices.
+     * @param shortIndices The 16 bit indices to append to.
+     * @return False, with nothing appended, if an index does not fit in 16 bits.
+     */
+    static bool AppendShortIndices(const uint32_t* begin, const uint32_t* end, std::vector<uint16_t>& shortIndices);
+
+    uint16_t position[4];   // w is unused padding
+    uint16_t uv[2];
+    int16_t  normal[2];
+    int16_t  tangent[2];
+};
+}   // namespace MapleLeaf
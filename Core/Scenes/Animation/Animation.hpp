@@ -50,6 +50,8 @@ public:
     const Keyframe&    getKeyframe(double time) const;
     bool               doesKeyframeExists(double time) const;
 
+    const std::vector<Keyframe>& getKeyframes() const { return mKeyframes; }
+
     glm::mat4 animate(double currentTime);
 
 private:
@@ -48,4 +48,22 @@ private:
 };
 
 template class TypeInfo<Component>;
+
+/**
+ * If T registers itself with the component factory, every component of such a type reports the type ID of T.
+ */
+template<typename T>
+inline constexpr bool IsRegisteredComponent = std::is_base_of_v<Component::Registrar<T>, T>;
+
+/**
+ * Gets the type ID of a component type, the key of the per type component indices.
+ * @tparam T The component type.
+ * @return The type ID.
+ */
+template<typename T>
+TypeId GetComponentTypeId() noexcept
+{
+    static const auto typeId = TypeInfo<Component>::GetTypeId<T>();
+    return typeId;
+}
 }   // namespace MapleLeaf
\ No newline at end of file
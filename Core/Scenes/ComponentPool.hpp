@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Component.hpp"
+#include "NonCopyable.hpp"
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+namespace MapleLeaf {
+/**
+ * Dense storage of every component of one type in an entity holder.
+ * Removing a component moves the last component into its slot, so the order is only kept while no component is removed.
+ */
+class ComponentPool : NonCopyable
+{
+public:
+    ComponentPool() = default;
+
+    void Add(Component* component)
+    {
+        indices[component] = components.size();
+        components.emplace_back(component);
+    }
+
+    void Remove(Component* component)
+    {
+        auto it = indices.find(component);
+        if (it == indices.end()) return;
+
+        auto index = it->second;
+        indices.erase(it);
+
+        if (index + 1 != components.size()) {
+            components[index]          = components.back();
+            indices[components[index]] = index;
+        }
+        components.pop_back();
+    }
+
+    void Clear()
+    {
+        components.clear();
+        indices.clear();
+    }
+
+    const std::vector<Component*>& GetComponents() const { return components; }
+    std::size_t                    GetSize() const { return components.size(); }
+
+private:
+    std::vector<Component*>                     components;
+    std::unordered_map<Component*, std::size_t> indices;
+};
+
+/**
+ * Iterates the components of a pool as T without copying or casting at runtime, disabled components are skipped unless allowed.
+ * The view stays valid for the lifetime of the entity holder that created it, components added later are seen by it.
+ * @tparam T The component type stored in the pool.
+ */
+template<typename T>
+class ComponentView
+{
+public:
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = T*;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = T* const*;
+        using reference         = T*;
+
+        Iterator(Component* const* it, Component* const* end, bool allowDisabled)
+            : it(it)
+            , end(end)
+            , allowDisabled(allowDisabled)
+        {
+            SkipDisabled();
+        }
+
+        T* operator*() const { return static_cast<T*>(*it); }
+
+        Iterator& operator++()
+        {
+            ++it;
+            SkipDisabled();
+            return *this;
+        }
+
+        bool operator==(const Iterator& rhs) const { return it == rhs.it; }
+        bool operator!=(const Iterator& rhs) const { return it != rhs.it; }
+
+    private:
+        void SkipDisabled()
+        {
+            while (!allowDisabled && it != end && !(*it)->IsEnabled()) ++it;
+        }
+
+        Component* const* it;
+        Component* const* end;
+        bool              allowDisabled;
+    };
+
+    ComponentView(const ComponentPool& pool, bool allowDisabled = false)
+        : pool(&pool)
+        , allowDisabled(allowDisabled)
+    {}
+
+    Iterator begin() const { return Iterator(Data(), Data() + pool->GetSize(), allowDisabled); }
+    Iterator end() const { return Iterator(Data() + pool->GetSize(), Data() + pool->GetSize(), allowDisabled); }
+
+    /**
+     * Gets the number of components in the pool, including disabled ones.
+     * @return The pool size.
+     */
+    std::size_t GetPoolSize() const { return pool->GetSize(); }
+
+private:
+    Component* const* Data() const { return pool->GetComponents().data(); }
+
+    const ComponentPool* pool;
+    bool                 allowDisabled;
+};
+}   // namespace MapleLeaf
@@ -1,10 +1,12 @@
 #include "Entity.hpp"
+#include "EntityHolder.hpp"
 
 namespace MapleLeaf {
 void Entity::Update()
 {
-    for (auto it = components.begin(); it != components.end(); ++it) {
+    for (auto it = components.begin(); it != components.end();) {
         if ((*it)->IsRemoved()) {
+            UnindexComponent(it->get());
             it = components.erase(it);
             continue;
         }
@@ -19,6 +21,7 @@ void Entity::Update()
 
             (*it)->Update();
         }
+        ++it;
     }
 }
 
@@ -27,21 +30,67 @@ Component* Entity::AddComponent(std::unique_ptr<Component>&& component)
     if (!component) return nullptr;
 
     component->SetEntity(this);
-    return components.emplace_back(std::move(component)).get();
+    auto added = components.emplace_back(std::move(component)).get();
+    IndexComponent(added);
+    return added;
 }
 
 void Entity::RemoveComponent(Component* component)
 {
-    components.erase(std::remove_if(components.begin(), components.end(), [component](const auto& c) { return c.get() == component; }),
+    components.erase(std::remove_if(components.begin(),
+                                    components.end(),
+                                    [this, component](const auto& c) {
+                                        if (c.get() != component) return false;
+                                        UnindexComponent(c.get());
+                                        return true;
+                                    }),
                      components.end());
 }
 
 void Entity::RemoveComponent(const std::string& name)
 {
-    components.erase(std::remove_if(components.begin(), components.end(), [name](const auto& c) { return name == c->GetTypeName(); }),
+    components.erase(std::remove_if(components.begin(),
+                                    components.end(),
+                                    [this, name](const auto& c) {
+                                        if (name != c->GetTypeName()) return false;
+                                        UnindexComponent(c.get());
+                                        return true;
+                                    }),
                      components.end());
 }
 
+void Entity::IndexComponent(Component* component)
+{
+    componentPointers.emplace_back(component);
+    componentsByType[component->GetTypeId()].emplace_back(component);
+    if (holder) holder->AddToPool(component);
+}
+
+void Entity::UnindexComponent(Component* component)
+{
+    componentPointers.erase(std::remove(componentPointers.begin(), componentPointers.end(), component), componentPointers.end());
+
+    if (auto it = componentsByType.find(component->GetTypeId()); it != componentsByType.end()) {
+        auto& typed = it->second;
+        typed.erase(std::remove(typed.begin(), typed.end(), component), typed.end());
+        if (typed.empty()) componentsByType.erase(it);
+    }
+
+    if (holder) holder->RemoveFromPool(component);
+}
+
+void Entity::SetName(const std::string& name)
+{
+    if (holder) holder->UnindexNames(this);
+    this->name = name;
+    if (holder) holder->IndexNames(this);
+}
+
+std::string Entity::GetPath() const
+{
+    return parent ? parent->GetPath() + '/' + name : name;
+}
+
 bool Entity::HasParent(const std::string& name) const
 {
     Entity* parent = GetParent();
@@ -64,9 +113,11 @@ bool Entity::HasParentContainFlag(const std::string& flagName) const
 
 void Entity::SetParent(Entity* parent)
 {
+    if (holder) holder->UnindexNames(this);
     if (this->parent) this->parent->RemoveChild(this);
     this->parent = parent;
     if (this->parent) parent->AddChild(this);
+    if (holder) holder->IndexNames(this);
 }
 
 
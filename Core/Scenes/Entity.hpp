@@ -2,9 +2,28 @@
 
 #include "Component.hpp"
 #include "NonCopyable.hpp"
+#include <limits>
 #include <unordered_map>
 
 namespace MapleLeaf {
+class EntityHolder;
+
+/**
+ * Identifies an entity in the holder it was added to, the handle of a removed entity never resolves to another entity.
+ */
+struct EntityHandle
+{
+    static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+    uint32_t index      = InvalidIndex;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != InvalidIndex; }
+
+    bool operator==(const EntityHandle& rhs) const { return index == rhs.index && generation == rhs.generation; }
+    bool operator!=(const EntityHandle& rhs) const { return !operator==(rhs); }
+};
+
 class Entity final : NonCopyable
 {
 public:
@@ -13,7 +32,19 @@ public:
     void Update();
 
     const std::string& GetName() const { return name; }
-    void               SetName(const std::string& name) { this->name = name; }
+    void               SetName(const std::string& name);
+
+    /**
+     * Gets the names of the parents and this entity joined by slashes, unlike names paths tell apart entities named the same.
+     * @return The hierarchical path.
+     */
+    std::string GetPath() const;
+
+    /**
+     * Gets the handle of this entity, invalid while it is not in a holder.
+     * @return The entity handle.
+     */
+    const EntityHandle& GetHandle() const { return handle; }
 
     bool IsRemoved() const { return removed; }
     void SetRemoved(bool removed) { this->removed = removed; }
@@ -32,8 +63,8 @@ public:
     {
         T* alternative = nullptr;
 
-        for (const auto& component : components) {
-            auto casted = dynamic_cast<T*>(component.get());
+        for (const auto& component : FindComponents<T>()) {
+            auto casted = Cast<T>(component);
 
             if (casted) {
                 if (allowDisabled && !component->IsEnabled()) {
@@ -59,17 +90,8 @@ public:
     {
         std::vector<T*> components;
 
-        for (const auto& component : this->components) {
-            auto casted = dynamic_cast<T*>(component.get());
-
-            if (casted) {
-                if (allowDisabled && !component->IsEnabled()) {
-                    components.emplace_back(casted);
-                    continue;
-                }
-
-                components.emplace_back(casted);
-            }
+        for (const auto& component : FindComponents<T>()) {
+            if (auto casted = Cast<T>(component)) components.emplace_back(casted);
         }
 
         return components;
@@ -114,13 +136,15 @@ public:
     template<typename T>
     void RemoveComponent()
     {
-        for (auto it = components.begin(); it != components.end(); ++it) {
-            auto casted = dynamic_cast<T*>((*it).get());
-
-            if (casted) {
-                (*it)->SetEntity(nullptr);
-                components.erase(it);
+        for (auto it = components.begin(); it != components.end();) {
+            if (!Cast<T>(it->get())) {
+                ++it;
+                continue;
             }
+
+            (*it)->SetEntity(nullptr);
+            UnindexComponent(it->get());
+            it = components.erase(it);
         }
     }
 
@@ -200,6 +224,39 @@ public:
     const std::unordered_map<std::string, bool>& GetFlags() const { return flags; }
 
 private:
+    friend class EntityHolder;
+
+    /**
+     * Gets the components a query for T has to look at, only the components indexed under T if all of them are a T.
+     * @tparam T The component type to find.
+     * @return The candidate components.
+     */
+    template<typename T>
+    const std::vector<Component*>& FindComponents() const
+    {
+        if constexpr (IsRegisteredComponent<T>) {
+            static const std::vector<Component*> none;
+
+            auto it = componentsByType.find(GetComponentTypeId<T>());
+            return it != componentsByType.end() ? it->second : none;
+        }
+        else {
+            return componentPointers;
+        }
+    }
+
+    template<typename T>
+    static T* Cast(Component* component)
+    {
+        if constexpr (IsRegisteredComponent<T>)
+            return static_cast<T*>(component);
+        else
+            return dynamic_cast<T*>(component);
+    }
+
+    void IndexComponent(Component* component);
+    void UnindexComponent(Component* component);
+
     /**
      * @brief Remove the child entity from this entity.
      * @param child The child entity to remove.
@@ -216,6 +273,15 @@ private:
     bool                                    removed = false;
     std::vector<std::unique_ptr<Component>> components;
 
+    // Components in the order they were added, and by the type ID they report.
+    std::vector<Component*>                             componentPointers;
+    std::unordered_map<TypeId, std::vector<Component*>> componentsByType;
+    EntityHolder*                                       holder = nullptr;
+
+    // Set by the holder, indexedParent is the parent index this entity is found under in the children index.
+    EntityHandle handle;
+    uint32_t     indexedParent = EntityHandle::InvalidIndex;
+
     Entity*              parent = nullptr;
     std::vector<Entity*> children;
 
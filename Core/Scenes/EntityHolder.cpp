@@ -1,12 +1,32 @@
 #include "EntityHolder.hpp"
 
 namespace MapleLeaf {
+namespace {
+template<typename Key, typename Hash>
+void EraseFromIndex(std::unordered_map<Key, std::vector<Entity*>, Hash>& index, const Key& key, Entity* entity)
+{
+    auto it = index.find(key);
+    if (it == index.end()) return;
+
+    // Entities are mostly renamed or reparented right after being added, searching from the back keeps colliding names cheap.
+    auto& entities = it->second;
+    if (auto found = std::find(entities.rbegin(), entities.rend(), entity); found != entities.rend()) entities.erase(std::next(found).base());
+    if (entities.empty()) index.erase(it);
+}
+}   // namespace
+
 EntityHolder::EntityHolder() {}
 
+EntityHolder::~EntityHolder()
+{
+    Clear();
+}
+
 void EntityHolder::Update()
 {
     for (auto it = entities.begin(); it != entities.end();) {
         if ((*it)->IsRemoved()) {
+            Detach(it->get());
             it = entities.erase(it);
             continue;
         }
@@ -18,41 +38,71 @@ void EntityHolder::Update()
 
 Entity* EntityHolder::GetEntity(const std::string& name) const
 {
-    for (auto& entity : entities) {
-        if (entity->GetName() == name) return entity.get();
-    }
+    auto it = names.find(name);
+    return it != names.end() ? it->second.front() : nullptr;
+}
+
+Entity* EntityHolder::GetEntityByPath(const std::string& path) const
+{
+    return FindByPath(EntityHandle::InvalidIndex, path);
+}
+
+Entity* EntityHolder::GetEntity(const EntityHandle& handle) const
+{
+    if (handle.index >= handleSlots.size()) return nullptr;
 
-    return nullptr;
+    const auto& slot = handleSlots[handle.index];
+    return slot.generation == handle.generation ? slot.entity : nullptr;
 }
 
 Entity* EntityHolder::CreateEntity()
 {
-    return entities.emplace_back(std::make_unique<Entity>()).get();
+    auto entity = entities.emplace_back(std::make_unique<Entity>()).get();
+    Attach(entity);
+    return entity;
 }
 
 void EntityHolder::Add(std::unique_ptr<Entity>&& entity)
 {
-    entities.emplace_back(std::move(entity));
+    Attach(entities.emplace_back(std::move(entity)).get());
 }
 
 void EntityHolder::Remove(Entity* entity)
 {
-    entities.erase(std::remove_if(entities.begin(), entities.end(), [entity](const auto& e) { return e.get() == entity; }), entities.end());
+    entities.erase(std::remove_if(entities.begin(),
+                                  entities.end(),
+                                  [this, entity](const auto& e) {
+                                      if (e.get() != entity) return false;
+                                      Detach(e.get());
+                                      return true;
+                                  }),
+                   entities.end());
 }
 
 void EntityHolder::Move(Entity* entity, EntityHolder& structure)
 {
-    for (auto it = --entities.end(); it != entities.begin(); --it) {
-        if ((*it).get() != entity) continue;
+    auto it = std::find_if(entities.begin(), entities.end(), [entity](const auto& e) { return e.get() == entity; });
+    if (it == entities.end()) return;
 
-        structure.Add(std::move(*it));
-        entities.erase(it);
-    }
+    Detach(entity);
+    structure.Add(std::move(*it));
+    entities.erase(it);
 }
 
 void EntityHolder::Clear()
 {
+    for (auto& entity : entities) entity->holder = nullptr;
+    for (auto& [typeId, pool] : pools) pool.Clear();
     entities.clear();
+
+    names.clear();
+    children.clear();
+    freeHandleSlots.clear();
+    for (uint32_t index = 0; index < handleSlots.size(); index++) {
+        handleSlots[index].entity = nullptr;
+        handleSlots[index].generation++;
+        freeHandleSlots.emplace_back(index);
+    }
 }
 
 std::vector<Entity *> EntityHolder::QueryAll() {
@@ -68,12 +118,98 @@ std::vector<Entity *> EntityHolder::QueryAll() {
 	return entities;
 }
 
-bool EntityHolder::Contains(Entity* entity)
+void EntityHolder::Attach(Entity* entity)
+{
+    entity->holder = this;
+    for (auto component : entity->componentPointers) AddToPool(component);
+
+    if (freeHandleSlots.empty()) {
+        entity->handle = {static_cast<uint32_t>(handleSlots.size()), 0};
+        handleSlots.push_back({entity, 0});
+    }
+    else {
+        auto index = freeHandleSlots.back();
+        freeHandleSlots.pop_back();
+        handleSlots[index].entity = entity;
+        entity->handle            = {index, handleSlots[index].generation};
+    }
+
+    IndexNames(entity);
+    ReindexChildren(entity);
+}
+
+void EntityHolder::Detach(Entity* entity)
+{
+    UnindexNames(entity);
+    for (auto component : entity->componentPointers) RemoveFromPool(component);
+
+    auto& slot = handleSlots[entity->handle.index];
+    slot.entity = nullptr;
+    slot.generation++;
+    freeHandleSlots.emplace_back(entity->handle.index);
+
+    entity->handle = {};
+    entity->holder = nullptr;
+    ReindexChildren(entity);
+}
+
+void EntityHolder::IndexNames(Entity* entity)
+{
+    auto parent           = entity->GetParent();
+    entity->indexedParent = parent && parent->holder == this ? parent->handle.index : EntityHandle::InvalidIndex;
+
+    names[entity->GetName()].emplace_back(entity);
+    children[{entity->indexedParent, entity->GetName()}].emplace_back(entity);
+}
+
+void EntityHolder::UnindexNames(Entity* entity)
+{
+    EraseFromIndex(names, entity->GetName(), entity);
+    EraseFromIndex(children, {entity->indexedParent, entity->GetName()}, entity);
+}
+
+void EntityHolder::ReindexChildren(Entity* entity)
+{
+    for (auto child : entity->GetChildren()) {
+        if (child->holder != this) continue;
+
+        UnindexNames(child);
+        IndexNames(child);
+    }
+}
+
+Entity* EntityHolder::FindByPath(uint32_t parent, std::string_view path) const
 {
-    for (const auto& tmpEntity : entities) {
-        if (tmpEntity.get() == entity) return true;
+    // Unambiguous segments are followed in a loop, only siblings sharing a name recurse, so deep hierarchies can't exhaust the stack.
+    while (true) {
+        auto separator = path.find('/');
+        auto name      = path.substr(0, separator);
+
+        auto it = children.find({parent, std::string(name)});
+        if (it == children.end()) return nullptr;
+        if (separator == std::string_view::npos) return it->second.front();
+
+        path = path.substr(separator + 1);
+        if (it->second.size() == 1) {
+            parent = it->second.front()->handle.index;
+            continue;
+        }
+
+        // Siblings may share a name, the rest of the path can be below any of them.
+        for (auto child : it->second) {
+            if (auto found = FindByPath(child->handle.index, path)) return found;
+        }
+        return nullptr;
     }
+}
+
+void EntityHolder::RemoveFromPool(Component* component)
+{
+    if (auto it = pools.find(component->GetTypeId()); it != pools.end()) it->second.Remove(component);
+}
 
-    return false;
+bool EntityHolder::Contains(Entity* entity)
+{
+    return entity && entity->holder == this;
 }
 }   // namespace MapleLeaf
\ No newline at end of file
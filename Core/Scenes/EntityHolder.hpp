@@ -1,22 +1,42 @@
 #pragma once
 
+#include "ComponentPool.hpp"
 #include "Entity.hpp"
 
+#include <string_view>
+
 namespace MapleLeaf {
 class EntityHolder : NonCopyable
 {
+    friend class Entity;
+
 public:
     EntityHolder();
+    ~EntityHolder();
 
     void Update();
 
     /**
-     * Gets a Entity by name.
+     * Gets a Entity by name, the first one added if several share the name.
      * @param name The Entity name.
      * @return The entity.
      */
     Entity* GetEntity(const std::string& name) const;
 
+    /**
+     * Gets a Entity by the hierarchical path returned by {@link Entity#GetPath}, the path starts at the topmost parent in this structure.
+     * @param path The Entity path.
+     * @return The entity.
+     */
+    Entity* GetEntityByPath(const std::string& path) const;
+
+    /**
+     * Gets a Entity by handle.
+     * @param handle The Entity handle.
+     * @return The entity, nullptr if it has been removed from this structure.
+     */
+    Entity* GetEntity(const EntityHandle& handle) const;
+
     /**
      * Creates a new entity.
      * @return The Entity.
@@ -68,6 +88,11 @@ public:
     template<typename T, typename = std::enable_if_t<std::is_convertible_v<T*, Component*>>>
     T* GetComponent(bool allowDisabled = false)
     {
+        if constexpr (IsRegisteredComponent<T>) {
+            for (auto component : GetComponentView<T>(allowDisabled)) return component;
+            return nullptr;
+        }
+
         for (auto it = entities.begin(); it != entities.end(); ++it) {
             auto component = (*it)->GetComponent<T>();
 
@@ -90,6 +115,13 @@ public:
     {
         std::vector<T*> components;
 
+        if constexpr (IsRegisteredComponent<T>) {
+            auto view = GetComponentView<T>(allowDisabled);
+            components.reserve(view.GetPoolSize());
+            for (auto component : view) components.emplace_back(component);
+            return components;
+        }
+
         for (auto it = entities.begin(); it != entities.end(); ++it) {
             for (const auto& component : (*it)->GetComponents<T>()) {
                 if (component && (component->IsEnabled() || allowDisabled)) {
@@ -101,6 +133,18 @@ public:
         return components;
     }
 
+    /**
+     * Gets a view over all components of a type in the spatial structure, iterating it does no allocation or type checks.
+     * @tparam T The components type to get.
+     * @param allowDisabled If disabled components will be included in this view.
+     * @return The view over the pool of the type.
+     */
+    template<typename T, typename = std::enable_if_t<IsRegisteredComponent<T>>>
+    ComponentView<T> GetComponentView(bool allowDisabled = false)
+    {
+        return ComponentView<T>(pools[GetComponentTypeId<T>()], allowDisabled);
+    }
+
     /**
      * If the structure contains the object.
      * @param object The object to check for.
@@ -109,6 +153,57 @@ public:
     bool Contains(Entity* object);
 
 private:
+    void Attach(Entity* entity);
+    void Detach(Entity* entity);
+
+    void AddToPool(Component* component) { pools[component->GetTypeId()].Add(component); }
+    void RemoveFromPool(Component* component);
+
+    // Index the name of an entity and its name under its parent, children are keyed by the handle index of their parent so only
+    // the entity itself has to be indexed again when it is renamed or reparented.
+    void IndexNames(Entity* entity);
+    void UnindexNames(Entity* entity);
+    // Index the children of an entity in this structure again, their parent index changes when it is attached or detached.
+    void ReindexChildren(Entity* entity);
+
+    /**
+     * Finds an entity by the remainder of a path below a parent, trying every child of the name until one holds the rest of the path.
+     * @param parent The handle index of the parent, EntityHandle::InvalidIndex for the topmost entities.
+     * @param path The path below the parent.
+     * @return The entity.
+     */
+    Entity* FindByPath(uint32_t parent, std::string_view path) const;
+
+    struct HandleSlot
+    {
+        Entity*  entity     = nullptr;
+        uint32_t generation = 0;
+    };
+
+    // The handle index of the parent, EntityHandle::InvalidIndex if the parent is not in this structure, and the entity name.
+    struct ChildKey
+    {
+        uint32_t    parent;
+        std::string name;
+
+        bool operator==(const ChildKey& rhs) const { return parent == rhs.parent && name == rhs.name; }
+    };
+
+    struct ChildKeyHash
+    {
+        std::size_t operator()(const ChildKey& key) const { return std::hash<std::string>()(key.name) ^ (std::hash<uint32_t>()(key.parent) << 1); }
+    };
+
     std::vector<std::unique_ptr<Entity>> entities;
+
+    std::unordered_map<std::string, std::vector<Entity*>>            names;
+    std::unordered_map<ChildKey, std::vector<Entity*>, ChildKeyHash> children;
+
+    // A removed entity frees its slot and bumps the generation, so its handles stop resolving.
+    std::vector<HandleSlot> handleSlots;
+    std::vector<uint32_t>   freeHandleSlots;
+
+    // Pools are never erased so views handed out stay valid, unordered_map keeps references to its values stable.
+    std::unordered_map<TypeId, ComponentPool> pools;
 };
 }   // namespace MapleLeaf
\ No newline at end of file
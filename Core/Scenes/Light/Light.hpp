@@ -74,7 +74,7 @@ private:
 
     // AreaLight
     std::array<glm::vec3, 4> points;
-    bool                     twoSide;
-    float                    intensity;
+    bool                     twoSide   = false;
+    float                    intensity = 1.0f;
 };
 }   // namespace MapleLeaf
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Color.hpp"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+namespace MapleLeaf {
+/**
+ * The lights of one type in the slots of a storage buffer, without the buffer. A light keeps its slot until it is freed, freed slots hold a black
+ * light and are reused lowest first, free slots at the end are dropped. Slot 0 is a placeholder, the shaders start at 1.
+ * @tparam T The light entry type, with a color.
+ */
+template<typename T>
+class LightSlots
+{
+public:
+    /**
+     * Takes a slot for a new light, the lowest free one or a new one at the end.
+     * @return The slot.
+     */
+    uint32_t Allocate();
+
+    /**
+     * Clears a slot to a black light and makes it free for the next Allocate.
+     * @param slot The slot.
+     */
+    void Free(uint32_t slot);
+
+    /**
+     * Sets the light in a slot, it is only marked dirty if it differs from the one there.
+     * @param slot The slot.
+     * @param light The light.
+     */
+    void Set(uint32_t slot, const T& light);
+
+    /**
+     * Takes the slots changed since the last call, the ones dropped from the end since they were marked have nothing left to upload.
+     * @return The changed slots, unsorted and possibly repeated.
+     */
+    std::vector<uint32_t> TakeDirtySlots();
+
+    /**
+     * Gets the lowest slot holding a light.
+     * @return The slot, 0 if there is none.
+     */
+    uint32_t GetLowestUsedSlot() const;
+
+    // The lights including the placeholder and freed slots below the highest one in use, the shaders loop up to its size.
+    const std::vector<T>& GetLights() const { return lights; }
+
+private:
+    std::vector<T>        lights = {T()};
+    std::set<uint32_t>    freeSlots;
+    std::vector<uint32_t> dirtySlots;
+};
+
+template<typename T>
+uint32_t LightSlots<T>::Allocate()
+{
+    if (!freeSlots.empty()) {
+        auto slot = *freeSlots.begin();
+        freeSlots.erase(freeSlots.begin());
+        return slot;
+    }
+
+    lights.emplace_back();
+    dirtySlots.push_back(static_cast<uint32_t>(lights.size() - 1));
+    return static_cast<uint32_t>(lights.size() - 1);
+}
+
+template<typename T>
+void LightSlots<T>::Free(uint32_t slot)
+{
+    // A black light adds nothing, the shaders skip it without reading the rest of the entry.
+    T light     = {};
+    light.color = Color::Black;
+    Set(slot, light);
+    freeSlots.insert(slot);
+
+    // Free slots at the end are dropped, so the shaders loop over fewer of them.
+    while (lights.size() > 1 && !freeSlots.empty() && *freeSlots.rbegin() == lights.size() - 1) {
+        freeSlots.erase(std::prev(freeSlots.end()));
+        lights.pop_back();
+    }
+}
+
+template<typename T>
+void LightSlots<T>::Set(uint32_t slot, const T& light)
+{
+    if (lights[slot] == light) return;
+
+    lights[slot] = light;
+    dirtySlots.push_back(slot);
+}
+
+template<typename T>
+std::vector<uint32_t> LightSlots<T>::TakeDirtySlots()
+{
+    std::vector<uint32_t> slots;
+    slots.swap(dirtySlots);
+    slots.erase(std::remove_if(slots.begin(), slots.end(), [this](uint32_t slot) { return slot >= lights.size(); }), slots.end());
+    return slots;
+}
+
+template<typename T>
+uint32_t LightSlots<T>::GetLowestUsedSlot() const
+{
+    for (uint32_t slot = 1; slot < lights.size(); slot++) {
+        if (freeSlots.count(slot) == 0) return slot;
+    }
+    return 0;
+}
+}   // namespace MapleLeaf
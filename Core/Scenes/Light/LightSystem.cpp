@@ -3,62 +3,119 @@
 #include "Light.hpp"
 #include "Resources.hpp"
 #include "Scenes.hpp"
+#include "ShadowSystem.hpp"
 #include "Transform.hpp"
 
+#include <algorithm>
+
 namespace MapleLeaf {
 
 LightSystem::LightSystem()
     : LTCTexture1(Resources::Get()->GetThreadPool().Enqueue(LoadLTCTexture1))
     , LTCTexture2(Resources::Get()->GetThreadPool().Enqueue(LoadLTCTexture2))
     , blueNoise(Resources::Get()->GetThreadPool().Enqueue(LoadBlueNoise))
-    , pointLights(1, PointLight())
-    , directionalLights(1, DirectionalLight())
-    , areaLights(1, AreaLight())
 {}
 
 void LightSystem::Update()
 {
-    auto sceneLights   = Scenes::Get()->GetScene()->GetComponents<Light>();
-    bool updateStorage = false;
+    updateCount++;
+    uploadedBytes = 0;
+
+    for (auto light : Scenes::Get()->GetScene()->GetComponentView<Light>()) {
+        if (light->type == LightType::Spot) continue;
 
-    for (const auto& light : sceneLights) {
-        if (light->GetEntity()->GetComponent<Transform>()->GetUpdateStatus() != Transform::UpdateStatus::Transformation) continue;
+        // A light that changed its type moves to a slot of the new type.
+        auto it = lightSlots.find(light);
+        if (it != lightSlots.end() && it->second.type != light->type) {
+            FreeSlot(it->second);
+            lightSlots.erase(it);
+            it = lightSlots.end();
+        }
+
+        if (it == lightSlots.end()) {
+            uint32_t slot = 0;
+            if (light->type == LightType::Directional) slot = directionalLights.slots.Allocate();
+            if (light->type == LightType::Point) slot = pointLights.slots.Allocate();
+            if (light->type == LightType::Area) slot = areaLights.slots.Allocate();
+            it = lightSlots.emplace(light, LightSlot{light->type, slot, updateCount}).first;
+        }
+        it->second.seenUpdate = updateCount;
+
+        // The entry is built from the light every update, Set only marks the slot dirty if it differs from the uploaded one.
+        auto transform = light->GetEntity()->GetComponent<Transform>();
         if (light->type == LightType::Directional) {
             DirectionalLight directionalLight = {};
             directionalLight.color            = light->GetColor();
             directionalLight.direction        = light->GetDirection();
-            directionalLights.push_back(directionalLight);
+            directionalLights.slots.Set(it->second.slot, directionalLight);
         }
         else if (light->type == LightType::Point) {
-            PointLight pointLight = {};
-            pointLight.color      = light->GetColor();
-            if (auto transform = light->GetEntity()->GetComponent<Transform>()) {
-                pointLight.position = transform->GetPosition();
-            }
+            PointLight pointLight  = {};
+            pointLight.color       = light->GetColor();
+            pointLight.position    = transform ? transform->GetPosition() : light->GetPosition();
             pointLight.attenuation = light->GetAttenuation();
-            pointLights.push_back(pointLight);
+            pointLights.slots.Set(it->second.slot, pointLight);
         }
         else if (light->type == LightType::Area) {
-            AreaLight areatLight = {};
-            areatLight.color     = light->GetColor();
-            if (auto transform = light->GetEntity()->GetComponent<Transform>()) {
-                for (int i = 0; i < light->GetPoints().size(); i++) {
-                    areatLight.points[i] = transform->GetWorldMatrix() * glm::vec4(light->GetPoints()[i], 1.0f);
-                }
-            }
-            areatLight.twoSided  = light->GetTwoSide();
-            areatLight.intensity = light->GetIntensity();
-            areaLights.push_back(areatLight);
+            AreaLight areaLight = {};
+            areaLight.color     = light->GetColor();
+            auto worldMatrix    = transform ? transform->GetWorldMatrix() : glm::mat4(1.0f);
+            for (uint32_t i = 0; i < light->GetPoints().size(); i++) areaLight.points[i] = worldMatrix * glm::vec4(light->GetPoints()[i], 1.0f);
+            areaLight.twoSided  = light->GetTwoSide();
+            areaLight.intensity = light->GetIntensity();
+            areaLights.slots.Set(it->second.slot, areaLight);
+        }
+    }
+
+    // Lights not seen in this update had their component removed.
+    for (auto it = lightSlots.begin(); it != lightSlots.end();) {
+        if (it->second.seenUpdate == updateCount) {
+            ++it;
+            continue;
         }
-        updateStorage = true;
+
+        FreeSlot(it->second);
+        it = lightSlots.erase(it);
     }
 
-    if (updateStorage || storagePointLights == nullptr || storageDirectionalLights == nullptr || storageAreaLights == nullptr) {
-        storagePointLights = std::make_unique<StorageBuffer>(static_cast<VkDeviceSize>(pointLights.size() * sizeof(PointLight)), pointLights.data());
-        storageDirectionalLights =
-            std::make_unique<StorageBuffer>(static_cast<VkDeviceSize>(directionalLights.size() * sizeof(DirectionalLight)), directionalLights.data());
-        storageAreaLights = std::make_unique<StorageBuffer>(static_cast<VkDeviceSize>(areaLights.size() * sizeof(AreaLight)), areaLights.data());
+    // The directional light in the lowest slot casts the shadows. The ShadowSystem fits its cascades to the direction handed over here, a frame
+    // late if it updates before this system.
+    shadowLightSlot = directionalLights.slots.GetLowestUsedSlot();
+    auto shadows    = Scenes::Get()->GetScene()->GetSystem<ShadowSystem>();
+    if (shadows && shadowLightSlot != 0) shadows->SetLightDirection(directionalLights.slots.GetLights()[shadowLightSlot].direction);
+
+    uploadedBytes += pointLights.Upload();
+    uploadedBytes += directionalLights.Upload();
+    uploadedBytes += areaLights.Upload();
+}
+
+void LightSystem::FreeSlot(const LightSlot& lightSlot)
+{
+    if (lightSlot.type == LightType::Directional) directionalLights.slots.Free(lightSlot.slot);
+    if (lightSlot.type == LightType::Point) pointLights.slots.Free(lightSlot.slot);
+    if (lightSlot.type == LightType::Area) areaLights.slots.Free(lightSlot.slot);
+}
+
+template<typename T>
+VkDeviceSize LightSystem::LightBuffer<T>::Upload()
+{
+    const auto& lights = slots.GetLights();
+    auto        size   = static_cast<VkDeviceSize>(sizeof(T) * lights.size());
+    auto        dirty  = slots.TakeDirtySlots();
+    if (!storage || storage->GetSize() < size) {
+        // Grows by doubling, so lights added one at a time don't recreate the buffer every update.
+        auto capacity = storage ? std::max(size, storage->GetSize() * 2) : size;
+        storage       = std::make_unique<StorageBuffer>(capacity);
+        storage->Update(lights.data(), size);
+        return size;
     }
+    if (dirty.empty()) return 0;
+
+    auto         regions = Buffer::CoalesceRanges(dirty, sizeof(T));
+    VkDeviceSize bytes   = 0;
+    storage->Update(lights.data(), regions);
+    for (const auto& region : regions) bytes += region.size;
+    return bytes;
 }
 
 std::shared_ptr<Image2d> LightSystem::LoadLTCTexture1()
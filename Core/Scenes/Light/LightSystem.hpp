@@ -3,12 +3,19 @@
 #include "Color.hpp"
 #include "Future.hpp"
 #include "Image2d.hpp"
+#include "Light.hpp"
+#include "LightSlots.hpp"
 #include "StorageBuffer.hpp"
 #include "System.hpp"
 
 #include <array>
+#include <unordered_map>
 
 namespace MapleLeaf {
+/**
+ * Keeps the lights of the scene in one storage buffer per light type, each light in a LightSlots slot it holds until its component is removed.
+ * Only changed slots are uploaded and the buffers grow by doubling.
+ */
 class LightSystem : public System
 {
 public:
@@ -17,12 +24,19 @@ public:
         Color color                       = Color::White;
         alignas(16) glm::vec3 position    = glm::vec3(0.0f);
         alignas(16) glm::vec3 attenuation = glm::vec3(0.0f);
+
+        bool operator==(const PointLight& other) const
+        {
+            return color == other.color && position == other.position && attenuation == other.attenuation;
+        }
     };
 
     struct DirectionalLight
     {
         Color color                     = Color::White;
         alignas(16) glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+
+        bool operator==(const DirectionalLight& other) const { return color == other.color && direction == other.direction; }
     };
 
     struct AreaLight
@@ -31,32 +45,71 @@ public:
         alignas(16) std::array<glm::vec4, 4> points = {glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f)};
         uint32_t twoSided                           = 0;
         float    intensity                          = 1.0f;
+
+        bool operator==(const AreaLight& other) const
+        {
+            return color == other.color && points == other.points && twoSided == other.twoSided && intensity == other.intensity;
+        }
     };
 
     explicit LightSystem();
 
     void Update() override;
 
-    uint32_t GetPointLightsCount() const { return static_cast<uint32_t>(pointLights.size()); }
-    uint32_t GetDirectionalLightsCount() const { return static_cast<uint32_t>(directionalLights.size()); }
-    uint32_t GetAreaLightsCount() const { return static_cast<uint32_t>(areaLights.size()); }
+    // Slot counts including the placeholder and freed slots below the highest one in use, the shaders loop up to them.
+    uint32_t GetPointLightsCount() const { return static_cast<uint32_t>(pointLights.slots.GetLights().size()); }
+    uint32_t GetDirectionalLightsCount() const { return static_cast<uint32_t>(directionalLights.slots.GetLights().size()); }
+    uint32_t GetAreaLightsCount() const { return static_cast<uint32_t>(areaLights.slots.GetLights().size()); }
+
+    /**
+     * Gets the directional light slot the ShadowSystem casts shadows for, the lowest one in use so it doesn't change while other lights come and go.
+     * @return The slot, 0 if there is no directional light.
+     */
+    uint32_t GetShadowLightSlot() const { return shadowLightSlot; }
 
-    const StorageBuffer* GetStoragePointLights() const { return storagePointLights.get(); }
-    const StorageBuffer* GetStorageDirectionalLights() const { return storageDirectionalLights.get(); }
-    const StorageBuffer* GetStorageAreaLights() const { return storageAreaLights.get(); }
+    const StorageBuffer* GetStoragePointLights() const { return pointLights.storage.get(); }
+    const StorageBuffer* GetStorageDirectionalLights() const { return directionalLights.storage.get(); }
+    const StorageBuffer* GetStorageAreaLights() const { return areaLights.storage.get(); }
+
+    /**
+     * Gets the bytes written to the light buffers by the last Update, only changed slots are uploaded.
+     * @return The uploaded byte count.
+     */
+    VkDeviceSize GetUploadedBytes() const { return uploadedBytes; }
 
     const Image2d* GetLTCTexture1() { return (*LTCTexture1).get(); }
     const Image2d* GetLTCTexture2() { return (*LTCTexture2).get(); }
     const Image2d* GetBlueNoise() { return (*blueNoise).get(); }
 
 private:
-    std::vector<PointLight>       pointLights;
-    std::vector<DirectionalLight> directionalLights;
-    std::vector<AreaLight>        areaLights;
+    // The slots of one light type and the storage buffer they are uploaded to.
+    template<typename T>
+    struct LightBuffer
+    {
+        LightSlots<T>                  slots;
+        std::unique_ptr<StorageBuffer> storage;
+
+        VkDeviceSize Upload();
+    };
+
+    // The slot a light component holds, and the update it was last seen in.
+    struct LightSlot
+    {
+        LightType type;
+        uint32_t  slot;
+        uint64_t  seenUpdate;
+    };
+
+    void FreeSlot(const LightSlot& lightSlot);
+
+    LightBuffer<PointLight>       pointLights;
+    LightBuffer<DirectionalLight> directionalLights;
+    LightBuffer<AreaLight>        areaLights;
 
-    std::unique_ptr<StorageBuffer> storagePointLights;
-    std::unique_ptr<StorageBuffer> storageDirectionalLights;
-    std::unique_ptr<StorageBuffer> storageAreaLights;
+    std::unordered_map<const Light*, LightSlot> lightSlots;
+    uint64_t                                    updateCount     = 0;
+    uint32_t                                    shadowLightSlot = 0;
+    VkDeviceSize                                uploadedBytes   = 0;
 
     Future<std::shared_ptr<Image2d>> LTCTexture1;
     Future<std::shared_ptr<Image2d>> LTCTexture2;
@@ -67,4 +120,4 @@ private:
     static std::shared_ptr<Image2d> LoadBlueNoise();
 };
 
-}   // namespace MapleLeaf
\ No newline at end of file
+}   // namespace MapleLeaf
@@ -51,6 +51,8 @@ public:
     void ClearSystems() { systems.Clear(); }
 
     Entity* GetEntity(const std::string& name) const { return entities.GetEntity(name); }
+    Entity* GetEntity(const EntityHandle& handle) const { return entities.GetEntity(handle); }
+    Entity* GetEntityByPath(const std::string& path) const { return entities.GetEntityByPath(path); }
 
     Entity* CreateEntity() { return entities.CreateEntity(); }
 
@@ -74,6 +76,12 @@ public:
         return entities.GetComponents<T>(allowDisabled);
     }
 
+    template<typename T>
+    ComponentView<T> GetComponentView(bool allowDisabled = false)
+    {
+        return entities.GetComponentView<T>(allowDisabled);
+    }
+
     template<typename T>
     T* GetDerivedScene() const
     {
@@ -1,57 +1,138 @@
 #include "ShadowCascade.hpp"
-#include "Scenes.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace MapleLeaf {
-ShadowCascade::ShadowCascade() {}
+namespace {
+// World units the sphere radius is rounded up to, hides the float noise of fitting a rotated slice.
+constexpr float RadiusQuantum = 1.0f / 16.0f;
+// Fraction of the radius the light space depth of the center is snapped to.
+constexpr float DepthQuantum = 0.25f;
+
+glm::vec3 GetLightUp(const glm::vec3& lightDirection)
+{
+    return std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+}   // namespace
 
-void ShadowCascade::Update(const Camera& camera, const glm::vec3& lightDirection)
+std::vector<float> ShadowCascade::ComputeSplitDepths(float nearPlane, float farPlane, uint32_t count, float lambda)
 {
-    this->lightDirection = lightDirection;
+    std::vector<float> splitDepths(count);
+    for (uint32_t i = 1; i <= count; i++) {
+        float fraction    = static_cast<float>(i) / count;
+        float logarithmic = nearPlane * std::pow(farPlane / nearPlane, fraction);
+        float uniform     = nearPlane + (farPlane - nearPlane) * fraction;
+
+        splitDepths[i - 1] = lambda * logarithmic + (1.0f - lambda) * uniform;
+    }
 
-    glm::vec3 curMinExtents = Scenes::Get()->GetScene()->GetMinExtents();
-    glm::vec3 curMaxExtents = Scenes::Get()->GetScene()->GetMaxExtents();
+    // The last split lands on the far plane exactly, the power may round it away.
+    if (count > 0) splitDepths.back() = farPlane;
+    return splitDepths;
+}
+
+ShadowCascade::Corners ShadowCascade::ComputeFrustumCorners(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up,
+                                                            float fieldOfView, float aspectRatio, float nearDepth, float farDepth)
+{
+    glm::vec3 direction = glm::normalize(forward);
+    glm::vec3 right     = glm::normalize(glm::cross(direction, up));
+    glm::vec3 upright   = glm::cross(right, direction);
+    float     tanHalf   = std::tan(fieldOfView / 2.0f);
 
-    if (maxExtents != curMaxExtents || minExtents != curMinExtents) {
-        maxExtents = curMaxExtents;
-        minExtents = curMinExtents;
+    Corners corners;
+    for (uint32_t side = 0; side < 2; side++) {
+        float     depth      = side == 0 ? nearDepth : farDepth;
+        glm::vec3 center     = position + direction * depth;
+        glm::vec3 vertical   = upright * depth * tanHalf;
+        glm::vec3 horizontal = right * depth * tanHalf * aspectRatio;
 
-        UpdateLightViewMatrix();
-        UpdateLightOrthoMatrix();
+        corners[side * 4 + 0] = center - horizontal + vertical;
+        corners[side * 4 + 1] = center + horizontal + vertical;
+        corners[side * 4 + 2] = center - horizontal - vertical;
+        corners[side * 4 + 3] = center + horizontal - vertical;
     }
+    return corners;
 }
 
-void ShadowCascade::UpdateLightViewMatrix()
+ShadowCascade::Bounds ShadowCascade::TransformBounds(const glm::mat4& worldMatrix, const glm::vec3& min, const glm::vec3& max)
 {
-    glm::vec3 center   = (minExtents + maxExtents) / 2.0f;
-    float     radius   = glm::distance(minExtents, maxExtents) / 2.0;
-    glm::vec3 lightEye = center - lightDirection * radius;
+    // Transforms the center and the half extents, the extents along every world axis are the absolute sums over the model axes.
+    glm::vec3 center = worldMatrix * glm::vec4((min + max) * 0.5f, 1.0f);
+    glm::vec3 extent(0.0f);
+    for (uint32_t axis = 0; axis < 3; axis++) extent += glm::abs(glm::vec3(worldMatrix[axis])) * ((max[axis] - min[axis]) * 0.5f);
 
-    lightViewMatrix = glm::lookAt(lightEye, lightEye + lightDirection, glm::vec3(0.0f, 1.0f, 0.0f));
+    return {center - extent, center + extent};
 }
 
-void ShadowCascade::UpdateLightOrthoMatrix()
+bool ShadowCascade::Fit(const Corners& corners, const glm::vec3& lightDirection, const glm::vec3& sceneMin, const glm::vec3& sceneMax,
+                        uint32_t mapSize)
 {
-    // calc extent after use view matrix
-    glm::vec3 min = glm::vec3(std::numeric_limits<float>::infinity());
-    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::infinity());
-    for (int i = 0; i < 8; i++) {
-        glm::vec3 w = glm::vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1);
-        glm::vec4 v = lightViewMatrix * glm::vec4(glm::mix(minExtents, maxExtents, w), 1.0);
-
-        min = glm::vec3(std::min(min.x, v.x), std::min(min.y, v.y), std::min(min.z, v.z));
-        max = glm::vec3(std::max(max.x, v.x), std::max(max.y, v.y), std::max(max.z, v.z));
+    glm::vec3 sphereCenter(0.0f);
+    for (const auto& corner : corners) sphereCenter += corner;
+    sphereCenter /= static_cast<float>(corners.size());
+
+    float sphereRadius = 0.0f;
+    for (const auto& corner : corners) sphereRadius = std::max(sphereRadius, glm::distance(corner, sphereCenter));
+    sphereRadius = std::max(std::ceil(sphereRadius / RadiusQuantum) * RadiusQuantum, RadiusQuantum);
+
+    // Snaps the center in a light space that only depends on the light direction, so the whole projection moves in whole texels.
+    glm::vec3 direction     = glm::normalize(lightDirection);
+    glm::vec3 up            = GetLightUp(direction);
+    glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), direction, up);
+
+    // The projection is a texel wider than the sphere on every side, the snapped center is at most a texel off on each axis.
+    float texel     = 2.0f * sphereRadius / static_cast<float>(mapSize - 2);
+    float halfWidth = sphereRadius + texel;
+    float depthStep = sphereRadius * DepthQuantum;
+
+    glm::vec3 lightCenter = lightRotation * glm::vec4(sphereCenter, 1.0f);
+    lightCenter.x         = std::floor(lightCenter.x / texel) * texel;
+    lightCenter.y         = std::floor(lightCenter.y / texel) * texel;
+    lightCenter.z         = std::floor(lightCenter.z / depthStep) * depthStep;
+    sphereCenter          = glm::inverse(lightRotation) * glm::vec4(lightCenter, 1.0f);
+
+    float behind = sphereRadius + depthStep, ahead = sphereRadius + depthStep;
+    if (glm::all(glm::lessThanEqual(sceneMin, sceneMax))) {
+        for (uint32_t i = 0; i < 8; i++) {
+            glm::vec3 corner   = glm::mix(sceneMin, sceneMax, glm::vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+            float     distance = glm::dot(corner - sphereCenter, direction);
+            behind             = std::max(behind, -distance);
+            ahead              = std::max(ahead, distance);
+        }
+        // Depth steps keep the range still while the camera moves within them.
+        behind = std::ceil(behind / depthStep) * depthStep;
+        ahead  = std::ceil(ahead / depthStep) * depthStep;
     }
-    minExtents = min;
-    maxExtents = max;
-
-    float radius = glm::distance(minExtents, maxExtents) / 2.0;
-
-    lightOrthoMatrix = glm::ortho(minExtents.x,
-                                  maxExtents.x,
-                                  minExtents.y,
-                                  maxExtents.y,
-                                  std::min(abs(minExtents.z), abs(maxExtents.z)),
-                                  std::max(abs(minExtents.z), abs(maxExtents.z)));
-    // lightOrthoMatrix = glm::perspective(glm::radians(60.0f), Devices::Get()->GetWindow()->GetAspectRatio(), 0.1f, 100.0f);
+
+    glm::vec3 eye        = sphereCenter - direction * behind;
+    glm::mat4 view       = glm::lookAt(eye, sphereCenter, up);
+    glm::mat4 projection = glm::ortho(-halfWidth, halfWidth, -halfWidth, halfWidth, 0.0f, behind + ahead);
+    glm::mat4 matrix     = projection * view;
+
+    center    = sphereCenter;
+    radius    = halfWidth;
+    texelSize = texel;
+
+    if (matrix == lightProjectionViewMatrix && version > 0) return false;
+
+    lightProjectionViewMatrix = matrix;
+    version++;
+    return true;
+}
+
+bool ShadowCascade::Intersects(const glm::vec3& min, const glm::vec3& max) const
+{
+    glm::vec3 lightMin(std::numeric_limits<float>::max()), lightMax(std::numeric_limits<float>::lowest());
+    for (uint32_t i = 0; i < 8; i++) {
+        glm::vec4 corner = lightProjectionViewMatrix * glm::vec4(glm::mix(min, max, glm::vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1)), 1.0f);
+        lightMin         = glm::min(lightMin, glm::vec3(corner));
+        lightMax         = glm::max(lightMax, glm::vec3(corner));
+    }
+
+    // Casters between the light and the near plane are clipped anyway, the near plane already reaches the scene bounds.
+    return lightMax.x >= -1.0f && lightMin.x <= 1.0f && lightMax.y >= -1.0f && lightMin.y <= 1.0f && lightMax.z >= -1.0f && lightMin.z <= 1.0f;
 }
-}   // namespace MapleLeaf
\ No newline at end of file
+}   // namespace MapleLeaf
@@ -1,28 +1,95 @@
 #pragma once
 
-#include "Camera.hpp"
 #include "glm/glm.hpp"
+#include <array>
+#include <utility>
+#include <vector>
 
 namespace MapleLeaf {
+/**
+ * One cascade of a directional light shadow map, an orthographic projection around the bounding sphere of a slice of the camera frustum.
+ * The sphere only depends on the slice, and its center is snapped to whole shadow map texels in light space, so the projection keeps still
+ * while the camera rotates and moves in whole texels as it translates. The split and fit math runs on the CPU only.
+ */
 class ShadowCascade
 {
 public:
-    ShadowCascade();
+    using Corners = std::array<glm::vec3, 8>;
+    using Bounds  = std::pair<glm::vec3, glm::vec3>;
 
-    void Update(const Camera& camera, const glm::vec3& lightDirection);
+    /**
+     * Splits the view depth range between the logarithmic and the uniform scheme (Zhang et al. 2006).
+     * @param nearPlane The near plane distance, must be positive.
+     * @param farPlane The distance the last cascade ends at.
+     * @param count The number of cascades.
+     * @param lambda The weight of the logarithmic scheme, 0 splits uniformly and 1 logarithmically.
+     * @return The view depth each cascade ends at, in ascending order.
+     */
+    static std::vector<float> ComputeSplitDepths(float nearPlane, float farPlane, uint32_t count, float lambda);
 
-    const glm::mat4 GetLightProjectionViewMatrix() const { return lightOrthoMatrix * lightViewMatrix; }
+    /**
+     * Gets the corners of a slice of a perspective view frustum.
+     * @param position The camera position.
+     * @param forward The view direction.
+     * @param up The up vector, it does not have to be orthogonal to the view direction.
+     * @param fieldOfView The vertical field of view in radians.
+     * @param aspectRatio The width over the height of the view.
+     * @param nearDepth The view depth the slice starts at.
+     * @param farDepth The view depth the slice ends at.
+     * @return The four corners of the near side, then the four of the far side.
+     */
+    static Corners ComputeFrustumCorners(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up, float fieldOfView,
+                                         float aspectRatio, float nearDepth, float farDepth);
 
-private:
-    void UpdateLightViewMatrix();
-    void UpdateLightOrthoMatrix();
+    /**
+     * Gets the world space bounds of a box in model space.
+     * @param worldMatrix The model to world matrix.
+     * @param min The minimum of the box in model space.
+     * @param max The maximum of the box in model space.
+     * @return The minimum and the maximum in world space.
+     */
+    static Bounds TransformBounds(const glm::mat4& worldMatrix, const glm::vec3& min, const glm::vec3& max);
+
+    /**
+     * Fits the projection around the bounding sphere of the corners, extended towards the light to the scene bounds for casters outside the slice.
+     * @param corners The frustum slice corners.
+     * @param lightDirection The direction the light travels in.
+     * @param sceneMin The minimum of the scene bounds, ignored if it is above the maximum.
+     * @param sceneMax The maximum of the scene bounds.
+     * @param mapSize The width and height of the cascade in texels.
+     * @return If the projection changed, the cascade has to be rendered again.
+     */
+    bool Fit(const Corners& corners, const glm::vec3& lightDirection, const glm::vec3& sceneMin, const glm::vec3& sceneMax, uint32_t mapSize);
+
+    /**
+     * Checks if world space bounds overlap the projection, casters that don't can be skipped when rendering the cascade.
+     * @param min The minimum of the bounds.
+     * @param max The maximum of the bounds.
+     * @return If the bounds overlap.
+     */
+    bool Intersects(const glm::vec3& min, const glm::vec3& max) const;
 
-    glm::vec3 lightDirection;
+    const glm::mat4& GetLightProjectionViewMatrix() const { return lightProjectionViewMatrix; }
+    const glm::vec3& GetCenter() const { return center; }
+    float            GetRadius() const { return radius; }
+    // The size of a shadow map texel in world units.
+    float GetTexelSize() const { return texelSize; }
 
-    glm::mat4 lightOrthoMatrix;
-    glm::mat4 lightViewMatrix;
+    float GetSplitDepth() const { return splitDepth; }
+    void  SetSplitDepth(float splitDepth) { this->splitDepth = splitDepth; }
 
-    glm::vec3 minExtents;
-    glm::vec3 maxExtents;
+    /**
+     * Gets the number of times the projection changed, compare it with a value recorded when the cascade was rendered.
+     * @return The version.
+     */
+    uint64_t GetVersion() const { return version; }
+
+private:
+    glm::mat4 lightProjectionViewMatrix = glm::mat4(1.0f);
+    glm::vec3 center                    = glm::vec3(0.0f);
+    float     radius                    = 0.0f;
+    float     texelSize                 = 0.0f;
+    float     splitDepth                = 0.0f;
+    uint64_t  version                   = 0;
 };
 }   // namespace MapleLeaf
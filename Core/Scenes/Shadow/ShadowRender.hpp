@@ -1,12 +1,11 @@
 #pragma once
 
 #include "Component.hpp"
-#include "DescriptorHandler.hpp"
-#include "PipelineGraphics.hpp"
-#include "PushHandler.hpp"
-
 
 namespace MapleLeaf {
+/**
+ * Marks the mesh of the entity as a shadow caster, the GPU scene flags its instance and ShadowSubrender culls and draws it from there.
+ */
 class ShadowRender : public Component::Registrar<ShadowRender>
 {
     inline static const bool Registrar = Register("shadowRender");
@@ -16,11 +15,5 @@ public:
 
     void Start() override;
     void Update() override;
-
-    bool CmdRender(const CommandBuffer& commandBuffer, const PipelineGraphics& pipeline);
-
-private:
-    DescriptorsHandler descriptorSet;
-    PushHandler        pushObject;
 };
-}   // namespace MapleLeaf
\ No newline at end of file
+}   // namespace MapleLeaf
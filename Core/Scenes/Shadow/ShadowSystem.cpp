@@ -3,18 +3,44 @@
 #include "Light.hpp"
 #include "Scenes.hpp"
 
+#include <limits>
 
 namespace MapleLeaf {
 ShadowSystem::ShadowSystem()
     : lightDirection(0.0, 0.0, -1.0)
     , shadowBias(0.001f)
     , shadowPcf(1)
+    , splitLambda(0.75f)
+    , shadowDistance(std::numeric_limits<float>::max())
 {}
 
 void ShadowSystem::Update()
 {
-    if (auto camera = Scenes::Get()->GetScene()->GetCamera()) {
-        shadowCascade.Update(*camera, lightDirection);
+    auto camera = Scenes::Get()->GetScene()->GetCamera();
+    if (!camera) return;
+
+    auto scene       = Scenes::Get()->GetScene();
+    auto nearPlane   = camera->GetNearPlane();
+    auto farPlane    = std::min(camera->GetFarPlane(), shadowDistance);
+    auto splitDepths = ShadowCascade::ComputeSplitDepths(nearPlane, farPlane, CascadeCount, splitLambda);
+
+    for (uint32_t i = 0; i < CascadeCount; i++) {
+        auto corners = ShadowCascade::ComputeFrustumCorners(camera->GetPosition(),
+                                                            camera->GetForward(),
+                                                            camera->GetUpVector(),
+                                                            camera->GetFieldOfView(),
+                                                            camera->GetAspectRatio(),
+                                                            i == 0 ? nearPlane : splitDepths[i - 1],
+                                                            splitDepths[i]);
+        shadowCascades[i].Fit(corners, lightDirection, scene->GetMinExtents(), scene->GetMaxExtents(), SHADOW_MAP_SIZE);
+        shadowCascades[i].SetSplitDepth(splitDepths[i]);
     }
 }
-}   // namespace MapleLeaf
\ No newline at end of file
+
+glm::vec4 ShadowSystem::GetSplitDepths() const
+{
+    glm::vec4 splitDepths(shadowCascades.back().GetSplitDepth());
+    for (uint32_t i = 0; i < CascadeCount; i++) splitDepths[i] = shadowCascades[i].GetSplitDepth();
+    return splitDepths;
+}
+}   // namespace MapleLeaf
@@ -4,11 +4,16 @@
 #include "System.hpp"
 #include "glm/glm.hpp"
 
+#include "config.h"
 
 namespace MapleLeaf {
 class ShadowSystem : public System
 {
 public:
+    // The shaders read the split depths of every cascade from a vec4.
+    static constexpr uint32_t CascadeCount = SHADOW_CASCADE_COUNT;
+    static_assert(CascadeCount >= 1 && CascadeCount <= 4, "SHADOW_CASCADE_COUNT must be between 1 and 4");
+
     ShadowSystem();
 
     void Update() override;
@@ -22,14 +27,30 @@ public:
     float GetShadowBias() const { return shadowBias; }
     void  SetShadowBias(float shadowBias) { this->shadowBias = shadowBias; }
 
-    const ShadowCascade& GetShadowCascade() const { return shadowCascade; }
+    // Weight of the logarithmic split scheme against the uniform one.
+    float GetSplitLambda() const { return splitLambda; }
+    void  SetSplitLambda(float splitLambda) { this->splitLambda = splitLambda; }
+
+    // View depth the last cascade ends at, the camera far plane if that is closer.
+    float GetShadowDistance() const { return shadowDistance; }
+    void  SetShadowDistance(float shadowDistance) { this->shadowDistance = shadowDistance; }
+
+    const std::array<ShadowCascade, CascadeCount>& GetShadowCascades() const { return shadowCascades; }
+
+    /**
+     * Gets the view depth every cascade ends at, for the shaders to pick a cascade.
+     * @return The split depths, unused components are the last one.
+     */
+    glm::vec4 GetSplitDepths() const;
 
 private:
     glm::vec3 lightDirection;
 
     int32_t shadowPcf;
     float   shadowBias;
+    float   splitLambda;
+    float   shadowDistance;
 
-    ShadowCascade shadowCascade;
+    std::array<ShadowCascade, CascadeCount> shadowCascades;
 };
-}   // namespace MapleLeaf
\ No newline at end of file
+}   // namespace MapleLeaf
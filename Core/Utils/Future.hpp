@@ -1,17 +1,21 @@
 #pragma once
 
 #include <future>
+#include <memory>
 #include <optional>
 
 namespace MapleLeaf {
+class Task;
+
 template<typename T>
 class Future
 {
 public:
     Future() noexcept = default;
 
-    Future(std::future<T>&& future) noexcept
+    Future(std::future<T>&& future, std::shared_ptr<Task> task = nullptr) noexcept
         : future(std::move(future))
+        , task(std::move(task))
     {}
 
     bool has_value() const noexcept { return future.valid() || current; }
@@ -26,6 +30,12 @@ public:
         return *current;
     }
 
+    /**
+     * Gets the thread pool task producing this value, used to schedule continuations.
+     * @return The task, nullptr if the future was not created by a ThreadPool.
+     */
+    const std::shared_ptr<Task>& GetTask() const noexcept { return task; }
+
     constexpr explicit operator bool() const noexcept { return has_value(); }
     constexpr operator T&() const noexcept { return *get(); }
 
@@ -37,7 +47,40 @@ public:
     bool operator!=(const Future& rhs) const noexcept { return !operator==(rhs); }
 
 private:
-    std::future<T>   future;
-    std::optional<T> current;
+    std::future<T>        future;
+    std::optional<T>      current;
+    std::shared_ptr<Task> task;
+};
+
+template<>
+class Future<void>
+{
+public:
+    Future() noexcept = default;
+
+    Future(std::future<void>&& future, std::shared_ptr<Task> task = nullptr) noexcept
+        : future(std::move(future))
+        , task(std::move(task))
+    {}
+
+    bool has_value() const noexcept { return future.valid() || done; }
+
+    // will wait for completion
+    void get() noexcept
+    {
+        if (future.valid()) {
+            future.get();
+            done = true;
+        }
+    }
+
+    const std::shared_ptr<Task>& GetTask() const noexcept { return task; }
+
+    explicit operator bool() const noexcept { return has_value(); }
+
+private:
+    std::future<void>     future;
+    bool                  done = false;
+    std::shared_ptr<Task> task;
 };
-}   // namespace MapleLeaf
\ No newline at end of file
+}   // namespace MapleLeaf
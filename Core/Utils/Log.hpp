@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Time.hpp"
+#include <cassert>
 #include <cstddef>
 #include <filesystem>
 #include <fstream>
@@ -0,0 +1,170 @@
+#include "Profiler.hpp"
+#include "Log.hpp"
+#include <fstream>
+#include <set>
+
+namespace MapleLeaf {
+namespace {
+// Chrome trace process ids, every track of a process is one of its threads.
+constexpr uint32_t CpuProcess   = 0;
+constexpr uint32_t GpuProcess   = 1;
+constexpr uint32_t FrameProcess = 2;
+
+std::string EscapeJson(std::string_view value)
+{
+    std::string escaped;
+    escaped.reserve(value.size());
+
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            escaped += ' ';
+        }
+        else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+void WriteCompleteEvent(std::ofstream& stream, std::string_view name, uint32_t process, uint32_t thread, const Time& start, const Time& end)
+{
+    stream << ",\n{\"name\":\"" << EscapeJson(name) << "\",\"ph\":\"X\",\"pid\":" << process << ",\"tid\":" << thread
+           << ",\"ts\":" << start.AsMicroseconds<int64_t>() << ",\"dur\":" << (end - start).AsMicroseconds<int64_t>() << "}";
+}
+
+void WriteNameEvent(std::ofstream& stream, std::string_view event, uint32_t process, uint32_t thread, std::string_view name)
+{
+    stream << ",\n{\"name\":\"" << event << "\",\"ph\":\"M\",\"pid\":" << process << ",\"tid\":" << thread << ",\"args\":{\"name\":\""
+           << EscapeJson(name) << "\"}}";
+}
+}   // namespace
+
+std::mutex                  Profiler::mutex;
+std::deque<Profiler::Frame> Profiler::frames;
+Profiler::Frame             Profiler::currentFrame;
+std::atomic<uint32_t>       Profiler::threadCount = 0;
+
+void Profiler::BeginFrame()
+{
+    auto now = Time::Now();
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    currentFrame.end = now;
+    auto index       = currentFrame.index;
+    frames.emplace_back(std::move(currentFrame));
+    if (frames.size() > FrameCount) frames.pop_front();
+
+    currentFrame       = {};
+    currentFrame.index = index + 1;
+    currentFrame.start = now;
+}
+
+void Profiler::BeginZone(std::string_view name)
+{
+    GetOpenZones().push_back({std::string(name), Time::Now()});
+}
+
+void Profiler::EndZone()
+{
+    auto& openZones = GetOpenZones();
+    if (openZones.empty()) return;
+
+    Zone zone   = {};
+    zone.name   = std::move(openZones.back().name);
+    zone.thread = GetThreadIndex();
+    zone.depth  = static_cast<uint32_t>(openZones.size() - 1);
+    zone.start  = openZones.back().start;
+    zone.end    = Time::Now();
+    openZones.pop_back();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    currentFrame.zones.emplace_back(std::move(zone));
+}
+
+void Profiler::AddGpuZones(uint64_t frameIndex, std::vector<Zone>&& zones)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto* frame = frameIndex == currentFrame.index ? &currentFrame : nullptr;
+    for (auto it = frames.rbegin(); !frame && it != frames.rend(); ++it) {
+        if (it->index == frameIndex) frame = &*it;
+    }
+    if (!frame) return;
+
+    frame->zones.insert(frame->zones.end(), std::make_move_iterator(zones.begin()), std::make_move_iterator(zones.end()));
+}
+
+uint64_t Profiler::GetFrameIndex()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return currentFrame.index;
+}
+
+std::optional<Profiler::Frame> Profiler::GetFrame(uint64_t frameIndex)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (frames.empty() || frameIndex < frames.front().index || frameIndex > frames.back().index) return std::nullopt;
+    return frames[frameIndex - frames.front().index];
+}
+
+std::vector<Profiler::Frame> Profiler::GetFrames()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return {frames.begin(), frames.end()};
+}
+
+bool Profiler::ExportChromeTrace(const std::filesystem::path& filename)
+{
+    auto recentFrames = GetFrames();
+
+    if (auto parentPath = filename.parent_path(); !parentPath.empty()) std::filesystem::create_directories(parentPath);
+    std::ofstream stream(filename);
+    if (!stream) {
+        Log::Error("Failed to write profiler trace ", filename, "\n");
+        return false;
+    }
+
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << CpuProcess << ",\"args\":{\"name\":\"CPU\"}}";
+    WriteNameEvent(stream, "process_name", GpuProcess, 0, "GPU");
+    WriteNameEvent(stream, "process_name", FrameProcess, 0, "Frames");
+
+    std::set<uint32_t> threads;
+    for (const auto& frame : recentFrames) {
+        WriteCompleteEvent(stream, "Frame " + std::to_string(frame.index), FrameProcess, 0, frame.start, frame.end);
+
+        for (const auto& zone : frame.zones) {
+            if (zone.thread == GpuThread) {
+                WriteCompleteEvent(stream, zone.name, GpuProcess, 0, zone.start, zone.end);
+                continue;
+            }
+
+            threads.insert(zone.thread);
+            WriteCompleteEvent(stream, zone.name, CpuProcess, zone.thread, zone.start, zone.end);
+        }
+    }
+
+    for (auto thread : threads) WriteNameEvent(stream, "thread_name", CpuProcess, thread, "Thread " + std::to_string(thread));
+
+    stream << "\n]}\n";
+    return true;
+}
+
+uint32_t Profiler::GetThreadIndex()
+{
+    thread_local uint32_t threadIndex = threadCount++;
+    return threadIndex;
+}
+
+std::vector<Profiler::OpenZone>& Profiler::GetOpenZones()
+{
+    thread_local std::vector<OpenZone> openZones;
+    return openZones;
+}
+}   // namespace MapleLeaf
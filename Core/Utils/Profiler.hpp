@@ -0,0 +1,141 @@
+#pragma once
+
+#include "NonCopyable.hpp"
+#include "Time.hpp"
+#include "config.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MapleLeaf {
+/**
+ * Collects timed zones of the recent frames, CPU zones are recorded per thread and GPU zones are handed in once their timestamps are read back.
+ */
+class Profiler
+{
+public:
+    /**
+     * The thread index of zones measured on the GPU.
+     */
+    static constexpr uint32_t GpuThread = UINT32_MAX;
+
+    /**
+     * The number of recent frames kept.
+     */
+    static constexpr uint32_t FrameCount = 120;
+
+    struct Zone
+    {
+        std::string name;
+        uint32_t    thread;
+        uint32_t    depth;
+        Time        start;
+        Time        end;
+    };
+
+    struct Frame
+    {
+        uint64_t          index = 0;
+        Time              start;
+        Time              end;
+        std::vector<Zone> zones;
+    };
+
+    class Scope : NonCopyable
+    {
+    public:
+        explicit Scope(std::string_view name)
+            : active(enabled)
+        {
+            if (active) BeginZone(name);
+        }
+        ~Scope()
+        {
+            if (active) EndZone();
+        }
+
+    private:
+        // Toggling the profiler while the scope is open must not unbalance the zone stack.
+        bool active;
+    };
+
+    /**
+     * Closes the current frame into the ring of recent frames and starts a new one.
+     */
+    static void BeginFrame();
+
+    static void BeginZone(std::string_view name);
+    static void EndZone();
+
+    /**
+     * Adds zones measured on the GPU to the frame they were recorded in, dropped if the frame has left the ring.
+     * @param frameIndex The index of the frame the zones were recorded in.
+     * @param zones The zones, on the CPU timeline.
+     */
+    static void AddGpuZones(uint64_t frameIndex, std::vector<Zone>&& zones);
+
+    static uint64_t GetFrameIndex();
+
+    /**
+     * Gets a copy of a recent frame.
+     * @param frameIndex The index of the frame.
+     * @return The frame, nullopt if it has left the ring or is still being recorded.
+     */
+    static std::optional<Frame> GetFrame(uint64_t frameIndex);
+
+    /**
+     * Gets a copy of the recent frames, the oldest first.
+     */
+    static std::vector<Frame> GetFrames();
+
+    /**
+     * Writes the recent frames as a Chrome trace event file, it can be loaded in chrome://tracing or Perfetto.
+     * @param filename The file to write.
+     * @return If the file was written.
+     */
+    static bool ExportChromeTrace(const std::filesystem::path& filename);
+
+#ifdef MAPLELEAF_PROFILER
+    static bool IsEnabled() { return enabled; }
+#else
+    // Compiled out, zone names only built behind IsEnabled are dropped as dead code.
+    static constexpr bool IsEnabled() { return false; }
+#endif
+    static void SetEnabled(bool enable) { enabled = enable; }
+
+private:
+    struct OpenZone
+    {
+        std::string name;
+        Time        start;
+    };
+
+    static std::mutex            mutex;
+    static std::deque<Frame>     frames;
+    static Frame                 currentFrame;
+    static std::atomic<uint32_t> threadCount;
+
+#ifdef MAPLELEAF_PROFILER
+    inline static std::atomic<bool> enabled = true;
+#else
+    inline static std::atomic<bool> enabled = false;
+#endif
+
+    static uint32_t               GetThreadIndex();
+    static std::vector<OpenZone>& GetOpenZones();
+};
+}   // namespace MapleLeaf
+
+#ifdef MAPLELEAF_PROFILER
+#define MAPLELEAF_PROFILE_CONCAT_IMPL(a, b) a##b
+#define MAPLELEAF_PROFILE_CONCAT(a, b) MAPLELEAF_PROFILE_CONCAT_IMPL(a, b)
+#define MAPLELEAF_PROFILE_SCOPE(name) ::MapleLeaf::Profiler::Scope MAPLELEAF_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define MAPLELEAF_PROFILE_SCOPE(name)
+#endif
@@ -1,5 +1,9 @@
 #include "String.hpp"
 
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
 #include <sstream>
 
 namespace MapleLeaf {
@@ -22,4 +26,22 @@ std::string String::ReplaceFirst(std::string str, std::string_view token, std::s
     return str;
 }
 
+std::optional<uint32_t> String::ParseUint32(std::string_view str)
+{
+    uint32_t value    = 0;
+    auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (str.empty() || error != std::errc() || end != str.data() + str.size()) return std::nullopt;
+    return value;
+}
+
+std::optional<float> String::ParseFloat(const std::string& str)
+{
+    // std::from_chars for floats is missing from some standard libraries the engine builds with.
+    char* end  = nullptr;
+    errno      = 0;
+    auto value = std::strtof(str.c_str(), &end);
+    if (str.empty() || errno == ERANGE || end != str.c_str() + str.size() || !std::isfinite(value)) return std::nullopt;
+    return value;
+}
+
 }   // namespace MapleLeaf
\ No newline at end of file
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace MapleLeaf {
@@ -23,5 +26,19 @@ public:
      * @return The string with the tokens replaced.
      */
     static std::string ReplaceFirst(std::string str, std::string_view token, std::string_view to);
+
+    /**
+     * Parses a whole string as an unsigned 32 bit integer, such as a command line value.
+     * @param str The string.
+     * @return The value, nullopt if the string is not a number, has trailing characters or is out of range.
+     */
+    static std::optional<uint32_t> ParseUint32(std::string_view str);
+
+    /**
+     * Parses a whole string as a finite float, such as a command line value.
+     * @param str The string.
+     * @return The value, nullopt if the string is not a number, has trailing characters or is out of range.
+     */
+    static std::optional<float> ParseFloat(const std::string& str);
 };
 }   // namespace MapleLeaf
\ No newline at end of file
@@ -1,47 +1,217 @@
 #include "ThreadPool.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
 
 namespace MapleLeaf {
+namespace {
+// The pool and queue the calling thread works for, tasks scheduled from a worker go to its own deque.
+thread_local const ThreadPool* CurrentPool   = nullptr;
+thread_local int32_t           CurrentWorker = -1;
+// Tasks currently executing on this thread, more than one when a task helps out inside Wait.
+thread_local uint32_t RunningDepth = 0;
+
+// Counts a task as running on this thread for its lifetime, so the depth is restored even if the work throws.
+struct RunningDepthGuard
+{
+    RunningDepthGuard() { RunningDepth++; }
+    ~RunningDepthGuard() { RunningDepth--; }
+};
+}   // namespace
+
+bool Task::IsFinished() const
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    return finished;
+}
+
 ThreadPool::ThreadPool(uint32_t threadCount)
 {
+    threadCount = std::max(threadCount, 1u);
+
+    queues.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i) queues.emplace_back(std::make_unique<WorkerQueue>());
+
     workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i) workers.emplace_back([this, i] { WorkerLoop(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        stop = true;
+    }
+
+    wakeCondition.notify_all();
+
+    for (auto& worker : workers) worker.join();
+}
+
+std::shared_ptr<Task> ThreadPool::Schedule(std::function<void()>&& work, Task::Priority priority,
+                                           const std::vector<std::shared_ptr<Task>>& dependencies)
+{
+    {
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        if (stop) throw std::runtime_error("Enqueue called on a stopped ThreadPool");
+    }
+
+    auto task      = std::make_shared<Task>();
+    task->work     = std::move(work);
+    task->priority = priority;
+    pendingCount++;
+
+    for (const auto& dependency : dependencies) {
+        if (!dependency) continue;
+
+        std::unique_lock<std::mutex> lock(dependency->mutex);
+        if (!dependency->finished) {
+            task->remainingDependencies++;
+            dependency->continuations.emplace_back(task);
+        }
+    }
+
+    // Drops the scheduling guard, the task is queued here unless a dependency is still running.
+    Release(task);
+    return task;
+}
+
+void ThreadPool::Wait()
+{
+    if (auto worker = GetCurrentWorker(); worker >= 0) {
+        // Tasks blocked in here can never finish before the wait returns, so they are excluded from the pending count.
+        blockedCount += RunningDepth;
+        while (pendingCount > blockedCount) {
+            if (auto task = Pop(static_cast<uint32_t>(worker)))
+                Run(task);
+            else
+                std::this_thread::yield();
+        }
+        blockedCount -= RunningDepth;
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    idleCondition.wait(lock, [this]() { return pendingCount == 0; });
+}
+
+void ThreadPool::WorkerLoop(uint32_t index)
+{
+    CurrentPool   = this;
+    CurrentWorker = static_cast<int32_t>(index);
 
-    for (std::size_t i = 0; i < threadCount; ++i) {
-        workers.emplace_back([this] {
-            while (true) {
-                std::function<void()> task;
+    while (true) {
+        if (auto task = Pop(index)) {
+            Run(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCondition.wait(lock, [this] { return stop || queuedCount > 0; });
+
+        if (stop && queuedCount == 0) return;
+    }
+}
 
-                {
-                    std::unique_lock<std::mutex> lock(queueMutex);
-                    condition.wait(lock, [this] { return stop || !tasks.empty(); });
+void ThreadPool::Push(std::shared_ptr<Task> task)
+{
+    auto worker = GetCurrentWorker();
+    auto index  = worker >= 0 ? static_cast<uint32_t>(worker) : nextQueue++ % static_cast<uint32_t>(queues.size());
+    auto lane   = static_cast<std::size_t>(task->priority);
+
+    // Counted in the same critical section the task is published in, a thief can't take it before the count includes it,
+    // and a worker woken by the count finds it in the deque.
+    {
+        std::unique_lock<std::mutex> wakeLock(wakeMutex);
+        std::unique_lock<std::mutex> queueLock(queues[index]->mutex);
+        queues[index]->lanes[lane].emplace_back(std::move(task));
+        queuedCount++;
+    }
+
+    wakeCondition.notify_one();
+}
+
+std::shared_ptr<Task> ThreadPool::Pop(uint32_t index)
+{
+    auto queueCount = static_cast<uint32_t>(queues.size());
 
-                    if (stop && tasks.empty()) return;
+    for (std::size_t lane = 0; lane < static_cast<std::size_t>(Task::Priority::Count); lane++) {
+        std::shared_ptr<Task> task;
 
-                    task = std::move(tasks.front());
-                    tasks.pop();
+        // Newest task of our own deque first, it is the most likely to be hot in cache.
+        {
+            std::unique_lock<std::mutex> lock(queues[index]->mutex);
+            if (auto& deque = queues[index]->lanes[lane]; !deque.empty()) {
+                task = std::move(deque.back());
+                deque.pop_back();
+            }
+        }
+
+        // Otherwise steal the oldest task of another worker. Busy victims are skipped at first and only waited for if no other one had a task,
+        // giving up on them would leave the caller spinning on a queued count it can't bring down.
+        bool contended = false;
+        for (uint32_t pass = 0; !task && pass < 2 && (pass == 0 || contended); pass++) {
+            for (uint32_t i = 1; !task && i < queueCount; i++) {
+                auto&                        victim = queues[(index + i) % queueCount];
+                std::unique_lock<std::mutex> lock(victim->mutex, std::defer_lock);
+                if (pass > 0) {
+                    lock.lock();
+                }
+                else if (!lock.try_lock()) {
+                    contended = true;
+                    continue;
                 }
 
-                task();
+                if (auto& deque = victim->lanes[lane]; !deque.empty()) {
+                    task = std::move(deque.front());
+                    deque.pop_front();
+                }
             }
-        });
+        }
+
+        if (task) {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            queuedCount--;
+            return task;
+        }
     }
+
+    return nullptr;
 }
 
-ThreadPool::~ThreadPool()
+void ThreadPool::Run(const std::shared_ptr<Task>& task)
 {
     {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        stop = true;
+        RunningDepthGuard depthGuard;
+        MAPLELEAF_PROFILE_SCOPE(task->priority == Task::Priority::Critical ? "Critical task" : "Streaming task");
+        task->work();
     }
+    // Releases everything captured by the work, such as futures moved into a continuation.
+    task->work = nullptr;
 
-    condition.notify_all();
+    std::vector<std::shared_ptr<Task>> continuations;
+    {
+        std::unique_lock<std::mutex> lock(task->mutex);
+        task->finished = true;
+        continuations.swap(task->continuations);
+    }
 
-    for (auto& worker : workers) worker.join();
+    for (const auto& continuation : continuations) Release(continuation);
+
+    if (--pendingCount == 0) {
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        idleCondition.notify_all();
+    }
 }
 
-void ThreadPool::Wait()
+void ThreadPool::Release(const std::shared_ptr<Task>& task)
 {
-    std::unique_lock<std::mutex> lock(queueMutex);
+    if (--task->remainingDependencies == 0) Push(task);
+}
 
-    condition.wait(lock, [this]() { return tasks.empty(); });
+int32_t ThreadPool::GetCurrentWorker() const
+{
+    return CurrentPool == this ? CurrentWorker : -1;
 }
-}   // namespace MapleLeaf
\ No newline at end of file
+}   // namespace MapleLeaf
@@ -1,53 +1,169 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
 #include <mutex>
-#include <queue>
 #include <thread>
+#include <vector>
 
+#include "Future.hpp"
 #include "config.h"
 
 namespace MapleLeaf {
+/**
+ * A unit of work scheduled on a ThreadPool, it is queued once every task it depends on has finished.
+ */
+class Task
+{
+    friend class ThreadPool;
+
+public:
+    /**
+     * Lanes a task can be queued on, workers drain every frame critical task before touching streaming work.
+     */
+    enum class Priority : uint8_t
+    {
+        Critical = 0,
+        Streaming,
+        Count
+    };
+
+    bool     IsFinished() const;
+    Priority GetPriority() const { return priority; }
+
+private:
+    std::function<void()> work;
+    Priority              priority = Priority::Streaming;
+
+    // Unfinished dependencies, plus one guard held while the task is being scheduled.
+    std::atomic<uint32_t> remainingDependencies = 1;
+
+    mutable std::mutex                 mutex;
+    bool                               finished = false;
+    std::vector<std::shared_ptr<Task>> continuations;
+};
+
+/**
+ * Job system with a deque per worker and per priority lane, idle workers steal from the others.
+ */
 class ThreadPool
 {
 public:
     explicit ThreadPool(uint32_t threadCount = std::thread::hardware_concurrency());
     ~ThreadPool();
 
+    /**
+     * Schedules a streaming priority task.
+     * @return The future holding the result of the function.
+     */
     template<typename F, typename... Args>
     auto Enqueue(F&& f, Args&&... args);
 
+    template<typename F, typename... Args>
+    auto Enqueue(Task::Priority priority, F&& f, Args&&... args);
+
+    /**
+     * Schedules a task that only starts once every dependency has finished.
+     * @param dependencies The tasks to wait for, entries may be nullptr.
+     * @return The future holding the result of the function.
+     */
+    template<typename F, typename... Args>
+    auto EnqueueAfter(const std::vector<std::shared_ptr<Task>>& dependencies, Task::Priority priority, F&& f, Args&&... args);
+
+    /**
+     * Schedules a continuation consuming the value of a future produced by this pool, without blocking a worker while it is computed.
+     * @param future The future to consume, its value is moved into the continuation.
+     * @return The future holding the result of the continuation.
+     */
+    template<typename T, typename F>
+    auto Then(Future<T>&& future, F&& f, Task::Priority priority = Task::Priority::Streaming);
+
+    /**
+     * Schedules a type erased task, the building block of the Enqueue family.
+     * @return The task, usable as a dependency of other tasks.
+     */
+    std::shared_ptr<Task> Schedule(std::function<void()>&& work, Task::Priority priority = Task::Priority::Streaming,
+                                   const std::vector<std::shared_ptr<Task>>& dependencies = {});
+
+    /**
+     * Blocks until every scheduled task, including running ones and ones waiting on dependencies, has finished.
+     * When called from inside a task the calling worker keeps executing tasks while it waits, and tasks blocked in Wait are not waited on.
+     */
     void Wait();
 
     const std::vector<std::thread>& GetWorkers() const { return workers; }
 
 private:
-    std::vector<std::thread>          workers;
-    std::queue<std::function<void()>> tasks;
+    struct WorkerQueue
+    {
+        using Lane = std::deque<std::shared_ptr<Task>>;
+
+        std::mutex                                                        mutex;
+        std::array<Lane, static_cast<std::size_t>(Task::Priority::Count)> lanes;
+    };
+
+    std::vector<std::thread>                  workers;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
 
-    std::mutex              queueMutex;
-    std::condition_variable condition;
-    bool                    stop = false;
+    std::mutex               wakeMutex;
+    std::condition_variable  wakeCondition;
+    std::condition_variable  idleCondition;
+    std::size_t              queuedCount  = 0;   // Guarded by wakeMutex, which is locked before a queue mutex when both are held.
+    std::atomic<std::size_t> pendingCount = 0;   // Scheduled tasks that have not finished yet.
+    std::atomic<std::size_t> blockedCount = 0;   // Running tasks that are blocked in Wait.
+    std::atomic<uint32_t>    nextQueue    = 0;
+    bool                     stop         = false;
+
+    void                  WorkerLoop(uint32_t index);
+    void                  Push(std::shared_ptr<Task> task);
+    std::shared_ptr<Task> Pop(uint32_t index);
+    void                  Run(const std::shared_ptr<Task>& task);
+    void                  Release(const std::shared_ptr<Task>& task);
+    int32_t               GetCurrentWorker() const;
 };
 
 template<typename F, typename... Args>
 auto ThreadPool::Enqueue(F&& f, Args&&... args)
+{
+    return EnqueueAfter({}, Task::Priority::Streaming, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+template<typename F, typename... Args>
+auto ThreadPool::Enqueue(Task::Priority priority, F&& f, Args&&... args)
+{
+    return EnqueueAfter({}, priority, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+template<typename F, typename... Args>
+auto ThreadPool::EnqueueAfter(const std::vector<std::shared_ptr<Task>>& dependencies, Task::Priority priority, F&& f, Args&&... args)
 {
     using return_type = typename std::invoke_result_t<F, Args...>;
 
-    auto task   = std::make_shared<std::packaged_task<return_type()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-    auto result = task->get_future();
+    auto packagedTask = std::make_shared<std::packaged_task<return_type()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    auto result       = packagedTask->get_future();
 
-    {
-        std::unique_lock<std::mutex> lock(queueMutex);
+    auto task = Schedule([packagedTask]() { (*packagedTask)(); }, priority, dependencies);
+    return Future<return_type>(std::move(result), std::move(task));
+}
 
-        if (stop) throw std::runtime_error("Enqueue called on a stopped ThreadPool");
+template<typename T, typename F>
+auto ThreadPool::Then(Future<T>&& future, F&& f, Task::Priority priority)
+{
+    auto dependency = future.GetTask();
+    auto source     = std::make_shared<Future<T>>(std::move(future));
 
-        tasks.emplace([task]() { (*task)(); });
+    if constexpr (std::is_void_v<T>) {
+        return EnqueueAfter({dependency}, priority, [source, f = std::forward<F>(f)]() mutable {
+            source->get();
+            return f();
+        });
+    }
+    else {
+        return EnqueueAfter({dependency}, priority, [source, f = std::forward<F>(f)]() mutable { return f(std::move(source->get())); });
     }
-
-    condition.notify_one();
-    return result;
 }
-}   // namespace MapleLeaf
\ No newline at end of file
+}   // namespace MapleLeaf
@@ -1,4 +1,5 @@
 #include "DeferredSubrender.hpp"
+#include "GBufferSubrender.hpp"
 #include "LightSystem.hpp"
 #include "Scenes.hpp"
 #include "ShadowSystem.hpp"
@@ -8,8 +9,9 @@ namespace MapleLeaf {
 
 DeferredSubrender::DeferredSubrender(const Pipeline::Stage& pipelineStage)
     : Subrender(pipelineStage)
-    , pipeline(pipelineStage, {"Shader/Deferred/Deferred.vert", "Shader/Deferred/Deferred.frag"}, {}, {}, PipelineGraphics::Mode::Polygon,
-               PipelineGraphics::Depth::None)
+    , pipeline(pipelineStage, {"Shader/Deferred/Deferred.vert", "Shader/Deferred/Deferred.frag"}, {},
+               {GBufferSubrender::GetLayoutDefine(), {"SHADOW_CASCADE_COUNT", std::to_string(ShadowSystem::CascadeCount)}},
+               PipelineGraphics::Mode::Polygon, PipelineGraphics::Depth::None)
     , descriptorSet(pipeline)
 {
     // uniformScene  = UniformHandler(pipeline.GetShader()->GetUniformBlock("uniformScene").value());
@@ -29,8 +31,18 @@ void DeferredSubrender::Render(const CommandBuffer& commandBuffer)
 
     camera->PushUniforms(uniformCamera);
 
-    if (auto shadows = Scenes::Get()->GetScene()->GetSystem<ShadowSystem>())
-        uniformScene.Push("shadowMatrix", shadows->GetShadowCascade().GetLightProjectionViewMatrix());
+    auto shadows = Scenes::Get()->GetScene()->GetSystem<ShadowSystem>();
+    if (shadows) {
+        std::array<glm::mat4, ShadowSystem::CascadeCount> shadowMatrices;
+        for (uint32_t i = 0; i < ShadowSystem::CascadeCount; i++) shadowMatrices[i] = shadows->GetShadowCascades()[i].GetLightProjectionViewMatrix();
+
+        uniformScene.Push("shadowMatrices", shadowMatrices);
+        uniformScene.Push("shadowSplitDepths", shadows->GetSplitDepths());
+        uniformScene.Push("shadowBias", shadows->GetShadowBias());
+        uniformScene.Push("shadowPcf", shadows->GetShadowPcf());
+    }
+    uniformScene.Push("shadowsEnabled", int(shadows != nullptr));
+    uniformScene.Push("shadowLightSlot", lightSystem->GetShadowLightSlot());
     uniformScene.Push("pointLightsCount", lightSystem->GetPointLightsCount() - 1);
     uniformScene.Push("directionalLightsCount", lightSystem->GetDirectionalLightsCount() - 1);
     uniformScene.Push("areaLightsCount", lightSystem->GetAreaLightsCount() - 1);
@@ -42,7 +54,13 @@ void DeferredSubrender::Render(const CommandBuffer& commandBuffer)
     descriptorSet.Push("bufferDirectionalLights", lightSystem->GetStorageDirectionalLights());
     descriptorSet.Push("bufferAreaLights", lightSystem->GetStorageAreaLights());
 
-    descriptorSet.Push("inPosition", Graphics::Get()->GetAttachment("position"));
+    if (GBufferSubrender::layout == GBufferSubrender::Layout::Compact) {
+        descriptorSet.Push("inDepth", Graphics::Get()->GetAttachment("depth"));
+        descriptorSet.Push("inInstanceID", Graphics::Get()->GetAttachment("instanceId"));
+    }
+    else {
+        descriptorSet.Push("inPosition", Graphics::Get()->GetAttachment("position"));
+    }
     descriptorSet.Push("inDiffuse", Graphics::Get()->GetAttachment("diffuse"));
     descriptorSet.Push("inNormal", Graphics::Get()->GetAttachment("normal"));
     descriptorSet.Push("inMaterial", Graphics::Get()->GetAttachment("material"));
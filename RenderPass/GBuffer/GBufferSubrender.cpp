@@ -1,46 +1,114 @@
 #include "GBufferSubrender.hpp"
 #include "GpuScene.hpp"
+#include "Graphics.hpp"
 #include "Scenes.hpp"
 
 
 namespace MapleLeaf {
-GBufferSubrender::GBufferSubrender(const Pipeline::Stage& stage)
+namespace {
+void InsertMemoryBarrier(const CommandBuffer& commandBuffer, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask,
+                         VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask)
+{
+    VkMemoryBarrier memoryBarrier = {};
+    memoryBarrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask   = srcAccessMask;
+    memoryBarrier.dstAccessMask   = dstAccessMask;
+    vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+}
+}   // namespace
+
+GBufferSubrender::CullingPass::CullingPass(const std::filesystem::path& shaderStage)
+    : pipeline(shaderStage)
+    , descriptorSet(pipeline)
+    , pushHandler(pipeline.GetShader()->GetUniformBlock("pushObject").value())
+{}
+
+GBufferSubrender::GBufferSubrender(const Pipeline::Stage& stage, CullingMode cullingMode)
     : Subrender(stage)
-    , compute("Shader/GPUDriven/Culling.comp")
-    , pipeline(stage, {"Shader/GBuffer/GBuffer.vert", "Shader/GBuffer/GBuffer.frag"}, {Vertex3D::GetVertexInput()}, {}, PipelineGraphics::Mode::MRT,
-               PipelineGraphics::Depth::ReadWrite, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE,
-               VK_FRONT_FACE_COUNTER_CLOCKWISE, false)
-    , descriptorSetCompute(compute)
+    , pipeline(stage, {"Shader/GBuffer/GBuffer.vert", "Shader/GBuffer/GBuffer.frag"}, {GPUScene::GetVertexInput()},
+               {{"COMPACT_VERTICES", std::to_string(static_cast<uint32_t>(GPUInstance::vertexLayout == VertexLayout::Compact))}, GetLayoutDefine()},
+               PipelineGraphics::Mode::MRT, PipelineGraphics::Depth::ReadWrite, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_POLYGON_MODE_FILL,
+               VK_CULL_MODE_NONE, VK_FRONT_FACE_COUNTER_CLOCKWISE, false)
+    , hizCompute("Shader/GPUDriven/HiZ.comp")
     , descriptorSetGraphics(pipeline)
+    , cullingMode(cullingMode)
+    , instanceCulling("Shader/GPUDriven/Culling.comp")
 {
-    pushHandler   = PushHandler(compute.GetShader()->GetUniformBlock("pushObject").value());
-    uniformCamera = UniformHandler(compute.GetShader()->GetUniformBlock("camera").value(), true);
+    if (cullingMode == CullingMode::Cluster) clusterCulling = std::make_unique<CullingPass>("Shader/GPUDriven/ClusterCulling.comp");
+
+    hizPushHandler = PushHandler(hizCompute.GetShader()->GetUniformBlock("pushObject").value());
+    uniformCamera  = UniformHandler(instanceCulling.pipeline.GetShader()->GetUniformBlock("camera").value(), true);
 }
 
 void GBufferSubrender::PreRender(const CommandBuffer& commandBuffer)
 {
+    activeCulling = nullptr;
+
     const auto gpuScene = Scenes::Get()->GetScene()->GetDerivedScene<GPUScene>();
     if (!gpuScene || !gpuScene->GetIndirectBuffer()) return;
 
     auto camera = Scenes::Get()->GetScene()->GetCamera();
     camera->PushUniforms(uniformCamera);
 
-    uint32_t instanceCount = gpuScene->GetInstanceCount();
-
-    pushHandler.Push("instanceCount", instanceCount);
-
-    descriptorSetCompute.Push("instanceDatas", gpuScene->GetInstanceDatasHandler());
-    descriptorSetCompute.Push("drawCommandBuffer", gpuScene->GetIndirectBuffer());
-    descriptorSetCompute.Push("camera", uniformCamera);
-    descriptorSetCompute.Push("pushObject", pushHandler);
-
-    if (!descriptorSetCompute.Update(compute)) return;
-    compute.BindPipeline(commandBuffer);
-    descriptorSetCompute.BindDescriptor(commandBuffer, compute);
-    pushHandler.BindPush(commandBuffer, compute);
-    compute.CmdRender(commandBuffer, glm::uvec2(instanceCount, 1));
-
-    gpuScene->GetIndirectBuffer()->IndirectBufferPipelineBarrier(commandBuffer);
+    // The depth attachment is recreated with the swapchain, the pyramid follows it.
+    auto depth = Graphics::Get()->GetRenderStage(GetStage().first)->GetDepthStencil();
+    if (depth && (depth != hizDepth || depth->GetView() != hizDepthView)) CreateHierarchyZ(*depth);
+
+    // Scenes without meshlets, such as ones of non indexed models, are culled per instance.
+    auto useClusters = clusterCulling && gpuScene->GetClusterCount() > 0 && gpuScene->GetClusterIndirectBuffer();
+    auto& culling    = useClusters ? *clusterCulling : instanceCulling;
+    auto  count      = useClusters ? gpuScene->GetClusterCount() : gpuScene->GetInstanceCount();
+    if (count == 0) return;
+
+    // Nothing was visible last frame for a new instance or cluster set, the second phase finds and draws everything.
+    if (!culling.visibility || culling.visibility->GetSize() != sizeof(uint32_t) * count) {
+        std::vector<uint32_t> visibility(count, 0);
+        culling.visibility = std::make_unique<StorageBuffer>(sizeof(uint32_t) * count, visibility.data());
+    }
+
+    auto frameSlotCount = Graphics::Get()->GetSwapchain()->GetImageCount();
+    auto frameSlot      = static_cast<uint32_t>(Graphics::Get()->GetSurface()->GetCurrentFrameIndex());
+    if (!statisticsBuffer || statisticsBuffer->GetSize() < sizeof(CullingStatistics) * frameSlotCount) {
+        std::vector<CullingStatistics> statistics(frameSlotCount);
+        statisticsBuffer = std::make_unique<StorageBuffer>(sizeof(CullingStatistics) * frameSlotCount, statistics.data());
+    }
+    else {
+        // The fence of this frame slot has been waited on, the frame that last used it has finished.
+        void* data;
+        statisticsBuffer->MapMemory(&data);
+        auto slot         = static_cast<CullingStatistics*>(data) + frameSlot;
+        cullingStatistics = *slot;
+        *slot             = {};
+        statisticsBuffer->UnmapMemory();
+    }
+
+    culling.pushHandler.Push("frameSlot", frameSlot);
+
+    culling.descriptorSet.Push("instanceDatas", gpuScene->GetInstanceDatasHandler());
+    culling.descriptorSet.Push("drawCommandBuffer", useClusters ? gpuScene->GetClusterIndirectBuffer() : gpuScene->GetIndirectBuffer());
+    culling.descriptorSet.Push("camera", uniformCamera);
+    culling.descriptorSet.Push("visibility", culling.visibility);
+    culling.descriptorSet.Push("cullingStatistics", statisticsBuffer);
+    culling.descriptorSet.Push("hizDepth", hierarchyZ);
+    culling.descriptorSet.Push("lodDatas", gpuScene->GetLodDatasHandler());
+    if (useClusters) {
+        culling.descriptorSet.Push("meshletDatas", gpuScene->GetMeshletDatasHandler());
+        culling.descriptorSet.Push("clusterInstances", gpuScene->GetClusterInstancesHandler());
+    }
+    culling.descriptorSet.Push("pushObject", culling.pushHandler);
+
+    if (!culling.descriptorSet.Update(culling.pipeline)) return;
+
+    // The visibility written by the second phase of the previous frame.
+    Buffer::InsertBufferMemoryBarrier(commandBuffer,
+                                      culling.visibility->GetBuffer(),
+                                      VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    activeCulling = &culling;
+    DispatchCulling(commandBuffer, *gpuScene, 0);
 }
 
 void GBufferSubrender::Render(const CommandBuffer& commandBuffer)
@@ -54,16 +122,129 @@ void GBufferSubrender::Render(const CommandBuffer& commandBuffer)
     descriptorSetGraphics.Push("camera", uniformCamera);
     gpuScene->PushDescriptors(descriptorSetGraphics);
 
-    if (!descriptorSetGraphics.Update(pipeline)) return;
+    if (!descriptorSetGraphics.Update(pipeline)) {
+        activeCulling = nullptr;
+        return;
+    }
     pipeline.BindPipeline(commandBuffer);
 
     descriptorSetGraphics.BindDescriptor(commandBuffer, pipeline);
 
-    gpuScene->CmdRender(commandBuffer);
+    CmdRender(commandBuffer, *gpuScene);
 }
 
-void GBufferSubrender::PostRender(const CommandBuffer& commandBuffer) {}
+void GBufferSubrender::PostRender(const CommandBuffer& commandBuffer)
+{
+    if (!activeCulling || !occlusionCulling || !hierarchyZ) return;
+
+    const auto gpuScene = Scenes::Get()->GetScene()->GetDerivedScene<GPUScene>();
+    if (!gpuScene || !gpuScene->GetIndirectBuffer()) return;
+
+    // The first phase depth is complete before the pyramid reads it and its draws consumed the commands before they are rewritten.
+    InsertMemoryBarrier(commandBuffer,
+                        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    hizCompute.BindPipeline(commandBuffer);
+    auto srcSize = hizDepth->GetSize();
+    for (uint32_t level = 0; level < hierarchyZ->GetMipLevels(); level++) {
+        auto dstSize = glm::max(hierarchyZ->GetSize() >> level, glm::uvec2(1));
+
+        hizPushHandler.Push("srcSize", srcSize);
+        hizPushHandler.Push("dstSize", dstSize);
+        hizDescriptorSets[level].BindDescriptor(commandBuffer, hizCompute);
+        hizPushHandler.BindPush(commandBuffer, hizCompute);
+        hizCompute.CmdRender(commandBuffer, dstSize);
+
+        hierarchyZ->ImageHierarchyZPipelineBarrierComputeToCompute(commandBuffer);
+        srcSize = dstSize;
+    }
+
+    DispatchCulling(commandBuffer, *gpuScene, 1);
+    activeCulling = nullptr;
+
+    // The pyramid reads of the depth finish before the second phase writes it, the loaded attachments see the first phase writes.
+    InsertMemoryBarrier(commandBuffer,
+                        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+    // Other subpasses of the stage record nothing in the continued pass, their results are already in the loaded attachments.
+    auto renderStage = Graphics::Get()->GetRenderStage(GetStage().first);
+    Graphics::Get()->ContinueRenderpass(*renderStage);
+    for (const auto& subpass : renderStage->GetSubpasses()) {
+        if (subpass.GetBinding() == GetStage().second) {
+            pipeline.BindPipeline(commandBuffer);
+            descriptorSetGraphics.BindDescriptor(commandBuffer, pipeline);
+            CmdRender(commandBuffer, *gpuScene);
+        }
+
+        if (subpass.GetBinding() != renderStage->GetSubpasses().back().GetBinding()) vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+    }
+    vkCmdEndRenderPass(commandBuffer);
+}
 
 void GBufferSubrender::RegisterImGui() {}
 
+void GBufferSubrender::CreateHierarchyZ(const ImageDepth& depth)
+{
+    hizDepth     = &depth;
+    hizDepthView = depth.GetView();
+    hierarchyZ   = std::make_unique<ImageHierarchyZ>(ImageHierarchyZ::GetPyramidSize(depth.GetSize()));
+
+    // Level 0 reduces the depth attachment, every other level the one above it.
+    hizDescriptorSets.clear();
+    hizDescriptorSets.reserve(hierarchyZ->GetMipLevels());
+    for (uint32_t level = 0; level < hierarchyZ->GetMipLevels(); level++) {
+        auto& descriptorSet = hizDescriptorSets.emplace_back(hizCompute);
+
+        if (level == 0)
+            descriptorSet.Push("srcDepth", hizDepth);
+        else
+            descriptorSet.Push("srcDepth", static_cast<const Image*>(hierarchyZ.get()), level - 1);
+        descriptorSet.Push("dstDepth", static_cast<const Image*>(hierarchyZ.get()), level);
+        descriptorSet.Push("pushObject", hizPushHandler);
+
+        descriptorSet.Update(hizCompute);
+    }
+}
+
+void GBufferSubrender::DispatchCulling(const CommandBuffer& commandBuffer, const GPUScene& gpuScene, uint32_t phase)
+{
+    auto& culling     = *activeCulling;
+    auto  useClusters = activeCulling == clusterCulling.get();
+    auto  count       = useClusters ? gpuScene.GetClusterCount() : gpuScene.GetInstanceCount();
+
+    culling.pushHandler.Push(useClusters ? "clusterCount" : "instanceCount", count);
+    culling.pushHandler.Push("phase", phase);
+    culling.pushHandler.Push("occlusionCulling", static_cast<uint32_t>(occlusionCulling && hierarchyZ));
+    culling.pushHandler.Push("coneCulling", static_cast<uint32_t>(coneCulling));
+    culling.pushHandler.Push("lodErrorThreshold", lodErrorThreshold);
+    if (hierarchyZ) {
+        culling.pushHandler.Push("hizMipLevels", hierarchyZ->GetMipLevels());
+        culling.pushHandler.Push("hizSize", hierarchyZ->GetSize());
+    }
+
+    culling.pipeline.BindPipeline(commandBuffer);
+    culling.descriptorSet.BindDescriptor(commandBuffer, culling.pipeline);
+    culling.pushHandler.BindPush(commandBuffer, culling.pipeline);
+    culling.pipeline.CmdRender(commandBuffer, glm::uvec2(count, 1));
+
+    const auto indirectBuffer = useClusters ? gpuScene.GetClusterIndirectBuffer() : gpuScene.GetIndirectBuffer();
+    indirectBuffer->IndirectBufferPipelineBarrier(commandBuffer);
+}
+
+void GBufferSubrender::CmdRender(const CommandBuffer& commandBuffer, GPUScene& gpuScene) const
+{
+    if (clusterCulling && activeCulling == clusterCulling.get())
+        gpuScene.CmdRenderClusters(commandBuffer);
+    else
+        gpuScene.CmdRender(commandBuffer);
+}
 }   // namespace MapleLeaf
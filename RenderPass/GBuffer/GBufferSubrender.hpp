@@ -1,16 +1,64 @@
 #pragma once
 
 #include "DescriptorHandler.hpp"
+#include "ImageHierarchyZ.hpp"
 #include "PipelineCompute.hpp"
 #include "PipelineGraphics.hpp"
+#include "StorageBuffer.hpp"
 #include "Subrender.hpp"
 #include "UniformHandler.hpp"
 
+#include "config.h"
+
 namespace MapleLeaf {
+class GPUScene;
+class ImageDepth;
+
+/**
+ * Draws the GPU scene into the G-buffer with two phase occlusion culling.
+ * The render pass draws the instances visible last frame, PostRender builds a depth pyramid from them, tests every instance against it and draws the
+ * newly visible ones into the same attachments. With cluster culling the same is done per meshlet of every instance, with backface cone culling.
+ */
 class GBufferSubrender : public Subrender
 {
 public:
-    explicit GBufferSubrender(const Pipeline::Stage& stage);
+    enum class CullingMode
+    {
+        Instance,
+        Cluster
+    };
+
+    // Full stores world positions and every surface attribute in 32 bit floats, Compact reconstructs positions from depth and packs the
+    // attributes, see Misc/GBufferPacking.glsl.
+    enum class Layout
+    {
+        Full,
+        Compact
+    };
+
+#ifdef MAPLELEAF_COMPACT_GBUFFER
+    static constexpr Layout layout = Layout::Compact;
+#else
+    static constexpr Layout layout = Layout::Full;
+#endif
+
+    // Instance or cluster counts of one frame, mirrors the statistics buffer of Culling.comp and ClusterCulling.comp.
+    struct CullingStatistics
+    {
+        uint32_t frustumCulled    = 0;
+        uint32_t occlusionCulled  = 0;
+        uint32_t firstPhaseDrawn  = 0;
+        uint32_t secondPhaseDrawn = 0;
+        uint32_t backfaceCulled   = 0;
+        uint32_t trianglesDrawn   = 0;
+    };
+
+    /**
+     * Creates the G-buffer subrender.
+     * @param stage The pipeline stage.
+     * @param cullingMode Cluster culling falls back to instance culling for scenes without meshlets.
+     */
+    explicit GBufferSubrender(const Pipeline::Stage& stage, CullingMode cullingMode = CullingMode::Instance);
     ~GBufferSubrender() override = default;
 
     void PreRender(const CommandBuffer& commandBuffer) override;
@@ -19,14 +67,73 @@ public:
 
     void RegisterImGui() override;
 
+    bool        IsOcclusionCulling() const { return occlusionCulling; }
+    void        SetOcclusionCulling(bool occlusionCulling) { this->occlusionCulling = occlusionCulling; }
+    bool        IsConeCulling() const { return coneCulling; }
+    void        SetConeCulling(bool coneCulling) { this->coneCulling = coneCulling; }
+    CullingMode GetCullingMode() const { return cullingMode; }
+
+    /**
+     * Gets the define every shader writing or reading the G-buffer selects its layout with.
+     */
+    static Shader::Define GetLayoutDefine() { return {"COMPACT_GBUFFER", std::to_string(static_cast<uint32_t>(layout == Layout::Compact))}; }
+
+    /**
+     * Sets the largest error in pixels a coarser level of detail may show on screen, 0 only allows levels that lose no detail.
+     * @param lodErrorThreshold The error threshold in pixels.
+     */
+    void  SetLodErrorThreshold(float lodErrorThreshold) { this->lodErrorThreshold = lodErrorThreshold; }
+    float GetLodErrorThreshold() const { return lodErrorThreshold; }
+
+    /**
+     * Gets the culling statistics of the last frame the GPU has finished, read back once its frame slot is recorded again.
+     * @return The culling statistics.
+     */
+    const CullingStatistics& GetCullingStatistics() const { return cullingStatistics; }
+
 private:
+    // A compute pass writing one indirect draw per instance or per cluster, with the visibility of each from last frame.
+    struct CullingPass
+    {
+        explicit CullingPass(const std::filesystem::path& shaderStage);
+
+        PipelineCompute                pipeline;
+        DescriptorsHandler             descriptorSet;
+        PushHandler                    pushHandler;
+        std::unique_ptr<StorageBuffer> visibility;
+    };
+
+    void CreateHierarchyZ(const ImageDepth& depth);
+    void DispatchCulling(const CommandBuffer& commandBuffer, const GPUScene& gpuScene, uint32_t phase);
+    void CmdRender(const CommandBuffer& commandBuffer, GPUScene& gpuScene) const;
+
     PipelineGraphics pipeline;
-    PipelineCompute  compute;
+    PipelineCompute  hizCompute;
 
-    DescriptorsHandler descriptorSetCompute;
     DescriptorsHandler descriptorSetGraphics;
 
-    PushHandler    pushHandler;
+    PushHandler    hizPushHandler;
     UniformHandler uniformCamera;
+
+    CullingMode                  cullingMode;
+    CullingPass                  instanceCulling;
+    std::unique_ptr<CullingPass> clusterCulling;
+    // The pass culling this frame, null until PreRender has recorded the first phase.
+    CullingPass*                 activeCulling = nullptr;
+
+    bool occlusionCulling = true;
+    bool coneCulling      = true;
+
+    float lodErrorThreshold = 1.0f;
+
+    // Rebuilt with the depth attachment, one descriptor set per pyramid level.
+    std::unique_ptr<ImageHierarchyZ> hierarchyZ;
+    std::vector<DescriptorsHandler>  hizDescriptorSets;
+    const ImageDepth*                hizDepth     = nullptr;
+    VkImageView                      hizDepthView = VK_NULL_HANDLE;
+
+    // One statistics block per frame slot, a slot is read back and cleared once its frame fence has been waited on.
+    std::unique_ptr<StorageBuffer> statisticsBuffer;
+    CullingStatistics              cullingStatistics;
 };
 }   // namespace MapleLeaf
@@ -1,29 +1,208 @@
 #include "ShadowSubrender.hpp"
+#include "GPUScene.hpp"
+#include "Graphics.hpp"
+#include "Imgui.hpp"
 #include "Scenes.hpp"
-#include "ShadowRender.hpp"
 
 namespace MapleLeaf {
 ShadowSubrender::ShadowSubrender(const Pipeline::Stage& stage)
     : Subrender(stage)
-    , pipeline(stage, {"Shader/Shadow/Shadow.vert", "Shader/Shadow/Shadow.frag"}, {Vertex3D::GetVertexInput()}, {}, PipelineGraphics::Mode::Polygon,
-               PipelineGraphics::Depth::ReadWrite, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE,
-               VK_FRONT_FACE_COUNTER_CLOCKWISE, false)
+    , pipeline(stage, {"Shader/Shadow/Shadow.vert", "Shader/Shadow/Shadow.frag"}, {GPUScene::GetVertexInput()},
+               {{"COMPACT_VERTICES", std::to_string(static_cast<uint32_t>(GPUInstance::vertexLayout == VertexLayout::Compact))}},
+               PipelineGraphics::Mode::Polygon, PipelineGraphics::Depth::ReadWrite, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_POLYGON_MODE_FILL,
+               VK_CULL_MODE_NONE, VK_FRONT_FACE_COUNTER_CLOCKWISE, false)
+    , cullingPipeline("Shader/GPUDriven/ShadowCulling.comp", {{"SHADOW_CASCADE_COUNT", std::to_string(ShadowSystem::CascadeCount)}})
+    , descriptorSet(pipeline)
+    , cullingDescriptorSet(cullingPipeline)
+    , pushHandler(pipeline.GetShader()->GetUniformBlock("pushObject").value())
+    , cullingPushHandler(cullingPipeline.GetShader()->GetUniformBlock("pushObject").value())
 {}
 
-void ShadowSubrender::PreRender(const CommandBuffer& commandBuffer) {}
+void ShadowSubrender::PreRender(const CommandBuffer& commandBuffer)
+{
+    redrawMask = 0;
+
+    auto       shadows     = Scenes::Get()->GetScene()->GetSystem<ShadowSystem>();
+    const auto gpuScene    = Scenes::Get()->GetScene()->GetDerivedScene<GPUScene>();
+    auto       renderStage = Graphics::Get()->GetRenderStage(GetStage().first);
+    if (!shadows || !gpuScene || !renderStage || !gpuScene->GetInstanceDatasHandler()) return;
+
+    instanceCount = gpuScene->GetInstanceCount();
+    if (instanceCount == 0) return;
+
+    if (!drawCommands || drawCommands->GetSize() != sizeof(VkDrawIndexedIndirectCommand) * instanceCount * ShadowSystem::CascadeCount)
+        drawCommands = std::make_unique<IndirectBuffer>(sizeof(VkDrawIndexedIndirectCommand) * instanceCount * ShadowSystem::CascadeCount);
+
+    auto frameSlotCount = Graphics::Get()->GetSwapchain()->GetImageCount();
+    auto frameSlot      = static_cast<uint32_t>(Graphics::Get()->GetSurface()->GetCurrentFrameIndex());
+    if (!drawCounts || drawCounts->GetSize() < sizeof(uint32_t) * ShadowSystem::CascadeCount * frameSlotCount) {
+        std::vector<uint32_t> counts(ShadowSystem::CascadeCount * frameSlotCount, 0);
+        drawCounts = std::make_unique<IndirectBuffer>(sizeof(uint32_t) * counts.size(), counts.data());
+        pendingStatistics.assign(frameSlotCount, {});
+    }
+    else {
+        // The fence of this frame slot has been waited on, the frame that last used it has finished.
+        void* data;
+        drawCounts->MapMemory(&data);
+        auto slot = static_cast<uint32_t*>(data) + frameSlot * ShadowSystem::CascadeCount;
+        for (uint32_t i = 0; i < ShadowSystem::CascadeCount; i++) pendingStatistics[frameSlot].castersDrawn[i] = slot[i];
+        std::fill(slot, slot + ShadowSystem::CascadeCount, 0);
+        drawCounts->UnmapMemory();
+
+        statistics = pendingStatistics[frameSlot];
+    }
+    pendingStatistics[frameSlot] = {};
+
+    // Cascades are kept only if the stage loaded them, after a rebuild or once instances were added, removed or changed models all are drawn.
+    auto mask     = (1u << ShadowSystem::CascadeCount) - 1;
+    auto keepable = renderStage->IsContentsLoaded() && instanceCount == renderedInstanceCount;
+    if (keepable && gpuScene->GetUpdateStatus() != GPUScene::UpdateStatus::AllChanged) mask = GetRedrawMask(*shadows, *gpuScene);
+    if (mask == 0) return;
+
+    std::array<glm::mat4, ShadowSystem::CascadeCount> lightProjectionViews;
+    glm::vec4                                         texelSizes(0.0f);
+    for (uint32_t i = 0; i < ShadowSystem::CascadeCount; i++) {
+        lightProjectionViews[i] = shadows->GetShadowCascades()[i].GetLightProjectionViewMatrix();
+        texelSizes[i]           = shadows->GetShadowCascades()[i].GetTexelSize();
+    }
+    uniformCascades.Push("lightProjectionViews", lightProjectionViews);
+    uniformCascades.Push("texelSizes", texelSizes);
 
-void ShadowSubrender::Render(const CommandBuffer& commandBuffer) {}
+    cullingPushHandler.Push("instanceCount", instanceCount);
+    cullingPushHandler.Push("cascadeMask", mask);
+    cullingPushHandler.Push("frameSlot", frameSlot);
+    cullingPushHandler.Push("lodErrorThreshold", lodErrorThreshold);
+
+    cullingDescriptorSet.Push("instanceDatas", gpuScene->GetInstanceDatasHandler());
+    cullingDescriptorSet.Push("drawCommandBuffer", drawCommands);
+    cullingDescriptorSet.Push("drawCounts", drawCounts);
+    cullingDescriptorSet.Push("lodDatas", gpuScene->GetLodDatasHandler());
+    cullingDescriptorSet.Push("uniformCascades", uniformCascades);
+    cullingDescriptorSet.Push("pushObject", cullingPushHandler);
+
+    if (!cullingDescriptorSet.Update(cullingPipeline)) return;
+
+    // The draws of the previous frame have read the commands before they are rewritten.
+    Buffer::InsertBufferMemoryBarrier(commandBuffer,
+                                      drawCommands->GetBuffer(),
+                                      VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                                      VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    cullingPipeline.BindPipeline(commandBuffer);
+    cullingDescriptorSet.BindDescriptor(commandBuffer, cullingPipeline);
+    cullingPushHandler.BindPush(commandBuffer, cullingPipeline);
+    cullingPipeline.CmdRender(commandBuffer, glm::uvec2(instanceCount, ShadowSystem::CascadeCount));
+
+    drawCommands->IndirectBufferPipelineBarrier(commandBuffer);
+    drawCounts->IndirectBufferPipelineBarrier(commandBuffer);
+
+    auto& pending = pendingStatistics[frameSlot];
+    for (uint32_t i = 0; i < ShadowSystem::CascadeCount; i++) {
+        if (!(mask & (1u << i))) continue;
+
+        renderedVersions[i]  = shadows->GetShadowCascades()[i].GetVersion();
+        pending.drawCalls[i] = 1;
+        pending.cascadesRendered++;
+    }
+    renderedInstanceCount = instanceCount;
+    redrawMask            = mask;
+}
 
-void ShadowSubrender::PostRender(const CommandBuffer& commandBuffer)
+void ShadowSubrender::Render(const CommandBuffer& commandBuffer)
 {
-    auto camera = Scenes::Get()->GetScene()->GetCamera();
+    if (redrawMask == 0) return;
+
+    auto       shadows  = Scenes::Get()->GetScene()->GetSystem<ShadowSystem>();
+    const auto gpuScene = Scenes::Get()->GetScene()->GetDerivedScene<GPUScene>();
+
+    descriptorSet.Push("instanceDatas", gpuScene->GetInstanceDatasHandler());
+    descriptorSet.Push("pushObject", pushHandler);
+    if (!descriptorSet.Update(pipeline)) return;
+
     pipeline.BindPipeline(commandBuffer);
+    descriptorSet.BindDescriptor(commandBuffer, pipeline);
+
+    auto frameSlot = static_cast<uint32_t>(Graphics::Get()->GetSurface()->GetCurrentFrameIndex());
+    for (uint32_t i = 0; i < ShadowSystem::CascadeCount; i++) {
+        if (!(redrawMask & (1u << i))) continue;
+
+        // Each cascade has its own square of the attachment, the viewport height is negative like the one of the render stage.
+        VkRect2D tile = {};
+        tile.offset   = {static_cast<int32_t>(i * SHADOW_MAP_SIZE), 0};
+        tile.extent   = {SHADOW_MAP_SIZE, SHADOW_MAP_SIZE};
+
+        VkViewport viewport = {};
+        viewport.x          = static_cast<float>(tile.offset.x);
+        viewport.y          = static_cast<float>(SHADOW_MAP_SIZE);
+        viewport.width      = static_cast<float>(SHADOW_MAP_SIZE);
+        viewport.height     = -static_cast<float>(SHADOW_MAP_SIZE);
+        viewport.minDepth   = 0.0f;
+        viewport.maxDepth   = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &tile);
+
+        VkClearAttachment clearAttachment       = {};
+        clearAttachment.aspectMask              = VK_IMAGE_ASPECT_DEPTH_BIT;
+        clearAttachment.clearValue.depthStencil = {1.0f, 0};
+
+        VkClearRect clearRect    = {};
+        clearRect.rect           = tile;
+        clearRect.baseArrayLayer = 0;
+        clearRect.layerCount     = 1;
+        vkCmdClearAttachments(commandBuffer, 1, &clearAttachment, 1, &clearRect);
 
-    auto sceneShadowRenders = Scenes::Get()->GetScene()->GetComponents<ShadowRender>();
+        pushHandler.Push("lightProjectionView", shadows->GetShadowCascades()[i].GetLightProjectionViewMatrix());
+        pushHandler.BindPush(commandBuffer, pipeline);
 
-    for (const auto& shadowRender : sceneShadowRenders) shadowRender->CmdRender(commandBuffer, pipeline);
+        // The draw list of the cascade and its count, written by the culling pass in PreRender.
+        gpuScene->CmdRenderIndirectCount(commandBuffer,
+                                         *drawCommands,
+                                         sizeof(VkDrawIndexedIndirectCommand) * instanceCount * i,
+                                         *drawCounts,
+                                         sizeof(uint32_t) * (frameSlot * ShadowSystem::CascadeCount + i),
+                                         instanceCount);
+    }
 }
 
-void ShadowSubrender::RegisterImGui() {}
+void ShadowSubrender::PostRender(const CommandBuffer& commandBuffer) {}
 
+void ShadowSubrender::RegisterImGui()
+{
+    if (auto* imgui = Imgui::Get()) {
+        imgui->RegisterCustomWindow(typeid(*this).name(), [this]() {
+            ImGui::Text("Cascades rendered :%u / %u", statistics.cascadesRendered, ShadowSystem::CascadeCount);
+            for (uint32_t i = 0; i < ShadowSystem::CascadeCount; i++)
+                ImGui::Text("Cascade %u draw calls :%u casters :%u", i, statistics.drawCalls[i], statistics.castersDrawn[i]);
+        });
+    }
+}
+
+uint32_t ShadowSubrender::GetRedrawMask(const ShadowSystem& shadows, GPUScene& gpuScene) const
+{
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < ShadowSystem::CascadeCount; i++) {
+        if (renderedVersions[i] != shadows.GetShadowCascades()[i].GetVersion()) mask |= 1u << i;
+    }
+
+    // A moved caster is erased from the cascades it overlapped last frame and drawn into the ones it overlaps now, so is one that stopped casting.
+    const auto allMask = (1u << ShadowSystem::CascadeCount) - 1;
+    for (const auto& instance : gpuScene.GetInstances()) {
+        if (mask == allMask) break;
+        if (instance.GetInstanceStatus() == GPUInstance::Status::None) continue;
+
+        auto instanceData = instance.GetInstanceData();
+        if (!instanceData.castShadow && !instance.IsCastShadowChanged()) continue;
+
+        auto bounds = ShadowCascade::TransformBounds(instanceData.modelMatrix, instanceData.AABBLocalMin, instanceData.AABBLocalMax);
+        auto previousBounds =
+            ShadowCascade::TransformBounds(instanceData.prevModelMatrix, instanceData.AABBLocalMin, instanceData.AABBLocalMax);
+        for (uint32_t i = 0; i < ShadowSystem::CascadeCount; i++) {
+            const auto& cascade = shadows.GetShadowCascades()[i];
+            if (cascade.Intersects(bounds.first, bounds.second) || cascade.Intersects(previousBounds.first, previousBounds.second)) mask |= 1u << i;
+        }
+    }
+    return mask;
+}
 }   // namespace MapleLeaf
@@ -1,14 +1,37 @@
 #pragma once
 
 #include "DescriptorHandler.hpp"
+#include "IndirectBuffer.hpp"
+#include "PipelineCompute.hpp"
 #include "PipelineGraphics.hpp"
+#include "PushHandler.hpp"
+#include "ShadowSystem.hpp"
 #include "Subrender.hpp"
 #include "UniformHandler.hpp"
 
 namespace MapleLeaf {
+class GPUScene;
+
+/**
+ * Renders the cascades of the ShadowSystem side by side into one depth attachment, SHADOW_MAP_SIZE texels wide each.
+ * The casters are the GPU scene instances flagged by ShadowRender, a compute pass culls them against every cascade and compacts the overlapping ones
+ * into one indirect draw list per cascade, so a cascade is a single draw call whatever the number of casters.
+ * The render stage keeps its contents, a cascade is only cleared and drawn again when its projection changed or a caster in it moved.
+ */
 class ShadowSubrender : public Subrender
 {
 public:
+    // Counts of one frame, the caster counts are the draw counts GPUDriven/ShadowCulling.comp wrote.
+    struct Statistics
+    {
+        // Cascades drawn again, the others were kept.
+        uint32_t cascadesRendered = 0;
+        // Draw calls recorded for every cascade, one for a drawn cascade and none for a kept one.
+        std::array<uint32_t, ShadowSystem::CascadeCount> drawCalls = {};
+        // Casters drawn into every cascade, a caster is drawn into every cascade it overlaps.
+        std::array<uint32_t, ShadowSystem::CascadeCount> castersDrawn = {};
+    };
+
     explicit ShadowSubrender(const Pipeline::Stage& stage);
 
     void PreRender(const CommandBuffer& commandBuffer) override;
@@ -17,9 +40,52 @@ public:
 
     void RegisterImGui() override;
 
+    /**
+     * Sets the largest error in shadow map texels a coarser level of detail may show in a cascade, 0 only allows levels that lose no detail.
+     * @param lodErrorThreshold The error threshold in texels.
+     */
+    void  SetLodErrorThreshold(float lodErrorThreshold) { this->lodErrorThreshold = lodErrorThreshold; }
+    float GetLodErrorThreshold() const { return lodErrorThreshold; }
+
+    /**
+     * Gets the statistics of the last frame the GPU has finished, read back once its frame slot is recorded again.
+     * @return The statistics.
+     */
+    const Statistics& GetStatistics() const { return statistics; }
+
 private:
+    /**
+     * Finds the cascades whose projection changed or that a moved caster overlaps now or overlapped last frame.
+     * @param shadows The shadow system of the scene.
+     * @param gpuScene The GPU scene the casters are taken from.
+     * @return Bit i is set if cascade i has to be drawn again.
+     */
+    uint32_t GetRedrawMask(const ShadowSystem& shadows, GPUScene& gpuScene) const;
+
     PipelineGraphics   pipeline;
+    PipelineCompute    cullingPipeline;
     DescriptorsHandler descriptorSet;
-    UniformHandler     uniformObject;
+    DescriptorsHandler cullingDescriptorSet;
+    PushHandler        pushHandler;
+    PushHandler        cullingPushHandler;
+    UniformHandler     uniformCascades;
+
+    // One range of instance count commands per cascade, and the draw count of every cascade per frame slot.
+    std::unique_ptr<IndirectBuffer> drawCommands;
+    std::unique_ptr<IndirectBuffer> drawCounts;
+
+    float lodErrorThreshold = 1.0f;
+
+    // Cascades the culling pass wrote draw lists for this frame, 0 until PreRender has recorded it.
+    uint32_t redrawMask    = 0;
+    uint32_t instanceCount = 0;
+
+    // Cascade versions the kept contents were rendered at, 0 for cascades that were never rendered.
+    std::array<uint64_t, ShadowSystem::CascadeCount> renderedVersions = {};
+    uint32_t                                         renderedInstanceCount = 0;
+
+    // The statistics recorded into every frame slot, completed with the draw counts once the slot is read back.
+    std::vector<Statistics> pendingStatistics;
+    Statistics              statistics;
 };
 }   // namespace MapleLeaf
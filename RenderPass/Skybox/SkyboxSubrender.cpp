@@ -1,5 +1,6 @@
 #include "SkyboxSubrender.hpp"
 
+#include "GBufferSubrender.hpp"
 #include "Scenes.hpp"
 #include "SkyboxSystem.hpp"
 
@@ -8,9 +9,9 @@ static const Color SKYBOX_COLOUR_DAY(0x003C8A);
 
 SkyboxSubrender::SkyboxSubrender(const Pipeline::Stage& pipelineStage)
     : Subrender(pipelineStage)
-    , pipelineGraphics(pipelineStage, {"Shader/Skybox/Skybox.vert", "Shader/Skybox/Skybox.frag"}, {}, {}, PipelineGraphics::Mode::MRT,
-                       PipelineGraphics::Depth::None, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE,
-                       VK_FRONT_FACE_COUNTER_CLOCKWISE, false)
+    , pipelineGraphics(pipelineStage, {"Shader/Skybox/Skybox.vert", "Shader/Skybox/Skybox.frag"}, {}, {GBufferSubrender::GetLayoutDefine()},
+                       PipelineGraphics::Mode::MRT, PipelineGraphics::Depth::None, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VK_POLYGON_MODE_FILL,
+                       VK_CULL_MODE_NONE, VK_FRONT_FACE_COUNTER_CLOCKWISE, false)
     , descriptorSet(pipelineGraphics)
 {
     uniformSkybox = UniformHandler(pipelineGraphics.GetShader()->GetUniformBlock("uniformSkybox").value(), false);
@@ -5,6 +5,7 @@
 #include "ImguiSubrender.hpp"
 #include "RenderStage.hpp"
 #include "ResolvedSubrender.hpp"
+#include "ShadowSubrender.hpp"
 #include "SkyboxSubrender.hpp"
 #include "ToneMappingSubrender.hpp"
 
@@ -14,13 +15,24 @@
 namespace MapleLeafApp {
 DeferredRenderer::DeferredRenderer()
 {
-    // Render Pass for shadow map
-    std::vector<Attachment>  ShadowAttachments = {{0, "ShadowMap", Attachment::Type::Depth, false}};
+    // Render Pass for shadow map, the cascades side by side. Cascades that did not change are kept from the frames before.
+    std::vector<Attachment>  ShadowAttachments = {{0, "shadows", Attachment::Type::Depth, false}};
     std::vector<SubpassType> ShadowSubpasses   = {{0, {}, {0}}};
-    AddRenderStage(
-        std::make_unique<RenderStage>(RenderStage::Type::MONO, ShadowAttachments, ShadowSubpasses, Viewport({SHADOW_MAP_SIZE, SHADOW_MAP_SIZE})));
+    auto                     shadowStage       = std::make_unique<RenderStage>(
+        RenderStage::Type::MONO, ShadowAttachments, ShadowSubpasses, Viewport({SHADOW_MAP_SIZE * ShadowSystem::CascadeCount, SHADOW_MAP_SIZE}));
+    shadowStage->SetKeepContents(true);
+    AddRenderStage(std::move(shadowStage));
 
-    // Render Pass for G-Buffer
+    // Render Pass for G-Buffer, 18 bytes per pixel besides depth in the compact layout against 76 in the full one.
+#ifdef MAPLELEAF_COMPACT_GBUFFER
+    std::vector<Attachment>  GBufferAttachments = {{0, "depth", Attachment::Type::Depth, false},
+                                                   {1, "diffuse", Attachment::Type::Image, false, VK_FORMAT_R8G8B8A8_SRGB},
+                                                   {2, "normal", Attachment::Type::Image, false, VK_FORMAT_R16G16_SNORM},
+                                                   {3, "material", Attachment::Type::Image, false, VK_FORMAT_R8G8_UNORM},
+                                                   {4, "motionVector", Attachment::Type::Image, false, VK_FORMAT_R16G16_SFLOAT},
+                                                   {5, "instanceId", Attachment::Type::Image, false, VK_FORMAT_R32_UINT, VK_FILTER_NEAREST}};
+    std::vector<SubpassType> GBufferSubpasses   = {{0, {}, {1, 2, 3}}, {1, {}, {0, 1, 2, 3, 4, 5}}};
+#else
     std::vector<Attachment>  GBufferAttachments = {{0, "depth", Attachment::Type::Depth, false},
                                                    {1, "position", Attachment::Type::Image, false, VK_FORMAT_R32G32B32A32_SFLOAT},
                                                    {2, "diffuse", Attachment::Type::Image, false, VK_FORMAT_R32G32B32A32_SFLOAT},
@@ -29,6 +41,7 @@ DeferredRenderer::DeferredRenderer()
                                                    {5, "motionVector", Attachment::Type::Image, false, VK_FORMAT_R32G32_SFLOAT},
                                                    {6, "instanceId", Attachment::Type::Image, false, VK_FORMAT_R32_SFLOAT, VK_FILTER_NEAREST}};
     std::vector<SubpassType> GBufferSubpasses   = {{0, {}, {1, 2, 3, 4}}, {1, {}, {0, 1, 2, 3, 4, 5, 6}}};
+#endif
     AddRenderStage(std::make_unique<RenderStage>(RenderStage::Type::MONO, GBufferAttachments, GBufferSubpasses));
 
     // Render Pass for Lighting
@@ -49,9 +62,9 @@ DeferredRenderer::DeferredRenderer()
 
 void DeferredRenderer::Start()
 {
-    // AddSubrender<ShadowSubrender>({0, 0});
+    AddSubrender<ShadowSubrender>({0, 0});
     AddSubrender<SkyboxSubrender>({1, 0});
-    AddSubrender<GBufferSubrender>({1, 1});
+    AddSubrender<GBufferSubrender>({1, 1}, GBufferSubrender::CullingMode::Cluster);
     AddSubrender<DeferredSubrender>({2, 0});
     AddSubrender<ResolvedSubrender>({3, 0});
     AddSubrender<ToneMappingSubrender>({4, 0});
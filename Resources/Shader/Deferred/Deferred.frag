@@ -6,7 +6,12 @@
 #include <Misc/Camera.glsl>
 
 layout(set=0, binding = 1) uniform UniformScene {
-	mat4 shadowMatrix;
+	mat4 shadowMatrices[SHADOW_CASCADE_COUNT];
+	vec4 shadowSplitDepths;
+	float shadowBias;
+	int shadowPcf;
+	int shadowsEnabled;
+	int shadowLightSlot;
 
 	int pointLightsCount;
 	int directionalLightsCount;
@@ -44,11 +49,15 @@ layout(set=0, binding = 3) buffer BufferDirectionalLights {
 	DirectionalLight lights[];
 } bufferDirectionalLights;
 
+#if COMPACT_GBUFFER
+layout(set=0, binding = 4) uniform sampler2D inDepth;
+#else
 layout(set=0, binding = 4) uniform sampler2D inPosition;
+#endif
 layout(set=0, binding = 5) uniform sampler2D inDiffuse;
 layout(set=0, binding = 6) uniform sampler2D inNormal;
 layout(set=0, binding = 7) uniform sampler2D inMaterial;
-//layout(set=0, binding = 8) uniform sampler2D inShadowMap;
+layout(set=0, binding = 8) uniform sampler2D inShadowMap;
 // layout(set=0, binding = 9) uniform sampler2D inAOMap;
 
 layout(set=0, binding = 10) uniform sampler2D samplerBRDF;
@@ -62,6 +71,12 @@ layout(set=0, binding = 13) buffer BufferAreaLights {
 layout(set=0, binding = 14) uniform sampler2D LTC1; // for inverse M
 layout(set=0, binding = 15) uniform sampler2D LTC2; // GGX norm, fresnel, 0(unused), sphere
 
+#if COMPACT_GBUFFER
+layout(set=0, binding = 16) uniform usampler2D inInstanceID;
+
+#include <Misc/GBufferPacking.glsl>
+#endif
+
 layout(location = 0) in vec2 inUV;
 
 layout(location = 0) out vec4 outColour;
@@ -71,16 +86,28 @@ layout(location = 0) out vec4 outColour;
 #include <Materials/Fresnel.glsl>
 #include <Materials/BRDF.glsl>
 #include <Lighting/LTC.glsl>
+#include <Lighting/CascadedShadow.glsl>
 
 void main() {
 	vec2 uv = vec2(inUV.x, 1.0f - inUV.y);
 
+#if COMPACT_GBUFFER
+	// Depth and IDs are fetched unfiltered. The sky leaves the depth cleared, its normal is zero like in the full layout.
+	ivec2 pixel = ivec2(uv * textureSize(inDepth, 0));
+	float depth = texelFetch(inDepth, pixel, 0).r;
+	vec3 worldPosition = ReconstructWorldPosition(uv, depth);
+	uint instanceID = texelFetch(inInstanceID, pixel, 0).r;
+
+	vec3 baseColor = texture(inDiffuse, uv).rgb;
+	vec3 normal = depth < 1.0f ? UnpackNormal(texture(inNormal, uv).rg) : vec3(0.0f);
+	vec3 material = vec3(texture(inMaterial, uv).rg, float(UnpackIsAreaLight(instanceID)));
+#else
 	vec3 worldPosition = texture(inPosition, uv).rgb;
-	vec4 shadowCoords = uniformScene.shadowMatrix * vec4(worldPosition, 1.0f);
 
 	vec3 baseColor = texture(inDiffuse, uv).rgb;
 	vec3 normal = texture(inNormal, uv).rgb;
 	vec3 material = texture(inMaterial, uv).rgb;
+#endif
 	// vec3 ao = texture(inAOMap, uv).rgb;
 
 	float metallic = material.r;
@@ -107,6 +134,8 @@ void main() {
 		for(int i = 1; i <= uniformScene.pointLightsCount; i++)
 		{
 			PointLight light = bufferPointLights.lights[i];
+			// Freed slots of the LightSystem hold black lights.
+			if (light.color.rgb == vec3(0.0f)) continue;
 			vec3 L = light.position - worldPosition;
 			float d = length(L);
 			L = normalize(L);
@@ -119,9 +148,19 @@ void main() {
 			Lo += brdf * radiance * NoL;
 		}
 
+		// The ShadowSystem casts the shadows of the directional light the LightSystem picked.
+		float shadow = 1.0f;
+		if (uniformScene.shadowsEnabled == 1 && uniformScene.shadowLightSlot > 0)
+		{
+			float viewDepth = -(camera.view * vec4(worldPosition, 1.0f)).z;
+			shadow = CascadedShadow(worldPosition, viewDepth, uniformScene.shadowMatrices, uniformScene.shadowSplitDepths, uniformScene.shadowBias,
+									uniformScene.shadowPcf, inShadowMap);
+		}
+
 		for(int i = 1; i <= uniformScene.directionalLightsCount; i++)
 		{
 			DirectionalLight light = bufferDirectionalLights.lights[i];
+			if (light.color.rgb == vec3(0.0f)) continue;
 			vec3 L = normalize(-light.direction);
 
 			float NoL = clamp(dot(N, L), 0.0f, 1.0f);
@@ -129,10 +168,7 @@ void main() {
 
 			vec3 brdf = DiffuseReflectionDisneyEvalWeight(diffuseColor, roughness, N, L, V) + SpecularReflectionMicrofacetEvalWeight(specularColor, roughness, N, L, V);
 
-			//float shadowValue = shadowFactor(shadowCoords, inShadowMap);
-
-			//Lo += brdf * radiance * shadowValue;
-			Lo += brdf * radiance * NoL;
+			Lo += brdf * radiance * NoL * (i == uniformScene.shadowLightSlot ? shadow : 1.0f);
 		}
 
 		//AreaLight: use roughness and sqrt(1-cos_theta) to sample M_texture
@@ -145,6 +181,7 @@ void main() {
 		for (int i = 1; i <= uniformScene.areaLightsCount && isAreaLight == 0.0f; i++)
 		{
 			AreaLight areaLight = bufferAreaLights.lights[i];
+			if (areaLight.color.rgb == vec3(0.0f)) continue;
 			vec3 points[4] = {
 				areaLight.points[0].xyz,
 				areaLight.points[1].xyz,
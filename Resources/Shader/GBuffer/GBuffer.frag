@@ -24,7 +24,9 @@ layout(set = 0, binding = 2) buffer MaterialDatas
 
 layout(set = 1, binding = 0) uniform sampler2D ImageSamplers[];
 
+#if !COMPACT_GBUFFER
 layout(location = 0) in vec3 inPosition;
+#endif
 layout(location = 1) in vec2 inUV;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec3 inTangent;
@@ -34,12 +36,23 @@ layout(location = 6) in flat uint inIsAreaLight;
 layout(location = 7) in vec4 hPos;
 layout(location = 8) in vec4 prevHPos;
 
+#if COMPACT_GBUFFER
+#include <Misc/GBufferPacking.glsl>
+
+// The position is reconstructed from depth, the attributes are packed by Misc/GBufferPacking.glsl.
+layout(location = 0) out vec4 outDiffuse;
+layout(location = 1) out vec4 outNormal;
+layout(location = 2) out vec4 outMaterial;
+layout(location = 3) out vec4 outMotionVetcor;
+layout(location = 4) out uint outInstanceID;
+#else
 layout(location = 0) out vec4 outPosition;
 layout(location = 1) out vec4 outDiffuse;
 layout(location = 2) out vec4 outNormal;
 layout(location = 3) out vec4 outMaterial;
 layout(location = 4) out vec4 outMotionVetcor;
 layout(location = 5) out float outInstanceID;
+#endif
 
 void main() 
 {	
@@ -84,10 +97,19 @@ void main()
 	mv.y = -mv.y;
 	outMotionVetcor = vec4(mv, 0.0f, 1.0f);
 
+#if COMPACT_GBUFFER
+	// The alpha of every attachment but the albedo is one, the attachments are blended.
+	outDiffuse = diffuse;
+	outNormal = vec4(PackNormal(normal), 0.0f, 1.0f);
+	outMaterial = vec4(material.xy, 0.0f, 1.0f);
+
+	outInstanceID = PackInstanceID(inInstanceID, inIsAreaLight != 0u);
+#else
 	outPosition = vec4(inPosition, 1.0f);
 	outDiffuse = diffuse;
 	outNormal = vec4(normalize(normal), 1.0f);
 	outMaterial = vec4(material, 1.0f);
 
 	outInstanceID = float(inInstanceID);
+#endif
 }
\ No newline at end of file
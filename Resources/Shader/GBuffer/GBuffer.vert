@@ -12,12 +12,24 @@ layout(set = 0, binding = 1) readonly buffer InstanceDatas
     GPUInstanceData instanceData[];
 } instanceDatas;
 
+#if COMPACT_VERTICES
+#include <Misc/VertexCompact.glsl>
+
+// Position as a fraction of the model bounds, octahedral normal and tangent.
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec2 inUV;
+layout(location = 2) in vec2 inNormal;
+layout(location = 3) in vec2 inTangent;
+#else
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec2 inUV;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec3 inTangent;
+#endif
 
+#if !COMPACT_GBUFFER
 layout(location = 0) out vec3 outPosition;
+#endif
 layout(location = 1) out vec2 outUV;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec3 outTangent;
@@ -33,9 +45,15 @@ void main()
     GPUInstanceData instanceData = instanceDatas.instanceData[nonuniformEXT(instanceIndex)];
     uint materialId = instanceData.materialID;
 
+#if COMPACT_VERTICES
+    vec4 position = vec4(mix(instanceData.AABBLocalMin, instanceData.AABBLocalMax, inPosition.xyz), 1.0f);
+    vec4 normal = vec4(DecodeOctahedral(inNormal), 0.0f);
+    vec4 tangent = vec4(DecodeOctahedral(inTangent), 0.0f);
+#else
     vec4 position = vec4(inPosition, 1.0f);
     vec4 normal = vec4(inNormal, 0.0f);
     vec4 tangent = vec4(inTangent, 0.0f);
+#endif
 
     vec4 worldPosition = instanceData.modelMatrix * position;
     mat3 normalMatrix = transpose(inverse(mat3(instanceData.modelMatrix)));
@@ -47,7 +65,9 @@ void main()
     gl_Position = projection * view * worldPosition;
     // gl_Position.z = gl_Position.z * 0.5 + 0.5;
 
+#if !COMPACT_GBUFFER
     outPosition = worldPosition.xyz;
+#endif
     outUV = inUV;
 	outNormal = normalMatrix * normalize(normal.xyz);
     outTangent = normalMatrix * normalize(tangent.xyz);
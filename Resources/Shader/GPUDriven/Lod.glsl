@@ -0,0 +1,22 @@
+#ifndef GPUDRIVEN_LOD_GLSL
+#define GPUDRIVEN_LOD_GLSL
+
+// The largest model space error an instance may show so it stays below errorThreshold pixels on screen, needs Misc/Camera.glsl.
+// The distance is taken to the bounding sphere of the world space bounds, so no part of the instance is nearer than assumed.
+float GetLodErrorBound(mat4 M, vec3 boundMin, vec3 boundMax, float errorThreshold)
+{
+    vec3  columnScale = vec3(length(M[0].xyz), length(M[1].xyz), length(M[2].xyz));
+    float maxScale    = max(max(columnScale.x, columnScale.y), columnScale.z);
+
+    vec3  center   = (M * vec4(0.5f * (boundMin + boundMax), 1.0f)).xyz;
+    float radius   = 0.5f * length(boundMax - boundMin) * maxScale;
+    float distance = length(center - camera.cameraPosition.xyz) - radius;
+    if (distance <= 0.0f || maxScale <= 0.0f)
+        return 0.0f;
+
+    // Pixels one world space unit covers at that distance.
+    float pixelsPerUnit = abs(camera.projection[1][1]) * 0.5f * camera.pixelSize.y / distance;
+    return errorThreshold / (pixelsPerUnit * maxScale);
+}
+
+#endif
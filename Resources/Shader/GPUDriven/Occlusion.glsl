@@ -0,0 +1,47 @@
+#ifndef GPUDRIVEN_OCCLUSION_GLSL
+#define GPUDRIVEN_OCCLUSION_GLSL
+
+// Tests a box against the farthest depth pyramid built by HiZ.comp, needs Misc/Camera.glsl.
+bool IsOccluded(sampler2D hizDepth, uvec2 hizSize, uint hizMipLevels, mat4 M, vec3 boundMin, vec3 boundMax)
+{
+    mat4 viewProjection = camera.projection * camera.view;
+
+    vec2  uvMin   = vec2(1.0f);
+    vec2  uvMax   = vec2(0.0f);
+    float closest = 1.0f;
+
+    for (int i = 0; i < 8; i++) {
+        vec3 corner = mix(boundMin, boundMax, vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+        vec4 clip   = viewProjection * M * vec4(corner, 1.0f);
+
+        // A corner behind the camera has no meaningful screen position, such bounds are never occluded.
+        if (clip.w <= 0.0f)
+            return false;
+
+        vec3 ndc = clip.xyz / clip.w;
+        // The viewport is flipped, the top row of the attachments is at NDC y = 1.
+        vec2 uv  = vec2(0.5f + 0.5f * ndc.x, 0.5f - 0.5f * ndc.y);
+
+        uvMin   = min(uvMin, uv);
+        uvMax   = max(uvMax, uv);
+        closest = min(closest, ndc.z);
+    }
+
+    uvMin = clamp(uvMin, 0.0f, 1.0f);
+    uvMax = clamp(uvMax, 0.0f, 1.0f);
+
+    // The level where the projected bounds span at most 2x2 texels, its 4 corner texels cover them.
+    vec2 extent = (uvMax - uvMin) * vec2(hizSize);
+    int  level  = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0f)))), 0, int(hizMipLevels) - 1);
+
+    ivec2 levelSize = max(ivec2(hizSize) >> level, ivec2(1));
+    ivec2 texelMin  = clamp(ivec2(uvMin * vec2(levelSize)), ivec2(0), levelSize - 1);
+    ivec2 texelMax  = clamp(ivec2(uvMax * vec2(levelSize)), ivec2(0), levelSize - 1);
+
+    float farthest = max(max(texelFetch(hizDepth, texelMin, level).r, texelFetch(hizDepth, ivec2(texelMax.x, texelMin.y), level).r),
+                         max(texelFetch(hizDepth, ivec2(texelMin.x, texelMax.y), level).r, texelFetch(hizDepth, texelMax, level).r));
+
+    return closest > farthest;
+}
+
+#endif
\ No newline at end of file
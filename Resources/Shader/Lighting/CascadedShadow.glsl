@@ -0,0 +1,57 @@
+#ifndef CASCADED_SHADOW_GLSL
+#define CASCADED_SHADOW_GLSL
+
+// The shadow map holds SHADOW_CASCADE_COUNT square cascades side by side, cascade i covers the view depths up to splitDepths[i].
+
+int SelectCascade(float viewDepth, vec4 splitDepths)
+{
+	int cascade = 0;
+	for (int i = 0; i < SHADOW_CASCADE_COUNT - 1; i++)
+	{
+		if (viewDepth > splitDepths[i]) cascade = i + 1;
+	}
+	return cascade;
+}
+
+// Percentage closer filtering over (2 * pcf + 1)^2 texels, 1 is lit. The shadow vertex shader maps depths to [0, 1] like this lookup.
+float SampleCascade(vec4 shadowCoords, int cascade, float bias, int pcf, sampler2D shadowMap)
+{
+	vec3 ndc = shadowCoords.xyz / shadowCoords.w;
+	vec2 uv = vec2(ndc.x * 0.5f + 0.5f, 0.5f - ndc.y * 0.5f);
+	float depth = ndc.z * 0.5f + 0.5f;
+
+	if (any(lessThan(uv, vec2(0.0f))) || any(greaterThan(uv, vec2(1.0f))) || depth > 1.0f)
+	{
+		return 1.0f;
+	}
+
+	// Filter taps are clamped to the square of the cascade, they would read the neighbouring cascade otherwise.
+	vec2 texelSize = 1.0f / vec2(textureSize(shadowMap, 0));
+	float tileMin = float(cascade) / SHADOW_CASCADE_COUNT + texelSize.x * 0.5f;
+	float tileMax = float(cascade + 1) / SHADOW_CASCADE_COUNT - texelSize.x * 0.5f;
+	uv.x = (uv.x + float(cascade)) / SHADOW_CASCADE_COUNT;
+
+	float lit = 0.0f;
+	for (int x = -pcf; x <= pcf; x++)
+	{
+		for (int y = -pcf; y <= pcf; y++)
+		{
+			vec2 tap = uv + vec2(x, y) * texelSize;
+			tap.x = clamp(tap.x, tileMin, tileMax);
+			lit += depth - bias > texture(shadowMap, tap).r ? 0.0f : 1.0f;
+		}
+	}
+	return lit / float((2 * pcf + 1) * (2 * pcf + 1));
+}
+
+float CascadedShadow(vec3 worldPosition, float viewDepth, mat4 shadowMatrices[SHADOW_CASCADE_COUNT], vec4 splitDepths, float bias, int pcf,
+					 sampler2D shadowMap)
+{
+	// Beyond the shadow distance everything is lit.
+	if (viewDepth > splitDepths[SHADOW_CASCADE_COUNT - 1]) return 1.0f;
+
+	int cascade = SelectCascade(viewDepth, splitDepths);
+	return SampleCascade(shadowMatrices[cascade] * vec4(worldPosition, 1.0f), cascade, bias, pcf, shadowMap);
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef MISC_GBUFFER_PACKING_GLSL
+#define MISC_GBUFFER_PACKING_GLSL
+
+#include <Misc/Camera.glsl>
+#include <Misc/VertexCompact.glsl>
+
+// Packing of the compact G-buffer: depth, albedo in RGBA8 sRGB, octahedral normal in RG16 snorm, metallic and roughness in RG8,
+// motion in RG16F and the instance ID in R32UI, with the top bit of the instance ID flagging area light emitters.
+
+const uint GBUFFER_AREA_LIGHT_BIT = 0x80000000u;
+
+// Same mapping as VertexCompact::EncodeOctahedral, the result fits the snorm attachment as it is.
+vec2 EncodeOctahedral(vec3 direction)
+{
+    vec2 projected = direction.xy / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+    if (direction.z >= 0.0f) return projected;
+    return (1.0f - abs(projected.yx)) * mix(vec2(-1.0f), vec2(1.0f), greaterThanEqual(projected, vec2(0.0f)));
+}
+
+vec2 PackNormal(vec3 normal)
+{
+    return EncodeOctahedral(normalize(normal));
+}
+
+vec3 UnpackNormal(vec2 packedNormal)
+{
+    return DecodeOctahedral(packedNormal);
+}
+
+uint PackInstanceID(uint instanceID, bool isAreaLight)
+{
+    return instanceID | (isAreaLight ? GBUFFER_AREA_LIGHT_BIT : 0u);
+}
+
+uint UnpackInstanceID(uint packedInstanceID)
+{
+    return packedInstanceID & ~GBUFFER_AREA_LIGHT_BIT;
+}
+
+bool UnpackIsAreaLight(uint packedInstanceID)
+{
+    return (packedInstanceID & GBUFFER_AREA_LIGHT_BIT) != 0u;
+}
+
+// Inverts the projection of GBuffer.vert, uv is the texture coordinate of the attachments, which the negative viewport height flips.
+vec3 ReconstructWorldPosition(vec2 uv, float depth)
+{
+    vec4 position = camera.invView * camera.invProjection * vec4(uv.x * 2.0f - 1.0f, 1.0f - uv.y * 2.0f, depth, 1.0f);
+    return position.xyz / position.w;
+}
+
+#endif
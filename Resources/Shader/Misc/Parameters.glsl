@@ -64,6 +64,34 @@ struct GPUInstanceData
     uint isAreaLight;
     uint isThin;
     uint isUpdated;
-    uint padding1;
+    uint meshletOffset;
+    uint meshletCount;
+    uint lodOffset;
+    uint lodCount;
+    uint castShadow;
+};
+
+// One level of detail of a model, level 0 is the model itself. The error is in model space.
+struct LodData
+{
+    uint  indexOffset;
+    uint  indexCount;
+    uint  meshletOffset;
+    uint  meshletCount;
+    float error;
+    uint  padding[3];
+};
+
+struct Meshlet
+{
+    vec3  center;
+    float radius;
+    vec3  coneApex;
+    float coneCutoff;
+    vec3  coneAxis;
+    uint  indexOffset;
+    uint  indexCount;
+    uint  lod;
+    uint  padding[2];
 };
 #endif
\ No newline at end of file
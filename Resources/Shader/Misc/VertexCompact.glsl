@@ -0,0 +1,13 @@
+#ifndef MISC_VERTEX_COMPACT_GLSL
+#define MISC_VERTEX_COMPACT_GLSL
+
+// Inverse of VertexCompact::EncodeOctahedral, the lower half of the sphere is folded over the diagonals of the square.
+vec3 DecodeOctahedral(vec2 octahedral)
+{
+    vec3  direction = vec3(octahedral, 1.0f - abs(octahedral.x) - abs(octahedral.y));
+    float fold      = max(-direction.z, 0.0f);
+    direction.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(direction.xy, vec2(0.0f)));
+    return normalize(direction);
+}
+
+#endif
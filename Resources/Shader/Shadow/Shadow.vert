@@ -1,14 +1,27 @@
-#version 450
+#version 460
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
+#extension GL_EXT_nonuniform_qualifier : enable
+#extension GL_GOOGLE_include_directive : require
 
+#include <Misc/Parameters.glsl>
+
+layout(set = 0, binding = 0) readonly buffer InstanceDatas
+{
+    GPUInstanceData instanceData[];
+} instanceDatas;
+
+// The projection and view of the cascade being drawn.
 layout(push_constant) uniform PushObject {
-	mat4 mvp;
+	mat4 lightProjectionView;
 } pushObject;
 
+#if COMPACT_VERTICES
+// Position as a fraction of the model bounds.
+layout(location = 0) in vec4 inPosition;
+#else
 layout(location = 0) in vec3 inPosition;
-// layout(location = 1) in vec2 inUV;
-// layout(location = 2) in vec3 inNormal;
+#endif
 
 out gl_PerVertex 
 {
@@ -16,6 +29,14 @@ out gl_PerVertex
 };
 
 void main() {
-	gl_Position = pushObject.mvp * vec4(inPosition, 1.0f);
+	GPUInstanceData instanceData = instanceDatas.instanceData[nonuniformEXT(gl_InstanceIndex)];
+
+#if COMPACT_VERTICES
+	vec4 position = vec4(mix(instanceData.AABBLocalMin, instanceData.AABBLocalMax, inPosition.xyz), 1.0f);
+#else
+	vec4 position = vec4(inPosition, 1.0f);
+#endif
+
+	gl_Position = pushObject.lightProjectionView * instanceData.modelMatrix * position;
 	gl_Position.z = gl_Position.z * 0.5 + 0.5;
 }
\ No newline at end of file
@@ -13,16 +13,25 @@ layout(set = 0, binding = 2) uniform samplerCube SkyboxCubeMap;
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inUVW;
 
+#if COMPACT_GBUFFER
+// The sky leaves the depth cleared, which the deferred pass tells it apart by.
+layout(location = 0) out vec4 outDiffuse;
+layout(location = 1) out vec4 outNormal;
+layout(location = 2) out vec4 outMaterial;
+#else
 layout(location = 0) out vec4 outPosition;
 layout(location = 1) out vec4 outDiffuse;
 layout(location = 2) out vec4 outNormal;
 layout(location = 3) out vec4 outMaterial;
+#endif
 
 void main() {
 	vec3 cubemapColour = texture(SkyboxCubeMap, inUVW).rgb;
 	vec3 colour = mix(uniformSkybox.baseColour.rgb, cubemapColour, uniformSkybox.blendFactor);
 	
+#if !COMPACT_GBUFFER
 	outPosition = vec4(inPosition, 1.0f);
+#endif
 	outDiffuse = vec4(colour, 1.0f);
 	outNormal = vec4(0.0f);
 	outMaterial = vec4(0.0f);
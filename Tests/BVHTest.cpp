@@ -0,0 +1,202 @@
+#include "BVH.hpp"
+#include "ThreadPool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+namespace MapleLeaf {
+namespace {
+// Leaves store the primitive index offset by this, so a leaf that kept its index instead of its id shows up.
+constexpr uint32_t IdOffset    = 1000;
+constexpr uint32_t InvalidMask = BVH::Node::InvalidMask;
+
+/**
+ * Scatters boxes of varied sizes over a wide, flat area, like the instances of a scene.
+ * @param count The box count.
+ * @param seed The random seed.
+ * @return The bounds of every box.
+ */
+std::vector<BVH::AABB> BuildBounds(uint32_t count, uint32_t seed)
+{
+    std::mt19937                          random(seed);
+    std::uniform_real_distribution<float> position(0.0f, 1000.0f), extent(0.5f, 3.0f);
+
+    std::vector<BVH::AABB> bounds;
+    for (uint32_t i = 0; i < count; i++) {
+        glm::vec3 center(position(random), position(random) * 0.1f, position(random));
+        glm::vec3 halfExtent(extent(random));
+        bounds.emplace_back(center - halfExtent, center + halfExtent);
+    }
+    return bounds;
+}
+
+std::vector<uint32_t> BuildIds(std::size_t count)
+{
+    std::vector<uint32_t> ids(count);
+    for (uint32_t i = 0; i < count; i++) ids[i] = i + IdOffset;
+    return ids;
+}
+
+bool Contains(const BVH::Node& outer, const BVH::Node& inner)
+{
+    return glm::all(glm::lessThanEqual(outer.min, inner.min)) && glm::all(glm::greaterThanEqual(outer.max, inner.max));
+}
+
+/**
+ * Walks the hierarchy as a ray that hits every node and checks the bounds and links on the way.
+ * Internal nodes must bound their children, leaves the current bounds of their primitive, and every leaf is visited exactly once.
+ * @param bvh The hierarchy.
+ * @param bounds The current bounds of every primitive.
+ */
+void ExpectValid(const BVH& bvh, const std::vector<BVH::AABB>& bounds)
+{
+    const auto& nodes = bvh.GetNodes();
+    ASSERT_EQ(nodes.size(), 2 * bounds.size() - 1);
+    ASSERT_EQ(bvh.GetPrimitiveCount(), bounds.size());
+
+    std::vector<uint32_t> leafVisits(bounds.size(), 0);
+    std::size_t           visits = 0;
+    for (uint32_t node = 0; node != InvalidMask; visits++) {
+        ASSERT_LT(node, nodes.size());
+        ASSERT_LT(visits, nodes.size());
+
+        if (nodes[node].IsLeaf()) {
+            auto primitive = nodes[node].instanceID - IdOffset;
+            ASSERT_LT(primitive, bounds.size());
+            EXPECT_EQ(nodes[node].min, bounds[primitive].first);
+            EXPECT_EQ(nodes[node].max, bounds[primitive].second);
+            leafVisits[primitive]++;
+            node = nodes[node].next;
+            continue;
+        }
+
+        // The left child follows its parent and its miss link is the right child.
+        const auto& left = nodes[node + 1];
+        ASSERT_LT(left.next, nodes.size());
+        EXPECT_TRUE(Contains(nodes[node], left));
+        EXPECT_TRUE(Contains(nodes[node], nodes[left.next]));
+        node++;
+    }
+
+    EXPECT_EQ(visits, nodes.size());
+    for (auto count : leafVisits) EXPECT_EQ(count, 1u);
+    // A ray missing the root is done right away.
+    EXPECT_EQ(nodes.front().next, InvalidMask);
+}
+
+/**
+ * Moves every tenth primitive.
+ * @param bounds The bounds to move the primitives of.
+ * @param distance The largest distance a primitive moves along x.
+ * @param seed The random seed.
+ * @return The indices of the moved primitives.
+ */
+std::vector<uint32_t> MovePrimitives(std::vector<BVH::AABB>& bounds, float distance, uint32_t seed)
+{
+    std::mt19937                          random(seed);
+    std::uniform_real_distribution<float> offset(-distance, distance);
+
+    std::vector<uint32_t> moved;
+    for (uint32_t i = 0; i < bounds.size(); i += 10) {
+        glm::vec3 delta(offset(random), 0.0f, 0.0f);
+        bounds[i] = {bounds[i].first + delta, bounds[i].second + delta};
+        moved.emplace_back(i);
+    }
+    return moved;
+}
+}   // namespace
+
+TEST(BVHTest, BuildsTheSameTreeSeriallyAndOnThePool)
+{
+    ThreadPool pool(4);
+
+    // Ranges above the parallel threshold are built as tasks on the pool.
+    for (uint32_t count : {1u, 2u, 3u, 100u, 3 * BVH::ParallelThreshold}) {
+        auto bounds = BuildBounds(count, count);
+        auto ids    = BuildIds(count);
+
+        BVH serial, parallel;
+        serial.Build(bounds, ids);
+        parallel.Build(bounds, ids, &pool);
+        ExpectValid(serial, bounds);
+        ExpectValid(parallel, bounds);
+
+        // The partitions do not depend on which thread runs them, so neither does the depth first layout.
+        ASSERT_EQ(serial.GetNodes().size(), parallel.GetNodes().size());
+        for (std::size_t i = 0; i < serial.GetNodes().size(); i++) {
+            const auto &a = serial.GetNodes()[i], &b = parallel.GetNodes()[i];
+            EXPECT_TRUE(a.min == b.min && a.max == b.max && a.instanceID == b.instanceID && a.next == b.next) << "node " << i;
+        }
+        EXPECT_FALSE(parallel.NeedsRebuild(BVH::DefaultRebuildThreshold));
+    }
+
+    BVH empty;
+    empty.Build({}, {}, &pool);
+    EXPECT_TRUE(empty.GetNodes().empty());
+}
+
+TEST(BVHTest, RefitKeepsTheTreeValid)
+{
+    ThreadPool pool(4);
+
+    for (auto threadPool : {static_cast<ThreadPool*>(nullptr), &pool}) {
+        auto bounds = BuildBounds(3 * BVH::ParallelThreshold, 5);
+        BVH  bvh;
+        bvh.Build(bounds, BuildIds(bounds.size()), threadPool);
+
+        auto moved = MovePrimitives(bounds, 5.0f, 7);
+        bvh.Refit(moved, bounds);
+        ExpectValid(bvh, bounds);
+
+        // Only the moved leaves and their ancestors are refitted, once each and in order, the root with them.
+        const auto& refitted = bvh.GetRefittedNodes();
+        EXPECT_TRUE(std::is_sorted(refitted.begin(), refitted.end()));
+        EXPECT_EQ(std::adjacent_find(refitted.begin(), refitted.end()), refitted.end());
+        ASSERT_FALSE(refitted.empty());
+        EXPECT_EQ(refitted.front(), 0u);
+        EXPECT_LT(refitted.size(), bvh.GetNodes().size());
+        for (uint32_t node = 0; node < bvh.GetNodes().size(); node++) {
+            const auto& leaf = bvh.GetNodes()[node];
+            if (!leaf.IsLeaf()) continue;
+
+            bool wasMoved = (leaf.instanceID - IdOffset) % 10 == 0;
+            EXPECT_EQ(std::binary_search(refitted.begin(), refitted.end(), node), wasMoved) << "leaf " << node;
+        }
+
+        // Small moves barely change the cost.
+        EXPECT_FALSE(bvh.NeedsRebuild(BVH::DefaultRebuildThreshold));
+
+        bvh.Refit({}, bounds);
+        EXPECT_TRUE(bvh.GetRefittedNodes().empty());
+    }
+}
+
+TEST(BVHTest, ScatteredPrimitivesNeedARebuild)
+{
+    ThreadPool pool(4);
+
+    for (auto threadPool : {static_cast<ThreadPool*>(nullptr), &pool}) {
+        auto bounds = BuildBounds(3 * BVH::ParallelThreshold, 11);
+        auto ids    = BuildIds(bounds.size());
+        BVH  bvh;
+        bvh.Build(bounds, ids, threadPool);
+        auto buildCost = bvh.GetSahCost();
+
+        // Every tenth primitive jumps across the scene, stretching its ancestors over most of it.
+        auto moved = MovePrimitives(bounds, 1000.0f, 13);
+        bvh.Refit(moved, bounds);
+        ExpectValid(bvh, bounds);
+        EXPECT_GT(bvh.GetSahCost(), buildCost);
+        EXPECT_TRUE(bvh.NeedsRebuild(BVH::DefaultRebuildThreshold));
+        EXPECT_EQ(bvh.GetStatistics().buildSahCost, buildCost);
+
+        auto refitCost = bvh.GetSahCost();
+        bvh.Build(bounds, ids, threadPool);
+        ExpectValid(bvh, bounds);
+        EXPECT_LT(bvh.GetSahCost(), refitCost);
+        EXPECT_FALSE(bvh.NeedsRebuild(BVH::DefaultRebuildThreshold));
+    }
+}
+}   // namespace MapleLeaf
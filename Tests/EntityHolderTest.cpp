@@ -0,0 +1,97 @@
+#include "EntityHolder.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace MapleLeaf {
+namespace {
+/**
+ * Builds a chain of entities that all share one name, each the child of the one before.
+ * @param holder The holder to create the entities in.
+ * @param count The entity count.
+ * @return The entities from the topmost one down.
+ */
+std::vector<Entity*> BuildChain(EntityHolder& holder, uint32_t count)
+{
+    std::vector<Entity*> chain;
+    chain.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        auto entity = chain.emplace_back(holder.CreateEntity());
+        entity->SetName("Node");
+        if (i > 0) entity->SetParent(chain[i - 1]);
+    }
+    return chain;
+}
+}   // namespace
+
+TEST(EntityHolderTest, FindsEntitiesByNameAndPath)
+{
+    EntityHolder holder;
+
+    auto first = holder.CreateEntity();
+    first->SetName("Root");
+    auto second = holder.CreateEntity();
+    second->SetName("Root");
+
+    // glTF names collide, the path tells apart the children of both roots.
+    auto firstChild = holder.CreateEntity();
+    firstChild->SetName("Mesh");
+    firstChild->SetParent(first);
+    auto secondChild = holder.CreateEntity();
+    secondChild->SetName("Leaf");
+    secondChild->SetParent(second);
+
+    EXPECT_EQ(holder.GetEntity("Root"), first);
+    EXPECT_EQ(holder.GetEntityByPath("Root/Mesh"), firstChild);
+    EXPECT_EQ(holder.GetEntityByPath("Root/Leaf"), secondChild);
+    EXPECT_EQ(holder.GetEntityByPath("Root/Missing"), nullptr);
+    EXPECT_EQ(secondChild->GetPath(), "Root/Leaf");
+
+    // Renaming the parent moves the whole subtree to the new path.
+    second->SetName("Other");
+    EXPECT_EQ(holder.GetEntityByPath("Other/Leaf"), secondChild);
+    EXPECT_EQ(holder.GetEntityByPath("Root/Leaf"), nullptr);
+
+    secondChild->SetParent(first);
+    EXPECT_EQ(holder.GetEntityByPath("Root/Leaf"), secondChild);
+    EXPECT_EQ(holder.GetEntityByPath("Other/Leaf"), nullptr);
+}
+
+TEST(EntityHolderTest, HandlesOfRemovedEntitiesStopResolving)
+{
+    EntityHolder holder;
+
+    auto removed = holder.CreateEntity();
+    auto handle  = removed->GetHandle();
+    EXPECT_TRUE(handle.IsValid());
+    EXPECT_EQ(holder.GetEntity(handle), removed);
+
+    holder.Remove(removed);
+    EXPECT_EQ(holder.GetEntity(handle), nullptr);
+
+    // The freed slot is reused with a new generation, the old handle still resolves to nothing.
+    auto reused = holder.CreateEntity();
+    EXPECT_EQ(reused->GetHandle().index, handle.index);
+    EXPECT_NE(reused->GetHandle(), handle);
+    EXPECT_EQ(holder.GetEntity(handle), nullptr);
+    EXPECT_EQ(holder.GetEntity(reused->GetHandle()), reused);
+}
+
+TEST(EntityHolderTest, LooksUpDeepChains)
+{
+    // Every entity is named the same and nested one deeper than the one before, the worst case for indexing by path.
+    constexpr uint32_t depth = 100000;
+    EntityHolder       holder;
+    auto               chain = BuildChain(holder, depth);
+
+    for (auto entity : chain) EXPECT_EQ(holder.GetEntity(entity->GetHandle()), entity);
+    EXPECT_EQ(holder.GetEntity("Node"), chain.front());
+
+    // The path of the deepest entity is followed one segment per level without recursing, a recursive lookup would overflow the stack here.
+    std::string path = "Node";
+    for (uint32_t i = 1; i < depth; i++) path += "/Node";
+    EXPECT_EQ(holder.GetEntityByPath(path), chain.back());
+    EXPECT_EQ(holder.GetEntityByPath(path + "/Node"), nullptr);
+}
+}   // namespace MapleLeaf
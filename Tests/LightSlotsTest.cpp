@@ -0,0 +1,121 @@
+#include "Buffer.hpp"
+#include "LightSlots.hpp"
+
+#include <gtest/gtest.h>
+
+namespace MapleLeaf {
+namespace {
+struct TestLight
+{
+    Color color = Color::White;
+    float value = 0.0f;
+
+    bool operator==(const TestLight& other) const { return color == other.color && value == other.value; }
+};
+
+/**
+ * Allocates lights and gives each its slot as value, so a light that moved to another slot shows up.
+ * @param slots The slots to allocate in.
+ * @param count The light count.
+ * @return The allocated slots.
+ */
+std::vector<uint32_t> AllocateLights(LightSlots<TestLight>& slots, uint32_t count)
+{
+    std::vector<uint32_t> allocated;
+    for (uint32_t i = 0; i < count; i++) {
+        auto slot = allocated.emplace_back(slots.Allocate());
+        slots.Set(slot, TestLight{Color::White, static_cast<float>(slot)});
+    }
+    return allocated;
+}
+
+// The byte ranges an upload of the slots changed since the last one copies.
+std::vector<std::pair<VkDeviceSize, VkDeviceSize>> GetUploadRanges(LightSlots<TestLight>& slots)
+{
+    auto                                               dirty = slots.TakeDirtySlots();
+    std::vector<std::pair<VkDeviceSize, VkDeviceSize>> ranges;
+    for (const auto& region : Buffer::CoalesceRanges(dirty, sizeof(TestLight))) ranges.emplace_back(region.dstOffset, region.size);
+    return ranges;
+}
+}   // namespace
+
+TEST(LightSlotsTest, LightsKeepTheirSlots)
+{
+    LightSlots<TestLight> slots;
+    EXPECT_EQ(slots.GetLowestUsedSlot(), 0u);
+
+    // Slot 0 is the placeholder, the lights start at 1.
+    EXPECT_EQ(AllocateLights(slots, 4), (std::vector<uint32_t>{1, 2, 3, 4}));
+    EXPECT_EQ(slots.GetLowestUsedSlot(), 1u);
+
+    // Freeing a light leaves a black light in its slot and the others where they were.
+    slots.Free(1);
+    slots.Free(3);
+    ASSERT_EQ(slots.GetLights().size(), 5u);
+    EXPECT_EQ(slots.GetLights()[1].color, Color::Black);
+    EXPECT_EQ(slots.GetLights()[3].color, Color::Black);
+    EXPECT_EQ(slots.GetLights()[2].value, 2.0f);
+    EXPECT_EQ(slots.GetLights()[4].value, 4.0f);
+    EXPECT_EQ(slots.GetLowestUsedSlot(), 2u);
+}
+
+TEST(LightSlotsTest, FreedSlotsAreReusedLowestFirst)
+{
+    LightSlots<TestLight> slots;
+    AllocateLights(slots, 5);
+
+    slots.Free(4);
+    slots.Free(2);
+    EXPECT_EQ(slots.Allocate(), 2u);
+    EXPECT_EQ(slots.Allocate(), 4u);
+    EXPECT_EQ(slots.Allocate(), 6u);
+    EXPECT_EQ(slots.GetLights().size(), 7u);
+}
+
+TEST(LightSlotsTest, FreeSlotsAtTheEndAreDropped)
+{
+    LightSlots<TestLight> slots;
+    AllocateLights(slots, 4);
+
+    // A free slot below a used one stays, once the used one is freed both are dropped.
+    slots.Free(3);
+    EXPECT_EQ(slots.GetLights().size(), 5u);
+    slots.Free(4);
+    EXPECT_EQ(slots.GetLights().size(), 3u);
+
+    slots.Free(1);
+    slots.Free(2);
+    EXPECT_EQ(slots.GetLights().size(), 1u);
+    EXPECT_EQ(slots.GetLowestUsedSlot(), 0u);
+
+    // Dropped slots are allocated again from the end.
+    EXPECT_EQ(slots.Allocate(), 1u);
+}
+
+TEST(LightSlotsTest, OnlyChangedSlotsAreUploaded)
+{
+    LightSlots<TestLight> slots;
+    AllocateLights(slots, 6);
+
+    constexpr VkDeviceSize stride = sizeof(TestLight);
+    EXPECT_EQ(GetUploadRanges(slots), (std::vector<std::pair<VkDeviceSize, VkDeviceSize>>{{stride, 6 * stride}}));
+    EXPECT_TRUE(GetUploadRanges(slots).empty());
+
+    // Setting the light already in a slot marks nothing.
+    slots.Set(3, slots.GetLights()[3]);
+    EXPECT_TRUE(GetUploadRanges(slots).empty());
+
+    // Neighbouring changed slots are copied in one range.
+    slots.Set(2, TestLight{Color::Red, 2.0f});
+    slots.Set(3, TestLight{Color::Red, 3.0f});
+    slots.Free(5);
+    EXPECT_EQ(GetUploadRanges(slots), (std::vector<std::pair<VkDeviceSize, VkDeviceSize>>{{2 * stride, 2 * stride}, {5 * stride, stride}}));
+
+    // Slots dropped from the end after they changed have nothing left to upload.
+    slots.Set(4, TestLight{Color::Red, 4.0f});
+    slots.Set(6, TestLight{Color::Red, 6.0f});
+    slots.Free(6);
+    EXPECT_EQ(GetUploadRanges(slots), (std::vector<std::pair<VkDeviceSize, VkDeviceSize>>{{4 * stride, stride}}));
+    EXPECT_EQ(slots.GetLights().size(), 5u);
+}
+}   // namespace MapleLeaf
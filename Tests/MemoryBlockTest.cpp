@@ -0,0 +1,173 @@
+#include "MemoryAllocator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+namespace MapleLeaf {
+namespace {
+constexpr VkDeviceSize BlockSize = 1024 * 1024;
+
+/**
+ * Checks that the live allocations of a block lie inside it, do not overlap and add up to its used size.
+ * @param block The block.
+ */
+void ExpectConsistent(const MemoryBlock& block)
+{
+    auto         allocations = block.GetAllocations();
+    VkDeviceSize end = 0, used = 0;
+    for (const auto& [offset, size] : allocations) {
+        EXPECT_GE(offset, end);
+        end = offset + size;
+        used += size;
+    }
+    EXPECT_LE(end, block.GetSize());
+    EXPECT_EQ(used, block.GetUsedSize());
+    EXPECT_EQ(allocations.size(), block.GetAllocationCount());
+}
+
+// A device with the memory types of a typical discrete GPU, in the order drivers report them.
+VkPhysicalDeviceMemoryProperties GetFakeMemoryProperties()
+{
+    VkPhysicalDeviceMemoryProperties memoryProperties = {};
+    memoryProperties.memoryTypeCount                  = 4;
+    memoryProperties.memoryTypes[0].propertyFlags     = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    memoryProperties.memoryTypes[1].propertyFlags     = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    memoryProperties.memoryTypes[2].propertyFlags =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+    memoryProperties.memoryTypes[3].propertyFlags =
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    return memoryProperties;
+}
+}   // namespace
+
+TEST(MemoryBlockTest, TLSFAllocatesWithMixedAlignments)
+{
+    MemoryBlock block(BlockSize, MemoryBlock::Strategy::TLSF);
+
+    const std::pair<VkDeviceSize, VkDeviceSize> requests[] = {
+        {100, 1}, {256, 256}, {3, 16}, {4096, 4096}, {1000, 64}, {65536, 65536}, {17, 4}, {300, 256}, {8192, 1024}, {1, 1},
+    };
+
+    std::vector<VkDeviceSize> offsets;
+    for (const auto& [size, alignment] : requests) {
+        auto offset = block.Allocate(size, alignment);
+        ASSERT_TRUE(offset);
+        EXPECT_EQ(*offset % alignment, 0u);
+        offsets.push_back(*offset);
+    }
+    ExpectConsistent(block);
+
+    // The holes left by every other range are filled again with other alignments.
+    for (uint32_t i = 0; i < offsets.size(); i += 2) block.Free(offsets[i]);
+    ExpectConsistent(block);
+
+    for (const auto& [size, alignment] : requests) {
+        auto offset = block.Allocate(size / 2 + 1, alignment * 2);
+        ASSERT_TRUE(offset);
+        EXPECT_EQ(*offset % (alignment * 2), 0u);
+    }
+    ExpectConsistent(block);
+
+    EXPECT_FALSE(block.Allocate(0, 1));
+    EXPECT_FALSE(block.Allocate(BlockSize, 1));
+}
+
+TEST(MemoryBlockTest, TLSFCoalescesBackToOneFreeRange)
+{
+    MemoryBlock block(BlockSize, MemoryBlock::Strategy::TLSF);
+
+    // Fills the block with ranges of varied sizes and alignments until nothing fits.
+    std::mt19937              random(7);
+    std::vector<VkDeviceSize> offsets;
+    while (auto offset = block.Allocate(64 + random() % 8192, VkDeviceSize(1) << (random() % 9))) offsets.push_back(*offset);
+    ASSERT_GT(offsets.size(), 100u);
+    ExpectConsistent(block);
+
+    // Freed in random order every free neighbour is merged, both sides of a range freed between two free ones included.
+    std::shuffle(offsets.begin(), offsets.end(), random);
+    for (auto offset : offsets) block.Free(offset);
+
+    EXPECT_TRUE(block.IsEmpty());
+    EXPECT_EQ(block.GetUsedSize(), 0u);
+    EXPECT_EQ(block.GetLargestFreeRange(), BlockSize);
+    EXPECT_EQ(block.GetFragmentation(), 0.0f);
+
+    auto whole = block.Allocate(BlockSize, 1);
+    ASSERT_TRUE(whole);
+    EXPECT_EQ(*whole, 0u);
+}
+
+TEST(MemoryBlockTest, LinearResetsOnceDrained)
+{
+    MemoryBlock block(1024, MemoryBlock::Strategy::Linear);
+
+    EXPECT_EQ(block.Allocate(100, 1), VkDeviceSize(0));
+    EXPECT_EQ(block.Allocate(100, 64), VkDeviceSize(128));
+    EXPECT_EQ(block.Allocate(100, 1), VkDeviceSize(228));
+    EXPECT_EQ(block.GetLargestFreeRange(), 1024u - 328u);
+
+    // Freeing the top hands its space out again, a range below the top waits for the block to drain.
+    block.Free(228);
+    EXPECT_EQ(block.Allocate(50, 1), VkDeviceSize(228));
+    block.Free(0);
+    EXPECT_EQ(block.GetLargestFreeRange(), 1024u - 278u);
+    EXPECT_FALSE(block.Allocate(800, 1));
+
+    block.Free(128);
+    block.Free(228);
+    EXPECT_TRUE(block.IsEmpty());
+    EXPECT_EQ(block.GetLargestFreeRange(), 1024u);
+    EXPECT_EQ(block.Allocate(1024, 1), VkDeviceSize(0));
+}
+
+TEST(MemoryBlockTest, FindMemoryTypeMatchesFilterAndProperties)
+{
+    auto memoryProperties = GetFakeMemoryProperties();
+    auto find             = [&memoryProperties](uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+        return MemoryAllocator::FindMemoryType(memoryProperties, typeFilter, properties);
+    };
+
+    // The first type in the filter with every required property wins.
+    EXPECT_EQ(find(~0u, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT), 0u);
+    EXPECT_EQ(find(~0u, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT), 1u);
+    EXPECT_EQ(find(~0u, VK_MEMORY_PROPERTY_HOST_CACHED_BIT), 2u);
+    EXPECT_EQ(find(~0u, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT), 3u);
+    EXPECT_EQ(find(0b1010, 0), 1u);
+
+    // Types outside the filter are skipped even when they match.
+    EXPECT_EQ(find(0b1110, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT), 3u);
+    EXPECT_EQ(find(0b0001, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT), std::nullopt);
+    EXPECT_EQ(find(~0u, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT), std::nullopt);
+
+    // Filter bits past the reported type count are ignored.
+    memoryProperties.memoryTypeCount = 2;
+    EXPECT_EQ(find(0b1000, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT), std::nullopt);
+}
+
+TEST(MemoryBlockTest, FragmentationFollowsTheFreeRanges)
+{
+    constexpr VkDeviceSize rangeSize = 256;
+    MemoryBlock            block(16 * rangeSize, MemoryBlock::Strategy::TLSF);
+
+    std::vector<VkDeviceSize> offsets;
+    for (uint32_t i = 0; i < 16; i++) offsets.push_back(*block.Allocate(rangeSize, 1));
+    EXPECT_EQ(block.GetLargestFreeRange(), 0u);
+    EXPECT_EQ(block.GetFragmentation(), 0.0f);
+
+    // Every other range free leaves eight separate ones of a sixteenth of the block each.
+    for (uint32_t i = 0; i < 16; i += 2) block.Free(offsets[i]);
+    EXPECT_EQ(block.GetLargestFreeRange(), rangeSize);
+    EXPECT_FLOAT_EQ(block.GetFragmentation(), 1.0f - 1.0f / 8.0f);
+
+    // Freeing the ranges between the first four free ones joins them.
+    for (uint32_t i = 1; i < 7; i += 2) block.Free(offsets[i]);
+    EXPECT_EQ(block.GetLargestFreeRange(), 7 * rangeSize);
+    EXPECT_FLOAT_EQ(block.GetFragmentation(), 1.0f - 7.0f / 11.0f);
+
+    for (uint32_t i = 7; i < 16; i += 2) block.Free(offsets[i]);
+    EXPECT_EQ(block.GetFragmentation(), 0.0f);
+    EXPECT_EQ(block.GetLargestFreeRange(), 16 * rangeSize);
+}
+}   // namespace MapleLeaf
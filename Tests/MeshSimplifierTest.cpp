@@ -0,0 +1,160 @@
+#include "MeshSimplifier.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace MapleLeaf {
+namespace {
+/**
+ * Builds a closed unit sphere from latitude rings, the poles are single vertices so no seam is locked.
+ * @param segments The vertex count around each ring.
+ * @param rings The ring count between the poles.
+ * @param vertices The sphere vertices.
+ * @return The triangle list.
+ */
+std::vector<uint32_t> BuildSphere(uint32_t segments, uint32_t rings, std::vector<Vertex3D>& vertices)
+{
+    auto addVertex = [&vertices](const glm::vec3& position) {
+        vertices.emplace_back(position, glm::vec2(0.0f), position, glm::vec3(1.0f, 0.0f, 0.0f));
+    };
+
+    addVertex(glm::vec3(0.0f, 1.0f, 0.0f));
+    for (uint32_t ring = 1; ring < rings; ring++) {
+        auto theta = 3.14159265f * static_cast<float>(ring) / static_cast<float>(rings);
+        for (uint32_t segment = 0; segment < segments; segment++) {
+            auto phi = 2.0f * 3.14159265f * static_cast<float>(segment) / static_cast<float>(segments);
+            addVertex(glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+        }
+    }
+    addVertex(glm::vec3(0.0f, -1.0f, 0.0f));
+
+    auto south      = static_cast<uint32_t>(vertices.size() - 1);
+    auto ringVertex = [segments](uint32_t ring, uint32_t segment) { return 1 + (ring - 1) * segments + segment % segments; };
+
+    std::vector<uint32_t> indices;
+    for (uint32_t segment = 0; segment < segments; segment++) {
+        indices.insert(indices.end(), {0, ringVertex(1, segment + 1), ringVertex(1, segment)});
+        indices.insert(indices.end(), {south, ringVertex(rings - 1, segment), ringVertex(rings - 1, segment + 1)});
+        for (uint32_t ring = 1; ring + 1 < rings; ring++) {
+            auto a = ringVertex(ring, segment), b = ringVertex(ring, segment + 1);
+            auto c = ringVertex(ring + 1, segment), d = ringVertex(ring + 1, segment + 1);
+            indices.insert(indices.end(), {a, b, d, a, d, c});
+        }
+    }
+    return indices;
+}
+
+/**
+ * Gets the distance from a point to a triangle.
+ * @param p The point.
+ * @param a, b, c The triangle corners.
+ * @return The distance.
+ */
+float DistanceToTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    auto normal = glm::cross(b - a, c - a);
+    if (glm::length(normal) > 0.0f) {
+        normal = glm::normalize(normal);
+
+        // The projection lies inside when it is on the inner side of every edge.
+        auto projected = p - normal * glm::dot(p - a, normal);
+        if (glm::dot(glm::cross(b - a, projected - a), normal) >= 0.0f && glm::dot(glm::cross(c - b, projected - b), normal) >= 0.0f &&
+            glm::dot(glm::cross(a - c, projected - c), normal) >= 0.0f)
+            return std::abs(glm::dot(p - a, normal));
+    }
+
+    auto toSegment = [&p](const glm::vec3& from, const glm::vec3& to) {
+        auto edge = to - from;
+        auto t    = glm::dot(edge, edge) > 0.0f ? std::clamp(glm::dot(p - from, edge) / glm::dot(edge, edge), 0.0f, 1.0f) : 0.0f;
+        return glm::length(p - (from + edge * t));
+    };
+    return std::min({toSegment(a, b), toSegment(b, c), toSegment(c, a)});
+}
+
+// The largest distance from a vertex of the original mesh to the simplified surface.
+float GetDeviation(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& original, const std::vector<uint32_t>& simplified)
+{
+    std::vector<uint32_t> used(original);
+    std::sort(used.begin(), used.end());
+    used.erase(std::unique(used.begin(), used.end()), used.end());
+
+    float deviation = 0.0f;
+    for (auto index : used) {
+        float distance = std::numeric_limits<float>::infinity();
+        for (std::size_t i = 0; i + 2 < simplified.size(); i += 3) {
+            distance = std::min(distance,
+                                DistanceToTriangle(vertices[index].position,
+                                                   vertices[simplified[i]].position,
+                                                   vertices[simplified[i + 1]].position,
+                                                   vertices[simplified[i + 2]].position));
+        }
+        deviation = std::max(deviation, distance);
+    }
+    return deviation;
+}
+}   // namespace
+
+TEST(MeshSimplifierTest, LevelsGetCoarserWithGrowingError)
+{
+    std::vector<Vertex3D> vertices;
+    auto                  indices = BuildSphere(32, 16, vertices);
+
+    auto levels = MeshSimplifier::BuildLevels(vertices, indices);
+    ASSERT_GE(levels.size(), 2u);
+
+    auto  previousCount = indices.size();
+    float previousError = 0.0f;
+    for (const auto& level : levels) {
+        ASSERT_EQ(level.indices.size() % 3, 0u);
+        EXPECT_GT(level.indices.size(), 0u);
+        EXPECT_LE(level.indices.size(), previousCount * 4 / 5);
+        EXPECT_GE(level.error, previousError);
+        for (auto index : level.indices) EXPECT_LT(index, vertices.size());
+
+        previousCount = level.indices.size();
+        previousError = level.error;
+    }
+}
+
+TEST(MeshSimplifierTest, ErrorBoundsTheDeviationFromTheSurface)
+{
+    std::vector<Vertex3D> vertices;
+    auto                  indices = BuildSphere(32, 16, vertices);
+
+    for (const auto& level : MeshSimplifier::BuildLevels(vertices, indices)) {
+        // The error is a mean distance to the planes of the collapsed triangles, it stays within a small factor of the largest distance.
+        auto deviation = GetDeviation(vertices, indices, level.indices);
+        EXPECT_GT(level.error, 0.0f);
+        EXPECT_LE(deviation, 3.0f * level.error + 1e-4f);
+        EXPECT_LT(level.error, 0.5f);
+    }
+}
+
+TEST(MeshSimplifierTest, FlatMeshesSimplifyWithoutError)
+{
+    // A grid on a plane, every interior vertex can collapse at no cost and the border vertices are locked.
+    std::vector<Vertex3D> vertices;
+    std::vector<uint32_t> indices;
+    constexpr uint32_t    size = 16;
+    for (uint32_t y = 0; y <= size; y++) {
+        for (uint32_t x = 0; x <= size; x++)
+            vertices.emplace_back(glm::vec3(static_cast<float>(x), static_cast<float>(y), 0.0f), glm::vec2(0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
+                                  glm::vec3(1.0f, 0.0f, 0.0f));
+    }
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            auto corner = y * (size + 1) + x;
+            indices.insert(indices.end(), {corner, corner + 1, corner + size + 2, corner, corner + size + 2, corner + size + 1});
+        }
+    }
+
+    float error   = 1.0f;
+    auto  reduced = MeshSimplifier::Simplify(vertices, indices, indices.size() / 4, &error);
+    EXPECT_LE(reduced.size(), indices.size() / 4);
+    EXPECT_NEAR(error, 0.0f, 1e-5f);
+    EXPECT_NEAR(GetDeviation(vertices, indices, reduced), 0.0f, 1e-5f);
+}
+}   // namespace MapleLeaf
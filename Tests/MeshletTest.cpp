@@ -0,0 +1,126 @@
+#include "Meshlet.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <set>
+
+namespace MapleLeaf {
+namespace {
+/**
+ * Builds a grid of quads in the XY plane, two triangles per quad.
+ * @param size The quad count along each side.
+ * @param vertices The grid vertices.
+ * @return The triangle list.
+ */
+std::vector<uint32_t> BuildGrid(uint32_t size, std::vector<Vertex3D>& vertices)
+{
+    for (uint32_t y = 0; y <= size; y++) {
+        for (uint32_t x = 0; x <= size; x++)
+            vertices.emplace_back(glm::vec3(static_cast<float>(x), static_cast<float>(y), 0.0f), glm::vec2(0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
+                                  glm::vec3(1.0f, 0.0f, 0.0f));
+    }
+
+    std::vector<uint32_t> indices;
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            auto corner = y * (size + 1) + x;
+            indices.insert(indices.end(), {corner, corner + 1, corner + size + 2, corner, corner + size + 2, corner + size + 1});
+        }
+    }
+    return indices;
+}
+
+// The triangles of a triangle list as sorted corner triples, the same for any order of the triangles.
+std::multiset<std::array<uint32_t, 3>> GetTriangles(const std::vector<uint32_t>& indices)
+{
+    std::multiset<std::array<uint32_t, 3>> triangles;
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+        std::array<uint32_t, 3> triangle = {indices[i], indices[i + 1], indices[i + 2]};
+        std::sort(triangle.begin(), triangle.end());
+        triangles.insert(triangle);
+    }
+    return triangles;
+}
+
+/**
+ * Checks that the meshlets cover every triangle once and none references more vertices or triangles than allowed.
+ * @param meshlets The built meshlets.
+ * @param original The triangle list before the build.
+ * @param reordered The triangle list reordered by the build.
+ * @param maxVertices The vertex limit of the build.
+ * @param maxTriangles The triangle limit of the build.
+ */
+void ExpectValidMeshlets(const std::vector<Meshlet>& meshlets, const std::vector<uint32_t>& original, const std::vector<uint32_t>& reordered,
+                         uint32_t maxVertices, uint32_t maxTriangles)
+{
+    EXPECT_EQ(GetTriangles(original), GetTriangles(reordered));
+
+    uint32_t indexOffset = 0;
+    for (const auto& meshlet : meshlets) {
+        EXPECT_EQ(meshlet.indexOffset, indexOffset);
+        EXPECT_GT(meshlet.indexCount, 0u);
+        EXPECT_LE(meshlet.indexCount, maxTriangles * 3);
+
+        std::set<uint32_t> unique(reordered.begin() + meshlet.indexOffset, reordered.begin() + meshlet.indexOffset + meshlet.indexCount);
+        EXPECT_LE(unique.size(), maxVertices);
+        indexOffset += meshlet.indexCount;
+    }
+    EXPECT_EQ(indexOffset, reordered.size());
+}
+}   // namespace
+
+TEST(MeshletTest, RespectsLimits)
+{
+    std::vector<Vertex3D> vertices;
+    auto                  indices  = BuildGrid(32, vertices);
+    auto                  original = indices;
+
+    auto meshlets = MeshletBuilder::Build(vertices, indices, 64, 124);
+    EXPECT_GT(meshlets.size(), 1u);
+    ExpectValidMeshlets(meshlets, original, indices, 64, 124);
+}
+
+TEST(MeshletTest, CountsRepeatedVerticesOfDegenerateTrianglesOnce)
+{
+    std::vector<Vertex3D> vertices;
+    auto                  indices = BuildGrid(8, vertices);
+
+    // Triangles naming a vertex two or three times, next to the grid triangles using the same vertices.
+    indices.insert(indices.end(), {0, 0, 1, 1, 1, 1, 10, 11, 10, 12, 13, 13, 0, 1, 0});
+    auto original = indices;
+
+    // A tight vertex limit makes the cost of every candidate decide whether it fits.
+    for (uint32_t maxVertices : {3u, 4u, 8u, 64u}) {
+        auto reordered = original;
+        auto meshlets  = MeshletBuilder::Build(vertices, reordered, maxVertices, 124);
+        ExpectValidMeshlets(meshlets, original, reordered, maxVertices, 124);
+    }
+}
+
+TEST(MeshletTest, BuildsEveryLevelOfDetail)
+{
+    std::vector<Vertex3D> vertices;
+    auto                  indices = BuildGrid(32, vertices);
+    auto                  lods    = MeshSimplifier::BuildLevels(vertices, indices);
+    ASSERT_FALSE(lods.empty());
+
+    auto original     = indices;
+    auto originalLods = lods;
+    auto meshlets     = MeshletBuilder::BuildLevels(vertices, indices, lods);
+
+    // The meshlets come level by level, each level split like a build of its triangle list alone.
+    auto level = meshlets.begin();
+    for (uint32_t lod = 0; lod <= lods.size(); lod++) {
+        auto end = std::find_if(level, meshlets.end(), [lod](const Meshlet& meshlet) { return meshlet.lod != lod; });
+        ASSERT_NE(level, end);
+
+        const auto& levelOriginal = lod == 0 ? original : originalLods[lod - 1].indices;
+        const auto& levelIndices  = lod == 0 ? indices : lods[lod - 1].indices;
+        ExpectValidMeshlets({level, end}, levelOriginal, levelIndices, MeshletBuilder::MaxVertices, MeshletBuilder::MaxTriangles);
+        level = end;
+    }
+    EXPECT_EQ(level, meshlets.end());
+}
+}   // namespace MapleLeaf
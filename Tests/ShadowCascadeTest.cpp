@@ -0,0 +1,136 @@
+#include "ShadowCascade.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace MapleLeaf {
+namespace {
+constexpr uint32_t MapSize     = 2048;
+constexpr float    NearPlane   = 0.1f;
+constexpr float    FarPlane    = 50.0f;
+constexpr float    FieldOfView = 1.04719755f;
+constexpr float    AspectRatio = 16.0f / 9.0f;
+
+const glm::vec3 LightDirection = glm::normalize(glm::vec3(-0.3f, -1.0f, -0.2f));
+// Bounds with the minimum above the maximum, the depth range only follows the slice.
+const glm::vec3 NoSceneMin(1.0f), NoSceneMax(-1.0f);
+
+/**
+ * Fits a cascade around the whole view depth range of a camera.
+ * @param position The camera position.
+ * @param forward The view direction.
+ * @param up The camera up vector.
+ * @return The fitted cascade.
+ */
+ShadowCascade FitCascade(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up)
+{
+    ShadowCascade cascade;
+    auto          corners = ShadowCascade::ComputeFrustumCorners(position, forward, up, FieldOfView, AspectRatio, NearPlane, FarPlane);
+    cascade.Fit(corners, LightDirection, NoSceneMin, NoSceneMax, MapSize);
+    return cascade;
+}
+
+// The shadow map texel coordinates a world point lands on, with the fraction of a texel.
+glm::vec2 GetTexel(const ShadowCascade& cascade, const glm::vec3& point)
+{
+    glm::vec4 projected = cascade.GetLightProjectionViewMatrix() * glm::vec4(point, 1.0f);
+    return (glm::vec2(projected.x, projected.y) * 0.5f + glm::vec2(0.5f)) * static_cast<float>(MapSize);
+}
+
+/**
+ * Checks that two cascades map the world to the same texel grid, only shifted by whole texels.
+ * @param first The first cascade.
+ * @param second The second cascade.
+ */
+void ExpectWholeTexelShift(const ShadowCascade& first, const ShadowCascade& second)
+{
+    EXPECT_EQ(first.GetTexelSize(), second.GetTexelSize());
+    for (const auto& point : {glm::vec3(0.0f), glm::vec3(3.0f, -1.0f, 7.0f)}) {
+        auto shift = GetTexel(second, point) - GetTexel(first, point);
+        EXPECT_NEAR(shift.x, std::round(shift.x), 0.02f);
+        EXPECT_NEAR(shift.y, std::round(shift.y), 0.02f);
+    }
+}
+}   // namespace
+
+TEST(ShadowCascadeTest, SplitDepthsAscendToTheFarPlane)
+{
+    for (uint32_t count = 1; count <= 4; count++) {
+        for (float lambda : {0.0f, 0.5f, 0.75f, 1.0f}) {
+            auto splitDepths = ShadowCascade::ComputeSplitDepths(NearPlane, FarPlane, count, lambda);
+            ASSERT_EQ(splitDepths.size(), count);
+
+            float previous = NearPlane;
+            for (auto splitDepth : splitDepths) {
+                EXPECT_GT(splitDepth, previous);
+                previous = splitDepth;
+            }
+            EXPECT_EQ(splitDepths.back(), FarPlane);
+        }
+    }
+}
+
+TEST(ShadowCascadeTest, SplitDepthsFollowTheirScheme)
+{
+    // No weight on the logarithmic scheme splits in equal steps, the full weight in equal ratios.
+    auto uniform = ShadowCascade::ComputeSplitDepths(NearPlane, FarPlane, 4, 0.0f);
+    for (uint32_t i = 0; i < 4; i++) EXPECT_NEAR(uniform[i], NearPlane + (FarPlane - NearPlane) * (i + 1) / 4.0f, 1e-4f);
+
+    auto logarithmic = ShadowCascade::ComputeSplitDepths(NearPlane, FarPlane, 4, 1.0f);
+    EXPECT_NEAR(logarithmic[0] / NearPlane, std::pow(FarPlane / NearPlane, 0.25f), 1e-3f);
+    for (uint32_t i = 1; i < 4; i++) EXPECT_NEAR(logarithmic[i] / logarithmic[i - 1], logarithmic[0] / NearPlane, 1e-3f);
+
+    // Blending sits between both schemes.
+    auto blended = ShadowCascade::ComputeSplitDepths(NearPlane, FarPlane, 4, 0.75f);
+    for (uint32_t i = 0; i < 3; i++) {
+        EXPECT_GT(blended[i], logarithmic[i]);
+        EXPECT_LT(blended[i], uniform[i]);
+    }
+}
+
+TEST(ShadowCascadeTest, FitIsStableUnderCameraRotation)
+{
+    const glm::vec3 position(4.0f, 2.0f, -3.0f);
+    const glm::vec3 forward = glm::normalize(glm::vec3(0.2f, -0.1f, 1.0f));
+    auto            first   = FitCascade(position, forward, glm::vec3(0.0f, 1.0f, 0.0f));
+
+    // Rolling around the view direction keeps the slice in the same sphere, the projection does not change at all.
+    for (float roll = 0.1f; roll < 6.28f; roll += 0.1f) {
+        auto right = glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+        auto up    = glm::cross(right, forward) * std::cos(roll) + right * std::sin(roll);
+
+        ShadowCascade cascade = first;
+        auto          corners = ShadowCascade::ComputeFrustumCorners(position, forward, up, FieldOfView, AspectRatio, NearPlane, FarPlane);
+        EXPECT_FALSE(cascade.Fit(corners, LightDirection, NoSceneMin, NoSceneMax, MapSize));
+        EXPECT_EQ(cascade.GetLightProjectionViewMatrix(), first.GetLightProjectionViewMatrix());
+        EXPECT_EQ(cascade.GetVersion(), first.GetVersion());
+    }
+
+    // Turning the camera moves the slice, but the sphere keeps its size and the texel grid stays in place.
+    for (float yaw = 0.1f; yaw < 6.28f; yaw += 0.1f) {
+        auto cascade = FitCascade(position, glm::vec3(std::sin(yaw), -0.1f, std::cos(yaw)), glm::vec3(0.0f, 1.0f, 0.0f));
+        EXPECT_EQ(cascade.GetRadius(), first.GetRadius());
+        ExpectWholeTexelShift(first, cascade);
+    }
+}
+
+TEST(ShadowCascadeTest, FitMovesInWholeTexels)
+{
+    const glm::vec3 forward(0.0f, 0.0f, 1.0f);
+    const glm::vec3 up(0.0f, 1.0f, 0.0f);
+    auto            first = FitCascade(glm::vec3(0.0f), forward, up);
+
+    // Steps of a tenth of a texel, the projection only changes every few of them and then by whole texels.
+    ShadowCascade cascade = first;
+    uint32_t      changes = 0;
+    auto          step    = glm::vec3(1.0f, 0.3f, 0.5f) * (first.GetTexelSize() * 0.1f);
+    for (uint32_t i = 1; i <= 200; i++) {
+        auto corners = ShadowCascade::ComputeFrustumCorners(step * static_cast<float>(i), forward, up, FieldOfView, AspectRatio, NearPlane, FarPlane);
+        if (cascade.Fit(corners, LightDirection, NoSceneMin, NoSceneMax, MapSize)) changes++;
+        ExpectWholeTexelShift(first, cascade);
+    }
+    EXPECT_GT(changes, 0u);
+    EXPECT_LT(changes, 100u);
+}
+}   // namespace MapleLeaf
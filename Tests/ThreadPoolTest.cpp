@@ -0,0 +1,169 @@
+#include "ThreadPool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+namespace MapleLeaf {
+namespace {
+/**
+ * A gate tasks block on until the test opens it, so they are still running or queued when the test acts.
+ */
+class Gate
+{
+public:
+    void Open()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            open = true;
+        }
+        condition.notify_all();
+    }
+
+    void Pass()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return open; });
+    }
+
+private:
+    std::mutex              mutex;
+    std::condition_variable condition;
+    bool                    open = false;
+};
+
+/**
+ * Schedules a binary tree of tasks, every task below the given depth schedules its two children from its worker.
+ * @param pool The pool to schedule on.
+ * @param depth The levels left below this task.
+ * @param count Incremented once per task.
+ */
+void ScheduleTree(ThreadPool& pool, uint32_t depth, std::atomic<uint32_t>& count)
+{
+    pool.Schedule([&pool, depth, &count] {
+        count++;
+        if (depth == 0) return;
+        ScheduleTree(pool, depth - 1, count);
+        ScheduleTree(pool, depth - 1, count);
+    });
+}
+}   // namespace
+
+TEST(ThreadPoolTest, WaitCoversRunningTasks)
+{
+    ThreadPool pool(4);
+
+    std::atomic<bool> started = false, finished = false;
+    pool.Enqueue([&started, &finished] {
+        started = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        finished = true;
+    });
+
+    // The task is no longer queued once it runs, the wait has to cover it anyway.
+    while (!started) std::this_thread::yield();
+    pool.Wait();
+    EXPECT_TRUE(finished);
+
+    // Waiting on an idle pool returns right away.
+    pool.Wait();
+}
+
+TEST(ThreadPoolTest, WaitCoversDependenciesAndContinuations)
+{
+    ThreadPool pool(4);
+    Gate       gate;
+
+    std::mutex               mutex;
+    std::vector<std::string> order;
+    auto                     record = [&mutex, &order](const char* name) {
+        std::unique_lock<std::mutex> lock(mutex);
+        order.emplace_back(name);
+    };
+
+    auto first = pool.Enqueue([&gate, &record] {
+        gate.Pass();
+        record("first");
+        return 20;
+    });
+    auto second = pool.EnqueueAfter({first.GetTask()}, Task::Priority::Critical, [&record] { record("second"); });
+    auto third  = pool.Then(std::move(first), [&record](int value) {
+        record("third");
+        return value + 1;
+    });
+    auto fourth = pool.Then(std::move(second), [&record] { record("fourth"); });
+
+    // Only the first task is queued when the wait starts, the others wait on it.
+    std::thread opener([&gate] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        gate.Open();
+    });
+    pool.Wait();
+    opener.join();
+
+    ASSERT_EQ(order.size(), 4u);
+    EXPECT_EQ(order.front(), "first");
+    auto position = [&order](const char* name) { return std::find(order.begin(), order.end(), name) - order.begin(); };
+    EXPECT_LT(position("second"), position("fourth"));
+    EXPECT_EQ(third.get(), 21);
+    EXPECT_TRUE(fourth.GetTask()->IsFinished());
+}
+
+TEST(ThreadPoolTest, WaitInsideATaskHelpsOut)
+{
+    // With a single worker the waiting task has to run the ones it scheduled itself.
+    ThreadPool            pool(1);
+    std::atomic<uint32_t> count = 0;
+
+    auto outer = pool.Enqueue([&pool, &count] {
+        for (uint32_t i = 0; i < 100; i++) pool.Enqueue([&count] { count++; });
+        pool.Wait();
+        return count.load();
+    });
+
+    EXPECT_EQ(outer.get(), 100u);
+    pool.Wait();
+}
+
+TEST(ThreadPoolTest, CriticalTasksRunBeforeStreamingOnes)
+{
+    // The only worker is held by the gate until both lanes are filled.
+    ThreadPool pool(1);
+    Gate       gate;
+    pool.Enqueue(Task::Priority::Critical, [&gate] { gate.Pass(); });
+
+    std::mutex                  mutex;
+    std::vector<Task::Priority> order;
+    for (auto priority : {Task::Priority::Streaming, Task::Priority::Critical}) {
+        for (uint32_t i = 0; i < 8; i++) {
+            pool.Enqueue(priority, [&mutex, &order, priority] {
+                std::unique_lock<std::mutex> lock(mutex);
+                order.emplace_back(priority);
+            });
+        }
+    }
+
+    gate.Open();
+    pool.Wait();
+
+    ASSERT_EQ(order.size(), 16u);
+    EXPECT_TRUE(std::all_of(order.begin(), order.begin() + 8, [](Task::Priority priority) { return priority == Task::Priority::Critical; }));
+    EXPECT_TRUE(std::all_of(order.begin() + 8, order.end(), [](Task::Priority priority) { return priority == Task::Priority::Streaming; }));
+}
+
+TEST(ThreadPoolTest, StolenTasksAreAllWaitedOn)
+{
+    // Tasks scheduled from workers land in their own deque, the idle workers steal them while they are still being pushed.
+    ThreadPool pool(8);
+
+    for (uint32_t run = 0; run < 20; run++) {
+        std::atomic<uint32_t> count = 0;
+        ScheduleTree(pool, 10, count);
+        pool.Wait();
+        EXPECT_EQ(count, (1u << 11) - 1);
+    }
+}
+}   // namespace MapleLeaf
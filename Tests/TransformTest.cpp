@@ -0,0 +1,142 @@
+#include "Transform.hpp"
+
+#include <gtest/gtest.h>
+
+#include <glm/gtc/quaternion.hpp>
+#include <thread>
+
+namespace MapleLeaf {
+namespace {
+/**
+ * Checks the world position of a transform, the translation column of its world matrix.
+ * @param transform The transform.
+ * @param expected The expected world position.
+ */
+void ExpectWorldPosition(const Transform& transform, const glm::vec3& expected)
+{
+    glm::vec3 position(transform.GetWorldMatrix()[3]);
+    EXPECT_NEAR(position.x, expected.x, 1e-5f);
+    EXPECT_NEAR(position.y, expected.y, 1e-5f);
+    EXPECT_NEAR(position.z, expected.z, 1e-5f);
+}
+}   // namespace
+
+TEST(TransformTest, ChildFollowsDirtyParent)
+{
+    Transform root(glm::vec3(1.0f, 0.0f, 0.0f));
+    Transform child(glm::vec3(0.0f, 2.0f, 0.0f));
+    Transform grandchild(glm::vec3(0.0f, 0.0f, 3.0f));
+    child.SetParent(&root);
+    grandchild.SetParent(&child);
+    ExpectWorldPosition(grandchild, glm::vec3(1.0f, 2.0f, 3.0f));
+
+    // The cached world states of the whole chain are rebuilt after the root moves, whichever link is read first.
+    root.SetLocalPosition(glm::vec3(5.0f, 0.0f, 0.0f));
+    ExpectWorldPosition(child, glm::vec3(5.0f, 2.0f, 0.0f));
+    ExpectWorldPosition(grandchild, glm::vec3(5.0f, 2.0f, 3.0f));
+
+    root.SetLocalScale(glm::vec3(2.0f));
+    ExpectWorldPosition(grandchild, glm::vec3(5.0f, 4.0f, 6.0f));
+    EXPECT_EQ(grandchild.GetScale(), glm::vec3(2.0f));
+
+    // A quarter turn around z takes the child's offset from y to -x.
+    root.SetLocalRotation(glm::angleAxis(glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
+    ExpectWorldPosition(child, glm::vec3(1.0f, 0.0f, 0.0f));
+    ExpectWorldPosition(grandchild, glm::vec3(1.0f, 0.0f, 6.0f));
+
+    // A change in the middle of the chain leaves the root alone.
+    child.SetLocalPosition(glm::vec3(0.0f));
+    ExpectWorldPosition(root, glm::vec3(5.0f, 0.0f, 0.0f));
+    ExpectWorldPosition(grandchild, glm::vec3(5.0f, 0.0f, 6.0f));
+}
+
+TEST(TransformTest, ReparentMovesTheWorldState)
+{
+    Transform first(glm::vec3(1.0f, 0.0f, 0.0f));
+    Transform second(glm::vec3(0.0f, 0.0f, 3.0f));
+    Transform child(glm::vec3(0.0f, 1.0f, 0.0f));
+    Transform grandchild(glm::vec3(0.0f, 1.0f, 0.0f));
+    grandchild.SetParent(&child);
+
+    child.SetParent(&first);
+    ExpectWorldPosition(grandchild, glm::vec3(1.0f, 2.0f, 0.0f));
+
+    child.SetParent(&second);
+    EXPECT_TRUE(first.GetChildren().empty());
+    EXPECT_EQ(second.GetChildren(), std::vector<Transform*>{&child});
+    ExpectWorldPosition(child, glm::vec3(0.0f, 1.0f, 3.0f));
+    ExpectWorldPosition(grandchild, glm::vec3(0.0f, 2.0f, 3.0f));
+
+    // Moves of the old parent no longer reach the child.
+    auto generation = Transform::GetCurrentGeneration();
+    first.SetLocalPosition(glm::vec3(7.0f));
+    EXPECT_FALSE(child.HasChangedSince(generation));
+    ExpectWorldPosition(child, glm::vec3(0.0f, 1.0f, 3.0f));
+
+    child.SetParent(static_cast<Transform*>(nullptr));
+    EXPECT_TRUE(second.GetChildren().empty());
+    ExpectWorldPosition(grandchild, glm::vec3(0.0f, 2.0f, 0.0f));
+}
+
+TEST(TransformTest, ChangesBumpTheGeneration)
+{
+    Transform parent, child, sibling;
+    child.SetParent(&parent);
+
+    auto generation = Transform::GetCurrentGeneration();
+    EXPECT_FALSE(parent.HasChangedSince(generation));
+    EXPECT_FALSE(child.HasChangedSince(generation));
+
+    // Descendants are marked with the generation of their ancestor's change, unrelated transforms are not.
+    parent.SetLocalRotation(glm::angleAxis(1.0f, glm::vec3(0.0f, 1.0f, 0.0f)));
+    EXPECT_GT(Transform::GetCurrentGeneration(), generation);
+    EXPECT_TRUE(parent.HasChangedSince(generation));
+    EXPECT_TRUE(child.HasChangedSince(generation));
+    EXPECT_EQ(child.GetGeneration(), parent.GetGeneration());
+    EXPECT_FALSE(sibling.HasChangedSince(generation));
+
+    // Reading the world state is not a change.
+    generation = Transform::GetCurrentGeneration();
+    child.GetWorldMatrix();
+    EXPECT_FALSE(child.HasChangedSince(generation));
+
+    // A change of the child does not reach its parent, every change takes a new generation.
+    child.SetLocalScale(glm::vec3(2.0f));
+    EXPECT_TRUE(child.HasChangedSince(generation));
+    EXPECT_FALSE(parent.HasChangedSince(generation));
+
+    auto childGeneration = child.GetGeneration();
+    child.SetLocalScale(glm::vec3(3.0f));
+    EXPECT_GT(child.GetGeneration(), childGeneration);
+}
+
+TEST(TransformTest, DirtyChainIsReadFromManyThreads)
+{
+    // Subrenders read world matrices on the thread pool, several of them may find the same chain dirty.
+    std::vector<std::unique_ptr<Transform>> chain;
+    for (uint32_t i = 0; i < 64; i++) {
+        chain.emplace_back(std::make_unique<Transform>(glm::vec3(0.0f, 1.0f, 0.0f)));
+        if (i > 0) chain[i]->SetParent(chain[i - 1].get());
+    }
+
+    for (float x = 1.0f; x <= 8.0f; x++) {
+        chain.front()->SetLocalPosition(glm::vec3(x, 0.0f, 0.0f));
+
+        std::vector<std::vector<glm::vec3>> positions(4);
+        std::vector<std::thread>            threads;
+        for (auto& threadPositions : positions) {
+            threads.emplace_back([&chain, &threadPositions] {
+                for (auto it = chain.rbegin(); it != chain.rend(); ++it) threadPositions.emplace_back((*it)->GetWorldMatrix()[3]);
+            });
+        }
+        for (auto& thread : threads) thread.join();
+
+        // Read from the last link up, each link sits one above its parent.
+        for (const auto& threadPositions : positions) {
+            for (uint32_t i = 0; i < chain.size(); i++) EXPECT_EQ(threadPositions[i], glm::vec3(x, chain.size() - 1.0f - i, 0.0f));
+        }
+    }
+
+    while (!chain.empty()) chain.pop_back();
+}
+}   // namespace MapleLeaf
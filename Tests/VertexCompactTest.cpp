@@ -0,0 +1,115 @@
+#include "VertexCompact.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace MapleLeaf {
+namespace {
+// Directions spread evenly over the sphere on a Fibonacci spiral, plus the axes and the diagonals that sit on the octahedron folds.
+std::vector<glm::vec3> GetDirections(uint32_t count)
+{
+    std::vector<glm::vec3> directions;
+    for (uint32_t i = 0; i < count; i++) {
+        auto z   = 1.0f - 2.0f * (static_cast<float>(i) + 0.5f) / static_cast<float>(count);
+        auto phi = 2.39996323f * static_cast<float>(i);
+        auto r   = std::sqrt(1.0f - z * z);
+        directions.emplace_back(r * std::cos(phi), r * std::sin(phi), z);
+    }
+
+    for (float x : {-1.0f, 0.0f, 1.0f}) {
+        for (float y : {-1.0f, 0.0f, 1.0f}) {
+            for (float z : {-1.0f, 0.0f, 1.0f}) {
+                if (x != 0.0f || y != 0.0f || z != 0.0f) directions.push_back(glm::normalize(glm::vec3(x, y, z)));
+            }
+        }
+    }
+    return directions;
+}
+
+/**
+ * Gets the angle between two directions, from the sine and cosine so small angles keep their precision.
+ * @param a The first direction.
+ * @param b The second direction.
+ * @return The angle in radians.
+ */
+float GetAngle(const glm::vec3& a, const glm::vec3& b)
+{
+    return std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b));
+}
+}   // namespace
+
+TEST(VertexCompactTest, OctahedralDirectionsRoundTrip)
+{
+    for (const auto& direction : GetDirections(4096)) {
+        auto decoded = VertexCompact::DecodeOctahedral(VertexCompact::EncodeOctahedral(direction));
+        EXPECT_LT(GetAngle(direction, decoded), 1e-5f);
+    }
+
+    // A zero direction encodes to the center of the square, which decodes to +Z.
+    EXPECT_EQ(VertexCompact::DecodeOctahedral(VertexCompact::EncodeOctahedral(glm::vec3(0.0f))), glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+TEST(VertexCompactTest, VerticesRoundTripWithinQuantizationError)
+{
+    const glm::vec3 minExtents(-2.0f, 0.0f, 10.0f);
+    const glm::vec3 maxExtents(6.0f, 1.0f, 10.5f);
+
+    // Half a 16 bit step of every axis, and the relative precision of half floats with their 11 bit significand.
+    auto positionError = (maxExtents - minExtents) * (0.5f / 65535.0f) + glm::vec3(1e-5f);
+    auto uvError       = 1.0f / 2048.0f;
+    // The angle of half a snorm16 step on the octahedron, stretched up to twice near the folds.
+    auto directionError = 2.0f * 2.0f / 32767.0f;
+
+    auto directions = GetDirections(1024);
+    for (uint32_t i = 0; i < directions.size(); i++) {
+        auto t = static_cast<float>(i) / static_cast<float>(directions.size() - 1);
+
+        Vertex3D vertex(glm::mix(minExtents, maxExtents, glm::vec3(t, 1.0f - t, std::fmod(t * 7.0f, 1.0f))),
+                        glm::vec2(t * 4.0f - 1.0f, 1.0f - t),
+                        directions[i],
+                        directions[directions.size() - 1 - i]);
+
+        auto decoded = VertexCompact::Encode(vertex, minExtents, maxExtents).Decode(minExtents, maxExtents);
+        for (uint32_t axis = 0; axis < 3; axis++) EXPECT_LE(std::abs(decoded.position[axis] - vertex.position[axis]), positionError[axis]);
+        for (uint32_t axis = 0; axis < 2; axis++)
+            EXPECT_LE(std::abs(decoded.uv[axis] - vertex.uv[axis]), std::max(std::abs(vertex.uv[axis]), 1.0f) * uvError);
+        EXPECT_LE(GetAngle(decoded.normal, vertex.normal), directionError);
+        EXPECT_LE(GetAngle(decoded.tangent, vertex.tangent), directionError);
+    }
+}
+
+TEST(VertexCompactTest, FlatBoundsDecodeToTheirPlane)
+{
+    // A model flat along Y, its bounds have no extent on that axis.
+    const glm::vec3 minExtents(0.0f, 3.0f, 0.0f);
+    const glm::vec3 maxExtents(1.0f, 3.0f, 1.0f);
+
+    Vertex3D vertex(glm::vec3(0.25f, 3.0f, 0.75f), glm::vec2(0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    auto     decoded = VertexCompact::Encode(vertex, minExtents, maxExtents).Decode(minExtents, maxExtents);
+    EXPECT_EQ(decoded.position.y, 3.0f);
+    EXPECT_NEAR(decoded.position.x, 0.25f, 1e-4f);
+    EXPECT_NEAR(decoded.position.z, 0.75f, 1e-4f);
+}
+
+TEST(VertexCompactTest, IndicesNarrowOnlyWhenEveryIndexFits)
+{
+    std::vector<uint32_t> indices = {0, 1, 2, 65533, 65534, 65535};
+    std::vector<uint16_t> shortIndices;
+    ASSERT_TRUE(VertexCompact::AppendShortIndices(indices.data(), indices.data() + indices.size(), shortIndices));
+    ASSERT_EQ(shortIndices.size(), indices.size());
+    for (std::size_t i = 0; i < indices.size(); i++) EXPECT_EQ(shortIndices[i], indices[i]);
+
+    // Appending keeps the indices already narrowed.
+    std::vector<uint32_t> more = {7, 8, 9};
+    ASSERT_TRUE(VertexCompact::AppendShortIndices(more.data(), more.data() + more.size(), shortIndices));
+    EXPECT_EQ(shortIndices.size(), indices.size() + more.size());
+    EXPECT_EQ(shortIndices.back(), 9);
+
+    // One index past 16 bits keeps the whole list at 32 bits.
+    std::vector<uint32_t> large = {0, 1, 65536};
+    EXPECT_FALSE(VertexCompact::AppendShortIndices(large.data(), large.data() + large.size(), shortIndices));
+    EXPECT_EQ(shortIndices.size(), indices.size() + more.size());
+}
+}   // namespace MapleLeaf
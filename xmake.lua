@@ -18,6 +18,8 @@ set_configvar("VERSION_ALTER", 0)
 set_configvar("PROJECT_DIR", rootPath)
 set_configvar("MAPLELEAF_SCENE_DEBUG", false)
 set_configvar("MAPLELEAF_SHADER_DEBUG", true)
+set_configvar("MAPLELEAF_SHADER_CACHE", true)
+set_configvar("MAPLELEAF_SCENE_CACHE", true)
 set_configvar("MAPLELEAF_DEVICE_DEBUG", false)
 set_configvar("MAPLELEAF_GRAPHIC_DEBUG", false)
 set_configvar("MAPLELEAF_GPUSCENE_DEBUG", false)
@@ -26,11 +28,17 @@ set_configvar("MAPLELEAF_VALIDATION_DEBUG", true)
 set_configvar("MAPLELEAF_DESCRIPTOR_DEBUG", false)
 set_configvar("MAPLELEAF_RENDERSTAGE_DEBUG", false)
 set_configvar("MAPLELEAF_RAY_TRACING", false)
+set_configvar("MAPLELEAF_PROFILER", true)
+set_configvar("MAPLELEAF_COMPACT_VERTICES", true)
+set_configvar("MAPLELEAF_OPTIMIZE_OVERDRAW", true)
+set_configvar("MAPLELEAF_COMPACT_GBUFFER", true)
 set_configvar("SHADOW_MAP_SIZE", 1024)
+set_configvar("SHADOW_CASCADE_COUNT", 4)
 set_configdir("Config") 
 add_configfiles("./config.h.in")
 
 add_requires("glm", "glfw", "assimp", "stb", "boost", "nlohmann_json")
+add_requires("gtest", {configs = {main = true}})
 add_requires("volk 1.4.304", "spirv-reflect 1.4.304", "glslang 1.4.304", {verify = false})
 add_requires("imgui", {configs = {glfw_vulkan = true}})
 add_requires("freeimage", {configs = {shared = true}})
@@ -105,3 +113,23 @@ target("MapleLeaf")
         add_syslinks("Comdlg32") -- Adding Windows Common Dialogs Library.
     end
 target_end()
+
+-- Headless scene benchmark, see README for usage.
+target("MapleLeafBenchmark")
+    set_kind("binary")
+    add_deps("Core")
+    add_deps("RenderPass")
+    add_deps("Renderer")
+    add_includedirs("Benchmark/")
+    add_files("Benchmark/*.cpp")
+target_end()
+
+-- CPU unit tests, see README for usage.
+target("MapleLeafTests")
+    set_kind("binary")
+    set_default(false)
+    add_deps("Core")
+    add_packages("gtest")
+    add_files("Tests/*.cpp")
+    add_tests("default")
+target_end()